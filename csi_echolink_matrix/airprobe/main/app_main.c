@@ -9,6 +9,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <sys/param.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
@@ -21,7 +24,7 @@
 #include "esp_wifi.h"
 #include "esp_netif.h"
 #include "esp_now.h"
-#include "esp_chip_info.h"
+#include "esp_timer.h"
 
 #include "lwip/inet.h"
 #include "lwip/netdb.h"
@@ -31,77 +34,434 @@
 #include "protocol_examples_common.h"
 
 #include "csi_data_tools.h"
+#include "csi_stimulus.h"
+#include "csi_frame.h"
+#include "csi_ring.h"
+#include "csi_source.h"
+#if CONFIG_AIRPROBE_FEATURES_ENABLE
+#include "csi_features.h"
+#endif
+#if CONFIG_AIRPROBE_TRIGGER_ENABLE
+#include "csi_trigger.h"
+#endif
+#if CONFIG_AIRPROBE_RATE_CONTROL_ENABLE
+#include "csi_rate.h"
+#endif
+#if CONFIG_AIRPROBE_CLOCK_SYNC_ENABLE
+#include "csi_clock_sync.h"
+#endif
+#if CONFIG_AIRPROBE_FEC_ENABLE
+#include "csi_fec.h"
+#endif
+#if CONFIG_AIRPROBE_CSI_CODEC_ENABLE
+#include "csi_codec.h"
+#endif
+#if CONFIG_AIRPROBE_CPU_TRACE_ENABLE
+#include "csi_cpu.h"
+#endif
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+#include "csi_metrics_server.h"
+#endif
 
 #define CONFIG_SEND_FREQUENCY 100
 
+// Wi-Fi 驱动任务所在的核心（sdkconfig.defaults 中固定为核心 0）
+#if CONFIG_ESP_WIFI_TASK_PINNED_TO_CORE_1
+#define AIRPROBE_WIFI_CORE 1
+#else
+#define AIRPROBE_WIFI_CORE 0
+#endif
+
+/**
+ * 每帧保留的 I/Q 字节数上限，由采集配置（AIRPROBE_CSI_PROFILE）决定。
+ * 驱动按 LLTF、HT-LTF、STBC-HT-LTF 的顺序输出，截取前面的部分即为所选的 LTF；
+ * 帧头中的 len 为实际保留的字节数，主机据此和 bandwidth 选择子载波布局。
+ */
+#if CONFIG_AIRPROBE_CSI_PROFILE_HT40
+#define AIRPROBE_CSI_MAX_LEN 612 // HT40 + STBC：LLTF 64 + HT-LTF 121 + STBC-HT-LTF 121 个子载波
+#define AIRPROBE_CSI_HTLTF_EN true
+#define AIRPROBE_CSI_STBC_EN true
+#elif CONFIG_AIRPROBE_CSI_PROFILE_STBC
+#define AIRPROBE_CSI_MAX_LEN 384 // LLTF + HT-LTF + STBC-HT-LTF，各 64 个子载波
+#define AIRPROBE_CSI_HTLTF_EN true
+#define AIRPROBE_CSI_STBC_EN true
+#elif CONFIG_AIRPROBE_CSI_PROFILE_HTLTF
+#define AIRPROBE_CSI_MAX_LEN 256 // LLTF + HT-LTF
+#define AIRPROBE_CSI_HTLTF_EN true
+#define AIRPROBE_CSI_STBC_EN false
+#else
+#define AIRPROBE_CSI_MAX_LEN 128 // 只保留 LLTF
+#define AIRPROBE_CSI_HTLTF_EN false
+#define AIRPROBE_CSI_STBC_EN false
+#endif
+
+_Static_assert(AIRPROBE_CSI_MAX_LEN <= CSI_FRAME_MAX_PAYLOAD, "CSI profile exceeds CSI_FRAME_MAX_PAYLOAD");
+
 static const char *TAG = "AirProbe";
 
+static uint8_t s_probe_mac[6] = {0}; // 本机 STA MAC，写入二进制帧头用于区分探针
+
 /**
- * @brief CSI 回调函数，当接收到 CSI 数据时被调用
+ * 激励源白名单（AP BSSID 或各发射节点），CSI 回调只接收其中的 MAC 发出的帧，
+ * 按源下标标记每条记录并维护源内序号。只由 CSI 回调修改，其它任务只读取计数。
+ */
+static csi_source_table_t s_sources;
+#if CONFIG_AIRPROBE_STIMULUS_ESPNOW
+static uint8_t s_learned_mac[6] = {0}; // 白名单为空时 ESP-NOW 学习到的发射节点，第一帧 CSI 到达时加入白名单
+#endif
+
+/**
+ * @brief 环形缓冲区中的一条 CSI 记录
  *
- * @param ctx 用户上下文，这里是 AP 的 BSSID
- * @param info CSI 信息结构体指针
+ * Wi-Fi 回调只把 wifi_csi_info_t 中需要的字段拷贝到记录中，
+ * 编码（CSV/二进制）和 sendto 都在 csi_sender 任务中完成，不再阻塞驱动回调。
  */
-static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
+typedef struct {
+    uint32_t seq;                       // 采集序号（回调收到的帧数），线上的帧序号在发送时另行分配
+    uint8_t tx;                         // 激励源下标
+#if CONFIG_AIRPROBE_CLOCK_SYNC_ENABLE
+    int64_t rx_us;                      // 接收时刻（本地 esp_timer 时钟，见 csi_rx_clock_local）
+#endif
+    wifi_pkt_rx_ctrl_t rx_ctrl;
+    uint8_t mac[6];
+    bool first_word_invalid;
+    uint16_t len;
+    int8_t buf[AIRPROBE_CSI_MAX_LEN];
+} csi_record_t;
+
+static csi_ring_t *s_csi_ring = NULL;
+static TaskHandle_t s_sender_task = NULL;
+static volatile uint32_t s_csi_seq = 0; // 回调收到的帧数，也是记录的采集序号
+#if !CONFIG_AIRPROBE_FEATURES_ENABLE || CONFIG_AIRPROBE_FEATURES_SEND_RAW
+/**
+ * 线上的帧序号（csi_frame_hdr_t.seq / tx_seq，CSV 中的 seq）只分配给实际发送的帧，
+ * 接收端按序号的空缺统计丢包；环形缓冲区溢出和触发器没有发送的帧另外计数，不占用序号。
+ * 只由 csi_sender 任务写入，指标查询读取 s_send_seq。
+ */
+static volatile uint32_t s_send_seq = 0;
+#if CONFIG_AIRPROBE_CSI_FORMAT_BINARY
+static uint32_t s_send_tx_seq[CSI_SOURCE_MAX];
+#endif
+#endif
+#if CONFIG_AIRPROBE_TRIGGER_ENABLE
+static volatile uint32_t s_trigger_suppressed = 0; // 运动触发器没有发送的帧数，只由 csi_sender 任务写入
+#endif
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+static csi_metric_hist_t s_encode_us;   // 每帧编码耗时，csi_sender 任务写入，指标查询读取
+#endif
+
+#if CONFIG_AIRPROBE_CLOCK_SYNC_ENABLE
+static csi_rx_clock_t s_rx_clock;       // 接收时间戳换算，只由 CSI 回调访问
+static csi_clock_model_t s_clock_model; // 对时任务发布的模型，csi_sender 任务每轮取一次
+#endif
+
+#if CONFIG_AIRPROBE_CSI_FORMAT_BINARY
+#if CONFIG_AIRPROBE_CSI_CODEC_ENABLE
+// 压缩统计，只由 csi_sender 任务访问
+static uint32_t s_codec_frames;         // 压缩发送的帧数
+static uint32_t s_codec_raw_bytes;      // 压缩前的 I/Q 字节数
+static uint32_t s_codec_packed_bytes;   // 压缩后的数据区字节数
+static uint32_t s_codec_encode_us;      // 编码累计耗时（含未压缩成功的帧）
+static uint32_t s_codec_encoded;        // 尝试编码的帧数
+#endif
+
+/**
+ * @brief 将 CSI 记录编码为二进制帧（csi_frame_hdr_t + int8 I/Q）
+ *
+ * 只做定长字段拷贝和一次 memcpy，替代文本模式下逐个元素的 snprintf。
+ * 开启 AIRPROBE_CSI_CODEC_ENABLE 时 I/Q 压缩为 CSI_FRAME_TYPE_PACKED 帧，
+ * 压缩后不比原始数据短的帧仍按 CSI_FRAME_TYPE_RAW 发送。
+ *
+ * @param record CSI 记录
+ * @param seq 线上的帧序号
+ * @param tx_seq 激励源内的帧序号
+ * @param out 输出缓冲区，至少 sizeof(csi_frame_hdr_t) + record->len 字节
+ * @return 帧长度
+ */
+static size_t wifi_csi_encode_frame(const csi_record_t *record, uint32_t seq, uint32_t tx_seq, uint8_t *out)
 {
-    // 检查 info 和 info->buf 是否为空
-    if (!info || !info->buf)
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+    int64_t encode_start = esp_timer_get_time();
+#endif
+    const wifi_pkt_rx_ctrl_t *rx_ctrl = &record->rx_ctrl;
+    csi_frame_hdr_t *hdr = (csi_frame_hdr_t *)out;
+
+    csi_frame_hdr_init(hdr, CSI_FRAME_TYPE_RAW);
+    hdr->seq = seq;
+    hdr->local_timestamp = rx_ctrl->timestamp;
+    memcpy(hdr->probe_mac, s_probe_mac, sizeof(hdr->probe_mac));
+    memcpy(hdr->mac, record->mac, sizeof(hdr->mac));
+    hdr->rssi = rx_ctrl->rssi;
+    hdr->rate = rx_ctrl->rate;
+    hdr->sig_mode = rx_ctrl->sig_mode;
+    hdr->mcs = rx_ctrl->mcs;
+    hdr->cwb = rx_ctrl->cwb;
+    hdr->smoothing = rx_ctrl->smoothing;
+    hdr->not_sounding = rx_ctrl->not_sounding;
+    hdr->aggregation = rx_ctrl->aggregation;
+    hdr->stbc = rx_ctrl->stbc;
+    hdr->fec_coding = rx_ctrl->fec_coding;
+    hdr->sgi = rx_ctrl->sgi;
+    hdr->noise_floor = rx_ctrl->noise_floor;
+    hdr->ampdu_cnt = rx_ctrl->ampdu_cnt;
+    hdr->channel = rx_ctrl->channel;
+    hdr->secondary_channel = rx_ctrl->secondary_channel;
+    hdr->ant = rx_ctrl->ant;
+    hdr->rx_state = rx_ctrl->rx_state;
+    hdr->first_word_invalid = record->first_word_invalid;
+    hdr->sig_len = rx_ctrl->sig_len;
+    hdr->len = record->len;
+    hdr->tx = record->tx;
+    hdr->tx_seq = tx_seq;
+#if CONFIG_AIRPROBE_CLOCK_SYNC_ENABLE
+    hdr->sync_us = csi_clock_to_ref(&s_clock_model, record->rx_us);
+    hdr->drift_ppb = s_clock_model.drift_ppb;
+    hdr->sync_err_us = s_clock_model.err_us;
+#endif
+#if CONFIG_AIRPROBE_CSI_CODEC_ENABLE
+    int64_t start = esp_timer_get_time();
+    size_t packed = csi_codec_pack(record->buf, record->len, CONFIG_AIRPROBE_CSI_CODEC_QUANT, out + sizeof(*hdr));
+    s_codec_encode_us += esp_timer_get_time() - start;
+    s_codec_encoded++;
+    if (packed > 0)
     {
-        ESP_LOGW(TAG, "<%s> wifi_csi_cb", esp_err_to_name(ESP_ERR_INVALID_ARG));
-        return;
+        hdr->type = CSI_FRAME_TYPE_PACKED;
+        hdr->len = packed;
+        s_codec_frames++;
+        s_codec_raw_bytes += record->len;
+        s_codec_packed_bytes += packed;
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+        csi_metric_observe(&s_encode_us, (uint32_t)(esp_timer_get_time() - encode_start));
+#endif
+        return sizeof(*hdr) + packed;
+    }
+#endif
+    memcpy(out + sizeof(*hdr), record->buf, record->len);
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+    csi_metric_observe(&s_encode_us, (uint32_t)(esp_timer_get_time() - encode_start));
+#endif
+
+    return sizeof(*hdr) + record->len;
+}
+
+#if CONFIG_AIRPROBE_BATCH_ENABLE
+#if CONFIG_AIRPROBE_FEC_ENABLE
+// 容器头后追加 FEC 分组信息；校验数据报加上校验头后不能超过一个数据报，聚合数据报相应缩短
+#define AIRPROBE_BATCH_HDR_LEN  CSI_FEC_BATCH_HDR_LEN
+#define AIRPROBE_BATCH_BYTES    MIN(CONFIG_AIRPROBE_BATCH_MAX_BYTES, CSI_FEC_MAX_DATAGRAM)
+#else
+#define AIRPROBE_BATCH_HDR_LEN  sizeof(csi_batch_hdr_t)
+#define AIRPROBE_BATCH_BYTES    CONFIG_AIRPROBE_BATCH_MAX_BYTES
+#endif
+
+_Static_assert(AIRPROBE_BATCH_BYTES >= AIRPROBE_BATCH_HDR_LEN + sizeof(csi_frame_hdr_t) + AIRPROBE_CSI_MAX_LEN,
+               "AIRPROBE_BATCH_MAX_BYTES must hold at least one frame of the selected CSI profile");
+
+/**
+ * @brief 聚合发送缓冲区：多个帧打包进一个 csi_batch_hdr_t 容器
+ *
+ * 达到 AIRPROBE_BATCH_MAX_FRAMES 帧、放不下下一帧、或第一帧等待超过
+ * AIRPROBE_BATCH_FLUSH_MS 时发送，只由 csi_sender 任务访问。
+ */
+typedef struct {
+    uint8_t buf[AIRPROBE_BATCH_BYTES];
+    size_t len;             // 已使用的字节数（含容器头）
+    uint8_t count;          // 已聚合的帧数
+    TickType_t deadline;    // 最迟发送时间
+} csi_batch_t;
+
+static csi_batch_t s_batch;
+
+#if CONFIG_AIRPROBE_FEC_ENABLE
+/**
+ * @brief FEC 编码器：每 AIRPROBE_FEC_GROUP 个聚合数据报之后发送一个异或校验数据报
+ *
+ * 组在第一个数据报之后 AIRPROBE_FEC_FLUSH_MS 内未满时提前结束，发送暂停前丢失的数据报也能恢复。
+ * 编码耗时用 esp_timer 累计，随统计日志打印。只由 csi_sender 任务访问。
+ */
+static csi_fec_enc_t s_fec;
+static TickType_t s_fec_deadline;       // 当前组最迟结束时间
+static uint32_t s_fec_datagrams;        // 计入校验的聚合数据报数
+static uint32_t s_fec_parity;           // 发送的校验数据报数
+static uint32_t s_fec_encode_us;        // 编码累计耗时
+
+static void csi_fec_flush(void)
+{
+    int64_t start = esp_timer_get_time();
+    size_t len = csi_fec_enc_finish(&s_fec);
+    s_fec_encode_us += esp_timer_get_time() - start;
+
+    if (len > 0)
+    {
+        echo_csi_data(s_fec.buf, len);
+        s_fec_parity++;
     }
+}
 
-    // 检查接收到的 CSI 数据的 MAC 地址是否与期望的 MAC 地址匹配
-    if (memcmp(info->mac, ctx, 6))
+/**
+ * @return 距离当前组必须结束还剩多少 tick，组为空时返回 max_wait
+ */
+static TickType_t csi_fec_wait_ticks(TickType_t max_wait)
+{
+    if (s_fec.count == 0)
+    {
+        return max_wait;
+    }
+
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(s_fec_deadline - now) <= 0)
+    {
+        return 0;
+    }
+    return MIN(s_fec_deadline - now, max_wait);
+}
+#endif /* CONFIG_AIRPROBE_FEC_ENABLE */
+
+static void csi_batch_flush(void)
+{
+    csi_batch_hdr_t *hdr = (csi_batch_hdr_t *)s_batch.buf;
+
+    if (s_batch.count == 0)
     {
         return;
     }
 
-    // static int s_count = 0; // 静态计数器，用于记录接收到的 CSI 数据包的数量
-    static int s_version = 0;                           // 静态芯片版本号
-    const wifi_pkt_rx_ctrl_t *rx_ctrl = &info->rx_ctrl; // 指向接收控制信息的指针
+    csi_batch_hdr_init(hdr);
+    hdr->hdr_len = AIRPROBE_BATCH_HDR_LEN;
+    hdr->count = s_batch.count;
+    hdr->len = s_batch.len - AIRPROBE_BATCH_HDR_LEN;
+#if CONFIG_AIRPROBE_FEC_ENABLE
+    if (s_fec.count == 0)
+    {
+        s_fec_deadline = xTaskGetTickCount() + pdMS_TO_TICKS(CONFIG_AIRPROBE_FEC_FLUSH_MS);
+    }
+    int64_t start = esp_timer_get_time();
+    bool group_full = csi_fec_enc_add(&s_fec, s_batch.buf, s_batch.len);
+    s_fec_encode_us += esp_timer_get_time() - start;
+    s_fec_datagrams++;
+
+    echo_csi_data(s_batch.buf, s_batch.len);
+    if (group_full)
+    {
+        csi_fec_flush();
+    }
+#else
+    echo_csi_data(s_batch.buf, s_batch.len);
+#endif
+
+    s_batch.count = 0;
+}
+
+/**
+ * @return 距离聚合缓冲区必须发送还剩多少 tick，缓冲区为空时返回 max_wait
+ */
+static TickType_t csi_batch_wait_ticks(TickType_t max_wait)
+{
+    if (s_batch.count == 0)
+    {
+        return max_wait;
+    }
+
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(s_batch.deadline - now) <= 0)
+    {
+        return 0;
+    }
+    return MIN(s_batch.deadline - now, max_wait);
+}
+
+static void wifi_csi_send_frame(const csi_record_t *record, uint32_t seq, uint32_t tx_seq)
+{
+#if CONFIG_AIRPROBE_CSI_CODEC_ENABLE
+    // 压缩后的长度编码后才知道：先编码到临时缓冲区，按实际长度判断能否放入当前容器
+    uint8_t frame[sizeof(csi_frame_hdr_t) + AIRPROBE_CSI_MAX_LEN];
+    size_t frame_len = wifi_csi_encode_frame(record, seq, tx_seq, frame);
+#else
+    size_t frame_len = sizeof(csi_frame_hdr_t) + record->len;
+#endif
+
+    if (s_batch.count > 0 && s_batch.len + frame_len > sizeof(s_batch.buf))
+    {
+        csi_batch_flush();
+    }
+
+    if (s_batch.count == 0)
+    {
+        s_batch.len = AIRPROBE_BATCH_HDR_LEN;
+        s_batch.deadline = xTaskGetTickCount() + pdMS_TO_TICKS(CONFIG_AIRPROBE_BATCH_FLUSH_MS);
+    }
+
+#if CONFIG_AIRPROBE_CSI_CODEC_ENABLE
+    memcpy(s_batch.buf + s_batch.len, frame, frame_len);
+    s_batch.len += frame_len;
+#else
+    s_batch.len += wifi_csi_encode_frame(record, seq, tx_seq, s_batch.buf + s_batch.len);
+#endif
+    if (++s_batch.count >= CONFIG_AIRPROBE_BATCH_MAX_FRAMES)
+    {
+        csi_batch_flush();
+    }
+}
+#else
+static void wifi_csi_send_frame(const csi_record_t *record, uint32_t seq, uint32_t tx_seq)
+{
+    uint8_t frame[sizeof(csi_frame_hdr_t) + AIRPROBE_CSI_MAX_LEN];
+
+    echo_csi_data(frame, wifi_csi_encode_frame(record, seq, tx_seq, frame));
+}
+#endif /* CONFIG_AIRPROBE_BATCH_ENABLE */
+#else
+/**
+ * @brief 将 CSI 记录格式化为 "CSI_DATA,..." 文本并发送
+ *
+ * @param record CSI 记录
+ * @param seq 线上的帧序号
+ */
+static void wifi_csi_send_csv(const csi_record_t *record, uint32_t seq)
+{
+    static bool s_header_printed = false;
+    const wifi_pkt_rx_ctrl_t *rx_ctrl = &record->rx_ctrl; // 指向接收控制信息的指针
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+    int64_t encode_start = esp_timer_get_time();
+#endif
 
     // 打印 CSI 数据的头部信息，只在第一次接收到数据时打印
-    // if (!s_count)
-    if (!s_version)
+    if (!s_header_printed)
     {
         ESP_LOGI(TAG, "================ CSI RECV ================");
         ets_printf("type,seq,mac,rssi,rate,sig_mode,mcs,bandwidth,smoothing,not_sounding,aggregation,stbc,fec_coding,sgi,noise_floor,ampdu_cnt,channel,secondary_channel,local_timestamp,ant,sig_len,rx_state,len,first_word,data\n");
-        esp_chip_info_t Esp_Info;
-        esp_chip_info(&Esp_Info);
-        s_version = Esp_Info.revision;
+        s_header_printed = true;
     }
 
-    /** Only LLTF sub-carriers are selected. */
-    info->len = 128; // 设置 CSI 数据的长度为 128
-
-    char csi_values[1024]; // 假设1024足够长来存储整个字符串
+    // 每个 I/Q 值最多 5 个字符（",-128"），只由 csi_sender 任务调用，放在静态区以免占用任务栈
+    static char csi_values[256 + AIRPROBE_CSI_MAX_LEN * 5];
     char server_mac_str[18];
     // 格式化 CSI 数据为字符串
-    int snprintf_result = snprintf(csi_values, sizeof(csi_values), "CSI_DATA,%d," MACSTR ",%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d",
-                                   s_version, // s_count++,
-                                   MAC2STR(info->mac), rx_ctrl->rssi, rx_ctrl->rate, rx_ctrl->sig_mode,
+    // seq 与二进制帧的 seq 相同：只有实际发送的帧占用序号
+    int snprintf_result = snprintf(csi_values, sizeof(csi_values), "CSI_DATA,%" PRIu32 "," MACSTR ",%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d",
+                                   seq,
+                                   MAC2STR(record->mac), rx_ctrl->rssi, rx_ctrl->rate, rx_ctrl->sig_mode,
                                    rx_ctrl->mcs, rx_ctrl->cwb, rx_ctrl->smoothing, rx_ctrl->not_sounding,
                                    rx_ctrl->aggregation, rx_ctrl->stbc, rx_ctrl->fec_coding, rx_ctrl->sgi,
                                    rx_ctrl->noise_floor, rx_ctrl->ampdu_cnt, rx_ctrl->channel, rx_ctrl->secondary_channel,
                                    rx_ctrl->timestamp, rx_ctrl->ant, rx_ctrl->sig_len, rx_ctrl->rx_state);
-    snprintf(server_mac_str, sizeof(server_mac_str), MACSTR, MAC2STR(info->mac));
+    snprintf(server_mac_str, sizeof(server_mac_str), MACSTR, MAC2STR(record->mac));
 
     // 检查 snprintf 是否成功，并且没有发生缓冲区溢出
     if (snprintf_result >= 0 && snprintf_result < sizeof(csi_values))
     {
         int current_length = snprintf_result;
         // 添加 CSI 数据的长度、第一个无效字和第一个 CSI 值到字符串
-        snprintf_result = snprintf(csi_values + current_length, sizeof(csi_values) - current_length, ",%d,%d,\"[%d", info->len, info->first_word_invalid, info->buf[0]);
+        snprintf_result = snprintf(csi_values + current_length, sizeof(csi_values) - current_length, ",%d,%d,\"[%d", record->len, record->first_word_invalid, record->buf[0]);
 
         // 再次检查 snprintf 是否成功，并且没有发生缓冲区溢出
         if (snprintf_result >= 0 && current_length + snprintf_result < sizeof(csi_values))
         {
             current_length += snprintf_result;
             // 循环添加剩余的 CSI 值到字符串
-            for (int i = 1; i < info->len; i++)
+            for (int i = 1; i < record->len; i++)
             {
-                snprintf_result = snprintf(csi_values + current_length, sizeof(csi_values) - current_length, ",%d", info->buf[i]);
+                snprintf_result = snprintf(csi_values + current_length, sizeof(csi_values) - current_length, ",%d", record->buf[i]);
                 if (snprintf_result >= 0 && current_length + snprintf_result < sizeof(csi_values))
                 {
                     current_length += snprintf_result;
@@ -118,8 +478,10 @@ static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
             if (snprintf_result >= 0 && current_length + snprintf_result < sizeof(csi_values))
             {
                 // printf("%s", csi_values);
-                echo_csi_data(csi_values); // 调用函数发送 CSI 数据
-                // echo_csi_data_mcast(csi_values);// 用组播方式发送 CSI 数据
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+                csi_metric_observe(&s_encode_us, (uint32_t)(esp_timer_get_time() - encode_start));
+#endif
+                echo_csi_data(csi_values, current_length + snprintf_result); // 调用函数发送 CSI 数据
             }
             else
             {
@@ -136,37 +498,664 @@ static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
         ESP_LOGE(TAG, "snprintf error or buffer overflow at the beginning");
     }
 }
+#endif
+
+#if !CONFIG_AIRPROBE_FEATURES_ENABLE || CONFIG_AIRPROBE_FEATURES_SEND_RAW
+/**
+ * @brief 按配置的输出格式发送一条原始记录，并为其分配线上的帧序号
+ */
+static void wifi_csi_send_raw(const csi_record_t *record)
+{
+    uint32_t seq = s_send_seq++;
+#if CONFIG_AIRPROBE_CSI_FORMAT_BINARY
+    wifi_csi_send_frame(record, seq, s_send_tx_seq[record->tx]++);
+#else
+    wifi_csi_send_csv(record, seq);
+#endif
+}
+
+#if CONFIG_AIRPROBE_TRIGGER_ENABLE
+/**
+ * @brief 运动触发：空闲时只发送心跳帧，检测到变化时先补发预触发缓冲区，
+ *        再持续发送到最后一次超过阈值后 AIRPROBE_TRIGGER_HOLD_MS
+ *
+ * 预触发缓冲区只保存上一次发送之后的帧，补发的帧在时间上排在已发送的帧之后。
+ * 最终没有发送的帧（空闲时丢弃、被预触发缓冲区覆盖或在心跳时清空）计入 s_trigger_suppressed，不占用帧序号。
+ * 触发器和缓冲区只由 csi_sender 任务访问。
+ */
+static csi_trigger_t s_trigger;
+
+#if CONFIG_AIRPROBE_TRIGGER_PRE_FRAMES > 0
+static csi_record_t s_pretrigger[CONFIG_AIRPROBE_TRIGGER_PRE_FRAMES];
+static uint32_t s_pretrigger_head = 0;  // 下一个写入位置
+static uint32_t s_pretrigger_count = 0;
+
+static void pretrigger_push(const csi_record_t *record)
+{
+    memcpy(&s_pretrigger[s_pretrigger_head], record, offsetof(csi_record_t, buf) + record->len);
+    s_pretrigger_head = (s_pretrigger_head + 1) % CONFIG_AIRPROBE_TRIGGER_PRE_FRAMES;
+    if (s_pretrigger_count < CONFIG_AIRPROBE_TRIGGER_PRE_FRAMES)
+    {
+        s_pretrigger_count++;
+    }
+    else
+    {
+        s_trigger_suppressed++; // 覆盖了最早的一帧
+    }
+}
+
+static void pretrigger_flush(void)
+{
+    uint32_t index = (s_pretrigger_head + CONFIG_AIRPROBE_TRIGGER_PRE_FRAMES - s_pretrigger_count)
+                     % CONFIG_AIRPROBE_TRIGGER_PRE_FRAMES;
+
+    for (; s_pretrigger_count > 0; s_pretrigger_count--)
+    {
+        wifi_csi_send_raw(&s_pretrigger[index]);
+        index = (index + 1) % CONFIG_AIRPROBE_TRIGGER_PRE_FRAMES;
+    }
+}
+#else
+static void pretrigger_push(const csi_record_t *record)
+{
+    s_trigger_suppressed++;
+}
+static void pretrigger_flush(void) {}
+#endif
+
+static void wifi_csi_send_triggered(const csi_record_t *record)
+{
+    static bool s_active = false;
+
+    // 不同发射端的幅度不可比，只用源 0 检测；其它源的帧按长度 0 输入，只跟随触发状态
+    csi_trigger_action_t action = csi_trigger_update(&s_trigger, record->buf, record->tx == 0 ? record->len : 0,
+                                                     record->rx_ctrl.timestamp);
+    if (s_active && !s_trigger.active)
+    {
+        ESP_LOGI(TAG, "Motion trigger #%" PRIu32 " ended", s_trigger.events);
+    }
+    s_active = s_trigger.active;
+
+    switch (action)
+    {
+    case CSI_TRIGGER_DROP:
+        pretrigger_push(record);
+        break;
+    case CSI_TRIGGER_START:
+        ESP_LOGI(TAG, "Motion trigger #%" PRIu32 ": level %" PRIu32 ", baseline %" PRIu32 " (Q4)",
+                 s_trigger.events, csi_trigger_level_q4(&s_trigger), csi_trigger_baseline_q4(&s_trigger));
+        pretrigger_flush();
+        wifi_csi_send_raw(record);
+        break;
+    case CSI_TRIGGER_HEARTBEAT:
+#if CONFIG_AIRPROBE_TRIGGER_PRE_FRAMES > 0
+        s_trigger_suppressed += s_pretrigger_count;
+        s_pretrigger_count = 0;
+#endif
+        wifi_csi_send_raw(record);
+        break;
+    case CSI_TRIGGER_STREAM:
+        wifi_csi_send_raw(record);
+        break;
+    }
+}
+#endif /* CONFIG_AIRPROBE_TRIGGER_ENABLE */
+#endif
+
+#if CONFIG_AIRPROBE_FEATURES_ENABLE
+static csi_features_t s_features[CSI_SOURCE_MAX];  // 每个激励源一个窗口，只由 csi_sender 任务访问
+
+/**
+ * @brief 把记录加入所属激励源的特征窗口，窗口结束时发送特征数据报
+ *
+ * @param record CSI 记录
+ */
+static void wifi_csi_send_features(const csi_record_t *record)
+{
+    csi_features_result_t result;
+    uint8_t datagram[sizeof(csi_features_hdr_t) + CSI_FEATURES_SUBCARRIERS * sizeof(uint16_t)];
+
+    if (!csi_features_push(&s_features[record->tx], record->buf, record->len, record->rx_ctrl.rssi,
+                           record->rx_ctrl.timestamp, record->seq, &result))
+    {
+        return;
+    }
+
+    size_t len = csi_features_encode(&result, s_probe_mac, record->mac, datagram, sizeof(datagram));
+    echo_csi_data(datagram, len);
+}
+#endif
+
+/**
+ * @brief ping 激励：向网关持续发送 ping，路由器的应答帧产生 CSI
+ *
+ * esp_ping 不支持运行中修改间隔，调整速率时重建会话。
+ * 应答/超时计数由 ping 任务累加，速率控制和统计日志读取增量。
+ */
+static esp_ping_handle_t s_ping_handle = NULL;
+static esp_ping_config_t s_ping_config;
+static volatile uint32_t s_ping_replies = 0;
+static volatile uint32_t s_ping_timeouts = 0;
+
+static void wifi_ping_on_success(esp_ping_handle_t hdl, void *args)
+{
+    s_ping_replies++;
+}
+
+static void wifi_ping_on_timeout(esp_ping_handle_t hdl, void *args)
+{
+    s_ping_timeouts++;
+}
+
+static esp_err_t wifi_ping_session_start(uint32_t interval_ms)
+{
+    if (s_ping_handle)
+    {
+        esp_ping_stop(s_ping_handle);
+        esp_ping_delete_session(s_ping_handle);
+        s_ping_handle = NULL;
+    }
+
+    s_ping_config.interval_ms = interval_ms;
+    esp_ping_callbacks_t cbs = {
+        .on_ping_success = wifi_ping_on_success,
+        .on_ping_timeout = wifi_ping_on_timeout,
+    };
+    esp_err_t ret = esp_ping_new_session(&s_ping_config, &cbs, &s_ping_handle);
+    if (ret != ESP_OK)
+    {
+        s_ping_handle = NULL;
+        return ret;
+    }
+    return esp_ping_start(s_ping_handle);
+}
+
+/**
+ * @brief 每个统计周期的计数快照，日志和速率控制按两次快照的差值计算
+ */
+typedef struct {
+    TickType_t time;
+    uint32_t csi_frames;
+    uint32_t ping_replies;
+    uint32_t ping_timeouts;
+    uint32_t overflow;
+    uint32_t send_errors;
+    uint32_t tx_frames[CSI_SOURCE_MAX]; // 每个激励源收到的帧数
+#if CONFIG_AIRPROBE_TRIGGER_ENABLE
+    uint32_t trigger_suppressed;
+#endif
+#if CONFIG_AIRPROBE_FEC_ENABLE
+    uint32_t fec_datagrams;
+    uint32_t fec_parity;
+    uint32_t fec_encode_us;
+#endif
+#if CONFIG_AIRPROBE_CSI_CODEC_ENABLE
+    uint32_t codec_encoded;
+    uint32_t codec_frames;
+    uint32_t codec_raw_bytes;
+    uint32_t codec_packed_bytes;
+    uint32_t codec_encode_us;
+#endif
+} csi_counters_t;
+
+static void csi_counters_get(csi_counters_t *counters, csi_ring_stats_t *stats)
+{
+    csi_ring_get_stats(s_csi_ring, stats);
+    counters->time = xTaskGetTickCount();
+    counters->csi_frames = s_csi_seq;
+    counters->ping_replies = s_ping_replies;
+    counters->ping_timeouts = s_ping_timeouts;
+    counters->overflow = stats->overflow;
+    counters->send_errors = csi_sender_get_send_errors();
+    memcpy(counters->tx_frames, s_sources.seq, sizeof(counters->tx_frames));
+#if CONFIG_AIRPROBE_TRIGGER_ENABLE
+    counters->trigger_suppressed = s_trigger_suppressed;
+#endif
+#if CONFIG_AIRPROBE_FEC_ENABLE
+    counters->fec_datagrams = s_fec_datagrams;
+    counters->fec_parity = s_fec_parity;
+    counters->fec_encode_us = s_fec_encode_us;
+#endif
+#if CONFIG_AIRPROBE_CSI_CODEC_ENABLE
+    counters->codec_encoded = s_codec_encoded;
+    counters->codec_frames = s_codec_frames;
+    counters->codec_raw_bytes = s_codec_raw_bytes;
+    counters->codec_packed_bytes = s_codec_packed_bytes;
+    counters->codec_encode_us = s_codec_encode_us;
+#endif
+}
+
+#if CONFIG_AIRPROBE_RATE_CONTROL_ENABLE
+/**
+ * @brief 激励速率的闭环控制，每 AIRPROBE_RATE_PERIOD_MS 由 csi_sender 任务调用一次
+ */
+static csi_rate_t s_rate;
+
+static void wifi_rate_control(const csi_counters_t *prev, const csi_counters_t *now, const csi_ring_stats_t *stats)
+{
+    csi_rate_sample_t sample = {
+        .pings = (now->ping_replies - prev->ping_replies) + (now->ping_timeouts - prev->ping_timeouts),
+        .timeouts = now->ping_timeouts - prev->ping_timeouts,
+        .csi_frames = now->csi_frames - prev->csi_frames,
+        .overflow = now->overflow - prev->overflow,
+        .send_errors = now->send_errors - prev->send_errors,
+        .queue_depth = stats->count,
+        .queue_capacity = stats->capacity,
+    };
+
+    csi_rate_action_t action = csi_rate_update(&s_rate, &sample);
+    if (action == CSI_RATE_HOLD)
+    {
+        return;
+    }
+
+    if (action == CSI_RATE_DOWN)
+    {
+        ESP_LOGW(TAG, "CSI rate down to %u Hz (congestion 0x%02x: %" PRIu32 "/%" PRIu32 " ping timeouts, "
+                 "%" PRIu32 " CSI frames, %" PRIu32 " overflow, queue %" PRIu32 "/%" PRIu32 ", %" PRIu32 " send errors)",
+                 s_rate.rate_hz, s_rate.congestion, sample.timeouts, sample.pings, sample.csi_frames,
+                 sample.overflow, sample.queue_depth, sample.queue_capacity, sample.send_errors);
+    }
+    else
+    {
+        ESP_LOGD(TAG, "CSI rate up to %u Hz", s_rate.rate_hz);
+    }
+
+    if (wifi_ping_session_start(s_rate.interval_ms) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to restart ping at %u ms", s_rate.interval_ms);
+    }
+}
+#endif /* CONFIG_AIRPROBE_RATE_CONTROL_ENABLE */
+
+/**
+ * @brief 打印一个统计周期的实际 CSI 速率、ping 超时和环形缓冲区状态
+ */
+static void csi_log_stats(const csi_counters_t *prev, const csi_counters_t *now, const csi_ring_stats_t *stats)
+{
+    uint32_t ms = pdTICKS_TO_MS(now->time - prev->time);
+    uint32_t pings = (now->ping_replies - prev->ping_replies) + (now->ping_timeouts - prev->ping_timeouts);
+
+    if (ms == 0)
+    {
+        return;
+    }
+
+#if CONFIG_AIRPROBE_STIMULUS_PING
+    ESP_LOGI(TAG, "CSI rate: achieved %" PRIu32 " Hz, ping %" PRIu32 " Hz (interval %" PRIu32 " ms), %" PRIu32 "/%" PRIu32 " timeouts",
+             (now->csi_frames - prev->csi_frames) * 1000 / ms, pings * 1000 / ms, s_ping_config.interval_ms,
+             now->ping_timeouts - prev->ping_timeouts, pings);
+#else
+    ESP_LOGI(TAG, "CSI rate: achieved %" PRIu32 " Hz", (now->csi_frames - prev->csi_frames) * 1000 / ms);
+    (void)pings;
+#endif
+    // 多个激励源时分别打印各自的速率
+    for (int tx = 0; s_sources.count > 1 && tx < s_sources.count; tx++)
+    {
+        ESP_LOGI(TAG, "CSI source %d " MACSTR ": %" PRIu32 " Hz", tx, MAC2STR(s_sources.mac[tx]),
+                 (now->tx_frames[tx] - prev->tx_frames[tx]) * 1000 / ms);
+    }
+    ESP_LOGI(TAG, "CSI ring: pushed %" PRIu32 ", overflow %" PRIu32 ", high water %" PRIu32 "/%" PRIu32 ", send errors %" PRIu32,
+             stats->pushed, stats->overflow, stats->high_water, stats->capacity, now->send_errors);
+#if CONFIG_AIRPROBE_TRIGGER_ENABLE
+    ESP_LOGI(TAG, "Trigger: %" PRIu32 " frames not sent (%" PRIu32 " total)",
+             now->trigger_suppressed - prev->trigger_suppressed, now->trigger_suppressed);
+#endif
+#if CONFIG_AIRPROBE_CLOCK_SYNC_ENABLE
+    if (s_clock_model.synced)
+    {
+        ESP_LOGI(TAG, "Clock: offset %" PRId64 " us, drift %" PRId32 " ppb, error %" PRIu32 " us",
+                 s_clock_model.offset_us, s_clock_model.drift_ppb, s_clock_model.err_us);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Clock: not synced, frames carry sync_us = 0");
+    }
+#endif
+#if CONFIG_AIRPROBE_FEC_ENABLE
+    // 编码开销：每个数据报的平均耗时和占用的 CPU 时间比例
+    uint32_t fec_datagrams = now->fec_datagrams - prev->fec_datagrams;
+    uint32_t fec_us = now->fec_encode_us - prev->fec_encode_us;
+    ESP_LOGI(TAG, "FEC: %" PRIu32 " datagrams, %" PRIu32 " parity, encode %" PRIu32 " ns/datagram, %" PRIu32 " us/s",
+             fec_datagrams, now->fec_parity - prev->fec_parity,
+             fec_datagrams ? (uint32_t)((uint64_t)fec_us * 1000 / fec_datagrams) : 0,
+             (uint32_t)((uint64_t)fec_us * 1000 / ms));
+#endif
+#if CONFIG_AIRPROBE_CSI_CODEC_ENABLE
+    // 压缩率按压缩成功的帧计算（x100），编码耗时按所有尝试编码的帧平均
+    uint32_t codec_encoded = now->codec_encoded - prev->codec_encoded;
+    uint32_t codec_raw = now->codec_raw_bytes - prev->codec_raw_bytes;
+    uint32_t codec_packed = now->codec_packed_bytes - prev->codec_packed_bytes;
+    uint32_t codec_us = now->codec_encode_us - prev->codec_encode_us;
+    uint32_t codec_ratio = codec_packed ? (uint32_t)((uint64_t)codec_raw * 100 / codec_packed) : 0;
+    uint32_t codec_ns = codec_encoded ? (uint32_t)((uint64_t)codec_us * 1000 / codec_encoded) : 0;
+    ESP_LOGI(TAG, "Codec: %" PRIu32 "/%" PRIu32 " frames packed, ratio %" PRIu32 ".%02" PRIu32 " (%" PRIu32 " -> %" PRIu32 " bytes), "
+             "encode %" PRIu32 " ns/frame, %" PRIu32 " us/s",
+             now->codec_frames - prev->codec_frames, codec_encoded, codec_ratio / 100, codec_ratio % 100,
+             codec_raw, codec_packed, codec_ns, (uint32_t)((uint64_t)codec_us * 1000 / ms));
+    if (codec_ns > CONFIG_AIRPROBE_CSI_CODEC_BUDGET_US * 1000)
+    {
+        ESP_LOGW(TAG, "Codec: encode %" PRIu32 " ns/frame exceeds the %d us budget", codec_ns, CONFIG_AIRPROBE_CSI_CODEC_BUDGET_US);
+    }
+#endif
+}
+
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+/**
+ * @brief 指标查询：CSI 回调数、发送和未发送的帧数、编码耗时和环形缓冲区占用，在 csi_metrics 任务中调用
+ *
+ * 计数器各自只由一个任务写入，32 位读取是原子的；环形缓冲区的统计本身是原子变量。
+ */
+static void wifi_csi_put_metrics(csi_metrics_writer_t *writer)
+{
+    csi_ring_stats_t stats;
+
+    csi_ring_get_stats(s_csi_ring, &stats);
+    csi_metrics_put_counter(writer, CSI_CTRL_METRIC_CSI_CALLBACKS, s_csi_seq);
+    csi_metrics_put_hist(writer, CSI_CTRL_METRIC_CSI_ENCODE_US, &s_encode_us);
+    csi_metrics_put_gauge(writer, CSI_CTRL_METRIC_RING_USED, stats.count);
+    csi_metrics_put_gauge(writer, CSI_CTRL_METRIC_RING_HIGH_WATER, stats.high_water);
+    csi_metrics_put_counter(writer, CSI_CTRL_METRIC_RING_OVERFLOW, stats.overflow);
+#if !CONFIG_AIRPROBE_FEATURES_ENABLE || CONFIG_AIRPROBE_FEATURES_SEND_RAW
+    csi_metrics_put_counter(writer, CSI_CTRL_METRIC_CSI_SENT, s_send_seq);
+#endif
+#if CONFIG_AIRPROBE_TRIGGER_ENABLE
+    csi_metrics_put_counter(writer, CSI_CTRL_METRIC_TRIGGER_SUPPRESSED, s_trigger_suppressed);
+#endif
+}
+#endif
+
+/**
+ * @brief CSI 发送任务：取出环形缓冲区中的记录，编码后发送
+ */
+static void csi_sender_task(void *pvParameters)
+{
+    csi_ring_stats_t stats;
+    csi_counters_t now, last_log;
+#if CONFIG_AIRPROBE_RATE_CONTROL_ENABLE
+    csi_counters_t last_rate;
+#endif
+
+    csi_counters_get(&last_log, &stats);
+#if CONFIG_AIRPROBE_RATE_CONTROL_ENABLE
+    last_rate = last_log;
+#endif
+#if CONFIG_AIRPROBE_CPU_TRACE_ENABLE
+    // 快照约 1 KB，放在静态区而不是任务栈上
+    static csi_cpu_snapshot_t cpu_prev, cpu_now;
+    if (!csi_cpu_snapshot(&cpu_prev))
+    {
+        ESP_LOGW(TAG, "CPU trace: more than %d tasks", CSI_CPU_MAX_TASKS);
+    }
+#endif
+
+    while (1)
+    {
+        // 回调每提交一条记录就通知一次，超时用于聚合发送的截止时间和定期打印统计
+        TickType_t wait = pdMS_TO_TICKS(1000);
+#if CONFIG_AIRPROBE_BATCH_ENABLE
+        wait = csi_batch_wait_ticks(wait);
+#endif
+#if CONFIG_AIRPROBE_FEC_ENABLE
+        wait = csi_fec_wait_ticks(wait);
+#endif
+        ulTaskNotifyTake(pdTRUE, wait);
+#if CONFIG_AIRPROBE_CLOCK_SYNC_ENABLE
+        csi_clock_sync_get(&s_clock_model);
+#endif
+
+        const csi_record_t *record;
+        while ((record = csi_ring_peek(s_csi_ring, NULL)) != NULL)
+        {
+#if CONFIG_AIRPROBE_FEATURES_ENABLE
+            wifi_csi_send_features(record);
+#endif
+#if !CONFIG_AIRPROBE_FEATURES_ENABLE || CONFIG_AIRPROBE_FEATURES_SEND_RAW
+#if CONFIG_AIRPROBE_TRIGGER_ENABLE
+            wifi_csi_send_triggered(record);
+#else
+            wifi_csi_send_raw(record);
+#endif
+#endif
+            csi_ring_release(s_csi_ring);
+        }
+
+#if CONFIG_AIRPROBE_BATCH_ENABLE
+        if (csi_batch_wait_ticks(portMAX_DELAY) == 0)
+        {
+            csi_batch_flush();
+        }
+#endif
+#if CONFIG_AIRPROBE_FEC_ENABLE
+        if (csi_fec_wait_ticks(portMAX_DELAY) == 0)
+        {
+            csi_fec_flush();
+        }
+#endif
+
+        TickType_t tick = xTaskGetTickCount();
+#if CONFIG_AIRPROBE_RATE_CONTROL_ENABLE
+        if (tick - last_rate.time >= pdMS_TO_TICKS(CONFIG_AIRPROBE_RATE_PERIOD_MS))
+        {
+            csi_counters_get(&now, &stats);
+            wifi_rate_control(&last_rate, &now, &stats);
+            last_rate = now;
+        }
+#endif
+        if (tick - last_log.time >= pdMS_TO_TICKS(10000))
+        {
+            csi_counters_get(&now, &stats);
+            csi_log_stats(&last_log, &now, &stats);
+            last_log = now;
+#if CONFIG_AIRPROBE_CPU_TRACE_ENABLE
+            if (csi_cpu_snapshot(&cpu_now))
+            {
+                csi_cpu_log(TAG, &cpu_prev, &cpu_now);
+                cpu_prev = cpu_now;
+            }
+#endif
+        }
+    }
+}
+
+/**
+ * @brief CSI 回调函数，当接收到 CSI 数据时被调用
+ *
+ * 运行在 Wi-Fi 驱动任务中，只把数据拷贝到环形缓冲区的槽位并通知发送任务。
+ * 激励源过滤是对一个最多 CSI_SOURCE_MAX 项的有序表的二分查找。
+ *
+ * @param ctx 用户上下文，这里是激励源白名单（s_sources）
+ * @param info CSI 信息结构体指针
+ */
+static void wifi_csi_rx_cb(void *ctx, wifi_csi_info_t *info)
+{
+#if CONFIG_AIRPROBE_CLOCK_SYNC_ENABLE
+    int64_t now_us = esp_timer_get_time(); // 尽早读取，减小回调延迟
+#endif
+
+    // 检查 info 和 info->buf 是否为空
+    if (!info || !info->buf)
+    {
+        ESP_LOGW(TAG, "<%s> wifi_csi_cb", esp_err_to_name(ESP_ERR_INVALID_ARG));
+        return;
+    }
+
+    // 只接收白名单中的激励源
+    csi_source_table_t *sources = ctx;
+    int tx = csi_source_find(sources, info->mac);
+    if (tx < 0)
+    {
+#if CONFIG_AIRPROBE_STIMULUS_ESPNOW
+        if (sources->count > 0 || memcmp(info->mac, s_learned_mac, 6))
+        {
+            return;
+        }
+        tx = csi_source_add(sources, info->mac);
+#else
+        return;
+#endif
+    }
+
+    uint32_t seq = s_csi_seq++;
+    sources->seq[tx]++;
+    csi_record_t *record = csi_ring_acquire(s_csi_ring);
+    if (!record)
+    {
+        return; // 环形缓冲区已满，丢弃计数由 csi_ring 维护
+    }
+
+    record->seq = seq;
+    record->tx = tx;
+#if CONFIG_AIRPROBE_CLOCK_SYNC_ENABLE
+    record->rx_us = csi_rx_clock_local(&s_rx_clock, info->rx_ctrl.timestamp, now_us);
+#endif
+    record->rx_ctrl = info->rx_ctrl;
+    memcpy(record->mac, info->mac, sizeof(record->mac));
+    record->first_word_invalid = info->first_word_invalid;
+    record->len = info->len < AIRPROBE_CSI_MAX_LEN ? info->len : AIRPROBE_CSI_MAX_LEN;
+    memcpy(record->buf, info->buf, record->len);
+    csi_ring_commit(s_csi_ring, offsetof(csi_record_t, buf) + record->len);
+
+    xTaskNotifyGive(s_sender_task);
+}
 
 static void wifi_csi_init()
 {
     /**
-     * @brief In order to ensure the compatibility of routers, only LLTF sub-carriers are selected.
+     * @brief LLTF is always enabled for the compatibility of routers (non-HT frames only carry LLTF);
+     *        HT-LTF and STBC-HT-LTF are added by AIRPROBE_CSI_PROFILE.
      */
     wifi_csi_config_t csi_config = {
         .lltf_en = true,
-        .htltf_en = false,
-        .stbc_htltf2_en = false,
+        .htltf_en = AIRPROBE_CSI_HTLTF_EN,
+        .stbc_htltf2_en = AIRPROBE_CSI_STBC_EN,
         .ltf_merge_en = true,
         .channel_filter_en = true,
         .manu_scale = true,
         .shift = true,
     };
 
-    static wifi_ap_record_t s_ap_info = {0};
-    ESP_ERROR_CHECK(esp_wifi_sta_get_ap_info(&s_ap_info));
+    _Static_assert((CONFIG_AIRPROBE_CSI_RING_SLOTS & (CONFIG_AIRPROBE_CSI_RING_SLOTS - 1)) == 0,
+                   "AIRPROBE_CSI_RING_SLOTS must be a power of two");
+    s_csi_ring = csi_ring_create(CONFIG_AIRPROBE_CSI_RING_SLOTS, sizeof(csi_record_t));
+    if (!s_csi_ring)
+    {
+        ESP_LOGE(TAG, "Failed to create CSI ring (%d slots)", CONFIG_AIRPROBE_CSI_RING_SLOTS);
+        abort();
+    }
+
+#if CONFIG_AIRPROBE_FEATURES_ENABLE
+    csi_features_config_t features_config = {
+        .interval_ms = CONFIG_AIRPROBE_FEATURES_INTERVAL_MS,
+    };
+    for (int tx = 0; tx < CSI_SOURCE_MAX; tx++)
+    {
+        ESP_ERROR_CHECK(csi_features_init(&s_features[tx], &features_config) ? ESP_OK : ESP_ERR_INVALID_ARG);
+    }
+#endif
+
+#if CONFIG_AIRPROBE_RATE_CONTROL_ENABLE
+    csi_rate_config_t rate_config = {
+        .min_hz = CONFIG_AIRPROBE_RATE_MIN_HZ,
+        .max_hz = CONFIG_SEND_FREQUENCY,
+        .step_hz = CONFIG_AIRPROBE_RATE_STEP_HZ,
+        .max_loss_pct = CONFIG_AIRPROBE_RATE_MAX_LOSS_PCT,
+        .min_yield_pct = 80,    // 应答帧大多产生 CSI，明显少于 ping 数说明空口已经拥挤
+        .hold_periods = 3,
+    };
+    ESP_ERROR_CHECK(csi_rate_init(&s_rate, &rate_config) ? ESP_OK : ESP_ERR_INVALID_ARG);
+#endif
+
+#if CONFIG_AIRPROBE_TRIGGER_ENABLE
+    csi_trigger_config_t trigger_config = {
+        .hold_ms = CONFIG_AIRPROBE_TRIGGER_HOLD_MS,
+        .heartbeat_ms = CONFIG_AIRPROBE_TRIGGER_HEARTBEAT_MS,
+        .threshold_pct = CONFIG_AIRPROBE_TRIGGER_THRESHOLD_PCT,
+        .min_level_q4 = CONFIG_AIRPROBE_TRIGGER_MIN_LEVEL,
+        .warmup_frames = 2 * CONFIG_SEND_FREQUENCY, // 启动后 2 s 只学习基线
+    };
+    ESP_ERROR_CHECK(csi_trigger_init(&s_trigger, &trigger_config) ? ESP_OK : ESP_ERR_INVALID_ARG);
+#endif
+
+#if CONFIG_FREERTOS_UNICORE
+    xTaskCreate(csi_sender_task, "csi_sender", 4096, NULL, CONFIG_AIRPROBE_SENDER_TASK_PRIORITY, &s_sender_task);
+#else
+    xTaskCreatePinnedToCore(csi_sender_task, "csi_sender", 4096, NULL, CONFIG_AIRPROBE_SENDER_TASK_PRIORITY,
+                            &s_sender_task, CONFIG_AIRPROBE_SENDER_TASK_CORE);
+    // CSI 回调在 Wi-Fi 驱动任务中运行，编码和发送应在另一个核心上
+    if (CONFIG_AIRPROBE_SENDER_TASK_CORE == AIRPROBE_WIFI_CORE)
+    {
+        ESP_LOGW(TAG, "csi_sender shares core %d with the Wi-Fi task", AIRPROBE_WIFI_CORE);
+    }
+    ESP_LOGI(TAG, "Tasks: Wi-Fi and CSI callback on core %d, lwIP affinity 0x%x, csi_sender on core %d (priority %d)",
+             AIRPROBE_WIFI_CORE, CONFIG_LWIP_TCPIP_TASK_AFFINITY, CONFIG_AIRPROBE_SENDER_TASK_CORE,
+             CONFIG_AIRPROBE_SENDER_TASK_PRIORITY);
+#endif
+
+    csi_source_init(&s_sources);
+#if CONFIG_AIRPROBE_STIMULUS_PING
+    wifi_ap_record_t ap_info = {0};
+    ESP_ERROR_CHECK(esp_wifi_sta_get_ap_info(&ap_info));
+    csi_source_add(&s_sources, ap_info.bssid);
+#elif CONFIG_AIRPROBE_ROLE_PROBE
+    uint8_t macs[CSI_SOURCE_MAX][6];
+    int count = csi_source_parse_list(CONFIG_AIRPROBE_STIMULUS_SOURCE_MACS, macs, CSI_SOURCE_MAX);
+    if (count < 0)
+    {
+        ESP_LOGE(TAG, "Invalid AIRPROBE_STIMULUS_SOURCE_MACS \"%s\" (at most %d MACs)",
+                 CONFIG_AIRPROBE_STIMULUS_SOURCE_MACS, CSI_SOURCE_MAX);
+        abort();
+    }
+    for (int i = 0; i < count; i++)
+    {
+        csi_source_add(&s_sources, macs[i]);
+    }
+#if CONFIG_AIRPROBE_STIMULUS_ESPNOW
+    ESP_ERROR_CHECK(csi_stimulus_espnow_listen(count > 0 ? NULL : s_learned_mac));
+#else
+    // 注入的帧无法识别发送端，必须配置发射节点的 MAC
+    if (count == 0)
+    {
+        ESP_LOGE(TAG, "AIRPROBE_STIMULUS_SOURCE_MACS is required for injected stimulus");
+        abort();
+    }
+#endif
+#endif
+    for (int tx = 0; tx < s_sources.count; tx++)
+    {
+        ESP_LOGI(TAG, "CSI source %d " MACSTR, tx, MAC2STR(s_sources.mac[tx]));
+    }
+
+#if CONFIG_AIRPROBE_CSI_PROFILE_HT40
+    // HT40 CSI 只在 AP 工作于 40 MHz 信道时出现
+    uint8_t primary;
+    wifi_second_chan_t second;
+    ESP_ERROR_CHECK(esp_wifi_set_bandwidth(WIFI_IF_STA, WIFI_BW_HT40));
+    ESP_ERROR_CHECK(esp_wifi_get_channel(&primary, &second));
+    if (second == WIFI_SECOND_CHAN_NONE)
+    {
+        ESP_LOGW(TAG, "Channel %u is 20 MHz, no HT40 CSI will be captured", primary);
+    }
+#endif
+    ESP_LOGI(TAG, "CSI profile: up to %d bytes per frame", AIRPROBE_CSI_MAX_LEN);
+
+    ESP_ERROR_CHECK(esp_wifi_get_mac(WIFI_IF_STA, s_probe_mac));
+#if CONFIG_AIRPROBE_FEC_ENABLE
+    csi_fec_enc_init(&s_fec, CONFIG_AIRPROBE_FEC_GROUP, s_probe_mac);
+    ESP_LOGI(TAG, "FEC: one parity datagram per %d batches", CONFIG_AIRPROBE_FEC_GROUP);
+#endif
     ESP_ERROR_CHECK(esp_wifi_set_csi_config(&csi_config));
-    ESP_ERROR_CHECK(esp_wifi_set_csi_rx_cb(wifi_csi_rx_cb, s_ap_info.bssid));
+    ESP_ERROR_CHECK(esp_wifi_set_csi_rx_cb(wifi_csi_rx_cb, &s_sources));
     ESP_ERROR_CHECK(esp_wifi_set_csi(true));
 }
 
+#if CONFIG_AIRPROBE_STIMULUS_PING
 static esp_err_t wifi_ping_router_start()
 {
-    static esp_ping_handle_t ping_handle = NULL;
-
     esp_ping_config_t ping_config = ESP_PING_DEFAULT_CONFIG();
     ping_config.count = 0;
-    ping_config.interval_ms = 1000 / CONFIG_SEND_FREQUENCY;
-    ping_config.task_stack_size = 3072;
+    ping_config.task_stack_size = CONFIG_AIRPROBE_PING_TASK_STACK;
+    ping_config.task_prio = CONFIG_AIRPROBE_PING_TASK_PRIORITY;
     ping_config.data_size = 1;
 
     esp_netif_ip_info_t local_ip;
@@ -174,10 +1163,14 @@ static esp_err_t wifi_ping_router_start()
     ESP_LOGI(TAG, "got ip:" IPSTR ", gw: " IPSTR, IP2STR(&local_ip.ip), IP2STR(&local_ip.gw));
     ping_config.target_addr.u_addr.ip4.addr = ip4_addr_get_u32(&local_ip.gw);
     ping_config.target_addr.type = ESP_IPADDR_TYPE_V4;
+    s_ping_config = ping_config;
 
-    esp_ping_callbacks_t cbs = {0};
-    esp_ping_new_session(&ping_config, &cbs, &ping_handle);
-    esp_err_t ping_start_result = esp_ping_start(ping_handle);
+#if CONFIG_AIRPROBE_RATE_CONTROL_ENABLE
+    // 从最高速率开始，拥塞时由 csi_sender 任务降速
+    esp_err_t ping_start_result = wifi_ping_session_start(s_rate.interval_ms);
+#else
+    esp_err_t ping_start_result = wifi_ping_session_start(1000 / CONFIG_SEND_FREQUENCY);
+#endif
 
     if (ping_start_result != ESP_OK)
     {
@@ -191,6 +1184,7 @@ static esp_err_t wifi_ping_router_start()
 
     return ESP_OK;
 }
+#endif /* CONFIG_AIRPROBE_STIMULUS_PING */
 
 void app_main()
 {
@@ -205,6 +1199,20 @@ void app_main()
      */
     ESP_ERROR_CHECK(example_connect());
 
+#if CONFIG_AIRPROBE_ROLE_TRANSMITTER
+    // 发射节点只发送激励帧，不采集 CSI
+    ESP_ERROR_CHECK(csi_stimulus_tx_start(CONFIG_AIRPROBE_STIMULUS_TX_HZ));
+#else
+    ESP_ERROR_CHECK(csi_sender_init());
+#if CONFIG_AIRPROBE_CLOCK_SYNC_ENABLE
+    ESP_ERROR_CHECK(csi_clock_sync_start());
+#endif
     wifi_csi_init();
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+    ESP_ERROR_CHECK(csi_metrics_server_start(wifi_csi_put_metrics));
+#endif
+#if CONFIG_AIRPROBE_STIMULUS_PING
     wifi_ping_router_start();
+#endif
+#endif
 }
\ No newline at end of file
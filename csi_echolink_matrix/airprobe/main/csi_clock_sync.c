@@ -0,0 +1,158 @@
+#include "csi_clock_sync.h"
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "csi_ctrl.h"
+
+#if CONFIG_AIRPROBE_CLOCK_SYNC_ENABLE
+
+#define CLOCK_SYNC_FAST_EXCHANGES 8     // 启动后先以 CLOCK_SYNC_FAST_INTERVAL_MS 对时的次数
+#define CLOCK_SYNC_FAST_INTERVAL_MS 200
+
+static const char *TAG = "AirProbe_clock";
+
+static csi_clock_t s_clock;             // 只由对时任务访问
+static csi_clock_model_t s_model;       // 发布给其它任务的模型，由 s_model_lock 保护
+static portMUX_TYPE s_model_lock = portMUX_INITIALIZER_UNLOCKED;
+
+typedef struct __attribute__((packed)) {
+   csi_ctrl_hdr_t hdr;
+   csi_ctrl_time_t time;
+} csi_clock_sync_msg_t;
+
+void csi_clock_sync_get(csi_clock_model_t *model)
+{
+   portENTER_CRITICAL(&s_model_lock);
+   *model = s_model;
+   portEXIT_CRITICAL(&s_model_lock);
+}
+
+// 参考端地址：配置了 AIRPROBE_CLOCK_SYNC_SERVER 时使用该地址，否则为当前的 STA 网关
+static bool csi_clock_sync_dest(struct sockaddr_in *dest)
+{
+   memset(dest, 0, sizeof(*dest));
+   dest->sin_family = AF_INET;
+   dest->sin_port = htons(CONFIG_AIRPROBE_CLOCK_SYNC_PORT);
+
+   if (strlen(CONFIG_AIRPROBE_CLOCK_SYNC_SERVER) > 0) {
+      return inet_aton(CONFIG_AIRPROBE_CLOCK_SYNC_SERVER, &dest->sin_addr) == 1;
+   }
+
+   esp_netif_ip_info_t ip_info = { 0 };
+   esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+   if (!netif || esp_netif_get_ip_info(netif, &ip_info) != ESP_OK || ip_info.gw.addr == 0) {
+      return false;
+   }
+   dest->sin_addr.s_addr = ip_info.gw.addr;
+   return true;
+}
+
+/**
+ * @brief 一次对时：发出 TIME_REQ，等待带回同一个 t1 的 TIME_RESP
+ *
+ * 超时的应答可能在下一次对时中才到达，按 t1 识别后丢弃。
+ */
+static bool csi_clock_sync_exchange(int sock, const struct sockaddr_in *dest)
+{
+   csi_clock_sync_msg_t req;
+   uint8_t buf[64];
+
+   csi_ctrl_hdr_init(&req.hdr, CSI_CTRL_TYPE_TIME_REQ);
+   req.hdr.len = sizeof(req.time);
+   memset(&req.time, 0, sizeof(req.time));
+   req.time.t1 = esp_timer_get_time();
+   if (sendto(sock, &req, sizeof(req), 0, (const struct sockaddr *)dest, sizeof(*dest)) < 0) {
+      return false;
+   }
+
+   int64_t deadline = req.time.t1 + CONFIG_AIRPROBE_CLOCK_SYNC_MAX_DELAY_MS * 1000;
+   while (1) {
+      int len = recv(sock, buf, sizeof(buf), 0);
+      int64_t t4 = esp_timer_get_time();
+      if (len < 0) {
+         return false; // SO_RCVTIMEO 超时
+      }
+
+      const csi_ctrl_hdr_t *hdr = csi_ctrl_check(buf, len);
+      if (hdr && hdr->type == CSI_CTRL_TYPE_TIME_RESP && hdr->len >= sizeof(csi_ctrl_time_t)) {
+         csi_ctrl_time_t time;
+         memcpy(&time, buf + hdr->hdr_len, sizeof(time));
+         if (time.t1 == req.time.t1) {
+            return csi_clock_update(&s_clock, time.t1, time.t2, time.t3, t4);
+         }
+      }
+      if (t4 >= deadline) {
+         return false;
+      }
+   }
+}
+
+static void csi_clock_sync_task(void *pvParameters)
+{
+   int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+   if (sock < 0) {
+      ESP_LOGE(TAG, "Failed to create socket: %d", errno);
+      vTaskDelete(NULL);
+      return;
+   }
+
+   struct timeval timeout = {
+      .tv_sec = CONFIG_AIRPROBE_CLOCK_SYNC_MAX_DELAY_MS / 1000,
+      .tv_usec = (CONFIG_AIRPROBE_CLOCK_SYNC_MAX_DELAY_MS % 1000) * 1000,
+   };
+   setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+   uint32_t exchanges = 0;
+   uint32_t failures = 0;   // 连续失败次数，只在第一次失败时打印
+   uint32_t steps = 0;
+
+   while (1) {
+      struct sockaddr_in dest;
+      bool ok = csi_clock_sync_dest(&dest) && csi_clock_sync_exchange(sock, &dest);
+
+      if (ok) {
+         portENTER_CRITICAL(&s_model_lock);
+         s_model = s_clock.model;
+         portEXIT_CRITICAL(&s_model_lock);
+
+         if (exchanges++ == 0 || failures > 0 || s_clock.steps != steps) {
+            ESP_LOGI(TAG, "Clock synced to %s:%d, offset %" PRId64 " us, error %" PRIu32 " us%s",
+                     inet_ntoa(dest.sin_addr), CONFIG_AIRPROBE_CLOCK_SYNC_PORT, s_clock.model.offset_us,
+                     s_clock.model.err_us, s_clock.steps != steps ? " (reference clock stepped)" : "");
+         }
+         failures = 0;
+         steps = s_clock.steps;
+      } else if (failures++ == 0) {
+         ESP_LOGW(TAG, "No clock sync reply from port %d", CONFIG_AIRPROBE_CLOCK_SYNC_PORT);
+      }
+
+      vTaskDelay(pdMS_TO_TICKS(exchanges < CLOCK_SYNC_FAST_EXCHANGES
+                               ? CLOCK_SYNC_FAST_INTERVAL_MS : CONFIG_AIRPROBE_CLOCK_SYNC_INTERVAL_MS));
+   }
+}
+
+esp_err_t csi_clock_sync_start(void)
+{
+   csi_clock_init(&s_clock, CONFIG_AIRPROBE_CLOCK_SYNC_MAX_DELAY_MS * 1000);
+
+   // 与 csi_sender 在同一核心、优先级高一级，收到应答后尽快读取 t4；任务大部分时间阻塞在 recv/vTaskDelay 中
+#if CONFIG_FREERTOS_UNICORE
+   BaseType_t created = xTaskCreate(csi_clock_sync_task, "csi_clock_sync", 3072, NULL,
+                                    CONFIG_AIRPROBE_SENDER_TASK_PRIORITY + 1, NULL);
+#else
+   BaseType_t created = xTaskCreatePinnedToCore(csi_clock_sync_task, "csi_clock_sync", 3072, NULL,
+                                                CONFIG_AIRPROBE_SENDER_TASK_PRIORITY + 1, NULL,
+                                                CONFIG_AIRPROBE_SENDER_TASK_CORE);
+#endif
+   if (created != pdPASS) {
+      return ESP_ERR_NO_MEM;
+   }
+   return ESP_OK;
+}
+
+#endif /* CONFIG_AIRPROBE_CLOCK_SYNC_ENABLE */
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "esp_err.h"
+#include "csi_clock.h"
+
+/**
+ * @brief 启动对时任务
+ *
+ * 每 AIRPROBE_CLOCK_SYNC_INTERVAL_MS 向参考端（AIRPROBE_CLOCK_SYNC_SERVER，为空时为 STA 网关即 AirSight）
+ * 的 AIRPROBE_CLOCK_SYNC_PORT 发送一次 TIME_REQ（见 csi_ctrl.h），用应答更新时钟模型（components/csi_clock）。
+ * 启动后的前几次对时间隔缩短，尽快得到第一个模型。
+ */
+esp_err_t csi_clock_sync_start(void);
+
+/**
+ * @brief 当前时钟模型的拷贝，可在任意任务中调用；尚未同步时 model->synced 为 false
+ */
+void csi_clock_sync_get(csi_clock_model_t *model);
@@ -11,218 +11,176 @@
 #include "esp_log.h"
 #include "esp_err.h"
 #include "esp_netif.h"
+#include "esp_timer.h"
 #include "lwip/err.h"
 #include "lwip/sockets.h"
 #include "lwip/sys.h"
 #include "lwip/netdb.h"
 
 
-#define MULTICAST_IPV4_ADDR "232.10.11.12"
 #define ECHO_SERVER_PORT 3333
-#define MULTICAST_TTL 1
-
-static const char *TAG = "AirProbe_echo";
 
+#if CONFIG_AIRPROBE_CSI_DEST_MULTICAST
+#define MULTICAST_IPV4_ADDR CONFIG_AIRPROBE_MCAST_GROUP
+#define MULTICAST_PORT CONFIG_AIRPROBE_MCAST_PORT
+#define MULTICAST_TTL CONFIG_AIRPROBE_MCAST_TTL
+#endif
 
+static const char *TAG = "AirProbe_echo";
 
-static int esp_join_multicast_group(int sockfd)
+/**
+ * @brief 常驻的 CSI 数据发送器
+ *
+ * socket 只创建一次，并 connect 到网关（AirSight）的 ECHO_SERVER_PORT，
+ * 组播模式下 connect 到组播组，之后每帧只调用一次 send()，不等待任何应答。
+ * 目的地址只在 IP_EVENT_STA_GOT_IP 时重新解析，
+ * STA 断开期间直接丢弃数据，不再逐帧查询 netif 和格式化 IP 字符串。
+ */
+typedef struct {
+   int sock;                  // 常驻 UDP socket
+   volatile bool connected;   // 目的地址是否有效
+   uint32_t send_failed;      // 连续发送失败次数
+   volatile uint32_t send_errors; // 累计发送失败次数（含未连接时丢弃的）
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+   csi_metric_counter_t sent;     // 发送成功的数据报数
+   csi_metric_hist_t send_us;     // 每次 send() 的耗时
+#endif
+} csi_sender_t;
+
+static csi_sender_t s_sender = { .sock = -1 };
+
+#if CONFIG_AIRPROBE_CSI_DEST_MULTICAST
+// 组播：每次拿到 IP 后重新指定组播出口接口，目的地址为组播组
+static esp_err_t csi_sender_connect(const esp_netif_ip_info_t *ip_info)
 {
-   struct ip_mreq imreq = { 0 };
    struct in_addr iaddr = { 0 };
-   int err = 0;
-   
-   // 配置组播报文发送的接口
-   esp_netif_ip_info_t ip_info = { 0 };
-   err = esp_netif_get_ip_info(esp_netif_get_handle_from_ifkey("WIFI_STA_DEF"), &ip_info);
-   if (err != ESP_OK) {
-      ESP_LOGE(TAG, "Failed to get IP address info. Error 0x%x", err);
-      goto err;
-   }
-   inet_addr_from_ip4addr(&iaddr, &ip_info.ip);
-   err = setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_IF, &iaddr,
-                     sizeof(struct in_addr));
-   if (err < 0) {
+   struct sockaddr_in dest_addr = {
+      .sin_family = AF_INET,
+      .sin_port = htons(MULTICAST_PORT),
+   };
+
+   inet_addr_from_ip4addr(&iaddr, &ip_info->ip);
+   if (setsockopt(s_sender.sock, IPPROTO_IP, IP_MULTICAST_IF, &iaddr, sizeof(iaddr)) < 0) {
       ESP_LOGE(TAG, "Failed to set IP_MULTICAST_IF. Error %d", errno);
-      goto err;
+      s_sender.connected = false;
+      return ESP_FAIL;
    }
 
-   // 配置监听的组播组地址
-   inet_aton(MULTICAST_IPV4_ADDR, &imreq.imr_multiaddr.s_addr);
-
-   // 配置套接字加入组播组
-   err = setsockopt(sockfd, IPPROTO_IP, IP_ADD_MEMBERSHIP,
-                        &imreq, sizeof(struct ip_mreq));
-   if (err < 0) {
-      ESP_LOGE(TAG, "Failed to set IP_ADD_MEMBERSHIP. Error %d", errno);
+   if (inet_aton(MULTICAST_IPV4_ADDR, &dest_addr.sin_addr.s_addr) != 1
+         || connect(s_sender.sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr)) < 0) {
+      ESP_LOGE(TAG, "Failed to connect socket to multicast group %s: errno %d", MULTICAST_IPV4_ADDR, errno);
+      s_sender.connected = false;
+      return ESP_FAIL;
    }
 
-err:
-   return err;
+   s_sender.connected = true;
+   ESP_LOGI(TAG, "CSI data destination multicast %s:%d, TTL %d", MULTICAST_IPV4_ADDR, MULTICAST_PORT, MULTICAST_TTL);
+   return ESP_OK;
 }
-
-// AirProbe模块调用
-int echo_csi_data_mcast(const char *data)
+#else
+static esp_err_t csi_sender_connect(const esp_netif_ip_info_t *ip_info)
 {
-   esp_err_t err = ESP_FAIL;
-   struct sockaddr_in saddr = {0};
-   struct sockaddr_in from_addr = {0};
-   socklen_t from_addr_len      = sizeof(struct sockaddr_in);
-   char udp_recv_buf[64 + 1] = {0};
-
-   // 创建 IPv4 UDP 套接字
-   int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-   if (sockfd == -1) {
-      ESP_LOGE(TAG, "Create UDP socket fail");
-      return err;
-   }
-
-   // 绑定套接字
-   saddr.sin_family = PF_INET;
-   saddr.sin_port = htons(ECHO_SERVER_PORT);
-   saddr.sin_addr.s_addr = htonl(INADDR_ANY);
-   int ret = bind(sockfd, (struct sockaddr *)&saddr, sizeof(struct sockaddr_in));
-   if (ret < 0) {
-      ESP_LOGE(TAG, "Failed to bind socket. Error %d", errno);
-      goto exit;
-   }
-
-   // 设置组播 TTL 为 1，表示该组播包只能经由一个路由
-   uint8_t ttl = 1;
-   ret = setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(uint8_t));
-   if (ret < 0) {
-      ESP_LOGE(TAG, "Failed to set IP_MULTICAST_TTL. Error %d", errno);
-      goto exit;
-   }
-
-   // 加入组播组
-   ret = esp_join_multicast_group(sockfd);
-   if (ret < 0) {
-      ESP_LOGE(TAG, "Failed to join multicast group");
-      goto exit;
-   }
-
-   // 设置组播目的地址和端口
+   const esp_ip4_addr_t *gw = &ip_info->gw;
    struct sockaddr_in dest_addr = {
       .sin_family = AF_INET,
       .sin_port = htons(ECHO_SERVER_PORT),
+      .sin_addr.s_addr = gw->addr,
    };
-   inet_aton(MULTICAST_IPV4_ADDR, &dest_addr.sin_addr.s_addr);
-
-//    char *multicast_msg_buf = "Are you Espressif IOT Smart Light";
-
-   // 调用 sendto 接口发送组播数据
-//    ret = sendto(sockfd, multicast_msg_buf, strlen(multicast_msg_buf), 0, (struct sockaddr *)&dest_addr, sizeof(struct sockaddr));
-   ret = sendto(sockfd, data, strlen(data), 0, (struct sockaddr *)&dest_addr, sizeof(struct sockaddr));
-   if (ret < 0) {
-      ESP_LOGE(TAG, "Error occurred during sending: errno %d", errno);
-   } else {
-      ESP_LOGI(TAG, "Message sent #%d successfully!", strlen(data));
-      ret = recvfrom(sockfd, udp_recv_buf, sizeof(udp_recv_buf) - 1, 0, (struct sockaddr *)&from_addr, (socklen_t *)&from_addr_len);
-      if (ret > 0) {
-         ESP_LOGI(TAG, "Receive udp unicast from %s:%d, data is %s", inet_ntoa(((struct sockaddr_in *)&from_addr)->sin_addr), ntohs(((struct sockaddr_in *)&from_addr)->sin_port), udp_recv_buf);
-         err = ESP_OK;
-      }
+
+   if (connect(s_sender.sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr)) < 0) {
+      ESP_LOGE(TAG, "Failed to connect socket to " IPSTR ": errno %d", IP2STR(gw), errno);
+      s_sender.connected = false;
+      return ESP_FAIL;
    }
 
-exit:
-   close(sockfd);
-   return err;
+   s_sender.connected = true;
+   ESP_LOGI(TAG, "CSI data destination " IPSTR ":%d", IP2STR(gw), ECHO_SERVER_PORT);
+   return ESP_OK;
 }
+#endif /* CONFIG_AIRPROBE_CSI_DEST_MULTICAST */
 
-// AirSight模块调用
-int recv_csi_data_multicast(void)
+static void csi_sender_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
 {
-   esp_err_t err = ESP_FAIL;
-   struct sockaddr_in saddr = {0};
-   struct sockaddr_in from_addr = {0};
-   socklen_t from_addr_len      = sizeof(struct sockaddr_in);
-   char udp_server_buf[64 + 1] = {0};
-   char *udp_server_send_buf = "ESP32-C3 Smart Light https 443";
-
-   // 创建 IPv4 UDP 套接字
-   int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-   if (sockfd == -1) {
-      ESP_LOGE(TAG, "Create UDP socket fail");
-      return err;
+   if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+      ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
+      csi_sender_connect(&event->ip_info);
+   } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+      s_sender.connected = false;
    }
+}
 
-   // 绑定套接字
-   saddr.sin_family = PF_INET;
-   saddr.sin_port = htons(ECHO_SERVER_PORT);
-   saddr.sin_addr.s_addr = htonl(INADDR_ANY);
-   int ret = bind(sockfd, (struct sockaddr *)&saddr, sizeof(struct sockaddr_in));
-   if (ret < 0) {
-      ESP_LOGE(TAG, "Failed to bind socket. Error %d", errno);
-      goto exit;
+esp_err_t csi_sender_init(void)
+{
+   if (s_sender.sock >= 0) {
+      return ESP_OK;
    }
 
-   // 设置组播 TTL 为 1，表示该组播包只能经由一个路由
-   uint8_t ttl = 1;
-   ret = setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(uint8_t));
-   if (ret < 0) {
-      ESP_LOGE(TAG, "Failed to set IP_MULTICAST_TTL. Error %d", errno);
-      goto exit;
+   s_sender.sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+   if (s_sender.sock < 0) {
+      ESP_LOGE(TAG, "Failed to create socket: %d", errno);
+      return ESP_FAIL;
    }
 
-   // 加入组播组
-   ret = esp_join_multicast_group(sockfd);
-   if (ret < 0) {
-      ESP_LOGE(TAG, "Failed to join multicast group");
-      goto exit;
+#if CONFIG_AIRPROBE_CSI_DEST_MULTICAST
+   uint8_t ttl = MULTICAST_TTL;
+   if (setsockopt(s_sender.sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0) {
+      ESP_LOGE(TAG, "Failed to set IP_MULTICAST_TTL. Error %d", errno);
    }
+#endif
 
-   // 调用 recvfrom 接口接收组播数据
-   while (1) {
-      ret = recvfrom(sockfd, udp_server_buf, sizeof(udp_server_buf) - 1, 0, (struct sockaddr *)&from_addr, (socklen_t *)&from_addr_len);
-      if (ret > 0) {
-         ESP_LOGI(TAG, "Receive udp multicast from %s:%d, data is %s", inet_ntoa(((struct sockaddr_in *)&from_addr)->sin_addr), ntohs(((struct sockaddr_in *)&from_addr)->sin_port), udp_server_buf);
-         // 如果收到组播请求数据，单播发送对端数据通信应用端口
-         if (!strcmp(udp_server_buf, "Are you Espressif IOT Smart Light")) {
-            ret = sendto(sockfd, udp_server_send_buf, strlen(udp_server_send_buf), 0, (struct sockaddr *)&from_addr, from_addr_len);
-            if (ret < 0) {
-               ESP_LOGE(TAG, "Error occurred during sending: errno %d", errno);
-            } else {
-               ESP_LOGI(TAG, "Message sent successfully");
-            }
-         }
-      }
+   ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &csi_sender_event_handler, NULL, NULL));
+   ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &csi_sender_event_handler, NULL, NULL));
+
+   // example_connect() 返回时已经拿到 IP，这里先解析一次当前网关
+   esp_netif_ip_info_t local_ip = { 0 };
+   esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+   if (netif && esp_netif_get_ip_info(netif, &local_ip) == ESP_OK && local_ip.gw.addr != 0) {
+      csi_sender_connect(&local_ip);
    }
 
-exit:
-   close(sockfd);
-   return err;
+   return ESP_OK;
 }
 
-esp_err_t echo_csi_data(const char *data)
+esp_err_t echo_csi_data(const void *data, size_t len)
 {
+   if (!s_sender.connected) {
+      s_sender.send_errors++;
+      return ESP_ERR_INVALID_STATE;
+   }
 
-    esp_netif_ip_info_t local_ip;
-    esp_netif_get_ip_info(esp_netif_get_handle_from_ifkey("WIFI_STA_DEF"), &local_ip);
-   //  ESP_LOGI(TAG, "got ip:" IPSTR ", gw: " IPSTR, IP2STR(&local_ip.ip), IP2STR(&local_ip.gw));
-    char ip_str[16];
-    esp_ip4addr_ntoa((const esp_ip4_addr_t*)&local_ip.gw.addr, ip_str, sizeof(ip_str));
-
-    ESP_LOGI(TAG, "%s Echo CSI data: %s", ip_str, data);
-
-    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    if (sock < 0) {
-        ESP_LOGE(TAG, "Failed to create socket: %d", errno);
-        return -1;
-    }
-
-    // strcpy(ip_str, "192.168.3.173");
-
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+   int64_t start = esp_timer_get_time();
+   int sent = send(s_sender.sock, data, len, 0);
+   csi_metric_observe(&s_sender.send_us, (uint32_t)(esp_timer_get_time() - start));
+#else
+   int sent = send(s_sender.sock, data, len, 0);
+#endif
+   if (sent < 0) {
+      s_sender.send_errors++;
+      // 只在连续失败的第一次打印，避免 100Hz 刷屏
+      if (s_sender.send_failed++ == 0) {
+         ESP_LOGE(TAG, "Error occurred during sending: errno %d", errno);
+      }
+      return ESP_FAIL;
+   }
 
-    struct sockaddr_in dest_addr;
-    dest_addr.sin_addr.s_addr = inet_addr(ip_str);
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_port = htons(ECHO_SERVER_PORT);
+   s_sender.send_failed = 0;
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+   csi_metric_add(&s_sender.sent, 1);
+#endif
+   return ESP_OK;
+}
 
-    int err = sendto(sock, data, strlen(data), 0, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-    if (err < 0) {
-        ESP_LOGE(TAG, "Error occurred during sending: errno %d", errno);
-    }
-    close(sock);
+uint32_t csi_sender_get_send_errors(void)
+{
+   return s_sender.send_errors;
+}
 
-    return 0;
-}
\ No newline at end of file
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+void csi_sender_put_metrics(csi_metrics_writer_t *writer)
+{
+   csi_metrics_put_counter(writer, CSI_CTRL_METRIC_TX_DATAGRAMS, csi_metric_read(&s_sender.sent));
+   csi_metrics_put_counter(writer, CSI_CTRL_METRIC_TX_FAILED, s_sender.send_errors);
+   csi_metrics_put_hist(writer, CSI_CTRL_METRIC_SENDTO_US, &s_sender.send_us);
+}
+#endif
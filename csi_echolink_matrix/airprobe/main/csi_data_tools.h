@@ -1,4 +1,19 @@
-int echo_csi_data(const char *data);
-int echo_csi_data_mcast(const char *data);
-int recv_csi_data_multicast(void);
+#pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+#include "csi_metrics.h"
+#endif
+
+esp_err_t csi_sender_init(void);
+esp_err_t echo_csi_data(const void *data, size_t len);
+
+/** 累计发送失败次数，速率控制据此判断上行是否拥塞 */
+uint32_t csi_sender_get_send_errors(void);
+
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+/** 写入发送指标：发送成功的数据报数、失败次数和每次 send() 的耗时直方图，可在任意任务中调用 */
+void csi_sender_put_metrics(csi_metrics_writer_t *writer);
+#endif
@@ -0,0 +1,100 @@
+#include "csi_metrics_server.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "lwip/sockets.h"
+#include "csi_ctrl.h"
+#include "csi_data_tools.h"
+
+#if CONFIG_AIRPROBE_METRICS_ENABLE
+
+static const char *TAG = "AirProbe_metrics";
+
+static csi_metrics_server_fill_t s_fill;
+
+typedef struct __attribute__((packed)) {
+   csi_ctrl_hdr_t hdr;
+   uint8_t entries[CSI_METRICS_REPLY_MAX];
+} csi_metrics_reply_t;
+
+static void csi_metrics_server_fill(csi_metrics_writer_t *writer)
+{
+   csi_metrics_put_gauge(writer, CSI_CTRL_METRIC_UPTIME_S, (int32_t)(esp_timer_get_time() / 1000000));
+   csi_metrics_put_gauge(writer, CSI_CTRL_METRIC_FREE_HEAP, (int32_t)esp_get_free_heap_size());
+   csi_metrics_put_gauge(writer, CSI_CTRL_METRIC_MIN_FREE_HEAP, (int32_t)esp_get_minimum_free_heap_size());
+
+   wifi_ap_record_t ap_info;
+   if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+      csi_metrics_put_gauge(writer, CSI_CTRL_METRIC_WIFI_RSSI, ap_info.rssi);
+   }
+
+   csi_sender_put_metrics(writer);
+   if (s_fill) {
+      s_fill(writer);
+   }
+}
+
+static void csi_metrics_server_task(void *pvParameters)
+{
+   struct sockaddr_in addr = {
+      .sin_family = AF_INET,
+      .sin_port = htons(CONFIG_AIRPROBE_METRICS_PORT),
+      .sin_addr.s_addr = htonl(INADDR_ANY),
+   };
+
+   int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+   if (sock < 0 || bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+      ESP_LOGE(TAG, "Failed to bind port %d: errno %d", CONFIG_AIRPROBE_METRICS_PORT, errno);
+      if (sock >= 0) {
+         close(sock);
+      }
+      vTaskDelete(NULL);
+      return;
+   }
+   ESP_LOGI(TAG, "Serving metrics on port %d", CONFIG_AIRPROBE_METRICS_PORT);
+
+   csi_metrics_reply_t reply;
+   uint8_t buf[64];
+
+   while (1) {
+      struct sockaddr_in from;
+      socklen_t from_len = sizeof(from);
+      int len = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len);
+      const csi_ctrl_hdr_t *req = len > 0 ? csi_ctrl_check(buf, len) : NULL;
+      if (!req || req->type != CSI_CTRL_TYPE_STATS_GET) {
+         continue;
+      }
+
+      csi_metrics_writer_t writer;
+      csi_metrics_writer_init(&writer, reply.entries, sizeof(reply.entries));
+      csi_metrics_server_fill(&writer);
+
+      csi_ctrl_hdr_init(&reply.hdr, CSI_CTRL_TYPE_STATS);
+      reply.hdr.count = writer.count;
+      reply.hdr.len = writer.len;
+      sendto(sock, &reply, sizeof(reply.hdr) + reply.hdr.len, 0, (const struct sockaddr *)&from, sizeof(from));
+   }
+}
+
+esp_err_t csi_metrics_server_start(csi_metrics_server_fill_t fill)
+{
+   s_fill = fill;
+
+   // 低优先级：只在收到请求时运行，与 csi_sender 在同一核心，不抢占 Wi-Fi 驱动
+#if CONFIG_FREERTOS_UNICORE
+   BaseType_t created = xTaskCreate(csi_metrics_server_task, "csi_metrics", 3072, NULL, 1, NULL);
+#else
+   BaseType_t created = xTaskCreatePinnedToCore(csi_metrics_server_task, "csi_metrics", 3072, NULL, 1, NULL,
+                                                CONFIG_AIRPROBE_SENDER_TASK_CORE);
+#endif
+   if (created != pdPASS) {
+      return ESP_ERR_NO_MEM;
+   }
+   return ESP_OK;
+}
+
+#endif /* CONFIG_AIRPROBE_METRICS_ENABLE */
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "esp_err.h"
+#include "csi_metrics.h"
+
+/**
+ * @brief 由 csi_metrics_server 任务在应答 STATS_GET 时调用，写入调用方维护的指标
+ */
+typedef void (*csi_metrics_server_fill_t)(csi_metrics_writer_t *writer);
+
+/**
+ * @brief 启动指标查询任务
+ *
+ * 在 AIRPROBE_METRICS_PORT 上接收 STATS_GET（见 csi_ctrl.h），应答发回请求的源地址和端口：
+ * 运行时间、空闲堆、RSSI、发送指标（csi_sender_put_metrics），再加上 fill 写入的指标。
+ * 只在收到请求时读取指标，不占用数据通路。
+ */
+esp_err_t csi_metrics_server_start(csi_metrics_server_fill_t fill);
@@ -0,0 +1,141 @@
+#include "csi_stimulus.h"
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_now.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+
+static const char *TAG = "AirProbe_stimulus";
+
+static esp_err_t csi_stimulus_espnow_init(void)
+{
+   esp_err_t ret = esp_now_init();
+   if (ret != ESP_OK) {
+      ESP_LOGE(TAG, "esp_now_init failed: %s", esp_err_to_name(ret));
+   }
+   return ret;
+}
+
+/* ------------------------------------------------------------------ 接收端 */
+
+static uint8_t *s_learned_mac = NULL;  // 指向调用方的学习地址
+
+static void csi_stimulus_espnow_recv_cb(const esp_now_recv_info_t *info, const uint8_t *data, int len)
+{
+   static const uint8_t zero[6] = { 0 };
+
+   // 只记录第一个发送端；CSI 回调在另一个任务中按 6 字节比较，写入前后最多误丢几帧
+   if (memcmp(s_learned_mac, zero, sizeof(zero)) == 0) {
+      memcpy(s_learned_mac, info->src_addr, 6);
+      ESP_LOGI(TAG, "Stimulus source learned: " MACSTR, MAC2STR(info->src_addr));
+   }
+}
+
+esp_err_t csi_stimulus_espnow_listen(uint8_t learned_mac[6])
+{
+   esp_err_t ret = csi_stimulus_espnow_init();
+   if (ret != ESP_OK || learned_mac == NULL) {
+      return ret;
+   }
+
+   s_learned_mac = learned_mac;
+   ESP_LOGI(TAG, "Listening for ESP-NOW stimulus, learning the source from the first packet");
+   return esp_now_register_recv_cb(csi_stimulus_espnow_recv_cb);
+}
+
+/* ------------------------------------------------------------------ 发射节点 */
+
+static esp_timer_handle_t s_tx_timer = NULL;
+static uint32_t s_tx_seq = 0;
+static uint32_t s_tx_failed = 0;
+
+#if CONFIG_AIRPROBE_STIMULUS_INJECT
+static uint8_t s_null_frame[24] = {
+   0x48, 0x00,                            // Frame Control：数据帧，子类型 Null
+   0x00, 0x00,                            // Duration
+   0xff, 0xff, 0xff, 0xff, 0xff, 0xff,    // addr1：广播
+   0, 0, 0, 0, 0, 0,                      // addr2：本机 STA MAC
+   0, 0, 0, 0, 0, 0,                      // addr3：当前 AP 的 BSSID
+   0x00, 0x00,                            // Sequence Control，由驱动填写
+};
+
+static esp_err_t csi_stimulus_tx_frame(void)
+{
+   return esp_wifi_80211_tx(WIFI_IF_STA, s_null_frame, sizeof(s_null_frame), true);
+}
+#else
+static const uint8_t s_broadcast_mac[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+
+/** ESP-NOW 激励帧的负载，接收端只用它的发送端地址，序号用于在空口抓包中对照 */
+typedef struct __attribute__((packed)) {
+   uint8_t magic[4];          // "CSIS"
+   uint32_t seq;
+} csi_stimulus_payload_t;
+
+static esp_err_t csi_stimulus_tx_frame(void)
+{
+   csi_stimulus_payload_t payload = {
+      .magic = { 'C', 'S', 'I', 'S' },
+      .seq = s_tx_seq,
+   };
+   return esp_now_send(s_broadcast_mac, (const uint8_t *)&payload, sizeof(payload));
+}
+#endif
+
+static void csi_stimulus_tx_timer_cb(void *arg)
+{
+   if (csi_stimulus_tx_frame() != ESP_OK) {
+      s_tx_failed++;
+   }
+
+   // 每 10 s 打印一次发送统计
+   if (++s_tx_seq % (uint32_t)(uintptr_t)arg == 0) {
+      ESP_LOGI(TAG, "Stimulus sent %" PRIu32 ", failed %" PRIu32, s_tx_seq, s_tx_failed);
+   }
+}
+
+esp_err_t csi_stimulus_tx_start(uint32_t rate_hz)
+{
+   esp_err_t ret;
+
+#if CONFIG_AIRPROBE_STIMULUS_INJECT
+   wifi_ap_record_t ap_info = { 0 };
+   ret = esp_wifi_sta_get_ap_info(&ap_info);
+   if (ret != ESP_OK) {
+      return ret;
+   }
+   ESP_ERROR_CHECK(esp_wifi_get_mac(WIFI_IF_STA, s_null_frame + 10));
+   memcpy(s_null_frame + 16, ap_info.bssid, 6);
+   ESP_LOGI(TAG, "Injecting null-data frames at %" PRIu32 " Hz, BSSID " MACSTR, rate_hz, MAC2STR(ap_info.bssid));
+#else
+   ret = csi_stimulus_espnow_init();
+   if (ret != ESP_OK) {
+      return ret;
+   }
+
+   esp_now_peer_info_t peer = {
+      .ifidx = WIFI_IF_STA,
+      .channel = 0,              // 当前信道
+      .encrypt = false,
+   };
+   memcpy(peer.peer_addr, s_broadcast_mac, sizeof(peer.peer_addr));
+   ret = esp_now_add_peer(&peer);
+   if (ret != ESP_OK) {
+      return ret;
+   }
+   ESP_LOGI(TAG, "Broadcasting ESP-NOW stimulus at %" PRIu32 " Hz", rate_hz);
+#endif
+
+   const esp_timer_create_args_t timer_args = {
+      .callback = csi_stimulus_tx_timer_cb,
+      .arg = (void *)(uintptr_t)(rate_hz * 10),
+      .name = "csi_stimulus",
+   };
+   ret = esp_timer_create(&timer_args, &s_tx_timer);
+   if (ret != ESP_OK) {
+      return ret;
+   }
+   return esp_timer_start_periodic(s_tx_timer, 1000000 / rate_hz);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @brief 接收端：监听 ESP-NOW 发射节点的广播
+ *
+ * @param learned_mac 非 NULL 时（没有配置发射节点）把收到的第一个 ESP-NOW 数据包的发送端
+ *                    写入其中，调用方据此加入 CSI 源白名单；NULL 时只初始化 ESP-NOW
+ */
+esp_err_t csi_stimulus_espnow_listen(uint8_t learned_mac[6]);
+
+/**
+ * @brief 发射节点：以固定速率广播激励帧
+ *
+ * AIRPROBE_STIMULUS_ESPNOW 时发送 ESP-NOW 广播，AIRPROBE_STIMULUS_INJECT 时用
+ * esp_wifi_80211_tx 注入 null-data 帧（广播地址，BSSID 为当前 AP），
+ * 由 esp_timer 周期触发，不经过 IP 协议栈。
+ */
+esp_err_t csi_stimulus_tx_start(uint32_t rate_hz);
@@ -14,17 +14,24 @@
  *      当 STA 断开连接时，等待 3 秒后重试。
  * 3、UDP 服务器：
  *      创建一个 UDP socket，绑定到端口 3333。
- *      接收CSI数据：使用 recvfrom 接收来自客户端的数据，并打印到日志。
- *      转发CSI数据：将接收到的数据通过 UDP 发送到指定的 IP 和端口。
+ *      接收CSI数据：select 阻塞等待，唤醒后用非阻塞 recvmsg 一次取完所有待处理的数据报。
+ *      转发CSI数据：直接用接收缓冲区把每个数据报发送到转发表中的所有目标，不加锁、不拷贝。
+ *      转发表：启动时从 NVS 或 Kconfig 加载，可通过控制端口（默认 3334）在运行时替换；
+ *      组播：可选在 SoftAP 侧加入 AirProbe 的组播组接收数据，并把数据再发布到局域网组播组，任意数量的主机加入该组即可接收。
+ *      订阅：主机向控制端口发送 SUBSCRIBE 并定期续约，即可接收数据（可按探针 MAC 过滤），租期过后自动停止转发。
+ *      对时：AirProbe 定期向控制端口发送 TIME_REQ，AirSight 的 esp_timer 作为各探针同步时间戳（sync_us）的参考时钟。
+ *      连续发送失败的目标按指数退避跳过，每个目标单独统计 sent/failed/bytes。
+ *      序号统计：按探针统计丢失、乱序、重启、空洞长度分布和到达抖动（source_stats.c），每 10 秒打印，可通过 SRC_GET 查询。
+ *      运行指标：接收/转发计数、sendto 耗时直方图、堆和 RSSI 自启动起累计（components/csi_metrics），可通过 STATS_GET 查询。
  * 4、任务调度：
  *      使用 FreeRTOS 创建 UDP 服务器任务。
  * 
  * 5、注意事项
  * 1）WiFi 配置：
  *      确保 无线城市 热点没有密码，或者根据实际情况修改代码。
- *      确保 FORWARD_IP 和 FORWARD_PORT 设置正确，且目标设备在同一个局域网中。
+ *      确保 AIRSIGHT_FORWARD_TARGETS（或 NVS 中的转发表）设置正确，且目标设备在同一个局域网中。
  * 2）UDP 数据接收：
- *      接收的数据长度不能超过 rx_buffer 的大小（1024 字节）。
+ *      接收的数据长度不能超过 rx_buffer 的大小（CSI_DATAGRAM_MAX_SIZE，1472 字节），AirProbe 的聚合容器按此上限打包。
  * 3）调试：
  *      使用 ESP_LOGI 打印日志，方便调试和观察程序运行状态。
  */
@@ -60,16 +67,28 @@ graph LR
   */
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
+#include <sys/param.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
 #include "nvs_flash.h"
 #include "lwip/err.h"
 #include "lwip/sockets.h"
 #include "lwip/sys.h"
 #include "lwip/netdb.h"
+#include "csi_frame.h"
+#include "csi_ctrl.h"
+#include "forward_table.h"
+#include "source_stats.h"
+#include "csi_metrics.h"
+#if CONFIG_AIRSIGHT_CPU_TRACE_ENABLE
+#include "csi_cpu.h"
+#endif
 
 // 定义 WiFi 配置
 #define SOFTAP_SSID "AirSight"
@@ -80,22 +99,28 @@ graph LR
 // 定义 UDP 服务器端口
 #define UDP_PORT 3333
 
-// 定义转发目标的 IP 和端口
-// #define FORWARD_IP "192.168.99.55" // 替换为目标 IP
-// #define FORWARD_PORT 4444          // 替换为目标端口
+// 定义控制端口：转发表等运行时配置通过该端口下发（见 csi_ctrl.h）
+#define CTRL_PORT CONFIG_AIRSIGHT_CTRL_PORT
 
-static const char *FORWARD_IPS[] = {"192.168.99.42", "192.168.99.107"};
-// static const char *FORWARD_IPS[] = {"192.168.43.6","192.168.200.2","192.168.200.3"};
-static const int FORWARD_IPS_COUNT = sizeof(FORWARD_IPS) / sizeof(FORWARD_IPS[0]);
-static const int FORWARD_PORT = 4444;
-static int current_forward_index = 0;
-static struct sockaddr_in *forward_addrs = NULL;
-static SemaphoreHandle_t index_mutex = NULL;
+// 转发目标见 forward_table.c，默认值在 Kconfig AIRSIGHT_FORWARD_TARGETS 中配置
 
-// 定义性能统计变量
-static int total_sent = 0;
-static int total_failed = 0;
-static TickType_t last_log_time = 0;
+// 定义性能统计变量，只由 udp_server 任务访问
+typedef struct {
+    int sent;           // 成功发送的数据报数（按目标计）
+    int frames;         // 转发的 CSI 帧数
+    int datagrams;      // 收到的数据报数
+    int truncated;      // 超过 rx_buffer 被截断而丢弃的数据报数
+    int wakeups;        // select 唤醒次数
+} forward_stats_t;
+
+static forward_stats_t s_stats = {0};
+
+// 自启动起累计的接收指标，不随每秒的日志清零，STATS_GET 查询（发送指标见 forward_table_put_metrics）
+static struct {
+    csi_metric_counter_t datagrams;
+    csi_metric_counter_t frames;        // 含 STA 未连接时未转发的帧
+    csi_metric_counter_t truncated;
+} s_metrics;
 
 // 日志标签
 static const char *TAG = "AirSight";
@@ -103,45 +128,13 @@ static const char *TAG = "AirSight";
 // STA 模式的 IP 地址
 static esp_ip4_addr_t sta_ip = {0};
 
-// 初始化转发地址
-static bool init_forward_addrs() {
-    if (FORWARD_IPS_COUNT == 0) {
-        ESP_LOGE(TAG, "Error: No forward IPs configured.");
-        return false;
-    }
-
-    forward_addrs = malloc(sizeof(struct sockaddr_in) * FORWARD_IPS_COUNT);
-    if (!forward_addrs) {
-        ESP_LOGE(TAG, "Memory allocation failed.");
-        return false;
-    }
-
-    for (int i = 0; i < FORWARD_IPS_COUNT; i++) {
-        forward_addrs[i].sin_family = AF_INET;
-        forward_addrs[i].sin_port = htons(FORWARD_PORT);
-        if (inet_pton(AF_INET, FORWARD_IPS[i], &forward_addrs[i].sin_addr) != 1) {
-            ESP_LOGE(TAG, "Invalid IP: %s. Initialization aborted.", FORWARD_IPS[i]);
-            free(forward_addrs);
-            return false;
-        }
-    }
-
-    index_mutex = xSemaphoreCreateMutex();
-    if (!index_mutex) {
-        ESP_LOGE(TAG, "Failed to create mutex.");
-        free(forward_addrs);
-        return false;
-    }
-
-    return true;
-}
-
 // WiFi 事件处理函数
 static void wifi_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         esp_wifi_connect(); // STA 模式启动后尝试连接
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
         ESP_LOGI(TAG, "STA disconnected, retrying...");
+        sta_ip.addr = 0; // 断开期间不再转发
         vTaskDelay(3000 / portTICK_PERIOD_MS); // 等待 3 秒后重试
         esp_wifi_connect();
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
@@ -204,115 +197,438 @@ static void wifi_init() {
     ESP_ERROR_CHECK(esp_wifi_start());
 }
 
-// UDP 服务器任务
+// 统计数据报中的 CSI 帧数：聚合容器按其中的帧数计，CSV 文本按 1 帧计，同时按数据源统计序号
+// probe_mac 返回第一帧的探针 MAC（同一个聚合容器中的帧来自同一个探针），CSV 文本返回 NULL
+static int count_csi_frames(const char *buf, int len, const struct sockaddr_in *from, int64_t rx_us,
+                            const uint8_t **probe_mac) {
+    *probe_mac = NULL;
+    if (len <= 0 || (uint8_t)buf[0] != CSI_FRAME_MAGIC) {
+        if (len > 0) {
+            source_stats_text(buf, len, from, rx_us);
+        }
+        return len > 0 ? 1 : 0;
+    }
 
-static void udp_server_task(void *pvParameters) {
+    // 特征数据报不含 CSI 帧，但同样按 probe_mac 过滤订阅
+    const csi_features_hdr_t *features = csi_features_check(buf, len);
+    if (features) {
+        *probe_mac = features->probe_mac;
+        return 0;
+    }
 
-    // 初始化转发地址（必须在socket创建前调用）
-    if (!init_forward_addrs()) {
-        ESP_LOGE(TAG, "Forward address initialization failed. Task exiting.");
-        vTaskDelete(NULL); // 初始化失败，直接退出任务
+    // FEC 校验数据报原样转发，恢复由主机完成
+    const csi_parity_hdr_t *parity = csi_parity_check(buf, len);
+    if (parity) {
+        *probe_mac = parity->probe_mac;
+        return 0;
+    }
+
+    int count = 0;
+    csi_frame_iter_t it;
+    csi_frame_iter_init(&it, buf, len);
+    for (const csi_frame_hdr_t *hdr; (hdr = csi_frame_iter_next(&it)) != NULL;) {
+        if (count++ == 0) {
+            *probe_mac = hdr->probe_mac;
+        }
+        source_stats_frame(hdr, rx_us);
+    }
+    return count;
+}
+
+// 每秒打印一次吞吐量，每 10 秒打印一次各转发目标的状态和各数据源的序号统计
+static void log_forward_stats(void) {
+    static int log_count = 0;
+
+    ESP_LOGI(TAG, "Throughput: %d/s, Frames: %d/s, Datagrams: %d/s (%d wakeups), Truncated: %d",
+             s_stats.sent, s_stats.frames, s_stats.datagrams, s_stats.wakeups, s_stats.truncated);
+    memset(&s_stats, 0, sizeof(s_stats));
+
+    if (++log_count % 10 == 0) {
+        forward_table_log();
+        source_stats_log();
+#if CONFIG_AIRSIGHT_CPU_TRACE_ENABLE
+        static csi_cpu_snapshot_t cpu_prev, cpu_now;
+        if (csi_cpu_snapshot(&cpu_now)) {
+            // 第一次只记录快照
+            if (log_count > 10) {
+                csi_cpu_log(TAG, &cpu_prev, &cpu_now);
+            }
+            cpu_prev = cpu_now;
+        }
+#endif
+    }
+}
+
+// 处理 SUBSCRIBE / UNSUBSCRIBE，应答 SUB_ACK
+static void handle_subscribe(int sock, const csi_ctrl_hdr_t *req, const char *buf,
+                             const struct sockaddr_in *from) {
+    struct {
+        csi_ctrl_hdr_t hdr;
+        csi_ctrl_subscribe_t sub;
+    } __attribute__((packed)) reply;
+    csi_ctrl_hdr_init(&reply.hdr, CSI_CTRL_TYPE_SUB_ACK);
+    reply.hdr.len = sizeof(reply.sub);
+
+    csi_ctrl_subscribe_t sub = {0};
+    size_t mac_count = req->count;
+    bool valid = req->len >= sizeof(sub) + mac_count * 6;
+    if (valid) {
+        memcpy(&sub, buf + req->hdr_len, sizeof(sub));
+    }
+
+    // 数据发往请求方的 IP，端口未指定时使用请求的源端口
+    struct sockaddr_in data_addr = *from;
+    if (sub.port) {
+        data_addr.sin_port = htons(sub.port);
+    }
+    reply.sub.port = ntohs(data_addr.sin_port);
+    reply.sub.lease_s = 0;
+
+    if (!valid) {
+        reply.hdr.flags |= CSI_CTRL_FLAG_ERROR;
+    } else if (req->type == CSI_CTRL_TYPE_UNSUBSCRIBE) {
+        forward_table_unsubscribe(&data_addr);
+    } else {
+        uint32_t granted_s = 0;
+        const uint8_t *macs = (const uint8_t *)buf + req->hdr_len + sizeof(sub);
+        if (forward_table_subscribe(&data_addr, sub.lease_s, macs, mac_count, &granted_s) == ESP_OK) {
+            reply.sub.lease_s = granted_s;
+        } else {
+            reply.hdr.flags |= CSI_CTRL_FLAG_ERROR;
+        }
+    }
+
+    sendto(sock, &reply, sizeof(reply), 0, (const struct sockaddr *)from, sizeof(*from));
+}
+
+// 处理对时请求：AirSight 的 esp_timer 即各探针同步时间戳的参考时钟，t2 为收到请求的时刻，t3 在发送前读取
+static void handle_time_request(int sock, const csi_ctrl_hdr_t *req, const char *buf, int64_t rx_us,
+                                const struct sockaddr_in *from) {
+    struct {
+        csi_ctrl_hdr_t hdr;
+        csi_ctrl_time_t time;
+    } __attribute__((packed)) reply;
+    csi_ctrl_hdr_init(&reply.hdr, CSI_CTRL_TYPE_TIME_RESP);
+    reply.hdr.len = sizeof(reply.time);
+    memset(&reply.time, 0, sizeof(reply.time));
+
+    if (req->len < sizeof(reply.time)) {
+        reply.hdr.flags |= CSI_CTRL_FLAG_ERROR;
+    } else {
+        memcpy(&reply.time, buf + req->hdr_len, sizeof(reply.time));
+        reply.time.t2 = rx_us;
+        reply.time.t3 = esp_timer_get_time();
+    }
+
+    sendto(sock, &reply, sizeof(reply), 0, (const struct sockaddr *)from, sizeof(*from));
+}
+
+// 处理 SRC_GET，应答 SRC_STATUS
+static void handle_source_request(int sock, const csi_ctrl_hdr_t *req, const struct sockaddr_in *from) {
+    // 最多约 1.4 KB，只由 udp_server 任务使用，放在静态区
+    static struct {
+        csi_ctrl_hdr_t hdr;
+        csi_ctrl_src_status_t status[CONFIG_AIRSIGHT_MAX_SOURCES];
+    } __attribute__((packed)) reply;
+    static_assert(sizeof(reply) <= CSI_DATAGRAM_MAX_SIZE, "SRC_STATUS must fit one datagram");
+    csi_ctrl_hdr_init(&reply.hdr, CSI_CTRL_TYPE_SRC_STATUS);
+
+    reply.hdr.count = source_stats_get(reply.status, CONFIG_AIRSIGHT_MAX_SOURCES,
+                                       req->flags & CSI_CTRL_FLAG_RESET);
+    reply.hdr.len = reply.hdr.count * sizeof(reply.status[0]);
+    sendto(sock, &reply, sizeof(reply.hdr) + reply.hdr.len, 0,
+           (const struct sockaddr *)from, sizeof(*from));
+}
+
+// 处理 STATS_GET，应答 STATS：运行时间、堆、STA 的 RSSI 以及接收和转发指标
+static void handle_stats_request(int sock, const struct sockaddr_in *from) {
+    // 只由 udp_server 任务使用，放在静态区
+    static struct {
+        csi_ctrl_hdr_t hdr;
+        uint8_t entries[CSI_METRICS_REPLY_MAX];
+    } __attribute__((packed)) reply;
+    csi_metrics_writer_t writer;
+    csi_metrics_writer_init(&writer, reply.entries, sizeof(reply.entries));
+
+    csi_metrics_put_gauge(&writer, CSI_CTRL_METRIC_UPTIME_S, (int32_t)(esp_timer_get_time() / 1000000));
+    csi_metrics_put_gauge(&writer, CSI_CTRL_METRIC_FREE_HEAP, (int32_t)esp_get_free_heap_size());
+    csi_metrics_put_gauge(&writer, CSI_CTRL_METRIC_MIN_FREE_HEAP, (int32_t)esp_get_minimum_free_heap_size());
+    wifi_ap_record_t ap_info;
+    if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+        csi_metrics_put_gauge(&writer, CSI_CTRL_METRIC_WIFI_RSSI, ap_info.rssi);
+    }
+    csi_metrics_put_counter(&writer, CSI_CTRL_METRIC_RX_DATAGRAMS, csi_metric_read(&s_metrics.datagrams));
+    csi_metrics_put_counter(&writer, CSI_CTRL_METRIC_RX_FRAMES, csi_metric_read(&s_metrics.frames));
+    csi_metrics_put_counter(&writer, CSI_CTRL_METRIC_RX_TRUNCATED, csi_metric_read(&s_metrics.truncated));
+    forward_table_put_metrics(&writer);
+
+    csi_ctrl_hdr_init(&reply.hdr, CSI_CTRL_TYPE_STATS);
+    reply.hdr.count = writer.count;
+    reply.hdr.len = writer.len;
+    sendto(sock, &reply, sizeof(reply.hdr) + reply.hdr.len, 0,
+           (const struct sockaddr *)from, sizeof(*from));
+}
+
+// 处理一个控制数据报，应答发回请求方；rx_us 为收到该数据报的时刻
+static void handle_ctrl_datagram(int sock, const char *buf, int len, int64_t rx_us,
+                                 const struct sockaddr_in *from) {
+    const csi_ctrl_hdr_t *req = csi_ctrl_check(buf, len);
+    if (!req) {
         return;
     }
 
-    char rx_buffer[1024];
-    struct sockaddr_in server_addr;
-    struct sockaddr_in client_addr;
-    socklen_t socklen = sizeof(client_addr);
+    if (req->type == CSI_CTRL_TYPE_TIME_REQ) {
+        handle_time_request(sock, req, buf, rx_us, from);
+        return;
+    }
+    if (req->type == CSI_CTRL_TYPE_SUBSCRIBE || req->type == CSI_CTRL_TYPE_UNSUBSCRIBE) {
+        handle_subscribe(sock, req, buf, from);
+        return;
+    }
+    if (req->type == CSI_CTRL_TYPE_SRC_GET) {
+        handle_source_request(sock, req, from);
+        return;
+    }
+    if (req->type == CSI_CTRL_TYPE_STATS_GET) {
+        handle_stats_request(sock, from);
+        return;
+    }
+
+    // 应答和条目拷贝只由 udp_server 任务使用，放在静态区：持久化时 NVS 写入也在这个任务的栈上
+    static struct {
+        csi_ctrl_hdr_t hdr;
+        // 固定目标 + 组播组 + 订阅者
+        csi_ctrl_fwd_status_t status[CONFIG_AIRSIGHT_FORWARD_MAX_TARGETS + 1 + CONFIG_AIRSIGHT_MAX_SUBSCRIBERS];
+    } __attribute__((packed)) reply;
+    static_assert(sizeof(reply) <= CSI_DATAGRAM_MAX_SIZE, "FWD_STATUS must fit one datagram");
+    csi_ctrl_hdr_init(&reply.hdr, CSI_CTRL_TYPE_FWD_STATUS);
+
+    switch (req->type) {
+    case CSI_CTRL_TYPE_FWD_SET: {
+        // 条目可能不对齐，先拷贝出来
+        static csi_ctrl_fwd_target_t targets[CONFIG_AIRSIGHT_FORWARD_MAX_TARGETS];
+        size_t count = req->count;
+        esp_err_t err = ESP_ERR_INVALID_ARG;
+        if (count <= CONFIG_AIRSIGHT_FORWARD_MAX_TARGETS && req->len >= count * sizeof(targets[0])) {
+            memcpy(targets, buf + req->hdr_len, count * sizeof(targets[0]));
+            err = forward_table_set(targets, count, req->flags & CSI_CTRL_FLAG_PERSIST);
+        }
+        if (err != ESP_OK) {
+            reply.hdr.flags |= CSI_CTRL_FLAG_ERROR;
+        }
+        ESP_LOGI(TAG, "Forward table update from " IPSTR ": %d targets, %s",
+                 IP2STR((const esp_ip4_addr_t *)&from->sin_addr), (int)count, esp_err_to_name(err));
+        break;
+    }
+    case CSI_CTRL_TYPE_FWD_GET:
+        break;
+    default:
+        return;
+    }
+
+    reply.hdr.count = forward_table_get_status(reply.status, sizeof(reply.status) / sizeof(reply.status[0]));
+    reply.hdr.len = reply.hdr.count * sizeof(reply.status[0]);
+    sendto(sock, &reply, sizeof(reply.hdr) + reply.hdr.len, 0,
+           (const struct sockaddr *)from, sizeof(*from));
+}
+
+// 创建非阻塞的 UDP socket 并绑定到端口：由 select 阻塞等待，唤醒后用非阻塞 recvmsg 取完所有数据报
+static int create_udp_socket(int port) {
+    struct sockaddr_in server_addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
 
-    // 创建 UDP socket
     int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
     if (sock < 0) {
         ESP_LOGE(TAG, "Failed to create socket");
-        vTaskDelete(NULL);
+        return -1;
     }
-    // 设置为非阻塞模式
+
     int flags = fcntl(sock, F_GETFL, 0);
     fcntl(sock, F_SETFL, flags | O_NONBLOCK);
 
-    // 绑定 socket 到端口
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(UDP_PORT);
-    server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
     if (bind(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        ESP_LOGE(TAG, "Failed to bind socket");
+        ESP_LOGE(TAG, "Failed to bind socket to port %d", port);
         close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+#if CONFIG_AIRSIGHT_MCAST_JOIN_PROBE_GROUP
+// 在 SoftAP 接口上加入 AirProbe 的组播组，组播发送的 CSI 数据与单播一样由数据 socket 接收
+static void join_probe_multicast_group(int sock) {
+    struct ip_mreq imreq = { 0 };
+    esp_netif_ip_info_t ip_info = { 0 };
+
+    if (esp_netif_get_ip_info(esp_netif_get_handle_from_ifkey("WIFI_AP_DEF"), &ip_info) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to get SoftAP IP address info");
+        return;
+    }
+    inet_addr_from_ip4addr(&imreq.imr_interface, &ip_info.ip);
+
+    if (inet_aton(CONFIG_AIRSIGHT_MCAST_PROBE_GROUP, &imreq.imr_multiaddr.s_addr) != 1
+            || setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &imreq, sizeof(imreq)) < 0) {
+        ESP_LOGE(TAG, "Failed to join multicast group %s: errno %d", CONFIG_AIRSIGHT_MCAST_PROBE_GROUP, errno);
+        return;
+    }
+
+    ESP_LOGI(TAG, "Joined probe multicast group %s", CONFIG_AIRSIGHT_MCAST_PROBE_GROUP);
+}
+#endif
+
+#if CONFIG_AIRSIGHT_MCAST_REPUBLISH
+// 组播转发的出口接口跟随 STA 的 IP，使组播数据从 STA（局域网）侧发出
+static void update_multicast_if(int sock) {
+    static uint32_t if_addr = 0;
+
+    if (sta_ip.addr == 0 || sta_ip.addr == if_addr) {
+        return;
+    }
+
+    struct in_addr iaddr = { .s_addr = sta_ip.addr };
+    if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &iaddr, sizeof(iaddr)) < 0) {
+        ESP_LOGE(TAG, "Failed to set IP_MULTICAST_IF. Error %d", errno);
+        return;
+    }
+    if_addr = sta_ip.addr;
+}
+#endif
+
+// UDP 服务器任务
+
+static void udp_server_task(void *pvParameters) {
+
+    // 加载转发表（必须在socket创建前调用）
+    if (forward_table_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Forward table initialization failed. Task exiting.");
+        vTaskDelete(NULL); // 初始化失败，直接退出任务
+        return;
+    }
+
+    // 接收缓冲区占一个数据报，放在静态区，任务栈留给控制请求（NVS 写入、日志）
+    static char rx_buffer[CSI_DATAGRAM_MAX_SIZE];
+    struct sockaddr_in client_addr;
+    struct iovec iov = {
+        .iov_base = rx_buffer,
+        .iov_len = sizeof(rx_buffer),
+    };
+    struct msghdr msg = {
+        .msg_name = &client_addr,
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+    };
+
+    // 创建数据和控制 UDP socket
+    int sock = create_udp_socket(UDP_PORT);
+    int ctrl_sock = create_udp_socket(CTRL_PORT);
+    if (sock < 0 || ctrl_sock < 0) {
+        if (sock >= 0) {
+            close(sock);
+        }
         vTaskDelete(NULL);
+        return;
     }
 
-    ESP_LOGI(TAG, "UDP server started on port %d", UDP_PORT);
+    ESP_LOGI(TAG, "UDP server started on port %d, control port %d", UDP_PORT, CTRL_PORT);
 
+#if CONFIG_AIRSIGHT_MCAST_JOIN_PROBE_GROUP
+    join_probe_multicast_group(sock);
+#endif
+#if CONFIG_AIRSIGHT_MCAST_REPUBLISH
+    uint8_t ttl = CONFIG_AIRSIGHT_MCAST_TTL;
+    if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0) {
+        ESP_LOGE(TAG, "Failed to set IP_MULTICAST_TTL. Error %d", errno);
+    }
+    forward_table_set_multicast(CONFIG_AIRSIGHT_MCAST_GROUP, CONFIG_AIRSIGHT_MCAST_PORT);
+#endif
 
+    TickType_t last_log_time = xTaskGetTickCount();
 
     while (1) {
-        // 接收数据
-        int len = recvfrom(sock, rx_buffer, sizeof(rx_buffer) - 1, 0, (struct sockaddr *)&client_addr, &socklen);
-        if (len > 0) {
-            rx_buffer[len] = 0; // 添加字符串结束符
-            // ESP_LOGI(TAG, "Received data: %s", rx_buffer);
-            // 创建转发目标的地址结构
-            // struct sockaddr_in forward_addr;
-            // forward_addr.sin_family = AF_INET;
-            //     forward_addr.sin_port = htons(FORWARD_PORT);
-            // inet_pton(AF_INET, FORWARD_IP, &forward_addr.sin_addr);
-            // // 转发数据到指定 IP 和端口
-            // if (sta_ip.addr != 0) { // 确保 STA 已获取 IP
-            //     int sent = sendto(sock, rx_buffer, len, 0, (struct sockaddr *)&forward_addr, sizeof(forward_addr));
-            //     if (sent < 0) {
-            //         ESP_LOGE(TAG, "Failed to send data to forward target");
-            //     } else {
-            //         ESP_LOGI(TAG, "Forwarded data to %s:%d", FORWARD_IP, FORWARD_PORT);
-            //     }
-            // } else {
-            //     ESP_LOGE(TAG, "STA IP not available, cannot forward data");
-            // }
-            // 获取当前目标地址
-
-
-            // ESP_LOGI(TAG, "Forwarding to [%d/%d] %s:%d,csi data len %d", 
-            //         current_index + 1, FORWARD_IPS_COUNT,
-            //         FORWARD_IPS[current_index], FORWARD_PORT,len);
-
-            if (sta_ip.addr != 0) {
-                // 批量发送到所有目标IP
-                for (int i = 0; i < FORWARD_IPS_COUNT; i++) {
-                    struct sockaddr_in *target_addr = &forward_addrs[i];
-                    int sent = sendto(sock, rx_buffer, len, 0, 
-                                    (struct sockaddr *)target_addr, 
-                                    sizeof(*target_addr));
-                    // 修改后的索引更新逻辑
-                    xSemaphoreTake(index_mutex, portMAX_DELAY);
-                    if (sent >= 0) {
-                        total_sent++;
-                        current_forward_index = (current_forward_index + 1) % FORWARD_IPS_COUNT;
-                    } else {
-                        // 失败时保留当前索引，下次继续尝试同一IP
-                        total_failed++;
-                        // ESP_LOGE(TAG, "Retry IP %s in next cycle", FORWARD_IPS[current_forward_index]);
+        // 阻塞等待数据到达，超时时间对齐到下一次打印吞吐量的时刻
+        TickType_t elapsed = xTaskGetTickCount() - last_log_time;
+        TickType_t remain = elapsed >= pdMS_TO_TICKS(1000) ? 0 : pdMS_TO_TICKS(1000) - elapsed;
+        struct timeval timeout = {
+            .tv_sec = 0,
+            .tv_usec = pdTICKS_TO_MS(remain) * 1000,
+        };
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        FD_SET(sock, &rfds);
+        FD_SET(ctrl_sock, &rfds);
+
+        int ready = select(MAX(sock, ctrl_sock) + 1, &rfds, NULL, NULL, &timeout);
+        // 先处理控制数据报：对时请求的 t2 不应包含转发一批 CSI 数据的时间
+        if (ready > 0 && FD_ISSET(ctrl_sock, &rfds)) {
+            socklen_t addr_len = sizeof(client_addr);
+            int len = recvfrom(ctrl_sock, rx_buffer, sizeof(rx_buffer), MSG_DONTWAIT,
+                               (struct sockaddr *)&client_addr, &addr_len);
+            int64_t rx_us = esp_timer_get_time();
+            if (len > 0) {
+                handle_ctrl_datagram(ctrl_sock, rx_buffer, len, rx_us, &client_addr);
+            }
+        }
+
+        if (ready < 0) {
+            ESP_LOGE(TAG, "select failed: errno %d", errno);
+            vTaskDelay(pdMS_TO_TICKS(10));
+        } else if (ready > 0 && FD_ISSET(sock, &rfds)) {
+            s_stats.wakeups++;
+
+            // 一次唤醒取完所有待处理的数据报
+            while (1) {
+                msg.msg_namelen = sizeof(client_addr);
+                msg.msg_flags = 0;
+                int len = recvmsg(sock, &msg, MSG_DONTWAIT);
+                int64_t rx_us = esp_timer_get_time();
+                if (len < 0) {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                        ESP_LOGE(TAG, "recvmsg failed: errno %d", errno);
                     }
-                    xSemaphoreGive(index_mutex);
+                    break;
+                }
+
+                s_stats.datagrams++;
+                csi_metric_add(&s_metrics.datagrams, 1);
+                if (msg.msg_flags & MSG_TRUNC) {
+                    s_stats.truncated++;
+                    csi_metric_add(&s_metrics.truncated, 1);
+                    continue;
                 }
 
-                 // 每秒打印吞吐量
-                TickType_t now = xTaskGetTickCount();
-                if (now - last_log_time >= pdMS_TO_TICKS(1000)) {
-                    ESP_LOGI(TAG, "Throughput: %d/s, Failed: %d", total_sent, total_failed);
-                    total_sent = 0;
-                    total_failed = 0;
-                    last_log_time = now;
+                // 序号统计反映探针到 AirSight 这一段，不受上行是否可用影响
+                const uint8_t *probe_mac;
+                int frames = count_csi_frames(rx_buffer, len, &client_addr, rx_us, &probe_mac);
+                csi_metric_add(&s_metrics.frames, frames);
+
+                // 只有在 STA 获取 IP 后才转发，否则直接丢弃
+                if (len == 0 || sta_ip.addr == 0) {
+                    continue;
                 }
 
-                vTaskDelay(1 / portTICK_PERIOD_MS); // 释放CPU
+#if CONFIG_AIRSIGHT_MCAST_REPUBLISH
+                update_multicast_if(sock);
+#endif
+
+                // 直接使用接收缓冲区转发，不做拷贝
+                s_stats.frames += frames;
+                s_stats.sent += forward_table_send(sock, rx_buffer, len, probe_mac);
             }
-            
+        }
+
+        TickType_t now = xTaskGetTickCount();
+        if (now - last_log_time >= pdMS_TO_TICKS(1000)) {
+            log_forward_stats();
+            last_log_time = now;
         }
     }
 
-    // close(sock);
-    // vTaskDelete(NULL);
     // 清理资源
-    free(forward_addrs);
-    vSemaphoreDelete(index_mutex);
+    close(ctrl_sock);
     close(sock);
     vTaskDelete(NULL);
 }
@@ -321,6 +637,13 @@ void app_main() {
     // 初始化 WiFi
     wifi_init();
 
-    // 创建 UDP 服务器任务
-    xTaskCreate(udp_server_task, "udp_server", 4096, NULL, 5, NULL);
+    // 创建 UDP 服务器任务：Wi-Fi 驱动和 lwIP 在核心 0，收发与转发循环绑定在另一个核心
+#if CONFIG_FREERTOS_UNICORE
+    xTaskCreate(udp_server_task, "udp_server", 4096, NULL, CONFIG_AIRSIGHT_UDP_TASK_PRIORITY, NULL);
+#else
+    xTaskCreatePinnedToCore(udp_server_task, "udp_server", 4096, NULL, CONFIG_AIRSIGHT_UDP_TASK_PRIORITY, NULL,
+                            CONFIG_AIRSIGHT_UDP_TASK_CORE);
+    ESP_LOGI(TAG, "Tasks: lwIP affinity 0x%x, udp_server on core %d (priority %d)",
+             CONFIG_LWIP_TCPIP_TASK_AFFINITY, CONFIG_AIRSIGHT_UDP_TASK_CORE, CONFIG_AIRSIGHT_UDP_TASK_PRIORITY);
+#endif
 }
@@ -0,0 +1,467 @@
+#include "forward_table.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_netif.h"
+#include "nvs.h"
+#include "lwip/sockets.h"
+
+#define FORWARD_TABLE_MAX_TARGETS   CONFIG_AIRSIGHT_FORWARD_MAX_TARGETS
+#define FORWARD_TABLE_MAX_SUBSCRIBERS CONFIG_AIRSIGHT_MAX_SUBSCRIBERS
+#define FORWARD_TABLE_MAX_FILTERS   CONFIG_AIRSIGHT_SUBSCRIBE_MAX_FILTERS
+#define FORWARD_TABLE_NVS_NAMESPACE "airsight"
+#define FORWARD_TABLE_NVS_KEY       "fwd_table"
+
+typedef struct {
+    csi_ctrl_fwd_target_t target;   // 线上格式，用于比较、存储和应答
+    struct sockaddr_in addr;
+    uint32_t sent;
+    uint32_t failed;
+    uint32_t skipped;
+    uint64_t bytes;
+    uint32_t fail_streak;           // 连续失败次数，成功一次即清零
+    uint32_t backoff_ms;            // 0 表示正常转发
+    int64_t retry_at_us;            // 退避结束时间（esp_timer 时基）
+    int64_t lease_until_us;         // 订阅者：租期结束时间，0 表示空闲槽位
+    uint8_t mac_count;              // 订阅者：过滤条目数，0 表示不过滤
+    uint8_t macs[FORWARD_TABLE_MAX_FILTERS][6];
+} forward_target_t;
+
+static const char *TAG = "AirSight_fwd";
+
+static forward_target_t s_targets[FORWARD_TABLE_MAX_TARGETS];
+static size_t s_target_count;
+static forward_target_t s_subscribers[FORWARD_TABLE_MAX_SUBSCRIBERS];
+static forward_target_t s_multicast;    // 局域网组播转发，port 为 0 表示未启用
+
+// 所有目标合计，不随转发表替换清零，STATS_GET 查询
+static csi_metric_counter_t s_sent;
+static csi_metric_counter_t s_failed;
+static csi_metric_hist_t s_sendto_us;
+
+static void target_to_addr(const csi_ctrl_fwd_target_t *target, struct sockaddr_in *addr)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(target->port);
+    memcpy(&addr->sin_addr.s_addr, target->ip, sizeof(target->ip));
+}
+
+static bool target_is_valid(const csi_ctrl_fwd_target_t *target)
+{
+    static const uint8_t any[4] = {0};
+    return target->port != 0 && memcmp(target->ip, any, sizeof(any)) != 0;
+}
+
+// 解析 "ip[:port],ip[:port],..."，省略端口时使用 AIRSIGHT_FORWARD_PORT
+static size_t parse_targets(const char *str, csi_ctrl_fwd_target_t *targets, size_t max)
+{
+    char *copy = strdup(str);
+    char *save = NULL;
+    size_t count = 0;
+
+    if (!copy) {
+        return 0;
+    }
+
+    for (char *item = strtok_r(copy, ", ", &save); item && count < max; item = strtok_r(NULL, ", ", &save)) {
+        csi_ctrl_fwd_target_t *target = &targets[count];
+        struct in_addr ip;
+        char *colon = strchr(item, ':');
+
+        target->port = CONFIG_AIRSIGHT_FORWARD_PORT;
+        if (colon) {
+            *colon = '\0';
+            target->port = (uint16_t)strtoul(colon + 1, NULL, 10);
+        }
+
+        if (inet_pton(AF_INET, item, &ip) != 1) {
+            ESP_LOGE(TAG, "Invalid forward target: %s", item);
+            continue;
+        }
+        memcpy(target->ip, &ip.s_addr, sizeof(target->ip));
+
+        if (target_is_valid(target)) {
+            count++;
+        }
+    }
+
+    free(copy);
+    return count;
+}
+
+static size_t load_targets_from_nvs(csi_ctrl_fwd_target_t *targets, size_t max)
+{
+    nvs_handle_t handle;
+    size_t size = sizeof(csi_ctrl_fwd_target_t) * max;
+
+    if (nvs_open(FORWARD_TABLE_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return 0;
+    }
+
+    esp_err_t err = nvs_get_blob(handle, FORWARD_TABLE_NVS_KEY, targets, &size);
+    nvs_close(handle);
+
+    if (err != ESP_OK || size % sizeof(csi_ctrl_fwd_target_t) != 0) {
+        return 0;
+    }
+
+    return size / sizeof(csi_ctrl_fwd_target_t);
+}
+
+static esp_err_t save_targets_to_nvs(const csi_ctrl_fwd_target_t *targets, size_t count)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(FORWARD_TABLE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = nvs_set_blob(handle, FORWARD_TABLE_NVS_KEY, targets, sizeof(csi_ctrl_fwd_target_t) * count);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t forward_table_init(void)
+{
+    csi_ctrl_fwd_target_t targets[FORWARD_TABLE_MAX_TARGETS];
+    size_t count = load_targets_from_nvs(targets, FORWARD_TABLE_MAX_TARGETS);
+    const char *source = "NVS";
+
+    if (count == 0) {
+        count = parse_targets(CONFIG_AIRSIGHT_FORWARD_TARGETS, targets, FORWARD_TABLE_MAX_TARGETS);
+        source = "Kconfig";
+    }
+
+    esp_err_t err = forward_table_set(targets, count, false);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (count == 0) {
+        ESP_LOGW(TAG, "No forward target configured, forwarding to subscribers only");
+    } else {
+        ESP_LOGI(TAG, "Loaded %d forward targets from %s", (int)count, source);
+    }
+    return ESP_OK;
+}
+
+esp_err_t forward_table_set(const csi_ctrl_fwd_target_t *targets, size_t count, bool persist)
+{
+    // 每项约 100 字节，只由 udp_server 任务调用，放在静态区以免占用任务栈
+    static forward_target_t table[FORWARD_TABLE_MAX_TARGETS];
+
+    if (count > FORWARD_TABLE_MAX_TARGETS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(table, 0, sizeof(table));
+
+    for (size_t i = 0; i < count; i++) {
+        if (!target_is_valid(&targets[i])) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        // 地址不变的目标沿用原有的统计和退避状态
+        for (size_t j = 0; j < s_target_count; j++) {
+            if (memcmp(&s_targets[j].target, &targets[i], sizeof(targets[i])) == 0) {
+                table[i] = s_targets[j];
+                break;
+            }
+        }
+
+        table[i].target = targets[i];
+        target_to_addr(&targets[i], &table[i].addr);
+    }
+
+    if (persist) {
+        esp_err_t err = save_targets_to_nvs(targets, count);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to save forward table: %s", esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    memcpy(s_targets, table, sizeof(table));
+    s_target_count = count;
+    return ESP_OK;
+}
+
+esp_err_t forward_table_set_multicast(const char *group, uint16_t port)
+{
+    struct in_addr ip;
+
+    if (inet_aton(group, &ip) != 1 || !IP_MULTICAST(ntohl(ip.s_addr)) || port == 0) {
+        ESP_LOGE(TAG, "Invalid multicast group %s:%d", group, port);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(&s_multicast, 0, sizeof(s_multicast));
+    memcpy(s_multicast.target.ip, &ip.s_addr, sizeof(s_multicast.target.ip));
+    s_multicast.target.port = port;
+    target_to_addr(&s_multicast.target, &s_multicast.addr);
+    ESP_LOGI(TAG, "Republishing to multicast group %s:%d", group, port);
+    return ESP_OK;
+}
+
+// 释放租期已过的订阅者槽位；发送、订阅、状态查询和日志前都先调用，没有 CSI 数据时过期的订阅者也不再出现在状态中
+static void expire_subscribers(int64_t now_us)
+{
+    for (size_t i = 0; i < FORWARD_TABLE_MAX_SUBSCRIBERS; i++) {
+        forward_target_t *t = &s_subscribers[i];
+        if (t->lease_until_us && now_us >= t->lease_until_us) {
+            t->lease_until_us = 0;
+            ESP_LOGI(TAG, "Subscriber " IPSTR ":%d lease expired",
+                     t->target.ip[0], t->target.ip[1], t->target.ip[2], t->target.ip[3], t->target.port);
+        }
+    }
+}
+
+static forward_target_t *find_subscriber(const csi_ctrl_fwd_target_t *target)
+{
+    for (size_t i = 0; i < FORWARD_TABLE_MAX_SUBSCRIBERS; i++) {
+        forward_target_t *t = &s_subscribers[i];
+        if (t->lease_until_us && memcmp(&t->target, target, sizeof(*target)) == 0) {
+            return t;
+        }
+    }
+    return NULL;
+}
+
+static void addr_to_target(const struct sockaddr_in *addr, csi_ctrl_fwd_target_t *target)
+{
+    memcpy(target->ip, &addr->sin_addr.s_addr, sizeof(target->ip));
+    target->port = ntohs(addr->sin_port);
+}
+
+esp_err_t forward_table_subscribe(const struct sockaddr_in *addr, uint32_t lease_s,
+                                  const uint8_t *macs, size_t mac_count, uint32_t *granted_s)
+{
+    csi_ctrl_fwd_target_t target;
+    addr_to_target(addr, &target);
+
+    if (!target_is_valid(&target) || mac_count > FORWARD_TABLE_MAX_FILTERS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 租期已过的订阅者重新订阅时按新订阅者处理，统计从零开始
+    expire_subscribers(esp_timer_get_time());
+    forward_target_t *t = find_subscriber(&target);
+    if (!t) {
+        // 新订阅者占用一个空闲槽位，统计从零开始
+        for (size_t i = 0; i < FORWARD_TABLE_MAX_SUBSCRIBERS && !t; i++) {
+            if (s_subscribers[i].lease_until_us == 0) {
+                t = &s_subscribers[i];
+            }
+        }
+        if (!t) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        memset(t, 0, sizeof(*t));
+        t->target = target;
+        target_to_addr(&target, &t->addr);
+        ESP_LOGI(TAG, "Subscriber " IPSTR ":%d added, %d probe filters",
+                 target.ip[0], target.ip[1], target.ip[2], target.ip[3], target.port, (int)mac_count);
+    }
+
+    if (lease_s == 0) {
+        lease_s = CONFIG_AIRSIGHT_SUBSCRIBE_LEASE_DEFAULT_S;
+    } else if (lease_s > CONFIG_AIRSIGHT_SUBSCRIBE_LEASE_MAX_S) {
+        lease_s = CONFIG_AIRSIGHT_SUBSCRIBE_LEASE_MAX_S;
+    }
+
+    t->lease_until_us = esp_timer_get_time() + (int64_t)lease_s * 1000000;
+    t->mac_count = mac_count;
+    if (mac_count) {
+        memcpy(t->macs, macs, mac_count * 6);
+    }
+    *granted_s = lease_s;
+    return ESP_OK;
+}
+
+void forward_table_unsubscribe(const struct sockaddr_in *addr)
+{
+    csi_ctrl_fwd_target_t target;
+    addr_to_target(addr, &target);
+
+    forward_target_t *t = find_subscriber(&target);
+    if (t) {
+        t->lease_until_us = 0;
+        ESP_LOGI(TAG, "Subscriber " IPSTR ":%d removed",
+                 target.ip[0], target.ip[1], target.ip[2], target.ip[3], target.port);
+    }
+}
+
+// 订阅者是否接收该探针的数据：没有过滤条件或没有探针 MAC（CSV 文本）时都接收
+static bool subscriber_accepts(const forward_target_t *t, const uint8_t *probe_mac)
+{
+    if (t->mac_count == 0 || !probe_mac) {
+        return true;
+    }
+
+    for (size_t i = 0; i < t->mac_count; i++) {
+        if (memcmp(t->macs[i], probe_mac, 6) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 发送失败后更新健康状态：连续失败达到阈值后进入退避，退避中再次失败则退避时间加倍
+static void target_on_failure(forward_target_t *t, int64_t now_us, int err)
+{
+    t->failed++;
+
+    // 本地缓冲区耗尽与目标无关，不计入连续失败
+    if (err == ENOMEM || err == ENOBUFS) {
+        return;
+    }
+
+    if (++t->fail_streak < CONFIG_AIRSIGHT_FORWARD_FAIL_THRESHOLD) {
+        return;
+    }
+
+    if (t->backoff_ms == 0) {
+        t->backoff_ms = CONFIG_AIRSIGHT_FORWARD_BACKOFF_MIN_MS;
+        ESP_LOGW(TAG, IPSTR ":%d failing (errno %d), backing off",
+                 t->target.ip[0], t->target.ip[1], t->target.ip[2], t->target.ip[3], t->target.port, err);
+    } else if (t->backoff_ms < CONFIG_AIRSIGHT_FORWARD_BACKOFF_MAX_MS / 2) {
+        t->backoff_ms *= 2;
+    } else {
+        t->backoff_ms = CONFIG_AIRSIGHT_FORWARD_BACKOFF_MAX_MS;
+    }
+    t->retry_at_us = now_us + (int64_t)t->backoff_ms * 1000;
+}
+
+static void target_on_success(forward_target_t *t, size_t len)
+{
+    t->sent++;
+    t->bytes += len;
+    t->fail_streak = 0;
+
+    if (t->backoff_ms) {
+        t->backoff_ms = 0;
+        ESP_LOGI(TAG, IPSTR ":%d recovered",
+                 t->target.ip[0], t->target.ip[1], t->target.ip[2], t->target.ip[3], t->target.port);
+    }
+}
+
+static bool target_send(int sock, forward_target_t *t, const void *buf, size_t len, int64_t now_us)
+{
+    // 退避期间跳过，到期后发送一次作为探测
+    if (t->backoff_ms && now_us < t->retry_at_us) {
+        t->skipped++;
+        return false;
+    }
+
+    int64_t start = esp_timer_get_time();
+    int ret = sendto(sock, buf, len, 0, (struct sockaddr *)&t->addr, sizeof(t->addr));
+    csi_metric_observe(&s_sendto_us, (uint32_t)(esp_timer_get_time() - start));
+    if (ret < 0) {
+        csi_metric_add(&s_failed, 1);
+        target_on_failure(t, now_us, errno);
+        return false;
+    }
+
+    csi_metric_add(&s_sent, 1);
+    target_on_success(t, len);
+    return true;
+}
+
+int forward_table_send(int sock, const void *buf, size_t len, const uint8_t *probe_mac)
+{
+    int64_t now_us = esp_timer_get_time();
+    int delivered = 0;
+
+    expire_subscribers(now_us);
+    for (size_t i = 0; i < s_target_count; i++) {
+        delivered += target_send(sock, &s_targets[i], buf, len, now_us);
+    }
+
+    if (s_multicast.target.port) {
+        delivered += target_send(sock, &s_multicast, buf, len, now_us);
+    }
+
+    for (size_t i = 0; i < FORWARD_TABLE_MAX_SUBSCRIBERS; i++) {
+        forward_target_t *t = &s_subscribers[i];
+        if (t->lease_until_us && subscriber_accepts(t, probe_mac)) {
+            delivered += target_send(sock, t, buf, len, now_us);
+        }
+    }
+
+    return delivered;
+}
+
+static void target_get_status(const forward_target_t *t, uint8_t kind, csi_ctrl_fwd_status_t *status)
+{
+    memset(status, 0, sizeof(*status));
+    status->target = t->target;
+    status->state = t->backoff_ms ? CSI_CTRL_FWD_STATE_BACKOFF : CSI_CTRL_FWD_STATE_UP;
+    status->kind = kind;
+    status->backoff_ms = t->backoff_ms;
+    status->sent = t->sent;
+    status->failed = t->failed;
+    status->skipped = t->skipped;
+    status->bytes = t->bytes;
+}
+
+size_t forward_table_get_status(csi_ctrl_fwd_status_t *status, size_t max)
+{
+    size_t count = 0;
+
+    expire_subscribers(esp_timer_get_time());
+    for (size_t i = 0; i < s_target_count && count < max; i++) {
+        target_get_status(&s_targets[i], CSI_CTRL_FWD_KIND_STATIC, &status[count++]);
+    }
+
+    if (s_multicast.target.port && count < max) {
+        target_get_status(&s_multicast, CSI_CTRL_FWD_KIND_MULTICAST, &status[count++]);
+    }
+
+    for (size_t i = 0; i < FORWARD_TABLE_MAX_SUBSCRIBERS && count < max; i++) {
+        if (s_subscribers[i].lease_until_us) {
+            target_get_status(&s_subscribers[i], CSI_CTRL_FWD_KIND_SUBSCRIBER, &status[count++]);
+        }
+    }
+
+    return count;
+}
+
+static void target_log(const forward_target_t *t, const char *kind)
+{
+    ESP_LOGI(TAG, "%s " IPSTR ":%d %s sent: %" PRIu32 ", failed: %" PRIu32 ", skipped: %" PRIu32 ", bytes: %" PRIu64,
+             kind, t->target.ip[0], t->target.ip[1], t->target.ip[2], t->target.ip[3], t->target.port,
+             t->backoff_ms ? "BACKOFF" : "UP", t->sent, t->failed, t->skipped, t->bytes);
+}
+
+void forward_table_log(void)
+{
+    expire_subscribers(esp_timer_get_time());
+    for (size_t i = 0; i < s_target_count; i++) {
+        target_log(&s_targets[i], "Target");
+    }
+
+    if (s_multicast.target.port) {
+        target_log(&s_multicast, "Multicast");
+    }
+
+    for (size_t i = 0; i < FORWARD_TABLE_MAX_SUBSCRIBERS; i++) {
+        if (s_subscribers[i].lease_until_us) {
+            target_log(&s_subscribers[i], "Subscriber");
+        }
+    }
+}
+
+void forward_table_put_metrics(csi_metrics_writer_t *writer)
+{
+    csi_metrics_put_counter(writer, CSI_CTRL_METRIC_TX_DATAGRAMS, csi_metric_read(&s_sent));
+    csi_metrics_put_counter(writer, CSI_CTRL_METRIC_TX_FAILED, csi_metric_read(&s_failed));
+    csi_metrics_put_hist(writer, CSI_CTRL_METRIC_SENDTO_US, &s_sendto_us);
+}
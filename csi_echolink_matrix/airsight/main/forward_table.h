@@ -0,0 +1,91 @@
+/**
+ * @file forward_table.h
+ * @brief AirSight 转发目标表
+ *
+ * 转发表在启动时从 NVS 加载，NVS 中没有时使用 Kconfig AIRSIGHT_FORWARD_TARGETS，
+ * 运行时可以通过控制数据报（csi_ctrl.h）替换。除固定目标外，主机还可以发送 SUBSCRIBE
+ * 注册为订阅者：订阅者按租期保留，可按探针 MAC 过滤，过期后不再转发。
+ * 每个目标单独统计 sent/failed/bytes，连续发送失败的目标进入指数退避，退避期间不再占用发送时间。
+ *
+ * 转发表只由 udp_server 任务访问，所有接口都不加锁。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "lwip/sockets.h"
+#include "csi_ctrl.h"
+#include "csi_metrics.h"
+
+/**
+ * @brief 加载转发表：优先 NVS，其次 Kconfig
+ *
+ * 调用前需要先初始化 NVS。
+ */
+esp_err_t forward_table_init(void);
+
+/**
+ * @brief 用新的目标列表替换转发表
+ *
+ * 新旧表中地址相同的目标保留统计和健康状态。
+ *
+ * @param count 为 0 时清空固定目标，只转发给订阅者
+ * @param persist 为 true 时同时写入 NVS
+ * @return ESP_ERR_INVALID_ARG 目标数超过上限或地址非法，此时转发表不变
+ */
+esp_err_t forward_table_set(const csi_ctrl_fwd_target_t *targets, size_t count, bool persist);
+
+/**
+ * @brief 启用局域网组播转发：每个数据报额外向组播组发送一份，不受订阅过滤影响
+ *
+ * 组播 TTL 和出口接口由调用方在 socket 上设置。
+ */
+esp_err_t forward_table_set_multicast(const char *group, uint16_t port);
+
+/**
+ * @brief 新增订阅者或为已有订阅者续约
+ *
+ * @param addr 接收 CSI 数据的地址
+ * @param lease_s 请求的租期（秒），0 表示使用默认值，超过上限时截断
+ * @param macs 探针 MAC 过滤列表，每项 6 字节；mac_count 为 0 时接收所有探针的数据
+ * @param[out] granted_s 实际租期
+ * @return ESP_ERR_NO_MEM 订阅者已满；ESP_ERR_INVALID_ARG 地址非法或过滤条目过多
+ */
+esp_err_t forward_table_subscribe(const struct sockaddr_in *addr, uint32_t lease_s,
+                                  const uint8_t *macs, size_t mac_count, uint32_t *granted_s);
+
+/**
+ * @brief 取消订阅，addr 不是订阅者时忽略
+ */
+void forward_table_unsubscribe(const struct sockaddr_in *addr);
+
+/**
+ * @brief 把一个数据报发送到所有可用的目标
+ *
+ * 退避中的目标、租期已过的订阅者以及过滤条件不匹配的订阅者被跳过。
+ *
+ * @param probe_mac 数据报中第一帧的探针 MAC；CSV 文本没有探针 MAC，传 NULL 时发给所有订阅者
+ * @return 发送成功的目标数
+ */
+int forward_table_send(int sock, const void *buf, size_t len, const uint8_t *probe_mac);
+
+/**
+ * @brief 把各目标（固定目标、组播组、订阅者依次排列）的状态写入 status，最多 max 个
+ *
+ * 租期已过的订阅者先被释放，不出现在状态中。forward_table_log 同样如此。
+ *
+ * @return 写入的条目数
+ */
+size_t forward_table_get_status(csi_ctrl_fwd_status_t *status, size_t max);
+
+/**
+ * @brief 打印各目标的统计和健康状态
+ */
+void forward_table_log(void);
+
+/**
+ * @brief 写入所有目标合计的发送指标：成功和失败的数据报数、每次 sendto 的耗时直方图
+ */
+void forward_table_put_metrics(csi_metrics_writer_t *writer);
@@ -0,0 +1,147 @@
+#include "source_stats.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include "csi_seq.h"
+
+#define SOURCE_STATS_MAX    CONFIG_AIRSIGHT_MAX_SOURCES
+
+static_assert(sizeof(((csi_ctrl_src_status_t *)0)->gaps) == CSI_SEQ_GAP_BUCKETS * sizeof(uint32_t),
+              "csi_ctrl_src_status_t.gaps must match csi_seq");
+
+typedef struct {
+    uint8_t id[6];
+    uint8_t kind;                   // csi_ctrl_src_kind_t
+    int64_t last_us;                // 最近一帧的时刻，0 表示空闲槽位
+    csi_seq_stats_t seq;
+} source_t;
+
+static const char *TAG = "AirSight_src";
+
+static source_t s_sources[SOURCE_STATS_MAX];
+
+// 查找数据源，没有时占用空闲槽位或替换最久没有收到帧的数据源
+static source_t *source_find(const uint8_t id[6], uint8_t kind)
+{
+    source_t *oldest = &s_sources[0];
+
+    for (size_t i = 0; i < SOURCE_STATS_MAX; i++) {
+        source_t *s = &s_sources[i];
+        if (s->last_us && s->kind == kind && memcmp(s->id, id, sizeof(s->id)) == 0) {
+            return s;
+        }
+        if (s->last_us < oldest->last_us) {
+            oldest = s;
+        }
+    }
+
+    if (oldest->last_us) {
+        ESP_LOGW(TAG, "Source table full (%d), dropping the least recently seen source", SOURCE_STATS_MAX);
+    }
+    memset(oldest, 0, sizeof(*oldest));
+    memcpy(oldest->id, id, sizeof(oldest->id));
+    oldest->kind = kind;
+    return oldest;
+}
+
+void source_stats_frame(const csi_frame_hdr_t *hdr, int64_t rx_us)
+{
+    source_t *s = source_find(hdr->probe_mac, CSI_CTRL_SRC_KIND_PROBE);
+    s->last_us = rx_us;
+    csi_seq_update(&s->seq, hdr->seq, true, hdr->local_timestamp, (uint32_t)rx_us);
+}
+
+void source_stats_text(const char *buf, size_t len, const struct sockaddr_in *from, int64_t rx_us)
+{
+    static const char prefix[] = "CSI_DATA,";
+    if (len <= sizeof(prefix) - 1 || memcmp(buf, prefix, sizeof(prefix) - 1) != 0) {
+        return;
+    }
+
+    // 接收缓冲区不以 '\0' 结尾，序号最多 10 位，先拷贝出来
+    char digits[12] = {0};
+    size_t n = MIN(len - (sizeof(prefix) - 1), sizeof(digits) - 1);
+    memcpy(digits, buf + sizeof(prefix) - 1, n);
+
+    uint8_t id[6];
+    memcpy(id, &from->sin_addr.s_addr, 4);
+    memcpy(id + 4, &from->sin_port, 2);
+    source_t *s = source_find(id, CSI_CTRL_SRC_KIND_ADDRESS);
+    s->last_us = rx_us;
+    csi_seq_update(&s->seq, (uint32_t)strtoul(digits, NULL, 10), false, 0, 0);
+}
+
+size_t source_stats_get(csi_ctrl_src_status_t *status, size_t max, bool reset)
+{
+    int64_t now = esp_timer_get_time();
+    size_t count = 0;
+
+    for (size_t i = 0; i < SOURCE_STATS_MAX && count < max; i++) {
+        source_t *s = &s_sources[i];
+        if (!s->last_us) {
+            continue;
+        }
+
+        csi_ctrl_src_status_t *st = &status[count++];
+        memset(st, 0, sizeof(*st));
+        memcpy(st->id, s->id, sizeof(st->id));
+        st->kind = s->kind;
+        st->received = s->seq.received;
+        st->lost = s->seq.lost;
+        st->duplicate = s->seq.duplicate;
+        st->reordered = s->seq.reordered;
+        st->restarts = s->seq.restarts;
+        st->jitter_us = csi_seq_jitter_us(&s->seq);
+        st->last_seq = s->seq.last_seq;
+        st->idle_ms = (uint32_t)((now - s->last_us) / 1000);
+        memcpy(st->gaps, s->seq.gaps, sizeof(st->gaps));
+
+        if (reset) {
+            // 保留序号和抖动状态，下一帧仍按上一帧判断丢失
+            s->seq.received = 0;
+            s->seq.lost = 0;
+            s->seq.duplicate = 0;
+            s->seq.reordered = 0;
+            s->seq.restarts = 0;
+            memset(s->seq.gaps, 0, sizeof(s->seq.gaps));
+        }
+    }
+
+    return count;
+}
+
+void source_stats_log(void)
+{
+    for (size_t i = 0; i < SOURCE_STATS_MAX; i++) {
+        const source_t *s = &s_sources[i];
+        if (!s->last_us) {
+            continue;
+        }
+
+        uint32_t loss_bp = csi_seq_loss_bp(&s->seq);
+        const uint32_t *g = s->seq.gaps;
+        if (s->kind == CSI_CTRL_SRC_KIND_PROBE) {
+            ESP_LOGI(TAG, "Probe " MACSTR " received: %" PRIu32 ", lost: %" PRIu32 " (%" PRIu32 ".%02" PRIu32 "%%), "
+                     "reordered: %" PRIu32 ", dup: %" PRIu32 ", restarts: %" PRIu32 ", jitter: %" PRIu32 " us",
+                     MAC2STR(s->id), s->seq.received, s->seq.lost, loss_bp / 100, loss_bp % 100,
+                     s->seq.reordered, s->seq.duplicate, s->seq.restarts, csi_seq_jitter_us(&s->seq));
+        } else {
+            uint16_t port;
+            memcpy(&port, s->id + 4, sizeof(port));
+            ESP_LOGI(TAG, "Sender " IPSTR ":%d received: %" PRIu32 ", lost: %" PRIu32 " (%" PRIu32 ".%02" PRIu32 "%%), "
+                     "reordered: %" PRIu32 ", dup: %" PRIu32 ", restarts: %" PRIu32,
+                     s->id[0], s->id[1], s->id[2], s->id[3], ntohs(port), s->seq.received, s->seq.lost,
+                     loss_bp / 100, loss_bp % 100, s->seq.reordered, s->seq.duplicate, s->seq.restarts);
+        }
+        if (s->seq.lost) {
+            ESP_LOGI(TAG, "  gaps (frames lost: count) 1: %" PRIu32 ", 2-3: %" PRIu32 ", 4-7: %" PRIu32
+                     ", 8-15: %" PRIu32 ", 16-31: %" PRIu32 ", 32-63: %" PRIu32 ", 64-127: %" PRIu32 ", 128+: %" PRIu32,
+                     g[0], g[1], g[2], g[3], g[4], g[5], g[6], g[7]);
+        }
+    }
+}
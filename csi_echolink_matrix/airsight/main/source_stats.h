@@ -0,0 +1,43 @@
+/**
+ * @file source_stats.h
+ * @brief AirSight 按数据源统计的帧序号
+ *
+ * 二进制帧按 probe_mac 区分数据源，并用帧头的 local_timestamp 估计到达抖动；
+ * CSV 文本按发送端地址区分，序号取第二列。计数规则见 components/csi_seq。
+ * 数据源数量超过 AIRSIGHT_MAX_SOURCES 时，替换最久没有收到帧的数据源。
+ *
+ * 只由 udp_server 任务访问，所有接口都不加锁。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lwip/sockets.h"
+#include "csi_ctrl.h"
+#include "csi_frame.h"
+
+/**
+ * @brief 统计一个二进制帧
+ *
+ * @param rx_us 收到所在数据报的时刻（esp_timer）
+ */
+void source_stats_frame(const csi_frame_hdr_t *hdr, int64_t rx_us);
+
+/**
+ * @brief 统计一行 CSV 文本，不是 "CSI_DATA,<seq>,..." 时忽略
+ */
+void source_stats_text(const char *buf, size_t len, const struct sockaddr_in *from, int64_t rx_us);
+
+/**
+ * @brief 把各数据源的统计写入 status，最多 max 个
+ *
+ * @param reset 为 true 时写入后清零计数
+ * @return 写入的条目数
+ */
+size_t source_stats_get(csi_ctrl_src_status_t *status, size_t max, bool reset);
+
+/**
+ * @brief 打印各数据源的统计
+ */
+void source_stats_log(void);
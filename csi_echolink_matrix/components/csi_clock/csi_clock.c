@@ -0,0 +1,143 @@
+#include "csi_clock.h"
+
+#include <string.h>
+
+static int64_t round_to_int64(double v)
+{
+    return (int64_t)(v >= 0 ? v + 0.5 : v - 0.5);
+}
+
+void csi_clock_init(csi_clock_t *clock, uint32_t max_delay_us)
+{
+    memset(clock, 0, sizeof(*clock));
+    clock->max_delay_us = max_delay_us;
+}
+
+/* 筛选时延接近最小值的测量，拟合 offset = offset_us + (local - local_us) * drift */
+static void csi_clock_fit(csi_clock_t *clock)
+{
+    csi_clock_model_t *model = &clock->model;
+    uint32_t min_delay = UINT32_MAX;
+
+    for (int i = 0; i < clock->count; i++) {
+        if (clock->samples[i].delay_us < min_delay) {
+            min_delay = clock->samples[i].delay_us;
+        }
+    }
+    uint64_t limit = 2ull * min_delay + CSI_CLOCK_DELAY_SLACK_US;
+
+    // 以最新的测量为原点，x 以秒、y 以微秒计，避免双精度的舍入误差
+    const csi_clock_sample_t *origin = &clock->samples[(clock->next + CSI_CLOCK_WINDOW - 1) % CSI_CLOCK_WINDOW];
+    double n = 0, sum_x = 0, sum_y = 0;
+    int64_t first = origin->local_us;
+    for (int i = 0; i < clock->count; i++) {
+        const csi_clock_sample_t *s = &clock->samples[i];
+        if (s->delay_us > limit) {
+            continue;
+        }
+        n++;
+        sum_x += (s->local_us - origin->local_us) / 1e6;
+        sum_y += (double)(s->offset_us - origin->offset_us);
+        if (s->local_us < first) {
+            first = s->local_us;
+        }
+    }
+
+    double mean_x = sum_x / n, mean_y = sum_y / n;
+    double sxx = 0, sxy = 0;
+    for (int i = 0; i < clock->count; i++) {
+        const csi_clock_sample_t *s = &clock->samples[i];
+        if (s->delay_us <= limit) {
+            double dx = (s->local_us - origin->local_us) / 1e6 - mean_x;
+            sxx += dx * dx;
+            sxy += dx * ((double)(s->offset_us - origin->offset_us) - mean_y);
+        }
+    }
+
+    // 斜率单位为 us/s 即 ppm；跨度太短时沿用上一次的频率差
+    double drift_ppm = model->drift_ppb / 1000.0;
+    if (n >= 2 && origin->local_us - first >= CSI_CLOCK_MIN_SPAN_US && sxx > 0) {
+        drift_ppm = sxy / sxx;
+    }
+
+    double residual = 0;
+    for (int i = 0; i < clock->count; i++) {
+        const csi_clock_sample_t *s = &clock->samples[i];
+        if (s->delay_us <= limit) {
+            double dx = (s->local_us - origin->local_us) / 1e6 - mean_x;
+            double r = (double)(s->offset_us - origin->offset_us) - mean_y - drift_ppm * dx;
+            residual += r >= 0 ? r : -r;
+        }
+    }
+
+    model->local_us = origin->local_us + round_to_int64(mean_x * 1e6);
+    model->offset_us = origin->offset_us + round_to_int64(mean_y);
+    model->drift_ppb = (int32_t)round_to_int64(drift_ppm * 1000);
+    model->err_us = min_delay / 2 + (uint32_t)round_to_int64(residual / n);
+    model->synced = true;
+}
+
+bool csi_clock_update(csi_clock_t *clock, int64_t t1, int64_t t2, int64_t t3, int64_t t4)
+{
+    int64_t delay = (t4 - t1) - (t3 - t2);
+
+    if (t4 < t1 || t3 < t2 || delay < 0 || (clock->max_delay_us && delay > clock->max_delay_us)) {
+        return false;
+    }
+
+    csi_clock_sample_t sample = {
+        .local_us = t1 + (t4 - t1) / 2,
+        .offset_us = ((t2 - t1) + (t3 - t4)) / 2,
+        .delay_us = (uint32_t)delay,
+    };
+
+    // 单次测量的偏移误差不超过时延的一半，超出预测值更多说明参考时钟发生了跳变
+    if (clock->model.synced) {
+        int64_t step = sample.offset_us - (csi_clock_to_ref(&clock->model, sample.local_us) - sample.local_us);
+        if (step > CSI_CLOCK_STEP_US + delay / 2 || step < -(CSI_CLOCK_STEP_US + delay / 2)) {
+            clock->count = 0;
+            clock->next = 0;
+            clock->model.drift_ppb = 0;
+            clock->steps++;
+        }
+    }
+
+    clock->samples[clock->next] = sample;
+    clock->next = (clock->next + 1) % CSI_CLOCK_WINDOW;
+    if (clock->count < CSI_CLOCK_WINDOW) {
+        clock->count++;
+    }
+    csi_clock_fit(clock);
+    return true;
+}
+
+int64_t csi_clock_to_ref(const csi_clock_model_t *model, int64_t local_us)
+{
+    if (!model->synced) {
+        return 0;
+    }
+
+    int64_t dt = local_us - model->local_us;
+    return local_us + model->offset_us + dt * model->drift_ppb / 1000000000;
+}
+
+int64_t csi_rx_clock_local(csi_rx_clock_t *rx_clock, uint32_t rx_timestamp, int64_t now_us)
+{
+    uint32_t diff = (uint32_t)now_us - rx_timestamp;
+
+    // 更小的差值说明这一帧的回调延迟更短，立即采用；窗口结束时换成本窗口的最小值，跟踪两个时钟的相对漂移
+    if (!rx_clock->valid || (int32_t)(diff - rx_clock->offset) < 0) {
+        rx_clock->offset = diff;
+        rx_clock->valid = true;
+    }
+    if (rx_clock->count == 0 || (int32_t)(diff - rx_clock->next) < 0) {
+        rx_clock->next = diff;
+    }
+    if (++rx_clock->count >= CSI_RX_CLOCK_WINDOW) {
+        rx_clock->offset = rx_clock->next;
+        rx_clock->count = 0;
+    }
+
+    int32_t latency = (int32_t)(diff - rx_clock->offset);
+    return now_us - (latency > 0 ? latency : 0);
+}
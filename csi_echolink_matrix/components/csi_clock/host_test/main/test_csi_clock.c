@@ -0,0 +1,143 @@
+/**
+ * @file test_csi_clock.c
+ * @brief csi_clock 主机侧单元测试（linux target）
+ */
+#include <stdlib.h>
+#include "unity.h"
+#include "csi_clock.h"
+
+/* 参考时钟比本地时钟快 40 ppm，起点相差 5000 s */
+#define REF_PPM     40
+#define REF_BASE_US 5000000000LL
+
+static int64_t ref_of(int64_t local_us)
+{
+    return REF_BASE_US + local_us + local_us * REF_PPM / 1000000;
+}
+
+static int64_t local_of(int64_t ref_us)
+{
+    return (ref_us - REF_BASE_US) * 1000000 / (1000000 + REF_PPM);
+}
+
+static uint32_t s_lcg = 1;
+
+static uint32_t jitter_us(uint32_t max)
+{
+    s_lcg = s_lcg * 1103515245 + 12345;
+    return (s_lcg >> 8) % max;
+}
+
+/* 一次对时：去程、回程时延各为 800 us 加随机排队时延，每 4 次有一次排队 20 ms */
+static bool exchange(csi_clock_t *clock, int64_t t1)
+{
+    uint32_t queue = jitter_us(4) == 0 ? 20000 : 0;
+    int64_t t2 = ref_of(t1 + 800 + jitter_us(3000) + queue);
+    int64_t t3 = t2 + 50;
+    int64_t t4 = local_of(t3) + 800 + jitter_us(3000);
+    return csi_clock_update(clock, t1, t2, t3, t4);
+}
+
+static void test_converges_to_offset_and_drift(void)
+{
+    csi_clock_t clock;
+    csi_clock_init(&clock, 0);
+    TEST_ASSERT_FALSE(clock.model.synced);
+    TEST_ASSERT_EQUAL_INT64(0, csi_clock_to_ref(&clock.model, 1000));
+
+    int64_t local = 3000000;
+    TEST_ASSERT_TRUE(exchange(&clock, local));
+    TEST_ASSERT_TRUE(clock.model.synced);
+    // 单次测量的误差不超过时延的一半
+    TEST_ASSERT_TRUE(llabs(csi_clock_to_ref(&clock.model, local) - ref_of(local)) < 13000);
+
+    for (int i = 0; i < 60; i++) {
+        local += 2000000;
+        TEST_ASSERT_TRUE(exchange(&clock, local));
+    }
+
+    TEST_ASSERT_TRUE(abs(clock.model.drift_ppb - REF_PPM * 1000) < 3000);
+    TEST_ASSERT_TRUE(clock.model.err_us < 3000);
+    TEST_ASSERT_EQUAL_UINT32(0, clock.steps);
+    // 下一次对时前（2 s 之后）的外推误差
+    for (int64_t t = local; t <= local + 2000000; t += 500000) {
+        TEST_ASSERT_TRUE(llabs(csi_clock_to_ref(&clock.model, t) - ref_of(t)) < 1000);
+    }
+}
+
+static void test_rejects_invalid_exchanges(void)
+{
+    csi_clock_t clock;
+    csi_clock_init(&clock, 10000);
+
+    TEST_ASSERT_FALSE(csi_clock_update(&clock, 1000, 5000, 5100, 900));       // t4 早于 t1
+    TEST_ASSERT_FALSE(csi_clock_update(&clock, 1000, 5100, 5000, 2000));      // t3 早于 t2
+    TEST_ASSERT_FALSE(csi_clock_update(&clock, 1000, 5000, 5100, 12000));     // 时延 10900 us
+    TEST_ASSERT_FALSE(clock.model.synced);
+
+    TEST_ASSERT_TRUE(csi_clock_update(&clock, 1000, 5000, 5100, 3100));
+    TEST_ASSERT_EQUAL_INT64(2050, clock.model.local_us);
+    TEST_ASSERT_EQUAL_INT64(3000, clock.model.offset_us);
+    TEST_ASSERT_EQUAL_UINT32(1000, clock.model.err_us);
+    TEST_ASSERT_EQUAL_INT64(9000, csi_clock_to_ref(&clock.model, 6000));
+}
+
+static void test_restarts_after_reference_step(void)
+{
+    csi_clock_t clock;
+    csi_clock_init(&clock, 0);
+
+    int64_t local = 0;
+    for (int i = 0; i < 20; i++) {
+        local += 2000000;
+        exchange(&clock, local);
+    }
+
+    // 参考端重启：参考时钟回到 0 附近
+    local += 2000000;
+    int64_t t2 = 1000000;
+    TEST_ASSERT_TRUE(csi_clock_update(&clock, local, t2, t2 + 50, local + 1050));
+    TEST_ASSERT_EQUAL_UINT32(1, clock.steps);
+    TEST_ASSERT_EQUAL(1, clock.count);
+    TEST_ASSERT_EQUAL_INT32(0, clock.model.drift_ppb);
+    TEST_ASSERT_TRUE(llabs(csi_clock_to_ref(&clock.model, local + 525) - (t2 + 25)) <= 1);
+}
+
+static void test_rx_clock_removes_callback_latency(void)
+{
+    csi_rx_clock_t rx_clock = {0};
+    // 接收时间戳与本地时钟的起点不同，且在测试中途回绕
+    const uint32_t mac_base = 0xFFFF0000u;
+    int64_t rx = 10000000;
+
+    for (int i = 0; i < 2000; i++, rx += 10000) {
+        uint32_t latency = 60 + (i % 7 == 0 ? 0 : jitter_us(2000));
+        uint32_t rx_timestamp = mac_base + (uint32_t)rx;
+        int64_t now = rx + latency;
+        int64_t local = csi_rx_clock_local(&rx_clock, rx_timestamp, now);
+        TEST_ASSERT_TRUE(local <= now);
+        if (i > 0) {
+            TEST_ASSERT_EQUAL_INT64(rx + 60, local);   // 只剩最小回调延迟
+        }
+    }
+
+    // 接收时间戳的起点变化（如 MAC 定时器被重置）：至多两个窗口之后恢复
+    for (int i = 0; i < CSI_RX_CLOCK_WINDOW * 3; i++, rx += 10000) {
+        uint32_t rx_timestamp = (uint32_t)rx - 5000000;
+        int64_t local = csi_rx_clock_local(&rx_clock, rx_timestamp, rx + 100);
+        if (i >= CSI_RX_CLOCK_WINDOW * 2) {
+            TEST_ASSERT_EQUAL_INT64(rx + 100, local);
+        }
+    }
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_converges_to_offset_and_drift);
+    RUN_TEST(test_rejects_invalid_exchanges);
+    RUN_TEST(test_restarts_after_reference_step);
+    RUN_TEST(test_rx_clock_removes_callback_latency);
+    int failures = UNITY_END();
+    exit(failures);
+}
@@ -0,0 +1,9 @@
+# SPDX-License-Identifier: Unlicense OR CC0-1.0
+import pytest
+from pytest_embedded import Dut
+
+
+@pytest.mark.linux
+@pytest.mark.host_test
+def test_csi_clock_host(dut: Dut) -> None:
+    dut.expect(r'\d+ Tests 0 Failures 0 Ignored', timeout=60)
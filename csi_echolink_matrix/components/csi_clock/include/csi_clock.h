@@ -0,0 +1,105 @@
+/**
+ * @file csi_clock.h
+ * @brief 探针时钟与参考时钟（AirSight 或主机）的同步估计
+ *
+ * 对时为 SNTP 式的一次往返：探针在本地时刻 t1 发出请求，参考端在 t2 收到、t3 发出应答，
+ * 探针在 t4 收到。偏移 offset = ((t2 - t1) + (t3 - t4)) / 2，往返时延 delay = (t4 - t1) - (t3 - t2)。
+ * 无线信道的排队时延使单次测量的误差可达数毫秒，因此：
+ * - 保留最近 CSI_CLOCK_WINDOW 次测量，只用时延不超过窗口内最小时延 2 倍加 CSI_CLOCK_DELAY_SLACK_US 的测量；
+ * - 对这些测量的偏移按本地时间做最小二乘直线拟合，斜率即两个晶振的频率差（drift_ppb）；
+ * - 偏移与预测值相差超过 CSI_CLOCK_STEP_US（参考端重启、换了参考端）时丢弃历史重新开始。
+ *
+ * csi_rx_clock_t 把 Wi-Fi 接收时间戳（rx_ctrl.timestamp，32 位微秒，与本地时钟的起点不同）
+ * 换算到本地时钟：回调时刻的本地时钟减去接收时间戳，等于两个时钟的差加上回调延迟，
+ * 取一段时间内的最小值即去掉了回调延迟。
+ *
+ * 只依赖 C 标准头文件，可在主机上编译并运行单元测试（见 host_test）。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_CLOCK_WINDOW            32          /*!< 参与拟合的最近测量次数 */
+#define CSI_CLOCK_DELAY_SLACK_US    500         /*!< 时延筛选的余量 */
+#define CSI_CLOCK_MIN_SPAN_US       1000000     /*!< 测量跨度不足 1 s 时不估计频率差 */
+#define CSI_CLOCK_STEP_US           50000       /*!< 偏移跳变超过该值时重新开始 */
+#define CSI_RX_CLOCK_WINDOW         256         /*!< 接收时间戳换算的最小值窗口（帧数） */
+
+/** 一次对时测量 */
+typedef struct {
+    int64_t  local_us;          /*!< 测量时刻（(t1 + t4) / 2，本地时钟） */
+    int64_t  offset_us;         /*!< 参考时钟 - 本地时钟 */
+    uint32_t delay_us;          /*!< 往返时延 */
+} csi_clock_sample_t;
+
+/**
+ * 时钟模型：本地时间 t 对应的参考时间为 t + offset_us + (t - local_us) * drift_ppb / 1e9。
+ * drift_ppb 为参考时钟相对本地时钟每秒多走的纳秒数，即探针晶振相对参考端的频率误差取反。
+ */
+typedef struct {
+    int64_t  local_us;          /*!< 拟合的参考点（本地时钟） */
+    int64_t  offset_us;         /*!< 参考点处的偏移 */
+    int32_t  drift_ppb;
+    uint32_t err_us;            /*!< 误差估计：最小时延的一半加拟合残差的平均绝对值 */
+    bool     synced;            /*!< 至少有一次有效测量 */
+} csi_clock_model_t;
+
+typedef struct {
+    csi_clock_sample_t samples[CSI_CLOCK_WINDOW];
+    uint8_t  count;
+    uint8_t  next;
+    uint32_t max_delay_us;      // 时延超过该值的测量直接丢弃
+    uint32_t steps;             // 因偏移跳变而重新开始的次数
+    csi_clock_model_t model;
+} csi_clock_t;
+
+/** 接收时间戳换算状态，由 CSI 回调独占 */
+typedef struct {
+    uint32_t offset;            // 本地时钟低 32 位 - 接收时间戳 的当前估计
+    uint32_t next;              // 本窗口内的最小值，窗口结束时替换 offset
+    uint16_t count;
+    bool     valid;
+} csi_rx_clock_t;
+
+/**
+ * @brief 初始化同步估计
+ *
+ * @param max_delay_us 往返时延超过该值的测量直接丢弃，0 表示不限制
+ */
+void csi_clock_init(csi_clock_t *clock, uint32_t max_delay_us);
+
+/**
+ * @brief 输入一次对时测量，更新 clock->model
+ *
+ * @param t1 请求发出时刻（本地时钟）
+ * @param t2 参考端收到请求的时刻（参考时钟）
+ * @param t3 参考端发出应答的时刻（参考时钟）
+ * @param t4 收到应答的时刻（本地时钟）
+ * @return 测量被采用时返回 true；时间顺序错误或时延超过 max_delay_us 时返回 false
+ */
+bool csi_clock_update(csi_clock_t *clock, int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+
+/**
+ * @brief 本地时间换算为参考时间
+ *
+ * @return 参考时钟的微秒数；尚未同步时返回 0
+ */
+int64_t csi_clock_to_ref(const csi_clock_model_t *model, int64_t local_us);
+
+/**
+ * @brief 把一帧的接收时间戳换算为本地时钟
+ *
+ * @param rx_timestamp rx_ctrl.timestamp
+ * @param now_us 回调中读取的本地时钟
+ * @return 接收时刻（本地时钟），不晚于 now_us
+ */
+int64_t csi_rx_clock_local(csi_rx_clock_t *rx_clock, uint32_t rx_timestamp, int64_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
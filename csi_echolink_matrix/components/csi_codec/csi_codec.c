@@ -0,0 +1,177 @@
+#include "csi_codec.h"
+
+#include <string.h>
+
+// 位平面与 32/64 位字的换算假定小端字节序（ESP32 与 x86、ARM64 主机相同）
+#define ONES32  0x01010101u
+#define ONES64  0x0101010101010101ull
+
+static inline int8_t quantize(int8_t x, unsigned quant)
+{
+    if (quant == 0) {
+        return x;
+    }
+    // 四舍五入，正向饱和：127 >> quant 左移还原后仍在 int8 范围内
+    int v = (x + (1 << (quant - 1))) >> quant;
+    int max = 127 >> quant;
+    return (int8_t)(v > max ? max : v);
+}
+
+static inline uint8_t zigzag(int8_t r)
+{
+    return (uint8_t)(((uint8_t)r << 1) ^ (uint8_t)(r >> 7));
+}
+
+static inline unsigned bit_width(uint8_t v)
+{
+    return v ? 32 - (unsigned)__builtin_clz(v) : 0;
+}
+
+/**
+ * 位平面 j：4 个字节各自的第 j 位移到最低位后，乘以 0x01020408 把它们汇集到最高字节的低 4 位
+ */
+static inline uint8_t plane_byte(uint32_t lo, uint32_t hi, unsigned j)
+{
+    uint32_t a = (((lo >> j) & ONES32) * 0x01020408u) >> 24;
+    uint32_t b = (((hi >> j) & ONES32) * 0x01020408u) >> 24;
+    return (uint8_t)(a | b << 4);
+}
+
+size_t csi_codec_encode(const int8_t *iq, size_t n, unsigned quant, uint8_t *out, size_t limit)
+{
+    size_t blocks = CSI_CODEC_PADDED(n) / CSI_CODEC_BLOCK;
+    size_t pos = (blocks + 1) / 2;
+    int8_t prev[2] = {0, 0};    // 前一个子载波的虚部、实部（量化后）
+
+    if (quant > CSI_CODEC_MAX_QUANT || pos > limit) {
+        return 0;
+    }
+    memset(out, 0, pos);
+
+    for (size_t b = 0; b < blocks; b++) {
+        const int8_t *src = iq + b * CSI_CODEC_BLOCK;
+        size_t count = n - b * CSI_CODEC_BLOCK < CSI_CODEC_BLOCK ? n - b * CSI_CODEC_BLOCK : CSI_CODEC_BLOCK;
+        uint8_t zz[CSI_CODEC_BLOCK] = {0};
+        uint8_t any = 0;
+
+        // 块大小为偶数，块内第 k 个值与全局下标的奇偶性相同
+        for (size_t k = 0; k < count; k++) {
+            int8_t v = quantize(src[k], quant);
+            zz[k] = zigzag((int8_t)(v - prev[k & 1]));
+            prev[k & 1] = v;
+            any |= zz[k];
+        }
+
+        unsigned w = bit_width(any);
+        if (pos + w > limit) {
+            return 0;
+        }
+        out[b / 2] |= (uint8_t)(w << (4 * (b & 1)));
+
+        uint32_t lo, hi;
+        memcpy(&lo, zz, 4);
+        memcpy(&hi, zz + 4, 4);
+        for (unsigned j = 0; j < w; j++) {
+            out[pos + j] = plane_byte(lo, hi, j);
+        }
+        pos += w;
+    }
+
+    return pos;
+}
+
+/**
+ * 位平面字节展开为 8 个字节：第 k 位 -> 第 k 个字节的最低位
+ */
+static inline uint64_t spread_plane(uint8_t p)
+{
+    uint64_t t = (p * ONES64) & 0x8040201008040201ull;
+    // 非零字节的最高位置 1（各字节相加不会进位），再移到最低位
+    return (((t + 0x7F7F7F7F7F7F7F7Full) | t) >> 7) & ONES64;
+}
+
+size_t csi_codec_unpack(const uint8_t *in, size_t size, size_t n, uint8_t *zz)
+{
+    size_t blocks = CSI_CODEC_PADDED(n) / CSI_CODEC_BLOCK;
+    size_t pos = (blocks + 1) / 2;
+
+    if (pos > size) {
+        return 0;
+    }
+
+    for (size_t b = 0; b < blocks; b++) {
+        unsigned w = (in[b / 2] >> (4 * (b & 1))) & 0x0F;
+        if (w > 8 || pos + w > size) {
+            return 0;
+        }
+
+        uint64_t v = 0;
+        for (unsigned j = 0; j < w; j++) {
+            v |= spread_plane(in[pos + j]) << j;
+        }
+        memcpy(zz + b * CSI_CODEC_BLOCK, &v, CSI_CODEC_BLOCK);
+        pos += w;
+    }
+
+    return pos;
+}
+
+void csi_codec_reconstruct(const uint8_t *zz, size_t n, unsigned quant, int8_t *iq)
+{
+    uint8_t prev[2] = {0, 0};
+
+    for (size_t i = 0; i < n; i++) {
+        uint8_t r = (uint8_t)((zz[i] >> 1) ^ (uint8_t)-(zz[i] & 1));
+        prev[i & 1] = (uint8_t)(prev[i & 1] + r);
+        iq[i] = (int8_t)(uint8_t)(prev[i & 1] << quant);
+    }
+}
+
+size_t csi_codec_pack(const int8_t *iq, size_t n, unsigned quant, uint8_t *out)
+{
+    csi_codec_hdr_t hdr = {
+        .info = CSI_CODEC_INFO(n, quant),
+    };
+
+    if (n <= sizeof(hdr) || n > CSI_FRAME_MAX_PAYLOAD) {
+        return 0;
+    }
+
+    // 只接受比原始数据短的结果
+    size_t size = csi_codec_encode(iq, n, quant, out + sizeof(hdr), n - sizeof(hdr) - 1);
+    if (size == 0) {
+        return 0;
+    }
+    memcpy(out, &hdr, sizeof(hdr));
+    return sizeof(hdr) + size;
+}
+
+const csi_codec_hdr_t *csi_codec_check(const void *data, size_t len)
+{
+    const csi_codec_hdr_t *hdr = (const csi_codec_hdr_t *)data;
+
+    if (len < sizeof(csi_codec_hdr_t)) {
+        return NULL;
+    }
+
+    size_t n = CSI_CODEC_RAW_LEN(hdr->info);
+    if (n == 0 || n > CSI_FRAME_MAX_PAYLOAD || CSI_CODEC_QUANT(hdr->info) > CSI_CODEC_MAX_QUANT) {
+        return NULL;
+    }
+
+    return hdr;
+}
+
+size_t csi_codec_unpack_frame(const void *data, size_t len, int8_t *iq, size_t iq_size)
+{
+    uint8_t zz[CSI_CODEC_PADDED(CSI_FRAME_MAX_PAYLOAD)];
+    const csi_codec_hdr_t *hdr = csi_codec_check(data, len);
+    size_t n = hdr ? CSI_CODEC_RAW_LEN(hdr->info) : 0;
+
+    if (!hdr || n > iq_size || !csi_codec_unpack((const uint8_t *)(hdr + 1), len - sizeof(*hdr), n, zz)) {
+        return 0;
+    }
+
+    csi_codec_reconstruct(zz, n, CSI_CODEC_QUANT(hdr->info), iq);
+    return n;
+}
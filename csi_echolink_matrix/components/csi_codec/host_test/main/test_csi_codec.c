@@ -0,0 +1,164 @@
+/**
+ * @file test_csi_codec.c
+ * @brief csi_codec 主机侧单元测试（linux target）
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "csi_codec.h"
+
+// 类似 LLTF 的一帧：子载波间平滑变化，两端和中间为空子载波（0）
+static void make_frame(int8_t *iq, size_t n, unsigned seed)
+{
+    srand(seed);
+    for (size_t i = 0; i < n; i++) {
+        size_t sub = i / 2;
+        if (sub < 6 || sub == 32 || sub > 58) {
+            iq[i] = 0;
+            continue;
+        }
+        int base = (i & 1) ? 20 - (int)sub / 3 : (int)sub / 2 - 15;
+        iq[i] = (int8_t)(base + rand() % 5 - 2);
+    }
+}
+
+static void test_lossless_round_trip(void)
+{
+    static const size_t lengths[] = {128, 256, 384, 612, 126, 2};
+    int8_t iq[CSI_FRAME_MAX_PAYLOAD], out[CSI_FRAME_MAX_PAYLOAD];
+    uint8_t enc[CSI_CODEC_MAX_SIZE(CSI_FRAME_MAX_PAYLOAD)];
+    uint8_t zz[CSI_CODEC_PADDED(CSI_FRAME_MAX_PAYLOAD)];
+
+    for (size_t t = 0; t < sizeof(lengths) / sizeof(lengths[0]); t++) {
+        size_t n = lengths[t];
+        make_frame(iq, n, (unsigned)t);
+        size_t size = csi_codec_encode(iq, n, 0, enc, sizeof(enc));
+        TEST_ASSERT_GREATER_THAN(0, size);
+        TEST_ASSERT_LESS_OR_EQUAL(CSI_CODEC_MAX_SIZE(n), size);
+
+        TEST_ASSERT_EQUAL(size, csi_codec_unpack(enc, size, n, zz));
+        csi_codec_reconstruct(zz, n, 0, out);
+        TEST_ASSERT_EQUAL_INT8_ARRAY(iq, out, n);
+
+        // 数据不完整
+        TEST_ASSERT_EQUAL(0, csi_codec_unpack(enc, size - 1, n, zz));
+    }
+}
+
+static void test_full_range(void)
+{
+    int8_t iq[256], out[256];
+    uint8_t enc[CSI_CODEC_MAX_SIZE(256)];
+    uint8_t zz[CSI_CODEC_PADDED(256)];
+
+    // 所有取值，相邻值跳变最大（位宽为 8）
+    for (size_t i = 0; i < 256; i++) {
+        iq[i] = (int8_t)(i & 1 ? i : 255 - i);
+    }
+    iq[0] = -128;
+    iq[1] = 127;
+
+    size_t size = csi_codec_encode(iq, 256, 0, enc, sizeof(enc));
+    TEST_ASSERT_GREATER_THAN(0, size);
+    TEST_ASSERT_EQUAL(size, csi_codec_unpack(enc, size, 256, zz));
+    csi_codec_reconstruct(zz, 256, 0, out);
+    TEST_ASSERT_EQUAL_INT8_ARRAY(iq, out, 256);
+
+    // 超过 limit 时返回 0
+    TEST_ASSERT_EQUAL(0, csi_codec_encode(iq, 256, 0, enc, 100));
+    TEST_ASSERT_EQUAL(0, csi_codec_encode(iq, 256, CSI_CODEC_MAX_QUANT + 1, enc, sizeof(enc)));
+}
+
+static void test_quantization_error(void)
+{
+    int8_t iq[256], out[256];
+    uint8_t enc[CSI_CODEC_MAX_SIZE(256)];
+    uint8_t zz[CSI_CODEC_PADDED(256)];
+
+    for (size_t i = 0; i < 256; i++) {
+        iq[i] = (int8_t)(i - 128);
+    }
+
+    size_t prev = sizeof(enc);
+    for (unsigned q = 1; q <= CSI_CODEC_MAX_QUANT; q++) {
+        make_frame(iq, 128, q);
+        size_t size = csi_codec_encode(iq, 256, q, enc, sizeof(enc));
+        TEST_ASSERT_GREATER_THAN(0, size);
+        TEST_ASSERT_LESS_THAN(prev, size);
+        prev = size;
+
+        TEST_ASSERT_EQUAL(size, csi_codec_unpack(enc, size, 256, zz));
+        csi_codec_reconstruct(zz, 256, q, out);
+        int half = 1 << (q - 1);
+        for (size_t i = 0; i < 256; i++) {
+            if (iq[i] > 127 - half) {
+                TEST_ASSERT_EQUAL_INT8((127 >> q) << q, out[i]);
+                continue;
+            }
+            TEST_ASSERT_LESS_OR_EQUAL(half, abs(out[i] - iq[i]));
+            if (iq[i] == 0) {
+                TEST_ASSERT_EQUAL_INT8(0, out[i]);
+            }
+        }
+    }
+}
+
+static void test_frame_pack(void)
+{
+    int8_t iq[128], out[128];
+    uint8_t data[128];
+
+    make_frame(iq, sizeof(iq), 7);
+    size_t len = csi_codec_pack(iq, sizeof(iq), 0, data);
+    TEST_ASSERT_GREATER_THAN(0, len);
+    TEST_ASSERT_LESS_THAN(sizeof(iq), len);
+
+    const csi_codec_hdr_t *hdr = csi_codec_check(data, len);
+    TEST_ASSERT_NOT_NULL(hdr);
+    TEST_ASSERT_EQUAL(sizeof(iq), CSI_CODEC_RAW_LEN(hdr->info));
+    TEST_ASSERT_EQUAL(0, CSI_CODEC_QUANT(hdr->info));
+
+    TEST_ASSERT_EQUAL(sizeof(iq), csi_codec_unpack_frame(data, len, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_INT8_ARRAY(iq, out, sizeof(iq));
+    TEST_ASSERT_EQUAL(0, csi_codec_unpack_frame(data, len, out, sizeof(out) - 1));
+    TEST_ASSERT_EQUAL(0, csi_codec_unpack_frame(data, len - 1, out, sizeof(out)));
+
+    // 噪声无法压缩：调用方按原始帧发送
+    srand(11);
+    for (size_t i = 0; i < sizeof(iq); i++) {
+        iq[i] = (int8_t)rand();
+    }
+    TEST_ASSERT_EQUAL(0, csi_codec_pack(iq, sizeof(iq), 0, data));
+}
+
+static void test_frame_iter(void)
+{
+    uint8_t buf[sizeof(csi_frame_hdr_t) + 128];
+    int8_t iq[128];
+    csi_frame_hdr_t hdr;
+
+    make_frame(iq, sizeof(iq), 3);
+    csi_frame_hdr_init(&hdr, CSI_FRAME_TYPE_PACKED);
+    hdr.len = (uint16_t)csi_codec_pack(iq, sizeof(iq), 1, buf + sizeof(hdr));
+    memcpy(buf, &hdr, sizeof(hdr));
+
+    // 单独发送的压缩帧可以被遍历
+    csi_frame_iter_t it;
+    csi_frame_iter_init(&it, buf, sizeof(hdr) + hdr.len);
+    const csi_frame_hdr_t *frame = csi_frame_iter_next(&it);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL(CSI_FRAME_TYPE_PACKED, frame->type);
+    TEST_ASSERT_NULL(csi_frame_iter_next(&it));
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_lossless_round_trip);
+    RUN_TEST(test_full_range);
+    RUN_TEST(test_quantization_error);
+    RUN_TEST(test_frame_pack);
+    RUN_TEST(test_frame_iter);
+    int failures = UNITY_END();
+    exit(failures);
+}
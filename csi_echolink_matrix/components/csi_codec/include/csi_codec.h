@@ -0,0 +1,93 @@
+/**
+ * @file csi_codec.h
+ * @brief CSI I/Q 压缩：沿子载波方向差分 + 按块位平面打包，可选舍去低位的有损模式
+ *
+ * 编码步骤（n 个 int8，虚部、实部交替）：
+ * 1. 量化：quant > 0 时每个值四舍五入地右移 quant 位，解码时左移还原，误差不超过 2^(quant-1)
+ *    （大于 127 - 2^(quant-1) 的值还原为 (127 >> quant) << quant）；
+ * 2. 差分：虚部、实部各自减去前一个子载波的同一分量（x[i] - x[i-2]，按 8 位回绕），
+ *    相邻子载波的信道响应相近，差值集中在 0 附近；
+ * 3. zigzag：有符号差值映射为无符号数（0, -1, 1, -2 ... -> 0, 1, 2, 3 ...）；
+ * 4. 打包：每 CSI_CODEC_BLOCK 个值为一块，块的位宽 w 为块内最大值的有效位数（0..8，存为 4 位），
+ *    块内容为 w 个位平面字节（第 j 个字节的第 k 位是块内第 k 个值的第 j 位），末尾不足一块时补 0。
+ *
+ * 编码结果：ceil(块数 / 2) 字节的位宽表（每字节两个块，低 4 位在前），之后依次为各块的位平面。
+ *
+ * 不做帧间（时间方向）差分：载波频率偏移使每帧的相位整体旋转，相邻帧的 I/Q 差值并不比
+ * 子载波间的差值小；每帧独立解码也不受 UDP 丢包影响。
+ * 位平面布局使编码在 ESP32 上按 32 位字处理（每个位平面一次乘法），解码可以用 SIMD 展开，
+ * 不使用变长码（Rice/Huffman）逐值串行解析。
+ *
+ * 只依赖 C 标准头文件，可在主机上编译并运行单元测试（见 host_test）。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "csi_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 每块的值个数 */
+#define CSI_CODEC_BLOCK         8
+
+/** 量化位数上限 */
+#define CSI_CODEC_MAX_QUANT     3
+
+/** n 个值按块补齐后的长度，csi_codec_unpack() 的输出缓冲区大小 */
+#define CSI_CODEC_PADDED(n)     (((n) + CSI_CODEC_BLOCK - 1) / CSI_CODEC_BLOCK * CSI_CODEC_BLOCK)
+
+/** n 个值编码后的最大长度（每块都是 8 个位平面） */
+#define CSI_CODEC_MAX_SIZE(n)   ((CSI_CODEC_PADDED(n) / CSI_CODEC_BLOCK + 1) / 2 + CSI_CODEC_PADDED(n))
+
+/**
+ * @brief 编码 n 个 int8 I/Q
+ *
+ * @param quant 舍去的低位数，0 .. CSI_CODEC_MAX_QUANT
+ * @param limit out 的大小；编码结果超过 limit 时停止
+ * @return 编码长度，超过 limit（或参数非法）时返回 0
+ */
+size_t csi_codec_encode(const int8_t *iq, size_t n, unsigned quant, uint8_t *out, size_t limit);
+
+/**
+ * @brief 解码的第一步：展开位平面，得到 zigzag 形式的差值
+ *
+ * @param zz 至少 CSI_CODEC_PADDED(n) 字节
+ * @return 读取的字节数，数据不完整或位宽非法时返回 0
+ */
+size_t csi_codec_unpack(const uint8_t *in, size_t size, size_t n, uint8_t *zz);
+
+/**
+ * @brief 解码的第二步：还原差值，沿子载波方向累加并反量化（主机侧有 SIMD 实现，见 datastorage/native）
+ */
+void csi_codec_reconstruct(const uint8_t *zz, size_t n, unsigned quant, int8_t *iq);
+
+/**
+ * @brief 编码 CSI_FRAME_TYPE_PACKED 帧的数据区（csi_codec_hdr_t + 编码后的 I/Q）
+ *
+ * @param out 至少 n 字节
+ * @return 数据区长度；不比原始 I/Q 短时返回 0，调用方改为发送 CSI_FRAME_TYPE_RAW 帧
+ */
+size_t csi_codec_pack(const int8_t *iq, size_t n, unsigned quant, uint8_t *out);
+
+/**
+ * @brief 校验 CSI_FRAME_TYPE_PACKED 帧的数据区
+ *
+ * @return 数据区头部，编码数据紧随其后；I/Q 长度为 0 或超过 CSI_FRAME_MAX_PAYLOAD、量化位数非法时返回 NULL
+ */
+const csi_codec_hdr_t *csi_codec_check(const void *data, size_t len);
+
+/**
+ * @brief 解码 CSI_FRAME_TYPE_PACKED 帧的数据区
+ *
+ * @param iq 至少 iq_size 字节
+ * @return 解码后的 I/Q 字节数，数据非法或超过 iq_size 时返回 0
+ */
+size_t csi_codec_unpack_frame(const void *data, size_t len, int8_t *iq, size_t iq_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,45 @@
+#include "csi_cpu.h"
+
+static const csi_cpu_task_t *find_task(const csi_cpu_snapshot_t *snap, uint32_t id)
+{
+    for (uint32_t i = 0; i < snap->count; i++) {
+        if (snap->tasks[i].id == id) {
+            return &snap->tasks[i];
+        }
+    }
+    return NULL;
+}
+
+size_t csi_cpu_usage(const csi_cpu_snapshot_t *prev, const csi_cpu_snapshot_t *now,
+                     csi_cpu_usage_t *out, size_t max)
+{
+    uint32_t elapsed = now->time - prev->time;
+    size_t count = 0;
+
+    if (elapsed == 0) {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < now->count && count < max; i++) {
+        const csi_cpu_task_t *task = &now->tasks[i];
+        const csi_cpu_task_t *before = find_task(prev, task->id);
+        uint32_t runtime = task->runtime - (before ? before->runtime : 0);
+
+        // 计数器的读取与快照时刻不是同一瞬间，结果可能略超过 1000
+        uint64_t permille = ((uint64_t)runtime * 1000 + elapsed / 2) / elapsed;
+        csi_cpu_usage_t usage = {
+            .task = task,
+            .permille = permille > 1000 ? 1000 : (uint32_t)permille,
+        };
+
+        // 插入排序，任务数很少
+        size_t pos = count++;
+        while (pos > 0 && out[pos - 1].permille < usage.permille) {
+            out[pos] = out[pos - 1];
+            pos--;
+        }
+        out[pos] = usage;
+    }
+
+    return count;
+}
@@ -0,0 +1,57 @@
+#include "csi_cpu.h"
+
+#include <inttypes.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+bool csi_cpu_snapshot(csi_cpu_snapshot_t *snap)
+{
+    static TaskStatus_t status[CSI_CPU_MAX_TASKS];
+    configRUN_TIME_COUNTER_TYPE total = 0;
+
+    // 任务数超过数组大小时返回 0
+    UBaseType_t count = uxTaskGetSystemState(status, CSI_CPU_MAX_TASKS, &total);
+    if (count == 0) {
+        return false;
+    }
+
+    snap->time = (uint32_t)total;
+    snap->count = count;
+    for (UBaseType_t i = 0; i < count; i++) {
+        csi_cpu_task_t *task = &snap->tasks[i];
+        BaseType_t core = xTaskGetCoreID(status[i].xHandle);
+
+        task->id = status[i].xTaskNumber;
+        task->runtime = (uint32_t)status[i].ulRunTimeCounter;
+        task->stack_free = status[i].usStackHighWaterMark;
+        task->core = core == tskNO_AFFINITY ? CSI_CPU_NO_AFFINITY : (uint8_t)core;
+        task->priority = (uint8_t)status[i].uxCurrentPriority;
+        strlcpy(task->name, status[i].pcTaskName, sizeof(task->name));
+    }
+    return true;
+}
+#else
+bool csi_cpu_snapshot(csi_cpu_snapshot_t *snap)
+{
+    (void)snap;
+    return false;
+}
+#endif
+
+void csi_cpu_log(const char *tag, const csi_cpu_snapshot_t *prev, const csi_cpu_snapshot_t *now)
+{
+    csi_cpu_usage_t usage[CSI_CPU_MAX_TASKS];
+    size_t count = csi_cpu_usage(prev, now, usage, CSI_CPU_MAX_TASKS);
+
+    for (size_t i = 0; i < count && usage[i].permille > 0; i++) {
+        const csi_cpu_task_t *task = usage[i].task;
+        char core = task->core == CSI_CPU_NO_AFFINITY ? '-' : (char)('0' + task->core);
+        ESP_LOGI(tag, "CPU: %-16s core %c prio %2u %3" PRIu32 ".%" PRIu32 "%%, stack free %" PRIu32,
+                 task->name, core, task->priority, usage[i].permille / 10, usage[i].permille % 10,
+                 task->stack_free);
+    }
+}
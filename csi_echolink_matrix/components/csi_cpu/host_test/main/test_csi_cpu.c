@@ -0,0 +1,99 @@
+/**
+ * @file test_csi_cpu.c
+ * @brief csi_cpu 主机侧单元测试（linux target）
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "csi_cpu.h"
+
+static void add_task(csi_cpu_snapshot_t *snap, uint32_t id, const char *name, uint32_t runtime, uint8_t core)
+{
+    csi_cpu_task_t *task = &snap->tasks[snap->count++];
+    memset(task, 0, sizeof(*task));
+    task->id = id;
+    task->runtime = runtime;
+    task->core = core;
+    strncpy(task->name, name, sizeof(task->name) - 1);
+}
+
+static void test_usage_sorted(void)
+{
+    csi_cpu_snapshot_t prev = {.time = 1000}, now = {.time = 11000};
+    csi_cpu_usage_t usage[CSI_CPU_MAX_TASKS];
+
+    add_task(&prev, 1, "IDLE0", 500, 0);
+    add_task(&prev, 2, "wifi", 200, 0);
+    add_task(&prev, 3, "csi_sender", 100, 1);
+    add_task(&prev, 4, "IDLE1", 300, 1);
+
+    // 顺序与 prev 不同，按 id 对应
+    add_task(&now, 4, "IDLE1", 300 + 7000, 1);
+    add_task(&now, 3, "csi_sender", 100 + 3000, 1);
+    add_task(&now, 2, "wifi", 200 + 1500, 0);
+    add_task(&now, 1, "IDLE0", 500 + 8500, 0);
+
+    size_t count = csi_cpu_usage(&prev, &now, usage, CSI_CPU_MAX_TASKS);
+    TEST_ASSERT_EQUAL(4, count);
+    TEST_ASSERT_EQUAL_STRING("IDLE0", usage[0].task->name);
+    TEST_ASSERT_EQUAL_UINT32(850, usage[0].permille);
+    TEST_ASSERT_EQUAL_STRING("IDLE1", usage[1].task->name);
+    TEST_ASSERT_EQUAL_UINT32(700, usage[1].permille);
+    TEST_ASSERT_EQUAL_STRING("csi_sender", usage[2].task->name);
+    TEST_ASSERT_EQUAL_UINT32(300, usage[2].permille);
+    TEST_ASSERT_EQUAL_STRING("wifi", usage[3].task->name);
+    TEST_ASSERT_EQUAL_UINT32(150, usage[3].permille);
+
+    // 输出项数受 max 限制
+    TEST_ASSERT_EQUAL(2, csi_cpu_usage(&prev, &now, usage, 2));
+
+    // 同一时刻的两次快照
+    TEST_ASSERT_EQUAL(0, csi_cpu_usage(&now, &now, usage, CSI_CPU_MAX_TASKS));
+}
+
+static void test_usage_wraps(void)
+{
+    csi_cpu_snapshot_t prev = {.time = 0xFFFFF000u}, now = {.time = 0x00001000u};
+    csi_cpu_usage_t usage[CSI_CPU_MAX_TASKS];
+
+    // 计数器在两次快照之间回绕
+    add_task(&prev, 7, "ping", 0xFFFFFC00u, CSI_CPU_NO_AFFINITY);
+    add_task(&now, 7, "ping", 0x00000400u, CSI_CPU_NO_AFFINITY);
+
+    TEST_ASSERT_EQUAL(1, csi_cpu_usage(&prev, &now, usage, CSI_CPU_MAX_TASKS));
+    TEST_ASSERT_EQUAL_UINT32(250, usage[0].permille);
+    TEST_ASSERT_EQUAL_UINT8(CSI_CPU_NO_AFFINITY, usage[0].task->core);
+}
+
+static void test_usage_created_and_deleted(void)
+{
+    csi_cpu_snapshot_t prev = {.time = 0}, now = {.time = 1000};
+    csi_cpu_usage_t usage[CSI_CPU_MAX_TASKS];
+
+    add_task(&prev, 1, "old", 100, 0);
+    add_task(&prev, 2, "gone", 100, 0);
+    add_task(&now, 1, "old", 100, 0);
+    add_task(&now, 3, "new", 400, 1);
+
+    // 新建的任务按全部运行时间计算，已删除的任务不输出，未运行的任务占用为 0
+    TEST_ASSERT_EQUAL(2, csi_cpu_usage(&prev, &now, usage, CSI_CPU_MAX_TASKS));
+    TEST_ASSERT_EQUAL_STRING("new", usage[0].task->name);
+    TEST_ASSERT_EQUAL_UINT32(400, usage[0].permille);
+    TEST_ASSERT_EQUAL_STRING("old", usage[1].task->name);
+    TEST_ASSERT_EQUAL_UINT32(0, usage[1].permille);
+
+    // 超过一个核心的结果截断为 1000
+    now.tasks[1].runtime = 1200;
+    csi_cpu_usage(&prev, &now, usage, CSI_CPU_MAX_TASKS);
+    TEST_ASSERT_EQUAL_UINT32(1000, usage[0].permille);
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_usage_sorted);
+    RUN_TEST(test_usage_wraps);
+    RUN_TEST(test_usage_created_and_deleted);
+    int failures = UNITY_END();
+    exit(failures);
+}
@@ -0,0 +1,80 @@
+/**
+ * @file csi_cpu.h
+ * @brief 各任务的 CPU 占用：两次任务快照之间，每个任务占一个核心的比例
+ *
+ * AirProbe / AirSight 按双核布局运行（见各自 README 的 Task layout）：Wi-Fi 驱动、CSI 回调和 lwIP
+ * 在核心 0，编码、发送、转发任务绑定在核心 1。本组件用于在负载下验证这一布局：
+ * - csi_cpu_snapshot() 读取 FreeRTOS 运行时间统计（需要 CONFIG_FREERTOS_USE_TRACE_FACILITY
+ *   和 CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS，否则返回 false）；
+ * - csi_cpu_usage() 计算两次快照的差值，按占用从高到低排序；
+ * - csi_cpu_log() 每个任务打印一行：绑定的核心、优先级、CPU 占用和栈的最小剩余。
+ *
+ * 运行时间计数器为 32 位、按回绕相减，两次快照的间隔须小于一个回绕周期
+ * （默认用 esp_timer 计时，约 71 分钟）。
+ * csi_cpu_usage() 只依赖 C 标准头文件，可在主机上编译并运行单元测试（见 host_test）。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 快照记录的任务数上限，任务更多时 csi_cpu_snapshot() 失败 */
+#define CSI_CPU_MAX_TASKS       32
+
+/** 任务名长度（与 configMAX_TASK_NAME_LEN 的默认值相同） */
+#define CSI_CPU_NAME_LEN        16
+
+/** 未绑定核心的任务 */
+#define CSI_CPU_NO_AFFINITY     0xFF
+
+typedef struct {
+    uint32_t id;                    /*!< 任务编号（xTaskNumber），删除的任务的编号不会被复用 */
+    uint32_t runtime;               /*!< 累计运行时间（运行时间计数器单位） */
+    uint32_t stack_free;            /*!< 栈的历史最小剩余字节数 */
+    char name[CSI_CPU_NAME_LEN];
+    uint8_t core;                   /*!< 绑定的核心，CSI_CPU_NO_AFFINITY 为不绑定 */
+    uint8_t priority;               /*!< 当前优先级 */
+} csi_cpu_task_t;
+
+typedef struct {
+    uint32_t time;                  /*!< 快照时刻（运行时间计数器） */
+    uint32_t count;                 /*!< tasks 中的有效项数 */
+    csi_cpu_task_t tasks[CSI_CPU_MAX_TASKS];
+} csi_cpu_snapshot_t;
+
+typedef struct {
+    const csi_cpu_task_t *task;     /*!< now 快照中的任务 */
+    uint32_t permille;              /*!< 两次快照之间占一个核心的千分比 */
+} csi_cpu_usage_t;
+
+/**
+ * @brief 计算两次快照之间各任务的 CPU 占用
+ *
+ * 任务按 id 对应；prev 中没有的任务（期间新建）按其全部运行时间计算，now 中没有的任务（已删除）不输出。
+ *
+ * @param out 至少 max 项，按 permille 从高到低排序
+ * @return 输出的任务数；两次快照时刻相同时返回 0
+ */
+size_t csi_cpu_usage(const csi_cpu_snapshot_t *prev, const csi_cpu_snapshot_t *now,
+                     csi_cpu_usage_t *out, size_t max);
+
+/**
+ * @brief 读取当前所有任务的运行时间（使用静态缓冲区，同一时间只能由一个任务调用）
+ *
+ * @return 未开启运行时间统计或任务数超过 CSI_CPU_MAX_TASKS 时返回 false
+ */
+bool csi_cpu_snapshot(csi_cpu_snapshot_t *snap);
+
+/**
+ * @brief 按 ESP_LOGI 打印两次快照之间占用不为 0 的任务，每个任务一行
+ */
+void csi_cpu_log(const char *tag, const csi_cpu_snapshot_t *prev, const csi_cpu_snapshot_t *now);
+
+#ifdef __cplusplus
+}
+#endif
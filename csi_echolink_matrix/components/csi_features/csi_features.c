@@ -0,0 +1,204 @@
+#include "csi_features.h"
+
+#include <string.h>
+
+static_assert(CSI_FEATURES_SUBCARRIERS <= UINT8_MAX, "n_sub is a uint8_t on the wire");
+
+/* 有效子载波在 I/Q 中的下标，与 CSI_FEATURES_SUBCARRIERS 对应 */
+static inline uint32_t subcarrier_index(uint32_t k)
+{
+    return k < 26 ? 6 + k : 33 + (k - 26);
+}
+
+/* floor(sqrt(v))，逐位求平方根 */
+static uint32_t isqrt32(uint32_t v)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/* 四舍五入的除法（远离 0），b > 0 */
+static int64_t div_round(int64_t a, int64_t b)
+{
+    return a >= 0 ? (a + b / 2) / b : -((-a + b / 2) / b);
+}
+
+static uint64_t udiv_round(uint64_t a, uint64_t b)
+{
+    return (a + b / 2) / b;
+}
+
+static int16_t saturate_i16(int64_t v)
+{
+    return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : (int16_t)v;
+}
+
+static void window_reset(csi_features_t *f)
+{
+    f->frames = 0;
+    f->pairs = 0;
+    f->sum_rssi = 0;
+    f->sum_t = 0;
+    f->sum_tt = 0;
+    f->sum_tr = 0;
+    f->sum_motion = 0;
+    memset(f->sum_amp, 0, sizeof(f->sum_amp));
+    memset(f->sum_amp2, 0, sizeof(f->sum_amp2));
+}
+
+bool csi_features_init(csi_features_t *features, const csi_features_config_t *config)
+{
+    if (config->interval_ms == 0 || config->interval_ms > CSI_FEATURES_MAX_INTERVAL_MS
+            || config->max_frames > CSI_FEATURES_MAX_FRAMES) {
+        return false;
+    }
+
+    memset(features, 0, sizeof(*features));
+    features->interval_us = config->interval_ms * 1000;
+    features->max_frames = config->max_frames ? config->max_frames : CSI_FEATURES_MAX_FRAMES;
+    return true;
+}
+
+void csi_features_amplitude_q8(const int8_t *iq, uint16_t *amplitude)
+{
+    for (uint32_t k = 0; k < CSI_FEATURES_SUBCARRIERS; k++) {
+        int32_t imag = iq[2 * subcarrier_index(k)];
+        int32_t real = iq[2 * subcarrier_index(k) + 1];
+        amplitude[k] = (uint16_t)isqrt32((uint32_t)(imag * imag + real * real) << 16);
+    }
+}
+
+bool csi_features_flush(csi_features_t *f, csi_features_result_t *out)
+{
+    if (f->frames == 0) {
+        return false;
+    }
+
+    const int64_t n = f->frames;
+    const uint64_t var_den = (uint64_t)n * n * 4096;    // Q16 -> Q4
+    uint64_t sum_amp = 0;
+
+    for (uint32_t k = 0; k < CSI_FEATURES_SUBCARRIERS; k++) {
+        uint64_t s = f->sum_amp[k];
+        uint64_t var = udiv_round((uint64_t)n * f->sum_amp2[k] - s * s, var_den);
+        out->variance_q4[k] = var > UINT16_MAX ? UINT16_MAX : (uint16_t)var;
+        sum_amp += s;
+    }
+
+    out->seq = f->seq++;
+    out->frame_seq = f->frame_seq;
+    out->local_timestamp = f->t0;
+    out->duration_us = f->t_last - f->t0;
+    out->frames = f->frames;
+    out->amp_mean_q8 = (uint16_t)udiv_round(sum_amp, (uint64_t)n * CSI_FEATURES_SUBCARRIERS);
+    out->motion_q8 = f->pairs
+        ? (uint32_t)udiv_round(f->sum_motion, (uint64_t)f->pairs * CSI_FEATURES_SUBCARRIERS * 256) : 0;
+    out->rssi_mean_q8 = saturate_i16(div_round((int64_t)f->sum_rssi * 256, n));
+
+    // 斜率 = (n * sum(t r) - sum(t) sum(r)) / (n * sum(t^2) - sum(t)^2)，dB/ms 换算为 dB/s 的 Q8
+    int64_t den = n * f->sum_tt - f->sum_t * f->sum_t;
+    int64_t num = n * f->sum_tr - f->sum_t * f->sum_rssi;
+    out->rssi_slope_q8 = den > 0 ? saturate_i16(div_round(num * 256000, den)) : 0;
+
+    window_reset(f);
+    return true;
+}
+
+bool csi_features_push(csi_features_t *f, const int8_t *iq, size_t len, int8_t rssi,
+                       uint32_t timestamp_us, uint32_t seq, csi_features_result_t *out)
+{
+    if (len < CSI_FEATURES_MIN_LEN) {
+        return false;
+    }
+
+    bool emitted = false;
+    if (f->frames > 0 && (timestamp_us - f->t0 >= f->interval_us || f->frames >= f->max_frames)) {
+        emitted = csi_features_flush(f, out);
+    }
+
+    if (f->frames == 0) {
+        f->t0 = timestamp_us;
+        f->frame_seq = seq;
+    }
+    f->t_last = timestamp_us;
+
+    uint16_t amp[CSI_FEATURES_SUBCARRIERS];
+    csi_features_amplitude_q8(iq, amp);
+    for (uint32_t k = 0; k < CSI_FEATURES_SUBCARRIERS; k++) {
+        f->sum_amp[k] += amp[k];
+        f->sum_amp2[k] += (uint64_t)amp[k] * amp[k];
+    }
+
+    if (f->has_prev) {
+        for (uint32_t k = 0; k < CSI_FEATURES_SUBCARRIERS; k++) {
+            int64_t d = (int64_t)amp[k] - f->prev[k];
+            f->sum_motion += (uint64_t)(d * d);
+        }
+        f->pairs++;
+    }
+    memcpy(f->prev, amp, sizeof(f->prev));
+    f->has_prev = true;
+
+    int64_t t = (timestamp_us - f->t0) / 1000;
+    f->sum_rssi += rssi;
+    f->sum_t += t;
+    f->sum_tt += t * t;
+    f->sum_tr += t * rssi;
+    f->frames++;
+
+    return emitted;
+}
+
+size_t csi_features_encode(const csi_features_result_t *result, const uint8_t probe_mac[6],
+                           const uint8_t mac[6], uint8_t *out, size_t size)
+{
+    const size_t data_len = CSI_FEATURES_SUBCARRIERS * sizeof(uint16_t);
+    csi_features_hdr_t hdr;
+
+    if (size < sizeof(hdr) + data_len) {
+        return 0;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = CSI_FRAME_MAGIC;
+    hdr.version = CSI_FRAME_VERSION;
+    hdr.type = CSI_FRAME_TYPE_FEATURES;
+    hdr.hdr_len = sizeof(hdr);
+    hdr.seq = result->seq;
+    hdr.frame_seq = result->frame_seq;
+    hdr.local_timestamp = result->local_timestamp;
+    hdr.duration_us = result->duration_us;
+    memcpy(hdr.probe_mac, probe_mac, sizeof(hdr.probe_mac));
+    memcpy(hdr.mac, mac, sizeof(hdr.mac));
+    hdr.frames = result->frames;
+    hdr.n_sub = CSI_FEATURES_SUBCARRIERS;
+    hdr.rssi_mean_q8 = result->rssi_mean_q8;
+    hdr.rssi_slope_q8 = result->rssi_slope_q8;
+    hdr.amp_mean_q8 = result->amp_mean_q8;
+    hdr.motion_q8 = result->motion_q8;
+    hdr.len = data_len;
+
+    memcpy(out, &hdr, sizeof(hdr));
+    // 小端目标（ESP32 / x86），直接拷贝
+    memcpy(out + sizeof(hdr), result->variance_q4, data_len);
+    return sizeof(hdr) + data_len;
+}
+
+size_t csi_features_state_size(void)
+{
+    return sizeof(csi_features_t);
+}
@@ -0,0 +1,190 @@
+/**
+ * @file test_csi_features.c
+ * @brief csi_features 主机侧单元测试（linux target）
+ *
+ * 与 Python 参考实现的逐帧对比见 datastorage/csi_features.py verify（datastorage/native 的 ctest 中运行）。
+ */
+#include <stdlib.h>
+#include "unity.h"
+#include "csi_features.h"
+
+#define LLTF_LEN 128
+
+/* 所有有效子载波的 I/Q 都设为 (imag, real) */
+static void fill_iq(int8_t *iq, int8_t imag, int8_t real)
+{
+    for (int i = 0; i < LLTF_LEN / 2; i++) {
+        iq[2 * i] = imag;
+        iq[2 * i + 1] = real;
+    }
+}
+
+static void test_init_rejects_invalid_config(void)
+{
+    csi_features_t f;
+    csi_features_config_t config = { .interval_ms = 0 };
+
+    TEST_ASSERT_FALSE(csi_features_init(&f, &config));
+    config.interval_ms = CSI_FEATURES_MAX_INTERVAL_MS + 1;
+    TEST_ASSERT_FALSE(csi_features_init(&f, &config));
+    config.interval_ms = 500;
+    config.max_frames = CSI_FEATURES_MAX_FRAMES + 1;
+    TEST_ASSERT_FALSE(csi_features_init(&f, &config));
+    config.max_frames = 0;
+    TEST_ASSERT_TRUE(csi_features_init(&f, &config));
+}
+
+static void test_amplitude_q8(void)
+{
+    int8_t iq[LLTF_LEN];
+    uint16_t amp[CSI_FEATURES_SUBCARRIERS];
+
+    fill_iq(iq, 3, 4);
+    csi_features_amplitude_q8(iq, amp);
+    TEST_ASSERT_EQUAL_UINT16(5 * 256, amp[0]);
+
+    // 极值：sqrt(2) * 128 * 256 = 46340.95
+    fill_iq(iq, -128, -128);
+    csi_features_amplitude_q8(iq, amp);
+    TEST_ASSERT_EQUAL_UINT16(46340, amp[CSI_FEATURES_SUBCARRIERS - 1]);
+
+    // 只取有效子载波：第 0..5、32、59..63 个子载波不参与
+    fill_iq(iq, 0, 0);
+    iq[2 * 6 + 1] = 1;
+    iq[2 * 32 + 1] = 100;
+    iq[2 * 58 + 1] = 2;
+    csi_features_amplitude_q8(iq, amp);
+    TEST_ASSERT_EQUAL_UINT16(256, amp[0]);
+    TEST_ASSERT_EQUAL_UINT16(0, amp[25]);
+    TEST_ASSERT_EQUAL_UINT16(0, amp[26]);
+    TEST_ASSERT_EQUAL_UINT16(512, amp[CSI_FEATURES_SUBCARRIERS - 1]);
+}
+
+static void test_window_by_interval(void)
+{
+    csi_features_t f;
+    csi_features_config_t config = { .interval_ms = 100 };
+    csi_features_result_t out;
+    int8_t iq[LLTF_LEN];
+
+    TEST_ASSERT_TRUE(csi_features_init(&f, &config));
+
+    // 10 ms 一帧，幅度在 5 和 10 之间交替：方差 6.25，相邻帧差的平方 25
+    for (uint32_t i = 0; i < 10; i++) {
+        if (i % 2) {
+            fill_iq(iq, 6, 8);
+        } else {
+            fill_iq(iq, 3, 4);
+        }
+        TEST_ASSERT_FALSE(csi_features_push(&f, iq, sizeof(iq), -50, 1000 + i * 10000, 7 + i, &out));
+    }
+
+    // 第 11 帧距第一帧 100 ms，输出前 10 帧
+    TEST_ASSERT_TRUE(csi_features_push(&f, iq, sizeof(iq), -50, 101000, 17, &out));
+    TEST_ASSERT_EQUAL_UINT32(0, out.seq);
+    TEST_ASSERT_EQUAL_UINT32(7, out.frame_seq);
+    TEST_ASSERT_EQUAL_UINT32(1000, out.local_timestamp);
+    TEST_ASSERT_EQUAL_UINT32(90000, out.duration_us);
+    TEST_ASSERT_EQUAL_UINT16(10, out.frames);
+    TEST_ASSERT_EQUAL_UINT16(100, out.variance_q4[0]);          // 6.25 * 16
+    TEST_ASSERT_EQUAL_UINT16(100, out.variance_q4[CSI_FEATURES_SUBCARRIERS - 1]);
+    TEST_ASSERT_EQUAL_UINT16(1920, out.amp_mean_q8);            // 7.5 * 256
+    TEST_ASSERT_EQUAL_UINT32(6400, out.motion_q8);              // 25 * 256
+    TEST_ASSERT_EQUAL_INT16(-50 * 256, out.rssi_mean_q8);
+    TEST_ASSERT_EQUAL_INT16(0, out.rssi_slope_q8);
+
+    // 新窗口从第 11 帧开始，序号递增
+    TEST_ASSERT_TRUE(csi_features_flush(&f, &out));
+    TEST_ASSERT_EQUAL_UINT32(1, out.seq);
+    TEST_ASSERT_EQUAL_UINT16(1, out.frames);
+    TEST_ASSERT_EQUAL_UINT16(0, out.variance_q4[0]);
+    TEST_ASSERT_FALSE(csi_features_flush(&f, &out));
+}
+
+static void test_window_by_frames_and_short_frames(void)
+{
+    csi_features_t f;
+    csi_features_config_t config = { .interval_ms = 1000, .max_frames = 4 };
+    csi_features_result_t out;
+    int8_t iq[LLTF_LEN];
+    int emitted = 0;
+
+    fill_iq(iq, 1, 1);
+    TEST_ASSERT_TRUE(csi_features_init(&f, &config));
+    TEST_ASSERT_FALSE(csi_features_push(&f, iq, CSI_FEATURES_MIN_LEN - 1, -40, 0, 0, &out));
+    for (uint32_t i = 0; i < 9; i++) {
+        emitted += csi_features_push(&f, iq, sizeof(iq), -40, i, i, &out);
+    }
+    TEST_ASSERT_EQUAL(2, emitted);
+    TEST_ASSERT_EQUAL_UINT16(4, out.frames);
+    TEST_ASSERT_EQUAL_UINT32(4, out.frame_seq);
+}
+
+static void test_rssi_slope_and_timestamp_wrap(void)
+{
+    csi_features_t f;
+    csi_features_config_t config = { .interval_ms = 1000 };
+    csi_features_result_t out;
+    int8_t iq[LLTF_LEN];
+
+    fill_iq(iq, 1, 1);
+    TEST_ASSERT_TRUE(csi_features_init(&f, &config));
+
+    // RSSI 每 100 ms 上升 1 dB（10 dB/s），时间戳跨过 32 位回绕
+    uint32_t t0 = UINT32_MAX - 250000;
+    for (int i = 0; i < 10; i++) {
+        csi_features_push(&f, iq, sizeof(iq), (int8_t)(-60 + i), t0 + i * 100000, i, &out);
+    }
+    TEST_ASSERT_TRUE(csi_features_flush(&f, &out));
+    TEST_ASSERT_EQUAL_INT16(10 * 256, out.rssi_slope_q8);
+    TEST_ASSERT_EQUAL_INT16((int16_t)(-55.5 * 256), out.rssi_mean_q8);
+    TEST_ASSERT_EQUAL_UINT32(900000, out.duration_us);
+}
+
+static void test_encode(void)
+{
+    csi_features_result_t result = {0};
+    uint8_t probe_mac[6] = {1, 2, 3, 4, 5, 6};
+    uint8_t mac[6] = {7, 8, 9, 10, 11, 12};
+    uint8_t buf[sizeof(csi_features_hdr_t) + CSI_FEATURES_SUBCARRIERS * 2];
+
+    result.seq = 3;
+    result.frames = 50;
+    result.rssi_slope_q8 = -300;
+    result.variance_q4[0] = 0x1234;
+    result.variance_q4[CSI_FEATURES_SUBCARRIERS - 1] = 0xABCD;
+
+    TEST_ASSERT_EQUAL(0, csi_features_encode(&result, probe_mac, mac, buf, sizeof(buf) - 1));
+    size_t len = csi_features_encode(&result, probe_mac, mac, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(sizeof(buf), len);
+
+    const csi_features_hdr_t *hdr = csi_features_check(buf, len);
+    TEST_ASSERT_NOT_NULL(hdr);
+    TEST_ASSERT_EQUAL_UINT32(3, hdr->seq);
+    TEST_ASSERT_EQUAL_UINT16(50, hdr->frames);
+    TEST_ASSERT_EQUAL_UINT8(CSI_FEATURES_SUBCARRIERS, hdr->n_sub);
+    TEST_ASSERT_EQUAL_INT16(-300, hdr->rssi_slope_q8);
+    TEST_ASSERT_EQUAL_MEMORY(probe_mac, hdr->probe_mac, 6);
+    TEST_ASSERT_EQUAL_MEMORY(mac, hdr->mac, 6);
+    TEST_ASSERT_EQUAL_UINT8(0x34, buf[hdr->hdr_len]);
+    TEST_ASSERT_EQUAL_UINT8(0xAB, buf[len - 1]);
+    TEST_ASSERT_NULL(csi_features_check(buf, len - 1));
+
+    // 特征数据报中没有 CSI 帧
+    csi_frame_iter_t it;
+    csi_frame_iter_init(&it, buf, len);
+    TEST_ASSERT_NULL(csi_frame_iter_next(&it));
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_init_rejects_invalid_config);
+    RUN_TEST(test_amplitude_q8);
+    RUN_TEST(test_window_by_interval);
+    RUN_TEST(test_window_by_frames_and_short_frames);
+    RUN_TEST(test_rssi_slope_and_timestamp_wrap);
+    RUN_TEST(test_encode);
+    int failures = UNITY_END();
+    exit(failures);
+}
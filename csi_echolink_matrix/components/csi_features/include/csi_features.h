@@ -0,0 +1,130 @@
+/**
+ * @file csi_features.h
+ * @brief 设备侧 CSI 特征提取：按时间窗口统计 LLTF 子载波的幅度方差、运动能量和 RSSI 趋势
+ *
+ * 全部使用整数运算（定点数），AirProbe 上和主机上的结果逐位一致：
+ * - 幅度 = floor(sqrt((I^2 + Q^2) << 16))，即 Q8 的 sqrt(I^2 + Q^2)；
+ * - 每个子载波累加 sum(a) 和 sum(a^2)，窗口结束时方差 = (n * sum(a^2) - sum(a)^2) / n^2；
+ * - 运动能量为相邻两帧幅度差的平方，按帧对数和子载波数平均（跨窗口的相邻帧也计入）；
+ * - RSSI 取平均值，并以窗口内的毫秒时间为自变量做最小二乘直线拟合得到斜率。
+ * 除法均为四舍五入（远离 0），datastorage/csi_features.py 中的 Python 参考实现按同样的规则计算。
+ *
+ * 状态是一个定长结构体，不申请内存；只依赖 C11 标准库，可在主机上编译（见 host_test，
+ * 以及 datastorage/native 中编译进 libcsi_native 的版本）。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "csi_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 主机侧编译为共享库时定义为导出属性 */
+#ifndef CSI_FEATURES_API
+#define CSI_FEATURES_API
+#endif
+
+/** LLTF 有效子载波：I/Q 中第 6..31 和 33..58 个子载波（与 datastorage 的 csi_vaid_subcarrier_index 一致） */
+#define CSI_FEATURES_SUBCARRIERS    52
+
+/** 参与计算的帧至少包含的 I/Q 字节数 */
+#define CSI_FEATURES_MIN_LEN        118
+
+/** 一个窗口的最大帧数（保证 64 位累加不溢出） */
+#define CSI_FEATURES_MAX_FRAMES     1024
+
+/** 窗口的最大时长 */
+#define CSI_FEATURES_MAX_INTERVAL_MS 60000
+
+typedef struct {
+    uint32_t interval_ms;       /*!< 窗口时长：下一帧距窗口第一帧达到该时长时输出 */
+    uint16_t max_frames;        /*!< 窗口帧数上限，0 表示 CSI_FEATURES_MAX_FRAMES */
+} csi_features_config_t;
+
+/** 一个窗口的特征，字段含义见 csi_features_hdr_t */
+typedef struct {
+    uint32_t seq;
+    uint32_t frame_seq;
+    uint32_t local_timestamp;
+    uint32_t duration_us;
+    uint16_t frames;
+    int16_t  rssi_mean_q8;
+    int16_t  rssi_slope_q8;
+    uint16_t amp_mean_q8;
+    uint32_t motion_q8;
+    uint16_t variance_q4[CSI_FEATURES_SUBCARRIERS];    /*!< 每个子载波的幅度方差（Q4，饱和到 65535） */
+} csi_features_result_t;
+
+/** 提取器状态，由调用方分配（静态变量即可） */
+typedef struct {
+    uint32_t interval_us;
+    uint16_t max_frames;
+
+    uint32_t seq;               // 下一个窗口的序号
+    uint16_t frames;            // 当前窗口的帧数
+    uint16_t pairs;             // 当前窗口中参与运动能量的帧对数
+    uint32_t frame_seq;
+    uint32_t t0;
+    uint32_t t_last;
+    int32_t  sum_rssi;
+    int64_t  sum_t;             // t 为距窗口第一帧的毫秒数
+    int64_t  sum_tt;
+    int64_t  sum_tr;
+    uint64_t sum_motion;        // Q16
+    bool     has_prev;
+    uint16_t prev[CSI_FEATURES_SUBCARRIERS];           // 上一帧的幅度（Q8）
+    uint32_t sum_amp[CSI_FEATURES_SUBCARRIERS];        // Q8
+    uint64_t sum_amp2[CSI_FEATURES_SUBCARRIERS];       // Q16
+} csi_features_t;
+
+/**
+ * @brief 初始化提取器
+ *
+ * @return interval_ms 为 0 或超过 CSI_FEATURES_MAX_INTERVAL_MS、max_frames 超过 CSI_FEATURES_MAX_FRAMES 时返回 false
+ */
+CSI_FEATURES_API bool csi_features_init(csi_features_t *features, const csi_features_config_t *config);
+
+/**
+ * @brief 输入一帧
+ *
+ * 当前窗口已达到时长或帧数上限时，先输出当前窗口，再把这一帧作为新窗口的第一帧。
+ *
+ * @param iq int8 I/Q（虚部、实部交替），长度不足 CSI_FEATURES_MIN_LEN 的帧被忽略
+ * @param timestamp_us rx_ctrl->timestamp
+ * @param seq 帧的采集序号
+ * @param[out] out 输出的窗口特征
+ * @return 是否输出了一个窗口
+ */
+CSI_FEATURES_API bool csi_features_push(csi_features_t *features, const int8_t *iq, size_t len, int8_t rssi,
+                                        uint32_t timestamp_us, uint32_t seq, csi_features_result_t *out);
+
+/**
+ * @brief 输出当前窗口（不论是否达到时长），没有帧时返回 false
+ */
+CSI_FEATURES_API bool csi_features_flush(csi_features_t *features, csi_features_result_t *out);
+
+/**
+ * @brief 编码为特征数据报（csi_features_hdr_t + 方差数组）
+ *
+ * @param size out 的大小，至少 sizeof(csi_features_hdr_t) + CSI_FEATURES_SUBCARRIERS * 2
+ * @return 数据报长度，size 不足时返回 0
+ */
+CSI_FEATURES_API size_t csi_features_encode(const csi_features_result_t *result, const uint8_t probe_mac[6],
+                                            const uint8_t mac[6], uint8_t *out, size_t size);
+
+/**
+ * @brief 有效子载波的 Q8 幅度（CSI_FEATURES_SUBCARRIERS 个），iq 至少 CSI_FEATURES_MIN_LEN 字节
+ */
+CSI_FEATURES_API void csi_features_amplitude_q8(const int8_t *iq, uint16_t *amplitude);
+
+/** sizeof(csi_features_t)，供主机侧 ctypes 分配状态 */
+CSI_FEATURES_API size_t csi_features_state_size(void);
+
+#ifdef __cplusplus
+}
+#endif
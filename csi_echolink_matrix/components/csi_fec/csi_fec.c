@@ -0,0 +1,229 @@
+#include "csi_fec.h"
+
+#include <string.h>
+
+// 按机器字访问字节缓冲区，may_alias 避免违反严格别名规则
+typedef uintptr_t __attribute__((may_alias)) csi_fec_word_t;
+
+#define WORD_SIZE sizeof(csi_fec_word_t)
+
+void csi_fec_xor(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    if ((((uintptr_t)dst ^ (uintptr_t)src) & (WORD_SIZE - 1)) == 0) {
+        // 两者对齐方式相同：先按字节处理到字边界，其余按对齐的机器字处理（ESP32 不支持非对齐的字访问）
+        while (len && ((uintptr_t)dst & (WORD_SIZE - 1))) {
+            *dst++ ^= *src++;
+            len--;
+        }
+        for (; len >= WORD_SIZE; len -= WORD_SIZE, dst += WORD_SIZE, src += WORD_SIZE) {
+            *(csi_fec_word_t *)dst ^= *(const csi_fec_word_t *)src;
+        }
+    } else {
+        // 只在主机侧出现（解码器的累加区与校验数据错开 sizeof(csi_parity_hdr_t)），x86、ARM64 支持非对齐访问
+        for (; len >= WORD_SIZE; len -= WORD_SIZE, dst += WORD_SIZE, src += WORD_SIZE) {
+            uintptr_t a, b;
+            memcpy(&a, dst, WORD_SIZE);
+            memcpy(&b, src, WORD_SIZE);
+            a ^= b;
+            memcpy(dst, &a, WORD_SIZE);
+        }
+    }
+
+    while (len--) {
+        *dst++ ^= *src++;
+    }
+}
+
+// 把 len 字节计入异或累加区：*acc_len 之后的部分此前为 0，直接复制
+static void accumulate(uint8_t *acc, uint16_t *acc_len, const uint8_t *src, size_t len)
+{
+    size_t common = len < *acc_len ? len : *acc_len;
+    csi_fec_xor(acc, src, common);
+    if (len > *acc_len) {
+        memcpy(acc + *acc_len, src + *acc_len, len - *acc_len);
+        *acc_len = (uint16_t)len;
+    }
+}
+
+void csi_fec_enc_init(csi_fec_enc_t *enc, uint8_t k, const uint8_t probe_mac[6])
+{
+    memset(enc, 0, sizeof(*enc));
+    enc->k = k < 2 ? 2 : k > CSI_FEC_MAX_GROUP ? CSI_FEC_MAX_GROUP : k;
+    memcpy(enc->probe_mac, probe_mac, 6);
+}
+
+bool csi_fec_enc_add(csi_fec_enc_t *enc, uint8_t *datagram, size_t len)
+{
+    csi_batch_hdr_t *hdr = (csi_batch_hdr_t *)datagram;
+    if (len > CSI_FEC_MAX_DATAGRAM || hdr->hdr_len < CSI_FEC_BATCH_HDR_LEN) {
+        return false;
+    }
+
+    csi_batch_fec_t fec;
+    memcpy(fec.probe_mac, enc->probe_mac, 6);
+    fec.group = enc->group;
+    fec.index = enc->count;
+    fec.k = enc->k;
+    memcpy(hdr + 1, &fec, sizeof(fec));
+    hdr->flags |= CSI_BATCH_FLAG_FEC;
+
+    accumulate(enc->buf + sizeof(csi_parity_hdr_t), &enc->len, datagram, len);
+    enc->len_xor ^= (uint16_t)len;
+    return ++enc->count >= enc->k;
+}
+
+size_t csi_fec_enc_finish(csi_fec_enc_t *enc)
+{
+    if (enc->count == 0) {
+        return 0;
+    }
+
+    csi_parity_hdr_t hdr = {
+        .magic = CSI_FRAME_MAGIC,
+        .version = CSI_FRAME_VERSION,
+        .type = CSI_FRAME_TYPE_PARITY,
+        .hdr_len = sizeof(csi_parity_hdr_t),
+        .group = enc->group,
+        .count = enc->count,
+        .len_xor = enc->len_xor,
+        .len = enc->len,
+    };
+    memcpy(hdr.probe_mac, enc->probe_mac, 6);
+    memcpy(enc->buf, &hdr, sizeof(hdr));
+
+    size_t size = sizeof(hdr) + enc->len;
+    enc->group++;
+    enc->count = 0;
+    enc->len = 0;
+    enc->len_xor = 0;
+    return size;
+}
+
+void csi_fec_dec_init(csi_fec_dec_t *dec)
+{
+    memset(dec, 0, sizeof(*dec));
+}
+
+const uint8_t *csi_fec_probe(const void *buf, size_t len)
+{
+    const csi_batch_fec_t *fec = csi_batch_fec(buf, len);
+    if (fec) {
+        return fec->probe_mac;
+    }
+
+    const csi_parity_hdr_t *parity = csi_parity_check(buf, len);
+    return parity ? parity->probe_mac : NULL;
+}
+
+static unsigned popcount32(uint32_t v)
+{
+    unsigned n = 0;
+    for (; v; v &= v - 1) {
+        n++;
+    }
+    return n;
+}
+
+static void close_group(csi_fec_dec_t *dec)
+{
+    if (dec->done) {
+        return;
+    }
+    // 校验数据报丢失时组内实际的数据报数未知（组可能提前结束），只有收到的位置之间有空缺才确定有丢失
+    bool lost = dec->count ? popcount32(dec->mask) < dec->count
+                           : (dec->mask & (dec->mask + 1)) != 0;
+    if (lost) {
+        dec->failed++;
+    }
+}
+
+/**
+ * @return group 属于当前组或更新的组时返回 true，更早的组返回 false
+ */
+static bool enter_group(csi_fec_dec_t *dec, uint16_t group, uint8_t k)
+{
+    if (dec->active && group == dec->group) {
+        return true;
+    }
+    if (dec->active) {
+        if ((int16_t)(group - dec->group) < 0) {
+            return false;
+        }
+        close_group(dec);
+    }
+
+    dec->active = true;
+    dec->done = false;
+    dec->group = group;
+    dec->k = k;
+    dec->count = 0;
+    dec->mask = 0;
+    dec->len_xor = 0;
+    dec->acc_len = 0;
+    dec->groups++;
+    return true;
+}
+
+static size_t try_recover(csi_fec_dec_t *dec, uint8_t *out)
+{
+    if (dec->done || dec->count == 0) {
+        return 0;
+    }
+
+    unsigned received = popcount32(dec->mask);
+    if (received >= dec->count) {
+        dec->done = true;
+        return 0;
+    }
+    if (received + 1 < dec->count) {
+        return 0;
+    }
+
+    // 恰好缺一个：其余数据报与校验数据的异或即为丢失的数据报
+    unsigned missing = 0;
+    while (dec->mask & (1u << missing)) {
+        missing++;
+    }
+
+    dec->done = true;
+    size_t len = dec->len_xor;
+    const csi_batch_fec_t *fec = len <= dec->acc_len ? csi_batch_fec(dec->acc, len) : NULL;
+    if (!fec || fec->group != dec->group || fec->index != missing) {
+        dec->failed++;
+        return 0;
+    }
+
+    memcpy(out, dec->acc, len);
+    dec->mask |= 1u << missing;
+    dec->recovered++;
+    return len;
+}
+
+size_t csi_fec_dec_push(csi_fec_dec_t *dec, const void *buf, size_t len, uint8_t *out)
+{
+    const csi_batch_fec_t *fec = csi_batch_fec(buf, len);
+    if (fec) {
+        if (len > CSI_FEC_MAX_DATAGRAM || fec->k > CSI_FEC_MAX_GROUP || fec->index >= fec->k
+                || !enter_group(dec, fec->group, fec->k) || (dec->mask & (1u << fec->index))) {
+            return 0;
+        }
+        accumulate(dec->acc, &dec->acc_len, buf, len);
+        dec->len_xor ^= (uint16_t)len;
+        dec->mask |= 1u << fec->index;
+        return try_recover(dec, out);
+    }
+
+    const csi_parity_hdr_t *parity = csi_parity_check(buf, len);
+    if (parity) {
+        if (parity->len > CSI_FEC_MAX_DATAGRAM || parity->count > CSI_FEC_MAX_GROUP
+                || !enter_group(dec, parity->group, parity->count) || dec->count) {
+            return 0;
+        }
+        accumulate(dec->acc, &dec->acc_len, (const uint8_t *)buf + parity->hdr_len, parity->len);
+        dec->len_xor ^= parity->len_xor;
+        dec->count = parity->count;
+        return try_recover(dec, out);
+    }
+
+    return 0;
+}
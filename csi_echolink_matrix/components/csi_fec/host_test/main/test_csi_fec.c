@@ -0,0 +1,231 @@
+/**
+ * @file test_csi_fec.c
+ * @brief csi_fec 主机侧单元测试（linux target）
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "csi_fec.h"
+
+#define GROUP   4
+
+static const uint8_t PROBE_MAC[6] = {0x24, 0x6f, 0x28, 0x01, 0x02, 0x03};
+
+// 一个聚合数据报：容器头 + FEC 扩展 + n 字节内容（按 seed 填充）
+static size_t make_batch(uint8_t *buf, size_t n, uint8_t seed)
+{
+    csi_batch_hdr_t hdr;
+    csi_batch_hdr_init(&hdr);
+    hdr.hdr_len = CSI_FEC_BATCH_HDR_LEN;
+    hdr.count = 1;
+    hdr.len = (uint16_t)n;
+    memcpy(buf, &hdr, sizeof(hdr));
+    for (size_t i = 0; i < n; i++) {
+        buf[CSI_FEC_BATCH_HDR_LEN + i] = (uint8_t)(seed * 31 + i * 7);
+    }
+    return CSI_FEC_BATCH_HDR_LEN + n;
+}
+
+typedef struct {
+    uint8_t data[GROUP + 1][CSI_DATAGRAM_MAX_SIZE];
+    size_t len[GROUP + 1];      // 最后一个为校验数据报
+} group_t;
+
+static void encode_group(csi_fec_enc_t *enc, group_t *g, const size_t *sizes, uint8_t seed)
+{
+    for (int i = 0; i < GROUP; i++) {
+        g->len[i] = make_batch(g->data[i], sizes[i], (uint8_t)(seed + i));
+        bool full = csi_fec_enc_add(enc, g->data[i], g->len[i]);
+        TEST_ASSERT_EQUAL(i == GROUP - 1, full);
+    }
+    g->len[GROUP] = csi_fec_enc_finish(enc);
+    memcpy(g->data[GROUP], enc->buf, g->len[GROUP]);
+}
+
+static void test_recovers_any_single_loss(void)
+{
+    static csi_fec_enc_t enc;
+    static csi_fec_dec_t dec;
+    static group_t g;
+    static uint8_t out[CSI_FEC_MAX_DATAGRAM];
+    const size_t sizes[GROUP] = {300, 1200, 17, 1200};
+
+    csi_fec_enc_init(&enc, GROUP, PROBE_MAC);
+    csi_fec_dec_init(&dec);
+
+    // 依次丢失组内第 0..GROUP 个数据报（最后一个为校验数据报）
+    for (int lost = 0; lost <= GROUP; lost++) {
+        encode_group(&enc, &g, sizes, (uint8_t)(lost * 10));
+        TEST_ASSERT_NOT_NULL(csi_batch_fec(g.data[0], g.len[0]));
+        TEST_ASSERT_EQUAL_MEMORY(PROBE_MAC, csi_fec_probe(g.data[GROUP], g.len[GROUP]), 6);
+
+        size_t recovered = 0;
+        for (int i = 0; i <= GROUP; i++) {
+            if (i != lost) {
+                size_t n = csi_fec_dec_push(&dec, g.data[i], g.len[i], out);
+                if (n) {
+                    recovered = n;
+                }
+            }
+        }
+
+        if (lost < GROUP) {
+            TEST_ASSERT_EQUAL(g.len[lost], recovered);
+            TEST_ASSERT_EQUAL_MEMORY(g.data[lost], out, recovered);
+        } else {
+            TEST_ASSERT_EQUAL(0, recovered);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(GROUP, dec.recovered);
+    TEST_ASSERT_EQUAL_UINT32(0, dec.failed);
+}
+
+static unsigned popcount_mask(uint32_t mask)
+{
+    unsigned n = 0;
+    for (; mask; mask &= mask - 1) {
+        n++;
+    }
+    return n;
+}
+
+static void test_parity_first_and_double_loss(void)
+{
+    static csi_fec_enc_t enc;
+    static csi_fec_dec_t dec;
+    static group_t g;
+    static uint8_t out[CSI_FEC_MAX_DATAGRAM];
+    const size_t sizes[GROUP] = {64, 64, 128, 1000};
+
+    csi_fec_enc_init(&enc, GROUP, PROBE_MAC);
+    csi_fec_dec_init(&dec);
+
+    // 校验数据报先到
+    encode_group(&enc, &g, sizes, 1);
+    TEST_ASSERT_EQUAL(0, csi_fec_dec_push(&dec, g.data[GROUP], g.len[GROUP], out));
+    TEST_ASSERT_EQUAL(0, csi_fec_dec_push(&dec, g.data[0], g.len[0], out));
+    TEST_ASSERT_EQUAL(0, csi_fec_dec_push(&dec, g.data[3], g.len[3], out));
+    TEST_ASSERT_EQUAL(g.len[1], csi_fec_dec_push(&dec, g.data[2], g.len[2], out));
+    TEST_ASSERT_EQUAL_MEMORY(g.data[1], out, g.len[1]);
+
+    // 丢失两个：无法恢复，下一组开始时计为失败
+    encode_group(&enc, &g, sizes, 2);
+    csi_fec_dec_push(&dec, g.data[0], g.len[0], out);
+    csi_fec_dec_push(&dec, g.data[3], g.len[3], out);
+    TEST_ASSERT_EQUAL(0, csi_fec_dec_push(&dec, g.data[GROUP], g.len[GROUP], out));
+
+    encode_group(&enc, &g, sizes, 3);
+    TEST_ASSERT_EQUAL(0, csi_fec_dec_push(&dec, g.data[0], g.len[0], out));
+    TEST_ASSERT_EQUAL_UINT32(1, dec.failed);
+    TEST_ASSERT_EQUAL_UINT32(3, dec.groups);
+
+    // 重复的数据报和上一组迟到的数据报被忽略
+    TEST_ASSERT_EQUAL(0, csi_fec_dec_push(&dec, g.data[0], g.len[0], out));
+    csi_batch_fec_t *fec = (csi_batch_fec_t *)(g.data[1] + sizeof(csi_batch_hdr_t));
+    fec->group--;
+    TEST_ASSERT_EQUAL(0, csi_fec_dec_push(&dec, g.data[1], g.len[1], out));
+    TEST_ASSERT_EQUAL_UINT32(3, dec.groups);
+    TEST_ASSERT_EQUAL(1, popcount_mask(dec.mask));
+}
+
+static void test_partial_group(void)
+{
+    static csi_fec_enc_t enc;
+    static csi_fec_dec_t dec;
+    static uint8_t a[CSI_DATAGRAM_MAX_SIZE], b[CSI_DATAGRAM_MAX_SIZE], parity[CSI_DATAGRAM_MAX_SIZE];
+    static uint8_t out[CSI_FEC_MAX_DATAGRAM];
+
+    csi_fec_enc_init(&enc, GROUP, PROBE_MAC);
+    csi_fec_dec_init(&dec);
+    TEST_ASSERT_EQUAL(0, csi_fec_enc_finish(&enc));
+
+    // 发送暂停时提前结束的组：校验头中的 count 为实际的数据报数
+    size_t la = make_batch(a, 500, 7);
+    size_t lb = make_batch(b, 90, 8);
+    TEST_ASSERT_FALSE(csi_fec_enc_add(&enc, a, la));
+    TEST_ASSERT_FALSE(csi_fec_enc_add(&enc, b, lb));
+    size_t lp = csi_fec_enc_finish(&enc);
+    memcpy(parity, enc.buf, lp);
+
+    const csi_parity_hdr_t *hdr = csi_parity_check(parity, lp);
+    TEST_ASSERT_NOT_NULL(hdr);
+    TEST_ASSERT_EQUAL(2, hdr->count);
+    TEST_ASSERT_EQUAL(500 + CSI_FEC_BATCH_HDR_LEN, hdr->len);
+    TEST_ASSERT_EQUAL(1, enc.group);
+
+    TEST_ASSERT_EQUAL(0, csi_fec_dec_push(&dec, b, lb, out));
+    TEST_ASSERT_EQUAL(la, csi_fec_dec_push(&dec, parity, lp, out));
+    TEST_ASSERT_EQUAL_MEMORY(a, out, la);
+
+    // 校验数据报和其它数据报中没有 CSI 帧
+    csi_frame_iter_t it;
+    csi_frame_iter_init(&it, parity, lp);
+    TEST_ASSERT_NULL(csi_frame_iter_next(&it));
+}
+
+static void test_parity_lost(void)
+{
+    static csi_fec_enc_t enc;
+    static csi_fec_dec_t dec;
+    static group_t g;
+    static uint8_t a[CSI_DATAGRAM_MAX_SIZE], b[CSI_DATAGRAM_MAX_SIZE];
+    static uint8_t out[CSI_FEC_MAX_DATAGRAM];
+    const size_t sizes[GROUP] = {200, 200, 200, 200};
+
+    csi_fec_enc_init(&enc, GROUP, PROBE_MAC);
+    csi_fec_dec_init(&dec);
+
+    // 提前结束的组没有丢失数据报，只丢失了校验数据报：不计为失败
+    size_t la = make_batch(a, 500, 7);
+    size_t lb = make_batch(b, 90, 8);
+    TEST_ASSERT_FALSE(csi_fec_enc_add(&enc, a, la));
+    TEST_ASSERT_FALSE(csi_fec_enc_add(&enc, b, lb));
+    TEST_ASSERT_NOT_EQUAL(0, csi_fec_enc_finish(&enc));
+    csi_fec_dec_push(&dec, a, la, out);
+    csi_fec_dec_push(&dec, b, lb, out);
+
+    // 满组丢失了中间的数据报和校验数据报：收到的位置之间有空缺，计为失败
+    encode_group(&enc, &g, sizes, 1);
+    csi_fec_dec_push(&dec, g.data[0], g.len[0], out);
+    csi_fec_dec_push(&dec, g.data[2], g.len[2], out);
+    csi_fec_dec_push(&dec, g.data[3], g.len[3], out);
+    TEST_ASSERT_EQUAL_UINT32(0, dec.failed);
+
+    encode_group(&enc, &g, sizes, 2);
+    csi_fec_dec_push(&dec, g.data[0], g.len[0], out);
+    TEST_ASSERT_EQUAL_UINT32(1, dec.failed);
+    TEST_ASSERT_EQUAL_UINT32(3, dec.groups);
+}
+
+static void test_xor_alignment(void)
+{
+    uint8_t a[64], b[64], ref[64];
+
+    for (size_t off_a = 0; off_a < 8; off_a++) {
+        for (size_t off_b = 0; off_b < 8; off_b++) {
+            for (size_t i = 0; i < sizeof(a); i++) {
+                a[i] = (uint8_t)(i * 13 + 1);
+                b[i] = (uint8_t)(i * 29 + 5);
+            }
+            memcpy(ref, a, sizeof(ref));
+            for (size_t i = 0; i < 40; i++) {
+                ref[off_a + i] ^= b[off_b + i];
+            }
+            csi_fec_xor(a + off_a, b + off_b, 40);
+            TEST_ASSERT_EQUAL_MEMORY(ref, a, sizeof(a));
+        }
+    }
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_recovers_any_single_loss);
+    RUN_TEST(test_parity_first_and_double_loss);
+    RUN_TEST(test_partial_group);
+    RUN_TEST(test_parity_lost);
+    RUN_TEST(test_xor_alignment);
+    int failures = UNITY_END();
+    exit(failures);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file csi_fec.h
+ * @brief 聚合数据报的异或校验（FEC）：AirProbe 编码，主机恢复每组中丢失的一个数据报
+ *
+ * AirProbe 把连续 k 个聚合数据报分为一组，每个数据报的容器头后追加 csi_batch_fec_t，
+ * 组满（或发送暂停）时再发送一个校验数据报，内容为组内数据报逐字节异或（见 csi_frame.h）。
+ * 主机按探针各用一个解码器：组内任意一个数据报（含校验数据报）丢失时，
+ * 其余数据报与校验数据报异或即得到丢失的数据报，丢失两个及以上时无法恢复。
+ *
+ * 选用单校验的异或而不是 Reed-Solomon：SoftAP 链路上的丢包以单个数据报为主，
+ * 异或在 ESP32 上每字节只需一次按字访问的异或，额外带宽为 1/k。
+ * AirSight 不解析校验数据报，原样转发。
+ *
+ * 只依赖 C 标准头文件，可在主机上编译并运行单元测试（见 host_test）。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "csi_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 组大小上限（解码器用 32 位掩码记录收到的数据报） */
+#define CSI_FEC_MAX_GROUP       32
+
+/** 开启 FEC 时聚合容器头的长度 */
+#define CSI_FEC_BATCH_HDR_LEN   (sizeof(csi_batch_hdr_t) + sizeof(csi_batch_fec_t))
+
+/** 组内数据报的最大长度：校验数据报加上校验头后不能超过一个数据报 */
+#define CSI_FEC_MAX_DATAGRAM    (CSI_DATAGRAM_MAX_SIZE - sizeof(csi_parity_hdr_t))
+
+/**
+ * @brief dst[i] ^= src[i]，按机器字处理
+ */
+void csi_fec_xor(uint8_t *dst, const uint8_t *src, size_t len);
+
+typedef struct {
+    uint8_t  probe_mac[6];
+    uint16_t group;
+    uint16_t len_xor;
+    uint16_t len;               /*!< 当前组中最长数据报的长度 */
+    uint8_t  k;
+    uint8_t  count;             /*!< 当前组已加入的数据报数 */
+    uint8_t  buf[CSI_DATAGRAM_MAX_SIZE]; /*!< 校验数据报：csi_parity_hdr_t + 异或结果 */
+} __attribute__((aligned(8))) csi_fec_enc_t;
+
+// 异或结果按机器字对齐，与对齐的聚合缓冲区异或时不需要逐字节处理
+static_assert((offsetof(csi_fec_enc_t, buf) + sizeof(csi_parity_hdr_t)) % 8 == 0,
+              "csi_fec_enc_t parity payload must be word aligned");
+
+/**
+ * @param k 组大小，2 .. CSI_FEC_MAX_GROUP
+ */
+void csi_fec_enc_init(csi_fec_enc_t *enc, uint8_t k, const uint8_t probe_mac[6]);
+
+/**
+ * @brief 填写聚合数据报的 FEC 分组信息并把它计入当前组
+ *
+ * datagram 以 csi_batch_hdr_t 开头，hdr_len 须不小于 CSI_FEC_BATCH_HDR_LEN（为 csi_batch_fec_t 预留），
+ * len 不超过 CSI_FEC_MAX_DATAGRAM。调用后 datagram 即可发送。
+ *
+ * @return 组已满 k 个数据报，应调用 csi_fec_enc_finish() 发送校验数据报
+ */
+bool csi_fec_enc_add(csi_fec_enc_t *enc, uint8_t *datagram, size_t len);
+
+/**
+ * @brief 结束当前组，生成校验数据报（位于 enc->buf）
+ *
+ * 组未满时也可以提前结束（例如发送暂停），校验头中的 count 为实际的数据报数。
+ *
+ * @return 校验数据报长度，当前组为空时返回 0
+ */
+size_t csi_fec_enc_finish(csi_fec_enc_t *enc);
+
+typedef struct {
+    uint8_t  acc[CSI_FEC_MAX_DATAGRAM]; /*!< 已收到的数据报和校验数据的异或 */
+    uint32_t mask;              /*!< 已收到的数据报（按组内位置） */
+    uint16_t group;
+    uint16_t len_xor;
+    uint16_t acc_len;           /*!< acc 中有效（非零）部分的长度 */
+    uint8_t  k;
+    uint8_t  count;             /*!< 校验头中的数据报数，尚未收到校验数据报时为 0 */
+    bool     active;
+    bool     done;              /*!< 本组已恢复或没有丢失 */
+    uint32_t groups;            /*!< 见过的组数 */
+    uint32_t recovered;         /*!< 恢复的数据报数 */
+    uint32_t failed;            /*!< 有丢失但无法恢复的组数（丢失两个及以上；校验数据报丢失时只计组内有空缺的组） */
+} csi_fec_dec_t;
+
+void csi_fec_dec_init(csi_fec_dec_t *dec);
+
+/**
+ * @brief 带 FEC 信息的数据报（聚合容器或校验数据报）所属探针
+ *
+ * @return 探针 MAC，其它数据报返回 NULL
+ */
+const uint8_t *csi_fec_probe(const void *buf, size_t len);
+
+/**
+ * @brief 把该探针的一个数据报交给解码器
+ *
+ * 数据报按到达顺序交入；一组开始后收到更早的组的数据报时忽略。
+ * 恢复出的数据报与原始数据报逐字节相同，按正常收到的数据报处理即可（其中的帧通常比之后的帧晚到）。
+ *
+ * @param out 至少 CSI_FEC_MAX_DATAGRAM 字节
+ * @return 恢复出的数据报长度，没有恢复时返回 0
+ */
+size_t csi_fec_dec_push(csi_fec_dec_t *dec, const void *buf, size_t len, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,89 @@
+#include "csi_metrics.h"
+
+#include <string.h>
+
+void csi_metric_hist_init(csi_metric_hist_t *hist)
+{
+    atomic_init(&hist->count, 0);
+    atomic_init(&hist->sum, 0);
+    atomic_init(&hist->max, 0);
+    for (int i = 0; i < CSI_METRICS_BUCKETS; i++) {
+        atomic_init(&hist->buckets[i], 0);
+    }
+}
+
+unsigned csi_metric_bucket(uint32_t us)
+{
+    if (us < 2) {
+        return 0;
+    }
+    unsigned bucket = 31 - (unsigned)__builtin_clz(us);
+    return bucket < CSI_METRICS_BUCKETS ? bucket : CSI_METRICS_BUCKETS - 1;
+}
+
+void csi_metric_observe(csi_metric_hist_t *hist, uint32_t us)
+{
+    atomic_fetch_add_explicit(&hist->buckets[csi_metric_bucket(us)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->sum, us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->count, 1, memory_order_relaxed);
+
+    // 最大值只在变大时写入，通常一次读取就返回
+    uint32_t max = atomic_load_explicit(&hist->max, memory_order_relaxed);
+    while (us > max && !atomic_compare_exchange_weak_explicit(&hist->max, &max, us,
+                                                              memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void csi_metrics_writer_init(csi_metrics_writer_t *writer, void *buf, size_t size)
+{
+    memset(writer, 0, sizeof(*writer));
+    writer->buf = buf;
+    writer->size = size;
+}
+
+static bool writer_put(csi_metrics_writer_t *writer, const csi_ctrl_metric_t *metric, const void *data)
+{
+    if (writer->count == UINT8_MAX || writer->len + sizeof(*metric) + metric->len > writer->size) {
+        writer->overflow = true;
+        return false;
+    }
+
+    // 条目在应答中不对齐，用 memcpy 写入
+    memcpy(writer->buf + writer->len, metric, sizeof(*metric));
+    if (metric->len) {
+        memcpy(writer->buf + writer->len + sizeof(*metric), data, metric->len);
+    }
+    writer->len += sizeof(*metric) + metric->len;
+    writer->count++;
+    return true;
+}
+
+bool csi_metrics_put(csi_metrics_writer_t *writer, uint8_t id, uint8_t kind, uint32_t value)
+{
+    csi_ctrl_metric_t metric = {
+        .id = id,
+        .kind = kind,
+        .value = value,
+    };
+
+    return writer_put(writer, &metric, NULL);
+}
+
+bool csi_metrics_put_hist(csi_metrics_writer_t *writer, uint8_t id, const csi_metric_hist_t *hist)
+{
+    csi_ctrl_metric_hist_t data;
+    csi_ctrl_metric_t metric = {
+        .id = id,
+        .kind = CSI_CTRL_METRIC_HISTOGRAM,
+        .len = sizeof(data),
+        .value = atomic_load_explicit(&hist->count, memory_order_relaxed),
+    };
+
+    data.sum = atomic_load_explicit(&hist->sum, memory_order_relaxed);
+    data.max = atomic_load_explicit(&hist->max, memory_order_relaxed);
+    for (int i = 0; i < CSI_METRICS_BUCKETS; i++) {
+        data.buckets[i] = atomic_load_explicit(&hist->buckets[i], memory_order_relaxed);
+    }
+
+    return writer_put(writer, &metric, &data);
+}
@@ -0,0 +1,107 @@
+/**
+ * @file test_csi_metrics.c
+ * @brief csi_metrics 主机侧单元测试（linux target）
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "csi_metrics.h"
+
+static void test_bucket_bounds(void)
+{
+    TEST_ASSERT_EQUAL(0, csi_metric_bucket(0));
+    TEST_ASSERT_EQUAL(0, csi_metric_bucket(1));
+    TEST_ASSERT_EQUAL(1, csi_metric_bucket(2));
+    TEST_ASSERT_EQUAL(1, csi_metric_bucket(3));
+    TEST_ASSERT_EQUAL(6, csi_metric_bucket(64));
+    TEST_ASSERT_EQUAL(6, csi_metric_bucket(127));
+    TEST_ASSERT_EQUAL(14, csi_metric_bucket(32767));
+    TEST_ASSERT_EQUAL(CSI_METRICS_BUCKETS - 1, csi_metric_bucket(32768));
+    TEST_ASSERT_EQUAL(CSI_METRICS_BUCKETS - 1, csi_metric_bucket(UINT32_MAX));
+}
+
+static void test_observe(void)
+{
+    csi_metric_hist_t hist;
+    csi_metric_hist_init(&hist);
+
+    csi_metric_observe(&hist, 5);
+    csi_metric_observe(&hist, 7);
+    csi_metric_observe(&hist, 300);
+    csi_metric_observe(&hist, 0);
+
+    TEST_ASSERT_EQUAL_UINT32(4, hist.count);
+    TEST_ASSERT_EQUAL_UINT32(312, hist.sum);
+    TEST_ASSERT_EQUAL_UINT32(300, hist.max);
+    TEST_ASSERT_EQUAL_UINT32(1, hist.buckets[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, hist.buckets[2]);
+    TEST_ASSERT_EQUAL_UINT32(1, hist.buckets[8]);
+
+    // 计数器按 32 位回绕
+    csi_metric_counter_t counter = {0};
+    csi_metric_add(&counter, UINT32_MAX);
+    csi_metric_add(&counter, 3);
+    TEST_ASSERT_EQUAL_UINT32(2, csi_metric_read(&counter));
+}
+
+static void test_writer_entries(void)
+{
+    uint8_t buf[128];
+    csi_metrics_writer_t writer;
+    csi_metric_hist_t hist;
+    csi_metric_hist_init(&hist);
+    csi_metric_observe(&hist, 40);
+
+    csi_metrics_writer_init(&writer, buf, sizeof(buf));
+    TEST_ASSERT_TRUE(csi_metrics_put_counter(&writer, CSI_CTRL_METRIC_TX_FAILED, 17));
+    TEST_ASSERT_TRUE(csi_metrics_put_gauge(&writer, CSI_CTRL_METRIC_WIFI_RSSI, -61));
+    TEST_ASSERT_TRUE(csi_metrics_put_hist(&writer, CSI_CTRL_METRIC_SENDTO_US, &hist));
+    TEST_ASSERT_EQUAL(3, writer.count);
+    TEST_ASSERT_EQUAL(3 * sizeof(csi_ctrl_metric_t) + sizeof(csi_ctrl_metric_hist_t), writer.len);
+
+    csi_ctrl_metric_t metric;
+    memcpy(&metric, buf + sizeof(metric), sizeof(metric));
+    TEST_ASSERT_EQUAL(CSI_CTRL_METRIC_WIFI_RSSI, metric.id);
+    TEST_ASSERT_EQUAL(CSI_CTRL_METRIC_GAUGE, metric.kind);
+    TEST_ASSERT_EQUAL(0, metric.len);
+    TEST_ASSERT_EQUAL_INT32(-61, (int32_t)metric.value);
+
+    csi_ctrl_metric_hist_t data;
+    memcpy(&metric, buf + 2 * sizeof(metric), sizeof(metric));
+    memcpy(&data, buf + 3 * sizeof(metric), sizeof(data));
+    TEST_ASSERT_EQUAL(CSI_CTRL_METRIC_HISTOGRAM, metric.kind);
+    TEST_ASSERT_EQUAL(sizeof(data), metric.len);
+    TEST_ASSERT_EQUAL_UINT32(1, metric.value);
+    TEST_ASSERT_EQUAL_UINT32(40, data.sum);
+    TEST_ASSERT_EQUAL_UINT32(40, data.max);
+    TEST_ASSERT_EQUAL_UINT32(1, data.buckets[5]);
+}
+
+static void test_writer_overflow(void)
+{
+    uint8_t buf[2 * sizeof(csi_ctrl_metric_t) + 4];
+    csi_metrics_writer_t writer;
+    csi_metric_hist_t hist;
+    csi_metric_hist_init(&hist);
+
+    csi_metrics_writer_init(&writer, buf, sizeof(buf));
+    TEST_ASSERT_TRUE(csi_metrics_put_counter(&writer, CSI_CTRL_METRIC_RX_FRAMES, 1));
+    // 放不下的直方图被丢弃，之后较小的条目仍可写入
+    TEST_ASSERT_FALSE(csi_metrics_put_hist(&writer, CSI_CTRL_METRIC_SENDTO_US, &hist));
+    TEST_ASSERT_TRUE(csi_metrics_put_gauge(&writer, CSI_CTRL_METRIC_FREE_HEAP, 1000));
+    TEST_ASSERT_FALSE(csi_metrics_put_gauge(&writer, CSI_CTRL_METRIC_UPTIME_S, 1));
+    TEST_ASSERT_TRUE(writer.overflow);
+    TEST_ASSERT_EQUAL(2, writer.count);
+    TEST_ASSERT_EQUAL(2 * sizeof(csi_ctrl_metric_t), writer.len);
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bucket_bounds);
+    RUN_TEST(test_observe);
+    RUN_TEST(test_writer_entries);
+    RUN_TEST(test_writer_overflow);
+    int failures = UNITY_END();
+    exit(failures);
+}
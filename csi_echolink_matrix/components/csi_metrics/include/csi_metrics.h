@@ -0,0 +1,102 @@
+/**
+ * @file csi_metrics.h
+ * @brief 运行指标：无锁的原子计数器和耗时直方图，以及 STATS 应答（csi_ctrl.h）的编码
+ *
+ * 数据通路上的任务只做 relaxed 原子加法（ESP32-S3 上为 S32C1I 指令，不关中断、不加锁），
+ * 指标查询在另一个任务中读取，不会阻塞数据通路：
+ * - csi_metric_add() 累加计数器，32 位回绕，查询方按差值计算速率；
+ * - csi_metric_observe() 记录一个耗时样本（us），按 2 的幂分桶，同时累计样本数、和与最大值；
+ * - csi_metrics_writer_t 把计数器、GAUGE 和直方图依次写成 STATS 应答的条目。
+ *
+ * 直方图的各字段分别读取，与并发的 observe 之间不保证一致（样本数与各桶之和可能差几个样本）。
+ * 只依赖 C11 标准库，可在主机上编译并运行单元测试（见 host_test）。
+ */
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "csi_ctrl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_METRICS_BUCKETS     CSI_CTRL_METRIC_BUCKETS
+
+/** STATS 应答中条目的字节数上限：AirProbe 和 AirSight 的全部指标都不到其一半，应答缓冲区按此分配 */
+#define CSI_METRICS_REPLY_MAX   512
+
+typedef struct {
+    atomic_uint_least32_t value;
+} csi_metric_counter_t;
+
+typedef struct {
+    atomic_uint_least32_t count;
+    atomic_uint_least32_t sum;
+    atomic_uint_least32_t max;
+    atomic_uint_least32_t buckets[CSI_METRICS_BUCKETS];
+} csi_metric_hist_t;
+
+/** 静态变量按 0 初始化即可使用，栈上或需要清零的实例调用此函数 */
+void csi_metric_hist_init(csi_metric_hist_t *hist);
+
+static inline void csi_metric_add(csi_metric_counter_t *counter, uint32_t n)
+{
+    atomic_fetch_add_explicit(&counter->value, n, memory_order_relaxed);
+}
+
+static inline uint32_t csi_metric_read(const csi_metric_counter_t *counter)
+{
+    return atomic_load_explicit(&counter->value, memory_order_relaxed);
+}
+
+/**
+ * @brief 样本所在的桶：0-1 为桶 0，[2^i, 2^(i+1)) 为桶 i，超出的样本计入最后一个桶
+ */
+unsigned csi_metric_bucket(uint32_t us);
+
+/**
+ * @brief 记录一个耗时样本（us），可在任意任务中调用
+ */
+void csi_metric_observe(csi_metric_hist_t *hist, uint32_t us);
+
+/**
+ * @brief STATS 应答的条目写入器，条目依次写在 buf 中（不含 csi_ctrl_hdr_t）
+ */
+typedef struct {
+    uint8_t *buf;
+    size_t size;
+    size_t len;             /*!< 已写入的字节数，即 csi_ctrl_hdr_t.len */
+    uint8_t count;          /*!< 已写入的条目数，即 csi_ctrl_hdr_t.count */
+    bool overflow;          /*!< 有条目因空间不足被丢弃 */
+} csi_metrics_writer_t;
+
+void csi_metrics_writer_init(csi_metrics_writer_t *writer, void *buf, size_t size);
+
+/**
+ * @brief 写入一个计数器或 GAUGE 条目
+ *
+ * @return 空间不足时返回 false，条目不写入
+ */
+bool csi_metrics_put(csi_metrics_writer_t *writer, uint8_t id, uint8_t kind, uint32_t value);
+
+static inline bool csi_metrics_put_counter(csi_metrics_writer_t *writer, uint8_t id, uint32_t value)
+{
+    return csi_metrics_put(writer, id, CSI_CTRL_METRIC_COUNTER, value);
+}
+
+static inline bool csi_metrics_put_gauge(csi_metrics_writer_t *writer, uint8_t id, int32_t value)
+{
+    return csi_metrics_put(writer, id, CSI_CTRL_METRIC_GAUGE, (uint32_t)value);
+}
+
+/**
+ * @brief 写入一个直方图条目（csi_ctrl_metric_t + csi_ctrl_metric_hist_t）
+ */
+bool csi_metrics_put_hist(csi_metrics_writer_t *writer, uint8_t id, const csi_metric_hist_t *hist);
+
+#ifdef __cplusplus
+}
+#endif
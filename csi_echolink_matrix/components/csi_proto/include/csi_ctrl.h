@@ -0,0 +1,226 @@
+/**
+ * @file csi_ctrl.h
+ * @brief 主机 -> AirSight 控制数据报格式
+ *
+ * 控制数据报发送到 AirSight 的控制端口（Kconfig AIRSIGHT_CTRL_PORT），
+ * 与 CSI 数据端口分开，AirSight 在同一个 select 循环中处理。
+ * 公共头部与 csi_batch_hdr_t 同形（小端，紧凑排列），type 取值在 0x10 以上，
+ * 不会与 csi_frame_type_t 冲突：
+ *
+ *   +----------------+---------------------------+
+ *   | csi_ctrl_hdr_t | count 个条目 (len 字节)     |
+ *   +----------------+---------------------------+
+ *
+ * 每个请求都会收到一个应答，发回请求的源地址和端口。
+ *
+ * 转发目标有两类：转发表中的固定目标（FWD_SET），以及向 AirSight 发送 SUBSCRIBE
+ * 注册的订阅者。订阅者需要在租期内续约，过期后自动停止转发。
+ *
+ * 对时（TIME_REQ/TIME_RESP）由 AirProbe 发起，也可以发给主机上的对时服务（airsight_ctrl.py serve-time），
+ * 应答方的时钟即各探针帧头中 sync_us 的时间基准。
+ *
+ * SRC_GET 查询 AirSight 按数据源（探针）统计的帧序号：丢失、乱序、重启、空洞长度分布和到达抖动，
+ * 计数规则见 components/csi_seq，与主机侧 csi_recvd 的统计相同，两端对比即可区分空口丢失和局域网丢失。
+ *
+ * STATS_GET 查询运行指标（components/csi_metrics）：计数器自启动起累计，由查询方按两次查询的差值计算速率。
+ * AirSight 在控制端口应答，AirProbe 在 AIRPROBE_METRICS_PORT 应答；指标只在查询时读取，不经过数据通路。
+ *
+ * 本文件只依赖 C 标准头文件，主机侧工具可以直接包含。
+ */
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include "csi_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    CSI_CTRL_TYPE_FWD_SET = 0x10,    /*!< 请求：用 count 个 csi_ctrl_fwd_target_t 替换转发表 */
+    CSI_CTRL_TYPE_FWD_GET = 0x11,    /*!< 请求：查询转发表，无条目 */
+    CSI_CTRL_TYPE_FWD_STATUS = 0x12, /*!< 应答：count 个 csi_ctrl_fwd_status_t */
+    CSI_CTRL_TYPE_SUBSCRIBE = 0x13,  /*!< 请求：订阅或续约，csi_ctrl_subscribe_t + count 个探针 MAC（6 字节） */
+    CSI_CTRL_TYPE_UNSUBSCRIBE = 0x14, /*!< 请求：取消订阅，csi_ctrl_subscribe_t */
+    CSI_CTRL_TYPE_SUB_ACK = 0x15,    /*!< 应答：csi_ctrl_subscribe_t，lease_s 为实际租期，取消订阅时为 0 */
+    CSI_CTRL_TYPE_TIME_REQ = 0x16,   /*!< 请求：对时，csi_ctrl_time_t，只填 t1 */
+    CSI_CTRL_TYPE_TIME_RESP = 0x17,  /*!< 应答：csi_ctrl_time_t，原样带回 t1，填入 t2、t3 */
+    CSI_CTRL_TYPE_SRC_GET = 0x18,    /*!< 请求：查询各数据源的序号统计，无条目；可带 CSI_CTRL_FLAG_RESET */
+    CSI_CTRL_TYPE_SRC_STATUS = 0x19, /*!< 应答：count 个 csi_ctrl_src_status_t */
+    CSI_CTRL_TYPE_STATS_GET = 0x1A,  /*!< 请求：查询运行指标，无条目 */
+    CSI_CTRL_TYPE_STATS = 0x1B,      /*!< 应答：count 个指标条目（csi_ctrl_metric_t + len 字节附加数据） */
+} csi_ctrl_type_t;
+
+/** csi_ctrl_hdr_t.flags */
+#define CSI_CTRL_FLAG_PERSIST   0x01    /*!< FWD_SET：同时写入 NVS，重启后生效 */
+#define CSI_CTRL_FLAG_RESET     0x02    /*!< SRC_GET：应答后清零计数（序号状态保留） */
+#define CSI_CTRL_FLAG_ERROR     0x80    /*!< 应答：请求非法或执行失败，转发表未改变 */
+
+typedef struct __attribute__((packed)) {
+    uint8_t  magic;             /*!< CSI_FRAME_MAGIC */
+    uint8_t  version;           /*!< CSI_FRAME_VERSION */
+    uint8_t  type;              /*!< csi_ctrl_type_t */
+    uint8_t  hdr_len;           /*!< 头部长度，第一个条目从此偏移开始 */
+    uint8_t  count;             /*!< 条目数 */
+    uint8_t  flags;             /*!< CSI_CTRL_FLAG_* */
+    uint16_t len;               /*!< 头部之后所有条目的总字节数 */
+} csi_ctrl_hdr_t;
+
+static_assert(sizeof(csi_ctrl_hdr_t) == 8, "csi_ctrl_hdr_t is a wire format");
+
+typedef struct __attribute__((packed)) {
+    uint8_t  ip[4];             /*!< IPv4 地址，网络字节序（a.b.c.d 依次排列） */
+    uint16_t port;
+} csi_ctrl_fwd_target_t;
+
+static_assert(sizeof(csi_ctrl_fwd_target_t) == 6, "csi_ctrl_fwd_target_t is a wire format");
+
+typedef enum {
+    CSI_CTRL_FWD_STATE_UP = 0,      /*!< 正常转发 */
+    CSI_CTRL_FWD_STATE_BACKOFF = 1, /*!< 连续发送失败，退避期间跳过该目标 */
+} csi_ctrl_fwd_state_t;
+
+typedef enum {
+    CSI_CTRL_FWD_KIND_STATIC = 0,     /*!< 转发表中的固定目标 */
+    CSI_CTRL_FWD_KIND_SUBSCRIBER = 1, /*!< 通过 SUBSCRIBE 注册的订阅者 */
+    CSI_CTRL_FWD_KIND_MULTICAST = 2,  /*!< 局域网组播组（AIRSIGHT_MCAST_REPUBLISH） */
+} csi_ctrl_fwd_kind_t;
+
+typedef struct __attribute__((packed)) {
+    csi_ctrl_fwd_target_t target;
+    uint8_t  state;             /*!< csi_ctrl_fwd_state_t */
+    uint8_t  kind;              /*!< csi_ctrl_fwd_kind_t */
+    uint32_t backoff_ms;        /*!< 当前退避时长，UP 时为 0 */
+    uint32_t sent;              /*!< 发送成功的数据报数 */
+    uint32_t failed;            /*!< 发送失败的数据报数 */
+    uint32_t skipped;           /*!< 退避期间跳过的数据报数 */
+    uint64_t bytes;             /*!< 发送成功的字节数 */
+} csi_ctrl_fwd_status_t;
+
+static_assert(sizeof(csi_ctrl_fwd_status_t) == 32, "csi_ctrl_fwd_status_t is a wire format");
+
+/**
+ * 订阅者以 (请求的源 IP, port) 标识。租期内重复发送 SUBSCRIBE 即为续约，
+ * 同时用本次携带的 MAC 列表替换过滤条件；count 为 0 表示接收所有探针的数据。
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t port;              /*!< 接收 CSI 数据的端口，0 表示使用请求的源端口 */
+    uint16_t lease_s;           /*!< 请求的租期（秒），0 表示使用默认值 */
+} csi_ctrl_subscribe_t;
+
+static_assert(sizeof(csi_ctrl_subscribe_t) == 4, "csi_ctrl_subscribe_t is a wire format");
+
+typedef enum {
+    CSI_CTRL_SRC_KIND_PROBE = 0,    /*!< 二进制帧，id 为探针 MAC */
+    CSI_CTRL_SRC_KIND_ADDRESS = 1,  /*!< CSV 文本，id 为发送端 IPv4 地址（4 字节）+ 端口（网络字节序） */
+} csi_ctrl_src_kind_t;
+
+/** 一个数据源的序号统计，计数自 AirSight 启动或上次 RESET 起累计 */
+typedef struct __attribute__((packed)) {
+    uint8_t  id[6];
+    uint8_t  kind;              /*!< csi_ctrl_src_kind_t */
+    uint8_t  reserved;
+    uint32_t received;
+    uint32_t lost;
+    uint32_t duplicate;
+    uint32_t reordered;
+    uint32_t restarts;
+    uint32_t jitter_us;         /*!< 到达抖动，CSV 文本为 0 */
+    uint32_t last_seq;
+    uint32_t idle_ms;           /*!< 距上一帧的时间 */
+    uint32_t gaps[8];           /*!< 空洞个数，按丢失的帧数分桶：1、2-3、4-7、...、128 及以上 */
+} csi_ctrl_src_status_t;
+
+static_assert(sizeof(csi_ctrl_src_status_t) == 72, "csi_ctrl_src_status_t is a wire format");
+
+typedef enum {
+    CSI_CTRL_METRIC_COUNTER = 0,    /*!< 自启动起累计，32 位回绕 */
+    CSI_CTRL_METRIC_GAUGE = 1,      /*!< 查询时刻的值，有符号 */
+    CSI_CTRL_METRIC_HISTOGRAM = 2,  /*!< value 为样本数，后接 csi_ctrl_metric_hist_t */
+} csi_ctrl_metric_kind_t;
+
+/** 指标编号，两个节点共用；节点只上报自己有的指标 */
+typedef enum {
+    CSI_CTRL_METRIC_UPTIME_S = 0x01,        /*!< GAUGE：启动后的秒数 */
+    CSI_CTRL_METRIC_FREE_HEAP = 0x02,       /*!< GAUGE：空闲堆（字节） */
+    CSI_CTRL_METRIC_MIN_FREE_HEAP = 0x03,   /*!< GAUGE：空闲堆的历史最小值（字节） */
+    CSI_CTRL_METRIC_WIFI_RSSI = 0x04,       /*!< GAUGE：STA 与所连 AP 的 RSSI（dBm），未连接时不上报 */
+    CSI_CTRL_METRIC_CSI_CALLBACKS = 0x10,   /*!< COUNTER：AirProbe 接收的 CSI 回调数（白名单内） */
+    CSI_CTRL_METRIC_CSI_ENCODE_US = 0x11,   /*!< HISTOGRAM：AirProbe 每帧编码耗时 */
+    CSI_CTRL_METRIC_RING_USED = 0x12,       /*!< GAUGE：AirProbe 环形缓冲区当前占用的槽位数 */
+    CSI_CTRL_METRIC_RING_HIGH_WATER = 0x13, /*!< GAUGE：AirProbe 环形缓冲区历史最大占用 */
+    CSI_CTRL_METRIC_RING_OVERFLOW = 0x14,   /*!< COUNTER：AirProbe 环形缓冲区满丢弃的帧数 */
+    CSI_CTRL_METRIC_CSI_SENT = 0x15,        /*!< COUNTER：AirProbe 发送的原始帧数，即下一帧的 seq（只发送特征时不上报） */
+    CSI_CTRL_METRIC_TRIGGER_SUPPRESSED = 0x16, /*!< COUNTER：AirProbe 运动触发器没有发送的帧数（不占用 seq） */
+    CSI_CTRL_METRIC_RX_DATAGRAMS = 0x20,    /*!< COUNTER：AirSight 收到的数据报数 */
+    CSI_CTRL_METRIC_RX_FRAMES = 0x21,       /*!< COUNTER：AirSight 收到的 CSI 帧数 */
+    CSI_CTRL_METRIC_RX_TRUNCATED = 0x22,    /*!< COUNTER：AirSight 超长被丢弃的数据报数 */
+    CSI_CTRL_METRIC_TX_DATAGRAMS = 0x30,    /*!< COUNTER：发送成功的数据报数（AirSight 按目标计） */
+    CSI_CTRL_METRIC_TX_FAILED = 0x31,       /*!< COUNTER：发送失败的数据报数（AirProbe 含未连接时丢弃的） */
+    CSI_CTRL_METRIC_SENDTO_US = 0x32,       /*!< HISTOGRAM：每次 sendto 的耗时 */
+} csi_ctrl_metric_id_t;
+
+/** 直方图的桶数：桶 0 为 0-1 us，桶 i 为 [2^i, 2^(i+1)) us，最后一个桶包含 32768 us 及以上 */
+#define CSI_CTRL_METRIC_BUCKETS 16
+
+/** STATS 应答的一个条目，len 为其后附加数据的字节数，解析时据此跳过未知的 kind */
+typedef struct __attribute__((packed)) {
+    uint8_t  id;                /*!< csi_ctrl_metric_id_t */
+    uint8_t  kind;              /*!< csi_ctrl_metric_kind_t */
+    uint16_t len;               /*!< HISTOGRAM 为 sizeof(csi_ctrl_metric_hist_t)，其余为 0 */
+    uint32_t value;             /*!< 计数器的累计值、GAUGE 的值（按 int32_t 解释）或直方图的样本数 */
+} csi_ctrl_metric_t;
+
+static_assert(sizeof(csi_ctrl_metric_t) == 8, "csi_ctrl_metric_t is a wire format");
+
+typedef struct __attribute__((packed)) {
+    uint32_t sum;               /*!< 样本之和（us），32 位回绕 */
+    uint32_t max;               /*!< 最大样本（us） */
+    uint32_t buckets[CSI_CTRL_METRIC_BUCKETS];
+} csi_ctrl_metric_hist_t;
+
+static_assert(sizeof(csi_ctrl_metric_hist_t) == 72, "csi_ctrl_metric_hist_t is a wire format");
+
+/**
+ * SNTP 式对时：t1/t4 为请求方的时钟，t2/t3 为应答方的时钟，均为微秒。
+ * AirSight 用 esp_timer（启动后的微秒数），主机对时服务用 Unix 微秒。
+ */
+typedef struct __attribute__((packed)) {
+    int64_t  t1;                /*!< 请求方发出请求的时刻 */
+    int64_t  t2;                /*!< 应答方收到请求的时刻 */
+    int64_t  t3;                /*!< 应答方发出应答的时刻 */
+} csi_ctrl_time_t;
+
+static_assert(sizeof(csi_ctrl_time_t) == 24, "csi_ctrl_time_t is a wire format");
+
+static inline void csi_ctrl_hdr_init(csi_ctrl_hdr_t *hdr, uint8_t type)
+{
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = CSI_FRAME_MAGIC;
+    hdr->version = CSI_FRAME_VERSION;
+    hdr->type = type;
+    hdr->hdr_len = sizeof(*hdr);
+}
+
+/**
+ * @brief 校验 buf 中是否为一个完整的控制数据报
+ *
+ * @return 头部指针，条目位于 (uint8_t *)buf + hdr->hdr_len；不是合法控制数据报时返回 NULL
+ */
+static inline const csi_ctrl_hdr_t *csi_ctrl_check(const void *buf, size_t size)
+{
+    const csi_ctrl_hdr_t *hdr = (const csi_ctrl_hdr_t *)buf;
+
+    if (size < sizeof(csi_ctrl_hdr_t) || hdr->magic != CSI_FRAME_MAGIC
+            || hdr->hdr_len < sizeof(csi_ctrl_hdr_t) || (size_t)hdr->hdr_len + hdr->len > size) {
+        return NULL;
+    }
+
+    return hdr;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,393 @@
+/**
+ * @file csi_frame.h
+ * @brief AirProbe -> AirSight -> 主机 之间传输 CSI 数据的二进制帧格式
+ *
+ * 帧结构（小端，紧凑排列，无填充）：
+ *
+ *   +-------------------+----------------------------+
+ *   | csi_frame_hdr_t   | int8 I/Q 原始数据 (len 字节) |
+ *   +-------------------+----------------------------+
+ *
+ * 聚合模式下多个完整的帧首尾相接，放在一个 csi_batch_hdr_t 之后，
+ * 整个容器不超过 CSI_DATAGRAM_MAX_SIZE，作为一个 UDP 数据报发送：
+ *
+ *   +-----------------+---------+---------+-----+
+ *   | csi_batch_hdr_t | 帧 0    | 帧 1    | ... |
+ *   +-----------------+---------+---------+-----+
+ *
+ * 特征模式下 AirProbe 在设备上按时间窗口计算统计量，每个窗口发送一个特征数据报
+ * （见 components/csi_features），不含原始 I/Q：
+ *
+ *   +----------------------+-------------------------------+
+ *   | csi_features_hdr_t   | n_sub 个 uint16 幅度方差 (Q4)  |
+ *   +----------------------+-------------------------------+
+ *
+ * 开启 FEC 时聚合容器头之后追加 csi_batch_fec_t（flags 置 CSI_BATCH_FLAG_FEC，hdr_len 相应增加），
+ * 每 k 个聚合数据报之后发送一个校验数据报，内容为这一组数据报逐字节异或（短的按 0 补齐），
+ * 主机收到同组其余数据报和校验数据报时可以恢复丢失的一个（见 components/csi_fec）：
+ *
+ *   +------------------+-----------------------------------+
+ *   | csi_parity_hdr_t | 组内各数据报的异或 (len 字节)        |
+ *   +------------------+-----------------------------------+
+ *
+ * 开启压缩时 AirProbe 发送 CSI_FRAME_TYPE_PACKED 帧（单帧或放在聚合容器中），帧头不变，
+ * 数据区为 csi_codec_hdr_t 和编码后的 I/Q（见 components/csi_codec），len 为整个数据区的长度：
+ *
+ *   +-------------------+-----------------+---------------------+
+ *   | csi_frame_hdr_t   | csi_codec_hdr_t | 编码后的 I/Q         |
+ *   +-------------------+-----------------+---------------------+
+ *
+ * - magic 固定为 CSI_FRAME_MAGIC，用于和 "CSI_DATA,..." 文本格式区分；
+ * - version 每次扩展头部时递增，解码端按 hdr_len 定位数据区，
+ *   因此旧解码器可以跳过新版本追加在头部末尾的字段；
+ * - rx_ctrl 各字段与 CSV 文本格式的列一一对应（见 datastorage/config.py）；
+ * - version 2 在 csi_frame_hdr_t 末尾追加了激励源下标和源内序号（多发射端时按源分流），
+ *   解码端对 hdr_len 小于 sizeof(csi_frame_hdr_t) 的 version 1 帧按源 0 处理（见 csi_frame_tx()）。
+ * - version 3 追加了同步时间戳：接收时刻换算到参考时钟（AirSight 或主机对时服务，见 csi_ctrl.h 的
+ *   TIME_REQ）的微秒数，以及探针估计的频率差和误差，多个探针的帧可以按 sync_us 对齐（见 csi_frame_sync()）。
+ *
+ * 本文件只依赖 C 标准头文件，主机侧工具可以直接包含。
+ */
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CSI_FRAME_MAGIC         0xC5
+#define CSI_FRAME_VERSION       3
+
+/** 单帧 CSI 数据的最大长度（HT40 + STBC 时为 612 字节：LLTF 64 + HT-LTF 121 + STBC-HT-LTF 121 个子载波） */
+#define CSI_FRAME_MAX_PAYLOAD   612
+
+/** 单个 UDP 数据报的最大长度：1500 字节 MTU - IPv4 头 - UDP 头 */
+#define CSI_DATAGRAM_MAX_SIZE   1472
+
+typedef enum {
+    CSI_FRAME_TYPE_RAW = 0x01,  /*!< csi_frame_hdr_t + int8 I/Q 原始数据 */
+    CSI_FRAME_TYPE_BATCH = 0x02, /*!< csi_batch_hdr_t + count 个完整的 CSI 帧 */
+    CSI_FRAME_TYPE_FEATURES = 0x03, /*!< csi_features_hdr_t + n_sub 个子载波的幅度方差 */
+    CSI_FRAME_TYPE_PARITY = 0x04, /*!< csi_parity_hdr_t + 一组聚合数据报的异或校验 */
+    CSI_FRAME_TYPE_PACKED = 0x05, /*!< csi_frame_hdr_t + csi_codec_hdr_t + 压缩的 I/Q */
+    /* 0x10 及以上保留给控制数据报，见 csi_ctrl.h */
+} csi_frame_type_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  magic;             /*!< CSI_FRAME_MAGIC */
+    uint8_t  version;           /*!< CSI_FRAME_VERSION */
+    uint8_t  type;              /*!< csi_frame_type_t */
+    uint8_t  hdr_len;           /*!< 头部长度，数据区从此偏移开始 */
+    uint32_t seq;               /*!< 探针内单调递增的帧序号，只有发送的帧占用序号，空缺即传输中丢失 */
+    uint32_t local_timestamp;   /*!< rx_ctrl->timestamp，本地微秒计数 */
+    uint8_t  probe_mac[6];      /*!< 采集该帧的 AirProbe STA MAC */
+    uint8_t  mac[6];            /*!< 发送端 MAC（info->mac） */
+    int8_t   rssi;
+    uint8_t  rate;
+    uint8_t  sig_mode;
+    uint8_t  mcs;
+    uint8_t  cwb;               /*!< bandwidth: 0 = 20MHz, 1 = 40MHz */
+    uint8_t  smoothing;
+    uint8_t  not_sounding;
+    uint8_t  aggregation;
+    uint8_t  stbc;
+    uint8_t  fec_coding;
+    uint8_t  sgi;
+    int8_t   noise_floor;
+    uint8_t  ampdu_cnt;
+    uint8_t  channel;
+    uint8_t  secondary_channel;
+    uint8_t  ant;
+    uint8_t  rx_state;
+    uint8_t  first_word_invalid;
+    uint16_t sig_len;
+    uint16_t len;               /*!< 数据区长度（字节） */
+    /* version 2 */
+    uint8_t  tx;                /*!< 激励源（发射端）下标，即 mac 在 AirProbe 源白名单中的位置（见 components/csi_source） */
+    uint8_t  reserved;
+    uint32_t tx_seq;            /*!< 该激励源内单调递增的帧序号，与 seq 一样只计发送的帧 */
+    /* version 3 */
+    int64_t  sync_us;           /*!< 接收时刻（参考时钟微秒），探针尚未同步时为 0 */
+    int32_t  drift_ppb;         /*!< 参考时钟相对探针时钟的频率差 */
+    uint32_t sync_err_us;       /*!< sync_us 的误差估计 */
+} csi_frame_hdr_t;
+
+static_assert(sizeof(csi_frame_hdr_t) == 68, "csi_frame_hdr_t is a wire format");
+
+/** version 1 的帧头长度（不含 tx / tx_seq） */
+#define CSI_FRAME_HDR_V1_SIZE   offsetof(csi_frame_hdr_t, tx)
+/** version 2 的帧头长度（不含同步时间戳） */
+#define CSI_FRAME_HDR_V2_SIZE   offsetof(csi_frame_hdr_t, sync_us)
+
+typedef struct __attribute__((packed)) {
+    uint8_t  magic;             /*!< CSI_FRAME_MAGIC */
+    uint8_t  version;           /*!< CSI_FRAME_VERSION */
+    uint8_t  type;              /*!< CSI_FRAME_TYPE_BATCH */
+    uint8_t  hdr_len;           /*!< 头部长度，第一个帧从此偏移开始 */
+    uint8_t  count;             /*!< 容器中的帧数 */
+    uint8_t  flags;             /*!< CSI_BATCH_FLAG_* */
+    uint16_t len;               /*!< 头部之后所有帧的总字节数 */
+} csi_batch_hdr_t;
+
+static_assert(sizeof(csi_batch_hdr_t) == 8, "csi_batch_hdr_t is a wire format");
+
+/** 容器头之后紧跟 csi_batch_fec_t */
+#define CSI_BATCH_FLAG_FEC      0x01
+
+/**
+ * 聚合容器的 FEC 分组信息，追加在 csi_batch_hdr_t 之后（hdr_len 包含该结构）
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t  probe_mac[6];      /*!< 发送该容器的 AirProbe STA MAC */
+    uint16_t group;             /*!< 校验组序号，探针内递增（回绕） */
+    uint8_t  index;             /*!< 在组内的位置，0 .. k-1 */
+    uint8_t  k;                 /*!< 配置的组大小 */
+} csi_batch_fec_t;
+
+static_assert(sizeof(csi_batch_fec_t) == 10, "csi_batch_fec_t is a wire format");
+
+/**
+ * 校验数据报头。数据区为组内 count 个数据报（含各自的容器头）逐字节异或，
+ * 长度为其中最长的一个，较短的数据报按 0 补齐。
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t  magic;             /*!< CSI_FRAME_MAGIC */
+    uint8_t  version;           /*!< CSI_FRAME_VERSION */
+    uint8_t  type;              /*!< CSI_FRAME_TYPE_PARITY */
+    uint8_t  hdr_len;           /*!< 头部长度，校验数据从此偏移开始 */
+    uint8_t  probe_mac[6];
+    uint16_t group;             /*!< 与 csi_batch_fec_t.group 对应 */
+    uint8_t  count;             /*!< 组内实际的数据报数，发送暂停时组可能未满 k 个 */
+    uint8_t  reserved;
+    uint16_t len_xor;           /*!< 组内各数据报长度的异或 */
+    uint16_t len;               /*!< 校验数据长度 */
+} csi_parity_hdr_t;
+
+static_assert(sizeof(csi_parity_hdr_t) == 18, "csi_parity_hdr_t is a wire format");
+
+/**
+ * 压缩帧（CSI_FRAME_TYPE_PACKED）数据区的开头，之后为 csi_codec 编码的 I/Q。
+ * 只占 2 字节：LLTF 一帧压缩后约 40~50 字节，头部越短压缩率越高。
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t info;              /*!< 低 12 位为解码后的 I/Q 字节数，高 4 位为编码前舍去的低位数（0 为无损） */
+} csi_codec_hdr_t;
+
+#define CSI_CODEC_INFO(raw_len, quant)  ((uint16_t)((raw_len) | (unsigned)(quant) << 12))
+#define CSI_CODEC_RAW_LEN(info)         ((size_t)((info) & 0x0FFF))
+#define CSI_CODEC_QUANT(info)           ((unsigned)((info) >> 12))
+
+static_assert(sizeof(csi_codec_hdr_t) == 2, "csi_codec_hdr_t is a wire format");
+
+/**
+ * 一个时间窗口的特征。定点数 Qn 表示数值乘以 2^n 后取整；幅度为 sqrt(I^2 + Q^2)（int8 单位）。
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t  magic;             /*!< CSI_FRAME_MAGIC */
+    uint8_t  version;           /*!< CSI_FRAME_VERSION */
+    uint8_t  type;              /*!< CSI_FRAME_TYPE_FEATURES */
+    uint8_t  hdr_len;           /*!< 头部长度，方差数组从此偏移开始 */
+    uint32_t seq;               /*!< 探针内单调递增的窗口序号 */
+    uint32_t frame_seq;         /*!< 窗口中第一帧的采集序号（CSI 回调收到的帧数，含没有发送的帧） */
+    uint32_t local_timestamp;   /*!< 窗口中第一帧的 rx_ctrl->timestamp */
+    uint32_t duration_us;       /*!< 第一帧到最后一帧的时间 */
+    uint8_t  probe_mac[6];
+    uint8_t  mac[6];            /*!< 发送端 MAC */
+    uint16_t frames;            /*!< 窗口中的帧数 */
+    uint8_t  n_sub;             /*!< 子载波数 */
+    uint8_t  reserved;
+    int16_t  rssi_mean_q8;      /*!< 平均 RSSI（dBm，Q8） */
+    int16_t  rssi_slope_q8;     /*!< RSSI 随时间的最小二乘斜率（dB/s，Q8） */
+    uint16_t amp_mean_q8;       /*!< 所有子载波的平均幅度（Q8） */
+    uint32_t motion_q8;         /*!< 运动能量：相邻帧幅度差的平方，按帧对和子载波平均（Q8） */
+    uint16_t len;               /*!< 头部之后的字节数，n_sub * 2 */
+} csi_features_hdr_t;
+
+static_assert(sizeof(csi_features_hdr_t) == 48, "csi_features_hdr_t is a wire format");
+
+/**
+ * @brief 初始化帧头的公共字段
+ */
+static inline void csi_frame_hdr_init(csi_frame_hdr_t *hdr, uint8_t type)
+{
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = CSI_FRAME_MAGIC;
+    hdr->version = CSI_FRAME_VERSION;
+    hdr->type = type;
+    hdr->hdr_len = sizeof(*hdr);
+}
+
+/**
+ * @brief 校验 buf 中是否为一个完整的 CSI 帧
+ *
+ * @return 帧总长度（头部 + 数据），不是合法帧时返回 0
+ */
+static inline size_t csi_frame_check(const void *buf, size_t size)
+{
+    const csi_frame_hdr_t *hdr = (const csi_frame_hdr_t *)buf;
+
+    if (size < CSI_FRAME_HDR_V1_SIZE || hdr->magic != CSI_FRAME_MAGIC
+            || hdr->hdr_len < CSI_FRAME_HDR_V1_SIZE) {
+        return 0;
+    }
+
+    size_t total = (size_t)hdr->hdr_len + hdr->len;
+    return total <= size ? total : 0;
+}
+
+/**
+ * @brief 帧的激励源下标和源内序号；version 1 的帧没有这两个字段，返回源 0 和 hdr->seq
+ */
+static inline uint8_t csi_frame_tx(const csi_frame_hdr_t *hdr, uint32_t *tx_seq)
+{
+    if (hdr->hdr_len < CSI_FRAME_HDR_V2_SIZE) {
+        *tx_seq = hdr->seq;
+        return 0;
+    }
+
+    *tx_seq = hdr->tx_seq;
+    return hdr->tx;
+}
+
+/**
+ * @brief 帧的同步时间戳；version 3 之前的帧没有该字段，与未同步的帧一样返回 0，drift_ppb、err_us 为 0
+ */
+static inline int64_t csi_frame_sync(const csi_frame_hdr_t *hdr, int32_t *drift_ppb, uint32_t *err_us)
+{
+    if (hdr->hdr_len < sizeof(csi_frame_hdr_t)) {
+        *drift_ppb = 0;
+        *err_us = 0;
+        return 0;
+    }
+
+    *drift_ppb = hdr->drift_ppb;
+    *err_us = hdr->sync_err_us;
+    return hdr->sync_us;
+}
+
+static inline void csi_batch_hdr_init(csi_batch_hdr_t *hdr)
+{
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = CSI_FRAME_MAGIC;
+    hdr->version = CSI_FRAME_VERSION;
+    hdr->type = CSI_FRAME_TYPE_BATCH;
+    hdr->hdr_len = sizeof(*hdr);
+}
+
+/**
+ * @brief 校验 buf 中是否为一个完整的特征数据报
+ *
+ * @return 头部指针，方差数组位于 (uint8_t *)buf + hdr->hdr_len；不是特征数据报时返回 NULL
+ */
+static inline const csi_features_hdr_t *csi_features_check(const void *buf, size_t size)
+{
+    const csi_features_hdr_t *hdr = (const csi_features_hdr_t *)buf;
+
+    if (size < sizeof(csi_features_hdr_t) || hdr->magic != CSI_FRAME_MAGIC
+            || hdr->type != CSI_FRAME_TYPE_FEATURES || hdr->hdr_len < sizeof(csi_features_hdr_t)
+            || (size_t)hdr->hdr_len + hdr->len > size || hdr->len < (size_t)hdr->n_sub * 2) {
+        return NULL;
+    }
+
+    return hdr;
+}
+
+/**
+ * @brief 聚合容器的 FEC 分组信息
+ *
+ * @return 分组信息指针，不是带 FEC 扩展的聚合容器时返回 NULL
+ */
+static inline const csi_batch_fec_t *csi_batch_fec(const void *buf, size_t size)
+{
+    const csi_batch_hdr_t *hdr = (const csi_batch_hdr_t *)buf;
+
+    if (size < sizeof(csi_batch_hdr_t) + sizeof(csi_batch_fec_t) || hdr->magic != CSI_FRAME_MAGIC
+            || hdr->type != CSI_FRAME_TYPE_BATCH || !(hdr->flags & CSI_BATCH_FLAG_FEC)
+            || hdr->hdr_len < sizeof(csi_batch_hdr_t) + sizeof(csi_batch_fec_t)) {
+        return NULL;
+    }
+
+    return (const csi_batch_fec_t *)(hdr + 1);
+}
+
+/**
+ * @brief 校验 buf 中是否为一个完整的校验数据报
+ *
+ * @return 头部指针，校验数据位于 (uint8_t *)buf + hdr->hdr_len；不是校验数据报时返回 NULL
+ */
+static inline const csi_parity_hdr_t *csi_parity_check(const void *buf, size_t size)
+{
+    const csi_parity_hdr_t *hdr = (const csi_parity_hdr_t *)buf;
+
+    if (size < sizeof(csi_parity_hdr_t) || hdr->magic != CSI_FRAME_MAGIC
+            || hdr->type != CSI_FRAME_TYPE_PARITY || hdr->hdr_len < sizeof(csi_parity_hdr_t)
+            || (size_t)hdr->hdr_len + hdr->len > size || hdr->count == 0) {
+        return NULL;
+    }
+
+    return hdr;
+}
+
+/**
+ * @brief 遍历一个数据报中的 CSI 帧，单帧和聚合容器都适用
+ *
+ * 返回的帧可能是 CSI_FRAME_TYPE_RAW 或 CSI_FRAME_TYPE_PACKED，使用数据区之前须检查 hdr->type。
+ *
+ * 用法：
+ *   csi_frame_iter_t it;
+ *   csi_frame_iter_init(&it, buf, size);
+ *   for (const csi_frame_hdr_t *hdr; (hdr = csi_frame_iter_next(&it)) != NULL;) { ... }
+ */
+typedef struct {
+    const uint8_t *pos;
+    const uint8_t *end;
+} csi_frame_iter_t;
+
+static inline void csi_frame_iter_init(csi_frame_iter_t *it, const void *buf, size_t size)
+{
+    const csi_batch_hdr_t *batch = (const csi_batch_hdr_t *)buf;
+
+    it->pos = (const uint8_t *)buf;
+    it->end = it->pos + size;
+
+    // 特征数据报、校验数据报和控制数据报中没有 CSI 帧
+    if (size >= sizeof(csi_batch_hdr_t) && batch->magic == CSI_FRAME_MAGIC && batch->type != CSI_FRAME_TYPE_RAW
+            && batch->type != CSI_FRAME_TYPE_PACKED && batch->type != CSI_FRAME_TYPE_BATCH) {
+        it->pos = it->end;
+        return;
+    }
+
+    if (size >= sizeof(csi_batch_hdr_t) && batch->magic == CSI_FRAME_MAGIC
+            && batch->type == CSI_FRAME_TYPE_BATCH) {
+        if (batch->hdr_len < sizeof(csi_batch_hdr_t) || (size_t)batch->hdr_len + batch->len > size) {
+            it->pos = it->end;
+            return;
+        }
+        it->pos += batch->hdr_len;
+        it->end = it->pos + batch->len;
+    }
+}
+
+/**
+ * @return 下一个合法帧的头部指针，没有更多帧（或遇到非法数据）时返回 NULL
+ */
+static inline const csi_frame_hdr_t *csi_frame_iter_next(csi_frame_iter_t *it)
+{
+    size_t size = csi_frame_check(it->pos, (size_t)(it->end - it->pos));
+    if (size == 0) {
+        it->pos = it->end;
+        return NULL;
+    }
+
+    const csi_frame_hdr_t *hdr = (const csi_frame_hdr_t *)it->pos;
+    it->pos += size;
+    return hdr;
+}
+
+#ifdef __cplusplus
+}
+#endif
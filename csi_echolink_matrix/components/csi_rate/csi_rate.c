@@ -0,0 +1,77 @@
+#include "csi_rate.h"
+
+#include <string.h>
+
+static void set_rate(csi_rate_t *rate, uint32_t hz)
+{
+    rate->rate_hz = hz;
+    rate->interval_ms = (2000 / hz + 1) / 2;
+}
+
+bool csi_rate_init(csi_rate_t *rate, const csi_rate_config_t *config)
+{
+    if (config->min_hz == 0 || config->min_hz > config->max_hz || config->max_hz > 1000
+            || config->step_hz == 0 || config->max_loss_pct > 100 || config->min_yield_pct > 100) {
+        return false;
+    }
+
+    memset(rate, 0, sizeof(*rate));
+    rate->config = *config;
+    set_rate(rate, config->max_hz);
+    return true;
+}
+
+static uint8_t congestion_of(const csi_rate_config_t *config, const csi_rate_sample_t *s)
+{
+    uint8_t congestion = 0;
+
+    if ((uint64_t)s->timeouts * 100 > (uint64_t)config->max_loss_pct * s->pings) {
+        congestion |= CSI_RATE_CONGESTION_LOSS;
+    }
+    if ((uint64_t)s->csi_frames * 100 < (uint64_t)config->min_yield_pct * s->pings) {
+        congestion |= CSI_RATE_CONGESTION_YIELD;
+    }
+    if (s->overflow > 0) {
+        congestion |= CSI_RATE_CONGESTION_OVERFLOW;
+    }
+    if (s->queue_capacity > 0 && s->queue_depth * 2 > s->queue_capacity) {
+        congestion |= CSI_RATE_CONGESTION_QUEUE;
+    }
+    if (s->send_errors > 0) {
+        congestion |= CSI_RATE_CONGESTION_SEND;
+    }
+    return congestion;
+}
+
+csi_rate_action_t csi_rate_update(csi_rate_t *rate, const csi_rate_sample_t *sample)
+{
+    const csi_rate_config_t *config = &rate->config;
+    uint32_t hz = rate->rate_hz;
+
+    if (sample->pings == 0) {
+        rate->congestion = 0;
+        return CSI_RATE_HOLD;
+    }
+
+    rate->congestion = congestion_of(config, sample);
+    if (rate->congestion) {
+        rate->hold = config->hold_periods;
+        if (hz <= config->min_hz) {
+            return CSI_RATE_HOLD;
+        }
+        hz = hz * 3 / 4;
+        set_rate(rate, hz > config->min_hz ? hz : config->min_hz);
+        return CSI_RATE_DOWN;
+    }
+
+    if (rate->hold > 0) {
+        rate->hold--;
+        return CSI_RATE_HOLD;
+    }
+    if (hz >= config->max_hz) {
+        return CSI_RATE_HOLD;
+    }
+    hz += config->step_hz;
+    set_rate(rate, hz < config->max_hz ? hz : config->max_hz);
+    return CSI_RATE_UP;
+}
@@ -0,0 +1,169 @@
+/**
+ * @file test_csi_rate.c
+ * @brief csi_rate 主机侧单元测试（linux target）
+ */
+#include <stdlib.h>
+#include "unity.h"
+#include "csi_rate.h"
+
+static const csi_rate_config_t s_config = {
+    .min_hz = 5,
+    .max_hz = 100,
+    .step_hz = 2,
+    .max_loss_pct = 10,
+    .min_yield_pct = 80,
+    .hold_periods = 2,
+};
+
+/* 1 s 周期内按当前速率发出的 ping 全部得到应答、每个应答产生一帧 CSI */
+static csi_rate_sample_t healthy(const csi_rate_t *rate)
+{
+    uint32_t pings = rate->rate_hz;
+    csi_rate_sample_t s = {
+        .pings = pings,
+        .csi_frames = pings,
+        .queue_capacity = 64,
+    };
+    return s;
+}
+
+static void test_init_rejects_invalid_config(void)
+{
+    csi_rate_t rate;
+    csi_rate_config_t config = s_config;
+
+    config.min_hz = 0;
+    TEST_ASSERT_FALSE(csi_rate_init(&rate, &config));
+    config = s_config;
+    config.min_hz = 101;
+    TEST_ASSERT_FALSE(csi_rate_init(&rate, &config));
+    config = s_config;
+    config.max_hz = 1001;
+    TEST_ASSERT_FALSE(csi_rate_init(&rate, &config));
+    config = s_config;
+    config.step_hz = 0;
+    TEST_ASSERT_FALSE(csi_rate_init(&rate, &config));
+    config = s_config;
+    config.max_loss_pct = 101;
+    TEST_ASSERT_FALSE(csi_rate_init(&rate, &config));
+    TEST_ASSERT_TRUE(csi_rate_init(&rate, &s_config));
+    TEST_ASSERT_EQUAL_UINT16(100, rate.rate_hz);
+    TEST_ASSERT_EQUAL_UINT16(10, rate.interval_ms);
+}
+
+static void test_each_congestion_signal_slows_down(void)
+{
+    csi_rate_t rate;
+
+    for (int signal = 0; signal < 5; signal++) {
+        TEST_ASSERT_TRUE(csi_rate_init(&rate, &s_config));
+        csi_rate_sample_t s = healthy(&rate);
+        switch (signal) {
+        case 0: s.timeouts = 11; break;             // 11% 超时
+        case 1: s.csi_frames = 79; break;           // 79% 的 ping 产生了 CSI
+        case 2: s.overflow = 1; break;
+        case 3: s.queue_depth = 33; break;
+        case 4: s.send_errors = 1; break;
+        }
+        TEST_ASSERT_EQUAL(CSI_RATE_DOWN, csi_rate_update(&rate, &s));
+        TEST_ASSERT_EQUAL_UINT16(75, rate.rate_hz);
+        TEST_ASSERT_EQUAL_UINT16(13, rate.interval_ms);
+        TEST_ASSERT_EQUAL_UINT8(1 << signal, rate.congestion);
+    }
+
+    // 阈值以内不算拥塞
+    TEST_ASSERT_TRUE(csi_rate_init(&rate, &s_config));
+    csi_rate_sample_t s = healthy(&rate);
+    s.timeouts = 10;
+    s.csi_frames = 80;
+    s.queue_depth = 32;
+    TEST_ASSERT_EQUAL(CSI_RATE_HOLD, csi_rate_update(&rate, &s));
+    TEST_ASSERT_EQUAL_UINT8(0, rate.congestion);
+}
+
+static void test_hold_then_recover_within_bounds(void)
+{
+    csi_rate_t rate;
+    csi_rate_sample_t s;
+
+    TEST_ASSERT_TRUE(csi_rate_init(&rate, &s_config));
+    // 持续拥塞：降到 min_hz 后保持
+    for (int i = 0; i < 30; i++) {
+        s = healthy(&rate);
+        s.timeouts = s.pings;
+        csi_rate_update(&rate, &s);
+    }
+    TEST_ASSERT_EQUAL_UINT16(5, rate.rate_hz);
+    TEST_ASSERT_EQUAL_UINT16(200, rate.interval_ms);
+    s = healthy(&rate);
+    s.timeouts = s.pings;
+    TEST_ASSERT_EQUAL(CSI_RATE_HOLD, csi_rate_update(&rate, &s));
+
+    // 拥塞消失：先保持 hold_periods 个周期，再每个周期提速 step_hz，直到 max_hz
+    s = healthy(&rate);
+    TEST_ASSERT_EQUAL(CSI_RATE_HOLD, csi_rate_update(&rate, &s));
+    TEST_ASSERT_EQUAL(CSI_RATE_HOLD, csi_rate_update(&rate, &s));
+    TEST_ASSERT_EQUAL(CSI_RATE_UP, csi_rate_update(&rate, &s));
+    TEST_ASSERT_EQUAL_UINT16(7, rate.rate_hz);
+    TEST_ASSERT_EQUAL_UINT16(143, rate.interval_ms);
+    int periods = 0;
+    while (rate.rate_hz < 100 && periods < 100) {
+        s = healthy(&rate);
+        TEST_ASSERT_EQUAL(CSI_RATE_UP, csi_rate_update(&rate, &s));
+        periods++;
+    }
+    TEST_ASSERT_EQUAL_UINT16(10, rate.interval_ms);
+    TEST_ASSERT_EQUAL(47, periods);
+    s = healthy(&rate);
+    TEST_ASSERT_EQUAL(CSI_RATE_HOLD, csi_rate_update(&rate, &s));
+
+    // 没有 ping 结果的周期不调整
+    csi_rate_sample_t empty = { .queue_capacity = 64, .overflow = 5 };
+    TEST_ASSERT_EQUAL(CSI_RATE_HOLD, csi_rate_update(&rate, &empty));
+    TEST_ASSERT_EQUAL_UINT16(100, rate.rate_hz);
+}
+
+static void test_probes_share_channel(void)
+{
+    // 两个探针共用一个每秒只能承载 120 个 ping 的信道：超出部分按比例超时。
+    // 一个从最高速率开始，一个从最低速率开始，最终两者的平均速率都在 50..70 Hz 之间
+    csi_rate_t probes[2];
+    TEST_ASSERT_TRUE(csi_rate_init(&probes[0], &s_config));
+    TEST_ASSERT_TRUE(csi_rate_init(&probes[1], &s_config));
+    probes[1].rate_hz = 5;
+
+    uint32_t sum_rate[2] = {0};
+    for (int period = 0; period < 400; period++) {
+        uint32_t offered = probes[0].rate_hz + probes[1].rate_hz;
+        for (int p = 0; p < 2; p++) {
+            uint32_t pings = probes[p].rate_hz;
+            uint32_t lost = offered > 120 ? pings * (offered - 120) / offered : 0;
+            csi_rate_sample_t s = {
+                .pings = pings,
+                .timeouts = lost,
+                .csi_frames = pings - lost,
+                .queue_capacity = 64,
+            };
+            csi_rate_update(&probes[p], &s);
+            if (period >= 200) {
+                sum_rate[p] += probes[p].rate_hz;
+            }
+        }
+    }
+
+    for (int p = 0; p < 2; p++) {
+        uint32_t mean = sum_rate[p] / 200;
+        TEST_ASSERT_TRUE(mean >= 50 && mean <= 70);
+    }
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_init_rejects_invalid_config);
+    RUN_TEST(test_each_congestion_signal_slows_down);
+    RUN_TEST(test_hold_then_recover_within_bounds);
+    RUN_TEST(test_probes_share_channel);
+    int failures = UNITY_END();
+    exit(failures);
+}
@@ -0,0 +1,81 @@
+/**
+ * @file csi_rate.h
+ * @brief CSI 激励速率（ping 速率）的闭环控制
+ *
+ * 每个控制周期输入一次测量值（ping 超时数、实际收到的 CSI 帧数、环形缓冲区溢出和深度、
+ * UDP 发送失败数），按 AIMD 调整 ping 速率：
+ * - 任一拥塞信号出现时速率降为 3/4，并在 hold_periods 个周期内不再提速；
+ * - 没有拥塞时每个周期速率增加 step_hz，直到 max_hz。
+ * 多个探针共用信道时，加性增、乘性减使各探针的速率收敛到相近的份额，而不是互相挤占。
+ *
+ * 只依赖 C 标准头文件，可在主机上编译并运行单元测试（见 host_test）。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint16_t min_hz;            /*!< 最低 ping 速率 */
+    uint16_t max_hz;            /*!< 最高 ping 速率，不超过 1000 */
+    uint16_t step_hz;           /*!< 每个周期的提速幅度 */
+    uint8_t  max_loss_pct;      /*!< ping 超时比例超过该值视为拥塞 */
+    uint8_t  min_yield_pct;     /*!< 收到的 CSI 帧数低于 ping 数的该百分比视为拥塞 */
+    uint8_t  hold_periods;      /*!< 降速后保持的周期数 */
+} csi_rate_config_t;
+
+/** 一个控制周期内的测量值（除 queue_* 外都是该周期内的增量） */
+typedef struct {
+    uint32_t pings;             /*!< 得到结果（应答或超时）的 ping 数 */
+    uint32_t timeouts;          /*!< 超时的 ping 数 */
+    uint32_t csi_frames;        /*!< CSI 回调收到的帧数 */
+    uint32_t overflow;          /*!< 环形缓冲区满而丢弃的帧数 */
+    uint32_t send_errors;       /*!< UDP 发送失败数 */
+    uint32_t queue_depth;       /*!< 周期结束时环形缓冲区中的记录数 */
+    uint32_t queue_capacity;
+} csi_rate_sample_t;
+
+/** 拥塞原因（位掩码） */
+typedef enum {
+    CSI_RATE_CONGESTION_LOSS = 1 << 0,      /*!< ping 超时比例过高 */
+    CSI_RATE_CONGESTION_YIELD = 1 << 1,     /*!< CSI 帧数跟不上 ping 数 */
+    CSI_RATE_CONGESTION_OVERFLOW = 1 << 2,  /*!< 环形缓冲区溢出 */
+    CSI_RATE_CONGESTION_QUEUE = 1 << 3,     /*!< 环形缓冲区超过半满 */
+    CSI_RATE_CONGESTION_SEND = 1 << 4,      /*!< UDP 发送失败 */
+} csi_rate_congestion_t;
+
+typedef enum {
+    CSI_RATE_HOLD = 0,          /*!< 速率不变 */
+    CSI_RATE_UP,                /*!< 提速 */
+    CSI_RATE_DOWN,              /*!< 降速 */
+} csi_rate_action_t;
+
+typedef struct {
+    csi_rate_config_t config;
+    uint16_t rate_hz;           // 当前 ping 速率
+    uint16_t interval_ms;       // 对应的 ping 间隔（1000 / rate_hz，四舍五入）
+    uint8_t  hold;              // 剩余的保持周期数
+    uint8_t  congestion;        // 上一周期的拥塞原因（csi_rate_congestion_t）
+} csi_rate_t;
+
+/**
+ * @brief 初始化控制器，从 max_hz 开始
+ *
+ * @return min_hz 为 0 或大于 max_hz、max_hz 超过 1000、step_hz 为 0、百分比超过 100 时返回 false
+ */
+bool csi_rate_init(csi_rate_t *rate, const csi_rate_config_t *config);
+
+/**
+ * @brief 输入一个周期的测量值，更新 rate->rate_hz 和 rate->interval_ms
+ *
+ * 周期内没有 ping 结果（会话重建、断线）时保持不变。
+ */
+csi_rate_action_t csi_rate_update(csi_rate_t *rate, const csi_rate_sample_t *sample);
+
+#ifdef __cplusplus
+}
+#endif
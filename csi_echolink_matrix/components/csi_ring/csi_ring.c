@@ -0,0 +1,146 @@
+#include "csi_ring.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * head/tail 为自由运行的计数器，槽位下标为 (计数器 & mask)。
+ * head 只由生产者写，tail 只由消费者写；通过 acquire/release 保证
+ * 槽位内容在下标发布之前对另一端可见。
+ */
+struct csi_ring {
+    _Atomic uint32_t head;          // 下一个写入位置（生产者）
+    _Atomic uint32_t tail;          // 下一个读取位置（消费者）
+    _Atomic uint32_t high_water;    // 生产者维护
+    _Atomic uint32_t overflow;      // 生产者维护
+    uint32_t mask;
+    size_t slot_size;
+    uint32_t *lens;                 // 每个槽位的有效长度
+    uint8_t *slots;
+};
+
+csi_ring_t *csi_ring_create(uint32_t slot_count, size_t slot_size)
+{
+    if (slot_count == 0 || (slot_count & (slot_count - 1)) != 0 || slot_size == 0) {
+        return NULL;
+    }
+
+    csi_ring_t *ring = calloc(1, sizeof(csi_ring_t));
+    if (!ring) {
+        return NULL;
+    }
+
+    ring->lens = calloc(slot_count, sizeof(uint32_t));
+    ring->slots = malloc(slot_count * slot_size);
+    if (!ring->lens || !ring->slots) {
+        csi_ring_delete(ring);
+        return NULL;
+    }
+
+    ring->mask = slot_count - 1;
+    ring->slot_size = slot_size;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->high_water, 0);
+    atomic_init(&ring->overflow, 0);
+
+    return ring;
+}
+
+void csi_ring_delete(csi_ring_t *ring)
+{
+    if (!ring) {
+        return;
+    }
+
+    free(ring->lens);
+    free(ring->slots);
+    free(ring);
+}
+
+void *csi_ring_acquire(csi_ring_t *ring)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail > ring->mask) {
+        atomic_store_explicit(&ring->overflow,
+                              atomic_load_explicit(&ring->overflow, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+        return NULL;
+    }
+
+    return ring->slots + (size_t)(head & ring->mask) * ring->slot_size;
+}
+
+void csi_ring_commit(csi_ring_t *ring, size_t len)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    ring->lens[head & ring->mask] = len < ring->slot_size ? (uint32_t)len : (uint32_t)ring->slot_size;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    uint32_t count = head + 1 - tail;
+    if (count > atomic_load_explicit(&ring->high_water, memory_order_relaxed)) {
+        atomic_store_explicit(&ring->high_water, count, memory_order_relaxed);
+    }
+}
+
+bool csi_ring_push(csi_ring_t *ring, const void *data, size_t len)
+{
+    if (len > ring->slot_size) {
+        return false;
+    }
+
+    void *slot = csi_ring_acquire(ring);
+    if (!slot) {
+        return false;
+    }
+
+    memcpy(slot, data, len);
+    csi_ring_commit(ring, len);
+    return true;
+}
+
+const void *csi_ring_peek(csi_ring_t *ring, size_t *len)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == tail) {
+        return NULL;
+    }
+
+    if (len) {
+        *len = ring->lens[tail & ring->mask];
+    }
+
+    return ring->slots + (size_t)(tail & ring->mask) * ring->slot_size;
+}
+
+void csi_ring_release(csi_ring_t *ring)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+size_t csi_ring_slot_size(const csi_ring_t *ring)
+{
+    return ring->slot_size;
+}
+
+void csi_ring_get_stats(const csi_ring_t *ring, csi_ring_stats_t *stats)
+{
+    csi_ring_t *r = (csi_ring_t *)ring;
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+
+    stats->capacity = ring->mask + 1;
+    stats->count = head - tail;
+    stats->high_water = atomic_load_explicit(&r->high_water, memory_order_relaxed);
+    stats->pushed = head;
+    stats->popped = tail;
+    stats->overflow = atomic_load_explicit(&r->overflow, memory_order_relaxed);
+}
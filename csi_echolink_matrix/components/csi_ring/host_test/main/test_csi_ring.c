@@ -0,0 +1,194 @@
+/**
+ * @file test_csi_ring.c
+ * @brief csi_ring 主机侧单元测试（linux target）
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "csi_ring.h"
+
+#define STRESS_FRAMES 1000000
+
+static void test_create_rejects_invalid_args(void)
+{
+    TEST_ASSERT_NULL(csi_ring_create(0, 16));
+    TEST_ASSERT_NULL(csi_ring_create(12, 16));
+    TEST_ASSERT_NULL(csi_ring_create(16, 0));
+
+    csi_ring_t *ring = csi_ring_create(16, 32);
+    TEST_ASSERT_NOT_NULL(ring);
+    TEST_ASSERT_EQUAL(32, csi_ring_slot_size(ring));
+    csi_ring_delete(ring);
+}
+
+static void test_fifo_order_and_length(void)
+{
+    csi_ring_t *ring = csi_ring_create(4, 8);
+    size_t len = 0;
+
+    TEST_ASSERT_NULL(csi_ring_peek(ring, &len));
+
+    for (uint8_t i = 1; i <= 3; i++) {
+        uint8_t data[8];
+        memset(data, i, sizeof(data));
+        TEST_ASSERT_TRUE(csi_ring_push(ring, data, i));
+    }
+
+    for (uint8_t i = 1; i <= 3; i++) {
+        const uint8_t *slot = csi_ring_peek(ring, &len);
+        TEST_ASSERT_NOT_NULL(slot);
+        TEST_ASSERT_EQUAL(i, len);
+        TEST_ASSERT_EQUAL_UINT8(i, slot[0]);
+        csi_ring_release(ring);
+    }
+
+    TEST_ASSERT_NULL(csi_ring_peek(ring, &len));
+    csi_ring_delete(ring);
+}
+
+static void test_push_rejects_oversized_data(void)
+{
+    csi_ring_t *ring = csi_ring_create(4, 8);
+    uint8_t data[9] = {0};
+
+    TEST_ASSERT_FALSE(csi_ring_push(ring, data, sizeof(data)));
+    TEST_ASSERT_NULL(csi_ring_peek(ring, NULL));
+    csi_ring_delete(ring);
+}
+
+static void test_overflow_and_high_water(void)
+{
+    csi_ring_t *ring = csi_ring_create(4, 4);
+    csi_ring_stats_t stats;
+    uint32_t value = 0;
+
+    for (int i = 0; i < 6; i++) {
+        value = i;
+        csi_ring_push(ring, &value, sizeof(value));
+    }
+
+    csi_ring_get_stats(ring, &stats);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.capacity);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.count);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.high_water);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.pushed);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.overflow);
+
+    // 溢出时丢弃的是新数据，已提交的数据保持不变
+    const uint32_t *slot = csi_ring_peek(ring, NULL);
+    TEST_ASSERT_EQUAL_UINT32(0, *slot);
+
+    csi_ring_release(ring);
+    csi_ring_release(ring);
+    csi_ring_get_stats(ring, &stats);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.count);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.popped);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.high_water);
+    csi_ring_delete(ring);
+}
+
+static void test_acquire_commit_in_place(void)
+{
+    csi_ring_t *ring = csi_ring_create(2, 16);
+    size_t len = 0;
+
+    char *slot = csi_ring_acquire(ring);
+    TEST_ASSERT_NOT_NULL(slot);
+    strcpy(slot, "csi");
+    // 提交之前消费者看不到该槽位
+    TEST_ASSERT_NULL(csi_ring_peek(ring, NULL));
+    csi_ring_commit(ring, 4);
+
+    TEST_ASSERT_EQUAL_STRING("csi", csi_ring_peek(ring, &len));
+    TEST_ASSERT_EQUAL(4, len);
+    csi_ring_delete(ring);
+}
+
+static void test_wrap_around(void)
+{
+    csi_ring_t *ring = csi_ring_create(8, sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < 1000; i++) {
+        TEST_ASSERT_TRUE(csi_ring_push(ring, &i, sizeof(i)));
+        if (i % 3 == 0) {
+            TEST_ASSERT_TRUE(csi_ring_push(ring, &i, sizeof(i)));
+            csi_ring_release(ring);
+        }
+        const uint32_t *slot = csi_ring_peek(ring, NULL);
+        TEST_ASSERT_NOT_NULL(slot);
+        csi_ring_release(ring);
+    }
+
+    TEST_ASSERT_NULL(csi_ring_peek(ring, NULL));
+    csi_ring_delete(ring);
+}
+
+static void *stress_producer(void *arg)
+{
+    csi_ring_t *ring = arg;
+
+    for (uint32_t seq = 0; seq < STRESS_FRAMES; seq++) {
+        uint32_t *slot = csi_ring_acquire(ring);
+        if (slot) {
+            slot[0] = seq;
+            slot[1] = ~seq;
+            csi_ring_commit(ring, 2 * sizeof(uint32_t));
+        }
+    }
+
+    return NULL;
+}
+
+static void test_spsc_stress(void)
+{
+    csi_ring_t *ring = csi_ring_create(64, 2 * sizeof(uint32_t));
+    pthread_t producer;
+    uint32_t received = 0;
+    int64_t last_seq = -1;
+    csi_ring_stats_t stats;
+
+    TEST_ASSERT_EQUAL(0, pthread_create(&producer, NULL, stress_producer, ring));
+
+    while (1) {
+        size_t len = 0;
+        const uint32_t *slot = csi_ring_peek(ring, &len);
+        if (!slot) {
+            csi_ring_get_stats(ring, &stats);
+            if (stats.pushed + stats.overflow == STRESS_FRAMES && stats.count == 0) {
+                break;
+            }
+            continue;
+        }
+
+        // 序号严格递增（允许因溢出产生空洞），且槽位内容完整
+        TEST_ASSERT_EQUAL(2 * sizeof(uint32_t), len);
+        TEST_ASSERT_TRUE((int64_t)slot[0] > last_seq);
+        TEST_ASSERT_EQUAL_UINT32(~slot[0], slot[1]);
+        last_seq = slot[0];
+        received++;
+        csi_ring_release(ring);
+    }
+
+    pthread_join(producer, NULL);
+    csi_ring_get_stats(ring, &stats);
+    TEST_ASSERT_EQUAL_UINT32(STRESS_FRAMES, received + stats.overflow);
+    TEST_ASSERT_EQUAL_UINT32(received, stats.popped);
+    TEST_ASSERT_TRUE(stats.high_water <= stats.capacity);
+    csi_ring_delete(ring);
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_create_rejects_invalid_args);
+    RUN_TEST(test_fifo_order_and_length);
+    RUN_TEST(test_push_rejects_oversized_data);
+    RUN_TEST(test_overflow_and_high_water);
+    RUN_TEST(test_acquire_commit_in_place);
+    RUN_TEST(test_wrap_around);
+    RUN_TEST(test_spsc_stress);
+    int failures = UNITY_END();
+    exit(failures);
+}
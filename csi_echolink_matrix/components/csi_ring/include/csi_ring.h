@@ -0,0 +1,87 @@
+/**
+ * @file csi_ring.h
+ * @brief 单生产者/单消费者（SPSC）无锁环形缓冲区
+ *
+ * 用于把 Wi-Fi 驱动回调中的 CSI 采集与网络发送解耦：
+ * - 生产者（CSI 回调）：csi_ring_acquire() 取得空闲槽位，填充后 csi_ring_commit()；
+ * - 消费者（发送任务）：csi_ring_peek() 读取最早的槽位，处理完后 csi_ring_release()。
+ *
+ * 所有槽位在 csi_ring_create() 时一次性分配，运行期间不再申请内存。
+ * 只依赖 C11 标准库，可在主机上编译并运行单元测试（见 host_test）。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct csi_ring csi_ring_t;
+
+typedef struct {
+    uint32_t capacity;      /*!< 槽位数量 */
+    uint32_t count;         /*!< 当前已占用的槽位数量 */
+    uint32_t high_water;    /*!< 历史最大占用数量 */
+    uint32_t pushed;        /*!< 成功写入的槽位总数 */
+    uint32_t popped;        /*!< 已取出的槽位总数 */
+    uint32_t overflow;      /*!< 环形缓冲区满导致丢弃的次数 */
+} csi_ring_stats_t;
+
+/**
+ * @brief 创建环形缓冲区
+ *
+ * @param slot_count 槽位数量，必须是 2 的幂
+ * @param slot_size  每个槽位的字节数
+ * @return 缓冲区句柄，参数非法或内存不足时返回 NULL
+ */
+csi_ring_t *csi_ring_create(uint32_t slot_count, size_t slot_size);
+
+void csi_ring_delete(csi_ring_t *ring);
+
+/**
+ * @brief 生产者：取得下一个空闲槽位
+ *
+ * @return 槽位指针（slot_size 字节可写）；缓冲区已满时返回 NULL，并累加 overflow
+ */
+void *csi_ring_acquire(csi_ring_t *ring);
+
+/**
+ * @brief 生产者：提交 csi_ring_acquire() 取得的槽位，使其对消费者可见
+ *
+ * @param len 槽位中有效数据的字节数
+ */
+void csi_ring_commit(csi_ring_t *ring, size_t len);
+
+/**
+ * @brief 生产者：把 data 拷贝到一个空闲槽位并提交
+ *
+ * @return 缓冲区已满或 len 超过槽位大小时返回 false
+ */
+bool csi_ring_push(csi_ring_t *ring, const void *data, size_t len);
+
+/**
+ * @brief 消费者：取得最早提交的槽位，不移出
+ *
+ * @param[out] len 槽位中有效数据的字节数，可为 NULL
+ * @return 槽位指针；缓冲区为空时返回 NULL
+ */
+const void *csi_ring_peek(csi_ring_t *ring, size_t *len);
+
+/**
+ * @brief 消费者：释放 csi_ring_peek() 取得的槽位
+ */
+void csi_ring_release(csi_ring_t *ring);
+
+size_t csi_ring_slot_size(const csi_ring_t *ring);
+
+/**
+ * @brief 读取统计计数，任一端都可以调用
+ */
+void csi_ring_get_stats(const csi_ring_t *ring, csi_ring_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
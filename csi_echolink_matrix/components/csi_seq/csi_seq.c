@@ -0,0 +1,63 @@
+#include "csi_seq.h"
+
+// RFC 3550：J += (|D| - J) / 16，J 以 Q4 保存，避免小抖动被整数除法舍去
+static void update_jitter(csi_seq_stats_t *stats, uint32_t send_us, uint32_t arrival_us)
+{
+    uint32_t transit = arrival_us - send_us;
+    if (stats->transit_valid) {
+        int32_t d = (int32_t)(transit - stats->last_transit);
+        uint32_t abs_d = d < 0 ? (uint32_t)-(int64_t)d : (uint32_t)d;
+        stats->jitter_q4 += abs_d - ((stats->jitter_q4 + 8) >> 4);
+    }
+    stats->last_transit = transit;
+    stats->transit_valid = true;
+}
+
+csi_seq_event_t csi_seq_update(csi_seq_stats_t *stats, uint32_t seq,
+                               bool has_time, uint32_t send_us, uint32_t arrival_us)
+{
+    stats->received++;
+
+    if (!stats->started) {
+        stats->started = true;
+        stats->last_seq = seq;
+        if (has_time) {
+            update_jitter(stats, send_us, arrival_us);
+        }
+        return CSI_SEQ_IN_ORDER;
+    }
+
+    csi_seq_event_t event;
+    int32_t delta = (int32_t)(seq - stats->last_seq);
+    if (delta > 0) {
+        uint32_t missing = (uint32_t)delta - 1;
+        event = CSI_SEQ_IN_ORDER;
+        if (missing) {
+            stats->lost += missing;
+            stats->gaps[csi_seq_gap_bucket(missing)]++;
+            event = CSI_SEQ_GAP;
+        }
+        stats->last_seq = seq;
+    } else if (delta == 0) {
+        stats->duplicate++;
+        return CSI_SEQ_DUPLICATE;
+    } else if ((uint32_t)-(int64_t)delta > CSI_SEQ_RESTART_WINDOW) {
+        // 重启后发送端的时间戳也从头开始，抖动从下一帧重新计算
+        stats->restarts++;
+        stats->last_seq = seq;
+        stats->transit_valid = false;
+        event = CSI_SEQ_RESTART;
+    } else {
+        // 迟到的帧此前已被计为丢失
+        stats->reordered++;
+        if (stats->lost) {
+            stats->lost--;
+        }
+        event = CSI_SEQ_REORDERED;
+    }
+
+    if (has_time) {
+        update_jitter(stats, send_us, arrival_us);
+    }
+    return event;
+}
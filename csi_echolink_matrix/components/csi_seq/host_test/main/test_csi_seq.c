@@ -0,0 +1,101 @@
+/**
+ * @file test_csi_seq.c
+ * @brief csi_seq 主机侧单元测试（linux target）
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "csi_seq.h"
+
+static csi_seq_event_t update(csi_seq_stats_t *s, uint32_t seq)
+{
+    return csi_seq_update(s, seq, false, 0, 0);
+}
+
+static void test_counts_loss_and_gap_histogram(void)
+{
+    csi_seq_stats_t s;
+    memset(&s, 0, sizeof(s));
+
+    TEST_ASSERT_EQUAL(CSI_SEQ_IN_ORDER, update(&s, 100));
+    TEST_ASSERT_EQUAL(CSI_SEQ_IN_ORDER, update(&s, 101));
+    TEST_ASSERT_EQUAL(CSI_SEQ_GAP, update(&s, 103));        // 丢 1 帧
+    TEST_ASSERT_EQUAL(CSI_SEQ_GAP, update(&s, 107));        // 丢 3 帧
+    TEST_ASSERT_EQUAL(CSI_SEQ_GAP, update(&s, 308));        // 丢 200 帧
+    TEST_ASSERT_EQUAL(CSI_SEQ_DUPLICATE, update(&s, 308));
+
+    TEST_ASSERT_EQUAL_UINT32(6, s.received);
+    TEST_ASSERT_EQUAL_UINT32(204, s.lost);
+    TEST_ASSERT_EQUAL_UINT32(1, s.duplicate);
+    TEST_ASSERT_EQUAL_UINT32(1, s.gaps[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, s.gaps[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, s.gaps[CSI_SEQ_GAP_BUCKETS - 1]);
+    TEST_ASSERT_EQUAL_UINT32(204 * 10000 / 210, csi_seq_loss_bp(&s));
+
+    TEST_ASSERT_EQUAL(0, csi_seq_gap_bucket(1));
+    TEST_ASSERT_EQUAL(1, csi_seq_gap_bucket(3));
+    TEST_ASSERT_EQUAL(2, csi_seq_gap_bucket(4));
+    TEST_ASSERT_EQUAL(6, csi_seq_gap_bucket(127));
+    TEST_ASSERT_EQUAL(7, csi_seq_gap_bucket(128));
+    TEST_ASSERT_EQUAL(7, csi_seq_gap_bucket(UINT32_MAX));
+}
+
+static void test_reorder_restart_and_wrap(void)
+{
+    csi_seq_stats_t s;
+    memset(&s, 0, sizeof(s));
+
+    update(&s, 10);
+    update(&s, 12);
+    TEST_ASSERT_EQUAL(CSI_SEQ_REORDERED, update(&s, 11));   // 迟到的帧回补丢失
+    TEST_ASSERT_EQUAL_UINT32(0, s.lost);
+    TEST_ASSERT_EQUAL_UINT32(1, s.reordered);
+    TEST_ASSERT_EQUAL_UINT32(12, s.last_seq);
+
+    update(&s, 50000);
+    TEST_ASSERT_EQUAL(CSI_SEQ_RESTART, update(&s, 0));      // 探针重启
+    TEST_ASSERT_EQUAL_UINT32(1, s.restarts);
+    TEST_ASSERT_EQUAL(CSI_SEQ_IN_ORDER, update(&s, 1));
+
+    // 序号回绕不是重启
+    memset(&s, 0, sizeof(s));
+    update(&s, UINT32_MAX - 1);
+    TEST_ASSERT_EQUAL(CSI_SEQ_IN_ORDER, update(&s, UINT32_MAX));
+    TEST_ASSERT_EQUAL(CSI_SEQ_GAP, update(&s, 1));
+    TEST_ASSERT_EQUAL_UINT32(1, s.lost);
+    TEST_ASSERT_EQUAL_UINT32(0, s.restarts);
+}
+
+static void test_jitter(void)
+{
+    csi_seq_stats_t s;
+    memset(&s, 0, sizeof(s));
+
+    // 发送间隔 10 ms，到达时延恒定：抖动为 0，时间戳回绕不影响
+    uint32_t send = UINT32_MAX - 50000;
+    for (uint32_t i = 0; i < 100; i++) {
+        csi_seq_update(&s, i, true, send + i * 10000, 7000000 + i * 10000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, csi_seq_jitter_us(&s));
+
+    // 到达时延在 0 和 2 ms 之间交替：|D| = 2000，抖动收敛到 2000 us
+    for (uint32_t i = 100; i < 400; i++) {
+        csi_seq_update(&s, i, true, send + i * 10000, 7000000 + i * 10000 + (i % 2) * 2000);
+    }
+    TEST_ASSERT_UINT32_WITHIN(20, 2000, csi_seq_jitter_us(&s));
+
+    // 不带时间戳的帧不影响抖动
+    uint32_t jitter = s.jitter_q4;
+    csi_seq_update(&s, 400, false, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(jitter, s.jitter_q4);
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_counts_loss_and_gap_histogram);
+    RUN_TEST(test_reorder_restart_and_wrap);
+    RUN_TEST(test_jitter);
+    int failures = UNITY_END();
+    exit(failures);
+}
@@ -0,0 +1,87 @@
+/**
+ * @file csi_seq.h
+ * @brief 按数据源统计帧序号：丢失、重复、乱序、探针重启、空洞长度分布和到达抖动
+ *
+ * 每个数据源（探针）一个 csi_seq_stats_t，每收到一帧调用一次 csi_seq_update()：
+ * - 序号前进超过 1 时，中间的帧计为丢失，并按空洞长度计入直方图；
+ * - 序号小于上一帧时计为乱序（此前计为丢失的帧回补），回退超过 CSI_SEQ_RESTART_WINDOW 时视为探针重启；
+ * - 带发送端时间戳时按 RFC 3550 的方法估计到达抖动：相邻两帧到达间隔与发送间隔之差的指数平均。
+ * AirSight 的转发统计和主机侧的 csi_recvd 共用这份实现，两端的计数可以直接对比。
+ *
+ * 只依赖 C 标准头文件，可在主机上编译并运行单元测试（见 host_test）。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 序号回退超过该值时视为探针重启，而不是乱序 */
+#define CSI_SEQ_RESTART_WINDOW  1024
+
+/** 空洞长度直方图的桶数：丢失 1、2-3、4-7、...、64-127、128 帧及以上 */
+#define CSI_SEQ_GAP_BUCKETS     8
+
+typedef struct {
+    uint32_t received;          /*!< 收到的帧数 */
+    uint32_t lost;              /*!< 序号空洞中的帧数（迟到的帧会回补） */
+    uint32_t duplicate;         /*!< 与上一帧序号相同 */
+    uint32_t reordered;         /*!< 序号小于上一帧（迟到） */
+    uint32_t restarts;          /*!< 序号大幅回退，视为探针重启 */
+    uint32_t gaps[CSI_SEQ_GAP_BUCKETS]; /*!< 空洞个数，按丢失的帧数分桶（见 csi_seq_gap_bucket()） */
+    uint32_t jitter_q4;         /*!< 到达抖动（微秒，Q4 定点），见 csi_seq_jitter_us() */
+    uint32_t last_seq;
+    uint32_t last_transit;      /*!< 上一帧的到达时刻减发送时刻（按 32 位回绕） */
+    bool     started;
+    bool     transit_valid;
+} csi_seq_stats_t;
+
+typedef enum {
+    CSI_SEQ_IN_ORDER = 0,       /*!< 紧接上一帧，或第一帧 */
+    CSI_SEQ_GAP,                /*!< 前进超过 1，中间有丢失 */
+    CSI_SEQ_DUPLICATE,
+    CSI_SEQ_REORDERED,
+    CSI_SEQ_RESTART,
+} csi_seq_event_t;
+
+/** 丢失 missing（>= 1）帧的空洞所在的直方图桶 */
+static inline unsigned csi_seq_gap_bucket(uint32_t missing)
+{
+    unsigned bucket = 0;
+    while (missing > 1 && bucket < CSI_SEQ_GAP_BUCKETS - 1) {
+        missing >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/** 到达抖动（微秒） */
+static inline uint32_t csi_seq_jitter_us(const csi_seq_stats_t *stats)
+{
+    return stats->jitter_q4 >> 4;
+}
+
+/** 丢失率（万分比），没有帧时为 0 */
+static inline uint32_t csi_seq_loss_bp(const csi_seq_stats_t *stats)
+{
+    uint64_t total = (uint64_t)stats->received + stats->lost;
+    return total ? (uint32_t)((uint64_t)stats->lost * 10000 / total) : 0;
+}
+
+/**
+ * @brief 统计一帧
+ *
+ * @param seq 数据源内单调递增的帧序号
+ * @param has_time 是否带发送端时间戳；为 false 时不更新抖动（如 CSV 文本）
+ * @param send_us 发送端时间戳（微秒，可回绕，如帧头的 local_timestamp）
+ * @param arrival_us 本地到达时刻（微秒，可回绕）
+ */
+csi_seq_event_t csi_seq_update(csi_seq_stats_t *stats, uint32_t seq,
+                               bool has_time, uint32_t send_us, uint32_t arrival_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,115 @@
+#include "csi_source.h"
+
+#include <string.h>
+
+static uint64_t mac_key(const uint8_t mac[6])
+{
+    return (uint64_t)mac[0] << 40 | (uint64_t)mac[1] << 32 | (uint64_t)mac[2] << 24
+           | (uint64_t)mac[3] << 16 | (uint64_t)mac[4] << 8 | mac[5];
+}
+
+/**
+ * @return key 在 table->key 中的位置，不存在时返回应插入的位置
+ */
+static int lower_bound(const csi_source_table_t *table, uint64_t key)
+{
+    int lo = 0, hi = table->count;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (table->key[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void csi_source_init(csi_source_table_t *table)
+{
+    memset(table, 0, sizeof(*table));
+}
+
+int csi_source_add(csi_source_table_t *table, const uint8_t mac[6])
+{
+    uint64_t key = mac_key(mac);
+    int pos = lower_bound(table, key);
+
+    if (pos < table->count && table->key[pos] == key) {
+        return table->index[pos];
+    }
+    if (table->count >= CSI_SOURCE_MAX) {
+        return -1;
+    }
+
+    uint8_t index = table->count;
+    memmove(&table->key[pos + 1], &table->key[pos], (table->count - pos) * sizeof(table->key[0]));
+    memmove(&table->index[pos + 1], &table->index[pos], table->count - pos);
+    table->key[pos] = key;
+    table->index[pos] = index;
+    memcpy(table->mac[index], mac, 6);
+    table->seq[index] = 0;
+    table->count++;
+    return index;
+}
+
+int csi_source_find(const csi_source_table_t *table, const uint8_t mac[6])
+{
+    uint64_t key = mac_key(mac);
+    int pos = lower_bound(table, key);
+
+    return pos < table->count && table->key[pos] == key ? table->index[pos] : -1;
+}
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+int csi_source_parse_list(const char *str, uint8_t macs[][6], int max)
+{
+    int count = 0;
+
+    for (;;) {
+        while (*str == ' ') {
+            str++;
+        }
+        if (*str == '\0' && count == 0) {
+            return 0;
+        }
+        if (count >= max) {
+            return -1;
+        }
+
+        for (int i = 0; i < 6; i++) {
+            int hi = hex_digit(str[0]);
+            int lo = hi < 0 ? -1 : hex_digit(str[1]);
+            if (lo < 0 || (i < 5 && str[2] != ':')) {
+                return -1;
+            }
+            macs[count][i] = (uint8_t)(hi << 4 | lo);
+            str += i < 5 ? 3 : 2;
+        }
+        count++;
+
+        while (*str == ' ') {
+            str++;
+        }
+        if (*str == '\0') {
+            return count;
+        }
+        if (*str++ != ',') {
+            return -1;
+        }
+    }
+}
@@ -0,0 +1,96 @@
+/**
+ * @file test_csi_source.c
+ * @brief csi_source 主机侧单元测试（linux target）
+ */
+#include <stdlib.h>
+#include "unity.h"
+#include "csi_source.h"
+
+static void test_add_keeps_index_and_finds(void)
+{
+    // 加入顺序与 MAC 大小顺序不同，下标按加入顺序分配
+    static const uint8_t macs[][6] = {
+        {0x24, 0x0a, 0xc4, 0x00, 0x00, 0x05},
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x01},
+        {0xff, 0xff, 0xff, 0xff, 0xff, 0xfe},
+        {0x24, 0x0a, 0xc4, 0x00, 0x00, 0x02},
+        {0x24, 0x0a, 0xc3, 0xff, 0xff, 0xff},
+    };
+    csi_source_table_t table;
+
+    csi_source_init(&table);
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL(i, csi_source_add(&table, macs[i]));
+    }
+    TEST_ASSERT_EQUAL(3, csi_source_add(&table, macs[3]));
+    TEST_ASSERT_EQUAL_UINT8(5, table.count);
+
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL(i, csi_source_find(&table, macs[i]));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(macs[i], table.mac[i], 6);
+    }
+    for (int i = 1; i < table.count; i++) {
+        TEST_ASSERT_TRUE(table.key[i - 1] < table.key[i]);
+    }
+
+    static const uint8_t absent[][6] = {
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+        {0x24, 0x0a, 0xc4, 0x00, 0x00, 0x03},
+        {0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
+        {0x05, 0x00, 0xc4, 0x0a, 0x24, 0x00},   // 字节顺序反过来
+    };
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(-1, csi_source_find(&table, absent[i]));
+    }
+}
+
+static void test_full_table(void)
+{
+    csi_source_table_t table;
+    uint8_t mac[6] = {0x24, 0x0a, 0xc4, 0x00, 0x00, 0x00};
+
+    csi_source_init(&table);
+    TEST_ASSERT_EQUAL(-1, csi_source_find(&table, mac));
+    for (int i = 0; i < CSI_SOURCE_MAX; i++) {
+        mac[5] = (uint8_t)(CSI_SOURCE_MAX - i);
+        TEST_ASSERT_EQUAL(i, csi_source_add(&table, mac));
+    }
+    mac[5] = 0;
+    TEST_ASSERT_EQUAL(-1, csi_source_add(&table, mac));
+    mac[5] = 1;
+    TEST_ASSERT_EQUAL(CSI_SOURCE_MAX - 1, csi_source_add(&table, mac));
+    TEST_ASSERT_EQUAL(CSI_SOURCE_MAX - 1, csi_source_find(&table, mac));
+}
+
+static void test_parse_list(void)
+{
+    uint8_t macs[CSI_SOURCE_MAX][6];
+    static const uint8_t expected[][6] = {
+        {0x24, 0x0a, 0xc4, 0x00, 0x00, 0x01},
+        {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF},
+    };
+
+    TEST_ASSERT_EQUAL(0, csi_source_parse_list("", macs, CSI_SOURCE_MAX));
+    TEST_ASSERT_EQUAL(0, csi_source_parse_list("  ", macs, CSI_SOURCE_MAX));
+    TEST_ASSERT_EQUAL(1, csi_source_parse_list("24:0a:c4:00:00:01", macs, CSI_SOURCE_MAX));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected[0], macs[0], 6);
+    TEST_ASSERT_EQUAL(2, csi_source_parse_list(" 24:0a:c4:00:00:01 ,aa:BB:cc:dd:EE:ff ", macs, CSI_SOURCE_MAX));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, macs, 12);
+
+    TEST_ASSERT_EQUAL(-1, csi_source_parse_list("24:0a:c4:00:00:01,", macs, CSI_SOURCE_MAX));
+    TEST_ASSERT_EQUAL(-1, csi_source_parse_list("24:0a:c4:00:00", macs, CSI_SOURCE_MAX));
+    TEST_ASSERT_EQUAL(-1, csi_source_parse_list("24:0a:c4:00:00:1", macs, CSI_SOURCE_MAX));
+    TEST_ASSERT_EQUAL(-1, csi_source_parse_list("24-0a-c4-00-00-01", macs, CSI_SOURCE_MAX));
+    TEST_ASSERT_EQUAL(-1, csi_source_parse_list("24:0a:c4:00:00:01 24:0a:c4:00:00:02", macs, CSI_SOURCE_MAX));
+    TEST_ASSERT_EQUAL(-1, csi_source_parse_list("24:0a:c4:00:00:01,24:0a:c4:00:00:02", macs, 1));
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_add_keeps_index_and_finds);
+    RUN_TEST(test_full_table);
+    RUN_TEST(test_parse_list);
+    int failures = UNITY_END();
+    exit(failures);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file csi_source.h
+ * @brief CSI 激励源白名单：按发送端 MAC 分流，每个源单独计数
+ *
+ * 一个房间里有多个发射节点时，探针对每个节点的帧分别测得一条链路的 CSI。
+ * 白名单中的每个源有一个固定的下标（加入顺序，0 起），写入帧头供接收端组成
+ * TX x RX 的 CSI 矩阵；每个源有自己的序号，接收端按 (探针, 源) 统计丢包。
+ *
+ * 查找在 Wi-Fi 驱动回调中进行：MAC 按大端转换为 48 位整数，在按升序排列的表中二分查找，
+ * 8 个源时最多 3 次比较，不申请内存、不加锁。表只由 CSI 回调修改（初始化后
+ * 学习到的源也在回调中加入），其它任务只读取计数。
+ *
+ * 只依赖 C 标准头文件，可在主机上编译并运行单元测试（见 host_test）。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 白名单容量，也是帧头中源下标的上限 */
+#define CSI_SOURCE_MAX  8
+
+typedef struct {
+    uint8_t  count;
+    uint64_t key[CSI_SOURCE_MAX];       // 按升序排列的 MAC（大端 48 位整数）
+    uint8_t  index[CSI_SOURCE_MAX];     // key[i] 对应的源下标
+    uint8_t  mac[CSI_SOURCE_MAX][6];    // 按源下标
+    uint32_t seq[CSI_SOURCE_MAX];       // 按源下标：该源累计收到的帧数（帧头中的源内序号在发送时另行分配）
+} csi_source_table_t;
+
+void csi_source_init(csi_source_table_t *table);
+
+/**
+ * @brief 加入一个源，下标为加入前的 count
+ *
+ * @return 源下标；已在表中时返回原下标；表满时返回 -1
+ */
+int csi_source_add(csi_source_table_t *table, const uint8_t mac[6]);
+
+/**
+ * @return 源下标，不在表中时返回 -1
+ */
+int csi_source_find(const csi_source_table_t *table, const uint8_t mac[6]);
+
+/**
+ * @brief 解析以逗号分隔的 MAC 列表，如 "24:0a:c4:00:00:01, 24:0a:c4:00:00:02"
+ *
+ * @param macs 输出，最多 max 个
+ * @return 解析出的个数（空字符串为 0）；格式错误或超过 max 个时返回 -1
+ */
+int csi_source_parse_list(const char *str, uint8_t macs[][6], int max);
+
+#ifdef __cplusplus
+}
+#endif
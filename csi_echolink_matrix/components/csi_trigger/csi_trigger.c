@@ -0,0 +1,104 @@
+#include "csi_trigger.h"
+
+#include <string.h>
+
+#define MEAN_DIV        16      // 幅度均值的平滑系数 1/16
+#define LEVEL_DIV       8       // 变化量的平滑系数 1/8
+#define WARMUP_DIV      8       // 预热期间基线的平滑系数
+#define BASELINE_DIV    256     // 空闲时基线的平滑系数
+
+bool csi_trigger_init(csi_trigger_t *trigger, const csi_trigger_config_t *config)
+{
+    if (config->threshold_pct < 100 || config->hold_ms > CSI_TRIGGER_MAX_INTERVAL_MS
+            || config->heartbeat_ms > CSI_TRIGGER_MAX_INTERVAL_MS) {
+        return false;
+    }
+
+    memset(trigger, 0, sizeof(*trigger));
+    trigger->hold_us = config->hold_ms * 1000;
+    trigger->heartbeat_us = config->heartbeat_ms * 1000;
+    trigger->threshold_pct = config->threshold_pct;
+    trigger->min_level = (uint64_t)config->min_level_q4 << 12;
+    trigger->warmup_frames = config->warmup_frames;
+    return true;
+}
+
+/**
+ * @brief 更新幅度均值和变化量
+ *
+ * @return 这一帧是否超过触发阈值（预热期间总是 false）
+ */
+static bool detect(csi_trigger_t *t, const int8_t *iq)
+{
+    uint16_t amp[CSI_FEATURES_SUBCARRIERS];
+    int64_t energy = 0;
+
+    csi_features_amplitude_q8(iq, amp);
+    for (uint32_t k = 0; k < CSI_FEATURES_SUBCARRIERS; k++) {
+        int32_t a = (int32_t)amp[k] << 4;
+        if (t->frames == 0) {
+            t->mean[k] = a;
+        }
+        int32_t d = a - t->mean[k];
+        t->mean[k] += d / MEAN_DIV;
+        energy += ((int64_t)d * d) >> 8;        // Q24 -> Q16
+    }
+    energy /= CSI_FEATURES_SUBCARRIERS;
+    t->level += (energy - t->level) / LEVEL_DIV;
+
+    bool warming_up = t->frames < t->warmup_frames;
+    if (t->frames <= t->warmup_frames) {
+        t->frames++;
+    }
+    if (warming_up) {
+        t->baseline += (t->level - t->baseline) / WARMUP_DIV;
+        return false;
+    }
+
+    bool above = t->level * 100 > t->baseline * t->threshold_pct && (uint64_t)t->level >= t->min_level;
+    if (!t->active && !above) {
+        t->baseline += (t->level - t->baseline) / BASELINE_DIV;
+    }
+    return above;
+}
+
+csi_trigger_action_t csi_trigger_update(csi_trigger_t *t, const int8_t *iq, size_t len, uint32_t timestamp_us)
+{
+    bool above = len >= CSI_FEATURES_MIN_LEN && detect(t, iq);
+
+    if (above) {
+        t->last_above = timestamp_us;
+        t->last_sent = timestamp_us;
+        if (!t->active) {
+            t->active = true;
+            t->events++;
+            return CSI_TRIGGER_START;
+        }
+        return CSI_TRIGGER_STREAM;
+    }
+
+    if (t->active) {
+        if (timestamp_us - t->last_above < t->hold_us) {
+            t->last_sent = timestamp_us;
+            return CSI_TRIGGER_STREAM;
+        }
+        t->active = false;
+    }
+
+    if (t->heartbeat_us && (!t->heartbeat_sent || timestamp_us - t->last_sent >= t->heartbeat_us)) {
+        t->heartbeat_sent = true;
+        t->last_sent = timestamp_us;
+        return CSI_TRIGGER_HEARTBEAT;
+    }
+    return CSI_TRIGGER_DROP;
+}
+
+uint32_t csi_trigger_level_q4(const csi_trigger_t *t)
+{
+    return (uint32_t)(t->level >> 12);
+}
+
+uint32_t csi_trigger_baseline_q4(const csi_trigger_t *t)
+{
+    return (uint32_t)(t->baseline >> 12);
+}
@@ -0,0 +1,169 @@
+/**
+ * @file test_csi_trigger.c
+ * @brief csi_trigger 主机侧单元测试（linux target）
+ */
+#include <stdlib.h>
+#include "unity.h"
+#include "csi_trigger.h"
+
+#define LLTF_LEN    128
+#define FRAME_US    10000       // 100 Hz
+
+static uint32_t s_rand = 1;
+
+static int rand_range(int range)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return (int)((s_rand >> 16) % (2 * range + 1)) - range;
+}
+
+/* 所有子载波为 (10, 10) 加上 ±noise 的随机扰动 */
+static void fill_iq(int8_t *iq, int noise)
+{
+    for (int i = 0; i < LLTF_LEN; i++) {
+        iq[i] = (int8_t)(10 + rand_range(noise));
+    }
+}
+
+static const csi_trigger_config_t s_config = {
+    .hold_ms = 500,
+    .heartbeat_ms = 1000,
+    .threshold_pct = 400,
+    .min_level_q4 = 16,
+    .warmup_frames = 100,
+};
+
+static void test_init_rejects_invalid_config(void)
+{
+    csi_trigger_t t;
+    csi_trigger_config_t config = s_config;
+
+    config.threshold_pct = 99;
+    TEST_ASSERT_FALSE(csi_trigger_init(&t, &config));
+    config = s_config;
+    config.hold_ms = CSI_TRIGGER_MAX_INTERVAL_MS + 1;
+    TEST_ASSERT_FALSE(csi_trigger_init(&t, &config));
+    config = s_config;
+    config.heartbeat_ms = CSI_TRIGGER_MAX_INTERVAL_MS + 1;
+    TEST_ASSERT_FALSE(csi_trigger_init(&t, &config));
+    TEST_ASSERT_TRUE(csi_trigger_init(&t, &s_config));
+}
+
+static void test_static_sends_heartbeats_only(void)
+{
+    csi_trigger_t t;
+    int8_t iq[LLTF_LEN];
+    int counts[4] = {0};
+
+    TEST_ASSERT_TRUE(csi_trigger_init(&t, &s_config));
+    // 10 s 静止（小噪声）：第一帧和之后每秒一帧为心跳
+    for (uint32_t i = 0; i < 1000; i++) {
+        fill_iq(iq, 1);
+        counts[csi_trigger_update(&t, iq, sizeof(iq), i * FRAME_US)]++;
+    }
+    TEST_ASSERT_EQUAL(10, counts[CSI_TRIGGER_HEARTBEAT]);
+    TEST_ASSERT_EQUAL(990, counts[CSI_TRIGGER_DROP]);
+    TEST_ASSERT_EQUAL(0, counts[CSI_TRIGGER_START]);
+    TEST_ASSERT_EQUAL_UINT32(0, t.events);
+}
+
+static void test_motion_starts_streams_and_holds(void)
+{
+    csi_trigger_t t;
+    csi_trigger_config_t config = s_config;
+    int8_t iq[LLTF_LEN];
+    uint32_t i = 0;
+    int start_at = -1, last_stream = -1, starts = 0;
+
+    config.heartbeat_ms = 0;
+    TEST_ASSERT_TRUE(csi_trigger_init(&t, &config));
+    for (; i < 300; i++) {
+        fill_iq(iq, 2);
+        TEST_ASSERT_EQUAL(CSI_TRIGGER_DROP, csi_trigger_update(&t, iq, sizeof(iq), i * FRAME_US));
+    }
+
+    // 1 s 运动（大幅扰动），之后恢复静止
+    for (; i < 700; i++) {
+        fill_iq(iq, i < 400 ? 40 : 2);
+        csi_trigger_action_t action = csi_trigger_update(&t, iq, sizeof(iq), i * FRAME_US);
+        if (action == CSI_TRIGGER_START) {
+            starts++;
+            start_at = (int)i;
+        } else if (action == CSI_TRIGGER_STREAM) {
+            TEST_ASSERT_TRUE(start_at >= 0);
+            last_stream = (int)i;
+        }
+    }
+
+    TEST_ASSERT_EQUAL(1, starts);
+    TEST_ASSERT_EQUAL_UINT32(1, t.events);
+    TEST_ASSERT_TRUE(start_at >= 300 && start_at < 305);
+    // 最后一次超过阈值在运动结束后不久（变化量平滑衰减），再保持 500 ms
+    TEST_ASSERT_TRUE(last_stream >= 400 + 50 - 1);
+    TEST_ASSERT_TRUE(last_stream < 400 + 100);
+    TEST_ASSERT_FALSE(t.active);
+}
+
+static void test_warmup_and_min_level(void)
+{
+    csi_trigger_t t;
+    int8_t iq[LLTF_LEN];
+
+    TEST_ASSERT_TRUE(csi_trigger_init(&t, &s_config));
+    // 预热期间的大幅变化不触发
+    for (uint32_t i = 0; i < 100; i++) {
+        fill_iq(iq, i % 2 ? 40 : 0);
+        TEST_ASSERT_NOT_EQUAL(CSI_TRIGGER_START, csi_trigger_update(&t, iq, sizeof(iq), i * FRAME_US));
+    }
+
+    // 完全静止时基线趋于 0，低于 min_level 的扰动不触发
+    TEST_ASSERT_TRUE(csi_trigger_init(&t, &s_config));
+    for (uint32_t i = 0; i < 1000; i++) {
+        fill_iq(iq, i < 500 ? 0 : 1);
+        TEST_ASSERT_NOT_EQUAL(CSI_TRIGGER_START, csi_trigger_update(&t, iq, sizeof(iq), i * FRAME_US));
+    }
+    TEST_ASSERT_TRUE(csi_trigger_level_q4(&t) < s_config.min_level_q4);
+}
+
+static void test_short_frames_and_timestamp_wrap(void)
+{
+    csi_trigger_t t;
+    csi_trigger_config_t config = s_config;
+    int8_t iq[LLTF_LEN];
+    uint32_t t0 = UINT32_MAX - 3000000;
+    uint32_t i = 0;
+
+    config.heartbeat_ms = 0;
+    config.warmup_frames = 10;
+    TEST_ASSERT_TRUE(csi_trigger_init(&t, &config));
+    for (; i < 200; i++) {
+        fill_iq(iq, 2);
+        csi_trigger_update(&t, iq, sizeof(iq), t0 + i * FRAME_US);
+    }
+    for (; !t.active; i++) {
+        fill_iq(iq, 40);
+        csi_trigger_update(&t, iq, sizeof(iq), t0 + i * FRAME_US);
+    }
+
+    // 事件中的短帧照常发送，且不影响检测状态；保持时间跨过时间戳回绕
+    int64_t level = t.level;
+    TEST_ASSERT_EQUAL(CSI_TRIGGER_STREAM, csi_trigger_update(&t, iq, CSI_FEATURES_MIN_LEN - 1, t0 + i * FRAME_US));
+    TEST_ASSERT_EQUAL_INT64(level, t.level);
+
+    uint32_t last_above = t.last_above;
+    TEST_ASSERT_EQUAL(CSI_TRIGGER_STREAM, csi_trigger_update(&t, iq, 0, last_above + 499999));
+    TEST_ASSERT_EQUAL(CSI_TRIGGER_DROP, csi_trigger_update(&t, iq, 0, last_above + 500000));
+    TEST_ASSERT_FALSE(t.active);
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_init_rejects_invalid_config);
+    RUN_TEST(test_static_sends_heartbeats_only);
+    RUN_TEST(test_motion_starts_streams_and_holds);
+    RUN_TEST(test_warmup_and_min_level);
+    RUN_TEST(test_short_frames_and_timestamp_wrap);
+    int failures = UNITY_END();
+    exit(failures);
+}
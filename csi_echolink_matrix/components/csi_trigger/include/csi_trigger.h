@@ -0,0 +1,88 @@
+/**
+ * @file csi_trigger.h
+ * @brief 设备侧运动/存在触发：检测 CSI 幅度的变化，只在事件前后流式发送原始帧
+ *
+ * 检测量为 LLTF 子载波幅度相对各自滑动均值的偏差平方（即短时方差）：
+ * - 每个子载波的幅度均值按 1/16 的系数做指数平均（100 Hz 时约 160 ms）；
+ * - 偏差平方按子载波平均后，再按 1/8 的系数平滑，得到当前变化量 level；
+ * - 空闲时按 1/256 的系数跟踪 level 得到基线 baseline，触发期间基线冻结；
+ * - level 超过 baseline * threshold_pct / 100 且不低于 min_level 时触发，
+ *   最后一次超过阈值 hold_ms 之后恢复空闲。
+ *
+ * 调用方根据 csi_trigger_update() 的返回值决定每一帧的去向（见 csi_trigger_action_t），
+ * 触发前的帧由调用方缓存（预触发缓冲区），触发时一并发送。
+ *
+ * 全部使用整数运算，状态是一个定长结构体，不申请内存；可在主机上编译（见 host_test）。
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "csi_features.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** hold_ms / heartbeat_ms 的上限（时间戳为 32 位微秒计数） */
+#define CSI_TRIGGER_MAX_INTERVAL_MS 600000
+
+typedef struct {
+    uint32_t hold_ms;           /*!< 最后一次超过阈值后继续发送的时间 */
+    uint32_t heartbeat_ms;      /*!< 空闲时每隔多久发送一帧，0 表示不发送 */
+    uint16_t threshold_pct;     /*!< 触发阈值：基线的百分比，至少 100 */
+    uint16_t min_level_q4;      /*!< 触发所需的最小变化量（幅度^2，Q4，与特征数据报的方差单位相同） */
+    uint16_t warmup_frames;     /*!< 启动后只学习基线、不触发的帧数 */
+} csi_trigger_config_t;
+
+typedef enum {
+    CSI_TRIGGER_DROP = 0,       /*!< 空闲：只放入预触发缓冲区 */
+    CSI_TRIGGER_HEARTBEAT,      /*!< 空闲：作为心跳发送 */
+    CSI_TRIGGER_START,          /*!< 事件开始：先发送预触发缓冲区，再发送这一帧 */
+    CSI_TRIGGER_STREAM,         /*!< 事件中（含保持时间）：发送 */
+} csi_trigger_action_t;
+
+/** 触发器状态，由调用方分配（静态变量即可） */
+typedef struct {
+    uint32_t hold_us;
+    uint32_t heartbeat_us;
+    uint16_t threshold_pct;
+    uint64_t min_level;         // Q16
+
+    uint32_t frames;            // 已参与检测的帧数（到 warmup_frames + 1 后不再增加）
+    uint32_t warmup_frames;
+    bool     active;
+    bool     heartbeat_sent;
+    uint32_t last_above;        // 最后一次超过阈值的时间戳
+    uint32_t last_sent;         // 最后一次发送（心跳或事件中）的时间戳
+    uint32_t events;            // 触发次数
+    int64_t  level;             // 当前变化量（幅度^2，Q16）
+    int64_t  baseline;          // 基线（幅度^2，Q16）
+    int32_t  mean[CSI_FEATURES_SUBCARRIERS];           // 幅度均值（Q12）
+} csi_trigger_t;
+
+/**
+ * @brief 初始化触发器
+ *
+ * @return threshold_pct 小于 100、hold_ms 或 heartbeat_ms 超过 CSI_TRIGGER_MAX_INTERVAL_MS 时返回 false
+ */
+bool csi_trigger_init(csi_trigger_t *trigger, const csi_trigger_config_t *config);
+
+/**
+ * @brief 输入一帧，返回这一帧的去向
+ *
+ * @param iq int8 I/Q（虚部、实部交替），长度不足 CSI_FEATURES_MIN_LEN 的帧不参与检测，只按当前状态处理
+ * @param timestamp_us rx_ctrl->timestamp
+ */
+csi_trigger_action_t csi_trigger_update(csi_trigger_t *trigger, const int8_t *iq, size_t len,
+                                        uint32_t timestamp_us);
+
+/** 当前变化量和基线（幅度^2，Q4），用于日志 */
+uint32_t csi_trigger_level_q4(const csi_trigger_t *trigger);
+uint32_t csi_trigger_baseline_q4(const csi_trigger_t *trigger);
+
+#ifdef __cplusplus
+}
+#endif
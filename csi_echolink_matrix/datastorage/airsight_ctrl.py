@@ -0,0 +1,448 @@
+'''
+@module:airsight_ctrl
+@brief:通过控制端口查询和替换 AirSight 的转发表，订阅 CSI 数据
+1.数据报格式与 components/csi_proto/include/csi_ctrl.h 保持一致
+2.get：查询各转发目标的状态和统计
+3.set：替换转发表，--persist 同时写入 AirSight 的 NVS
+4.AirSightSubscriber：接收端向 AirSight 订阅并定期续约，可按探针 MAC 过滤
+5.time：查询 AirSight 时钟（esp_timer 微秒）与主机 Unix 时间的偏差，可把帧的 sync_us 换算为 Unix 时间
+6.serve-time：主机对时服务，探针配置 AIRPROBE_CLOCK_SYNC_SERVER 为本机地址时，sync_us 即为主机的 Unix 微秒
+7.sources：查询 AirSight 按探针统计的丢失、乱序、重启、空洞长度分布和到达抖动，--reset 同时清零
+8.stats：查询一个或多个节点的运行指标（AirSight 的控制端口、AirProbe 的 AIRPROBE_METRICS_PORT），每个节点输出一行 JSON；
+  --interval 定期查询，并按两次查询的差值给出计数器的每秒速率
+'''
+
+import argparse
+import json
+import socket
+import struct
+import threading
+import time
+from csi_frame import CSI_FRAME_MAGIC, CSI_FRAME_VERSION, mac_to_str
+from csi_seq import format_seq_stats
+
+AIRSIGHT_CTRL_PORT = 3334
+DEFAULT_FORWARD_PORT = 4444
+
+CSI_CTRL_TYPE_FWD_SET = 0x10
+CSI_CTRL_TYPE_FWD_GET = 0x11
+CSI_CTRL_TYPE_FWD_STATUS = 0x12
+CSI_CTRL_TYPE_SUBSCRIBE = 0x13
+CSI_CTRL_TYPE_UNSUBSCRIBE = 0x14
+CSI_CTRL_TYPE_SUB_ACK = 0x15
+CSI_CTRL_TYPE_TIME_REQ = 0x16
+CSI_CTRL_TYPE_TIME_RESP = 0x17
+CSI_CTRL_TYPE_SRC_GET = 0x18
+CSI_CTRL_TYPE_SRC_STATUS = 0x19
+CSI_CTRL_TYPE_STATS_GET = 0x1A
+CSI_CTRL_TYPE_STATS = 0x1B
+
+CSI_CTRL_FLAG_PERSIST = 0x01
+CSI_CTRL_FLAG_RESET = 0x02
+CSI_CTRL_FLAG_ERROR = 0x80
+
+# magic, version, type, hdr_len, count, flags, len
+CSI_CTRL_HDR = struct.Struct('<BBBBBBH')
+# ip[4], port
+CSI_CTRL_FWD_TARGET = struct.Struct('<4sH')
+# ip[4], port, state, kind, backoff_ms, sent, failed, skipped, bytes
+CSI_CTRL_FWD_STATUS = struct.Struct('<4sHBBIIIIQ')
+CSI_CTRL_FWD_STATES = {0: 'UP', 1: 'BACKOFF'}
+CSI_CTRL_FWD_KINDS = {0: 'static', 1: 'subscriber'}
+# port, lease_s
+CSI_CTRL_SUBSCRIBE = struct.Struct('<HH')
+# t1, t2, t3（微秒）
+CSI_CTRL_TIME = struct.Struct('<qqq')
+# id[6], kind, reserved, received, lost, duplicate, reordered, restarts, jitter_us, last_seq, idle_ms, gaps[8]
+CSI_CTRL_SRC_STATUS = struct.Struct('<6sBx8I8I')
+CSI_CTRL_SRC_KIND_PROBE = 0
+# id, kind, len, value
+CSI_CTRL_METRIC = struct.Struct('<BBHI')
+# sum, max, buckets[16]
+CSI_CTRL_METRIC_HIST = struct.Struct('<II16I')
+CSI_CTRL_METRIC_COUNTER = 0
+CSI_CTRL_METRIC_GAUGE = 1
+CSI_CTRL_METRIC_HISTOGRAM = 2
+CSI_CTRL_METRIC_NAMES = {
+    0x01: 'uptime_s', 0x02: 'free_heap', 0x03: 'min_free_heap', 0x04: 'wifi_rssi',
+    0x10: 'csi_callbacks', 0x11: 'csi_encode_us', 0x12: 'ring_used', 0x13: 'ring_high_water', 0x14: 'ring_overflow',
+    0x15: 'csi_sent', 0x16: 'trigger_suppressed',
+    0x20: 'rx_datagrams', 0x21: 'rx_frames', 0x22: 'rx_truncated',
+    0x30: 'tx_datagrams', 0x31: 'tx_failed', 0x32: 'sendto_us',
+}
+AIRPROBE_METRICS_PORT = 3335
+
+
+def pack_ctrl(msg_type, entries=b'', count=0, flags=0):
+    return CSI_CTRL_HDR.pack(CSI_FRAME_MAGIC, CSI_FRAME_VERSION, msg_type, CSI_CTRL_HDR.size,
+                             count, flags, len(entries)) + entries
+
+
+def parse_target(text):
+    '''
+    @brief:解析 "ip[:port]"
+    '''
+    ip, _, port = text.partition(':')
+    return CSI_CTRL_FWD_TARGET.pack(socket.inet_aton(ip), int(port) if port else DEFAULT_FORWARD_PORT)
+
+
+def unpack_fwd_status(data):
+    '''
+    @brief:解码 FWD_STATUS 应答
+    @return:(ok, 目标状态字典列表)
+    '''
+    magic, _, msg_type, hdr_len, count, flags, length = CSI_CTRL_HDR.unpack_from(data)
+    if magic != CSI_FRAME_MAGIC or msg_type != CSI_CTRL_TYPE_FWD_STATUS or hdr_len + length > len(data):
+        raise ValueError('not a FWD_STATUS reply')
+
+    targets = []
+    for i in range(count):
+        ip, port, state, kind, backoff_ms, sent, failed, skipped, nbytes = \
+            CSI_CTRL_FWD_STATUS.unpack_from(data, hdr_len + i * CSI_CTRL_FWD_STATUS.size)
+        targets.append({'target': f'{socket.inet_ntoa(ip)}:{port}', 'state': CSI_CTRL_FWD_STATES.get(state, state),
+                        'kind': CSI_CTRL_FWD_KINDS.get(kind, kind), 'backoff_ms': backoff_ms,
+                        'sent': sent, 'failed': failed, 'skipped': skipped, 'bytes': nbytes})
+    return not flags & CSI_CTRL_FLAG_ERROR, targets
+
+
+def request(host, port, payload, timeout=2.0):
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as sock:
+        sock.settimeout(timeout)
+        sock.sendto(payload, (host, port))
+        data, _ = sock.recvfrom(2048)
+    return unpack_fwd_status(data)
+
+
+def unpack_src_status(data):
+    '''
+    @brief:解码 SRC_STATUS 应答
+    @return:数据源统计字典列表，'source' 为探针 MAC 或 CSV 发送端的 "ip:port"
+    '''
+    magic, _, msg_type, hdr_len, count, _, length = CSI_CTRL_HDR.unpack_from(data)
+    if magic != CSI_FRAME_MAGIC or msg_type != CSI_CTRL_TYPE_SRC_STATUS or hdr_len + length > len(data):
+        raise ValueError('not a SRC_STATUS reply')
+
+    sources = []
+    for i in range(count):
+        fields = CSI_CTRL_SRC_STATUS.unpack_from(data, hdr_len + i * CSI_CTRL_SRC_STATUS.size)
+        source_id, kind = fields[0], fields[1]
+        if kind == CSI_CTRL_SRC_KIND_PROBE:
+            source = mac_to_str(source_id)
+        else:
+            source = f'{socket.inet_ntoa(source_id[:4])}:{struct.unpack(">H", source_id[4:])[0]}'
+        stats = dict(zip(('received', 'lost', 'duplicate', 'reordered', 'restarts', 'jitter_us', 'last_seq',
+                          'idle_ms'), fields[2:10]))
+        stats['source'] = source
+        stats['gaps'] = list(fields[10:])
+        sources.append(stats)
+    return sources
+
+
+def unpack_stats(data):
+    '''
+    @brief:解码 STATS 应答
+    @return:(计数器字典, 其余指标字典)；直方图为 {count, sum, max, mean, buckets}，桶 i 为 [2^i, 2^(i+1)) us（桶 0 含 0）
+    '''
+    magic, _, msg_type, hdr_len, count, _, length = CSI_CTRL_HDR.unpack_from(data)
+    if magic != CSI_FRAME_MAGIC or msg_type != CSI_CTRL_TYPE_STATS or hdr_len + length > len(data):
+        raise ValueError('not a STATS reply')
+
+    counters, values = {}, {}
+    pos, end = hdr_len, hdr_len + length
+    for _ in range(count):
+        if pos + CSI_CTRL_METRIC.size > end:
+            break
+        metric_id, kind, extra, value = CSI_CTRL_METRIC.unpack_from(data, pos)
+        name = CSI_CTRL_METRIC_NAMES.get(metric_id, f'metric_{metric_id:#04x}')
+        body = pos + CSI_CTRL_METRIC.size
+        if kind == CSI_CTRL_METRIC_COUNTER:
+            counters[name] = value
+        elif kind == CSI_CTRL_METRIC_GAUGE:
+            values[name] = value - (1 << 32) if value & 0x80000000 else value
+        elif kind == CSI_CTRL_METRIC_HISTOGRAM and extra >= CSI_CTRL_METRIC_HIST.size and body + extra <= end:
+            total, peak, *buckets = CSI_CTRL_METRIC_HIST.unpack_from(data, body)
+            values[name] = {'count': value, 'sum': total, 'max': peak,
+                            'mean': round(total / value, 1) if value else 0, 'buckets': buckets}
+        # 未知的 kind 按 len 跳过
+        pos = body + extra
+    return counters, values
+
+
+def query_stats(host, port, timeout=1.0):
+    '''
+    @brief:查询一个节点的运行指标
+    @return:(计数器字典, 其余指标字典)，无应答时返回 None
+    '''
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as sock:
+        sock.settimeout(timeout)
+        sock.sendto(pack_ctrl(CSI_CTRL_TYPE_STATS_GET), (host, port))
+        try:
+            data, _ = sock.recvfrom(2048)
+        except socket.timeout:
+            return None
+    return unpack_stats(data)
+
+
+def scrape_stats(nodes, interval=0.0):
+    '''
+    @brief:依次查询各节点，每个节点打印一行 JSON；interval 大于 0 时循环查询，
+           计数器按 32 位回绕求差，除以两次查询的间隔得到每秒速率（rates）
+    @param nodes:(host, port) 列表
+    '''
+    last = {}
+    while True:
+        for host, port in nodes:
+            node = f'{host}:{port}'
+            now = time.monotonic()
+            result = query_stats(host, port)
+            if result is None:
+                print(json.dumps({'node': node, 'error': 'no reply'}), flush=True)
+                continue
+            counters, values = result
+            record = {'node': node, **values, **counters}
+            if node in last:
+                prev_time, prev = last[node]
+                dt = now - prev_time
+                record['rates'] = {name: round(((value - prev[name]) & 0xFFFFFFFF) / dt, 1)
+                                   for name, value in counters.items() if name in prev and dt > 0}
+            last[node] = (now, counters)
+            print(json.dumps(record), flush=True)
+        if interval <= 0:
+            return
+        time.sleep(interval)
+
+
+def parse_node(text, default_port):
+    host, _, port = text.partition(':')
+    return host, int(port) if port else default_port
+
+
+def pack_subscribe(data_port, lease_s=0, probe_macs=(), unsubscribe=False):
+    '''
+    @brief:构造 SUBSCRIBE / UNSUBSCRIBE 请求
+    @param:data_port: 接收 CSI 数据的本地端口
+    @param:lease_s: 请求的租期（秒），0 表示使用 AirSight 的默认值
+    @param:probe_macs: 只接收这些探针的数据（"aa:bb:cc:dd:ee:ff"），为空时接收全部
+    '''
+    macs = b''.join(bytes.fromhex(mac.replace(':', '')) for mac in probe_macs)
+    msg_type = CSI_CTRL_TYPE_UNSUBSCRIBE if unsubscribe else CSI_CTRL_TYPE_SUBSCRIBE
+    return pack_ctrl(msg_type, CSI_CTRL_SUBSCRIBE.pack(data_port, lease_s) + macs, len(probe_macs))
+
+
+class AirSightSubscriber:
+    '''
+    @brief:向 AirSight 订阅 CSI 数据，后台线程在租期过去三分之一时续约
+    用法：
+        sub = AirSightSubscriber('192.168.99.1', 4444, probe_macs=['aa:bb:cc:dd:ee:ff'])
+        sub.start()
+        ...  # 在 4444 端口照常接收数据
+        sub.stop()
+    '''
+    def __init__(self, host, data_port, probe_macs=(), lease_s=30, port=AIRSIGHT_CTRL_PORT):
+        self.addr = (host, port)
+        self.data_port = data_port
+        self.probe_macs = list(probe_macs)
+        self.lease_s = lease_s
+        self.granted_s = 0
+        self._stop = threading.Event()
+        self._thread = None
+        # 控制请求使用单独的 socket，应答不会混进数据端口
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.settimeout(2.0)
+
+    def subscribe(self):
+        '''
+        @brief:发送一次订阅/续约请求
+        @return:实际租期（秒），失败时为 0
+        '''
+        try:
+            self.sock.sendto(pack_subscribe(self.data_port, self.lease_s, self.probe_macs), self.addr)
+            data, _ = self.sock.recvfrom(64)
+            _, _, msg_type, hdr_len, _, flags, _ = CSI_CTRL_HDR.unpack_from(data)
+            if msg_type != CSI_CTRL_TYPE_SUB_ACK or flags & CSI_CTRL_FLAG_ERROR:
+                print(f'AirSight {self.addr[0]} rejected subscription')
+                return 0
+            _, self.granted_s = CSI_CTRL_SUBSCRIBE.unpack_from(data, hdr_len)
+        except (socket.error, struct.error) as msg:
+            print(f'Subscribe to AirSight {self.addr[0]} failed: {msg}')
+            return 0
+        return self.granted_s
+
+    def _run(self):
+        while not self._stop.is_set():
+            granted_s = self.subscribe()
+            # 未收到应答时 1 秒后重试
+            self._stop.wait(granted_s / 3 if granted_s else 1.0)
+
+    def start(self):
+        self._thread = threading.Thread(target=self._run, daemon=True)
+        self._thread.start()
+        return self
+
+    def stop(self):
+        self._stop.set()
+        if self._thread:
+            self._thread.join()
+        try:
+            self.sock.sendto(pack_subscribe(self.data_port, unsubscribe=True), self.addr)
+        except socket.error:
+            pass
+        self.sock.close()
+
+
+def unix_us():
+    return time.time_ns() // 1000
+
+
+def query_time(host, port=AIRSIGHT_CTRL_PORT, count=8, timeout=0.5):
+    '''
+    @brief:向 AirSight（或另一个对时服务）对时 count 次，取往返时延最小的一次
+    @return:(offset_us, delay_us)，offset_us 为对端时钟减主机 Unix 微秒；全部超时时返回 None
+    '''
+    best = None
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as sock:
+        sock.settimeout(timeout)
+        for _ in range(count):
+            t1 = unix_us()
+            sock.sendto(pack_ctrl(CSI_CTRL_TYPE_TIME_REQ, CSI_CTRL_TIME.pack(t1, 0, 0)), (host, port))
+            try:
+                while True:
+                    data, _ = sock.recvfrom(64)
+                    t4 = unix_us()
+                    _, _, msg_type, hdr_len, _, flags, length = CSI_CTRL_HDR.unpack_from(data)
+                    if (msg_type == CSI_CTRL_TYPE_TIME_RESP and not flags & CSI_CTRL_FLAG_ERROR
+                            and length >= CSI_CTRL_TIME.size):
+                        r1, t2, t3 = CSI_CTRL_TIME.unpack_from(data, hdr_len)
+                        if r1 == t1:
+                            break
+            except (socket.timeout, struct.error):
+                continue
+
+            delay = (t4 - t1) - (t3 - t2)
+            offset = ((t2 - t1) + (t3 - t4)) // 2
+            if best is None or delay < best[1]:
+                best = (offset, delay)
+    return best
+
+
+def serve_time(port=AIRSIGHT_CTRL_PORT, bind='0.0.0.0', verbose=False):
+    '''
+    @brief:主机对时服务：用 Unix 微秒应答 TIME_REQ，其它数据报忽略
+    '''
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as sock:
+        sock.bind((bind, port))
+        print(f'Serving time on {bind}:{port}')
+        while True:
+            data, addr = sock.recvfrom(256)
+            t2 = unix_us()
+            try:
+                _, _, msg_type, hdr_len, _, _, length = CSI_CTRL_HDR.unpack_from(data)
+                if data[0] != CSI_FRAME_MAGIC or msg_type != CSI_CTRL_TYPE_TIME_REQ or length < CSI_CTRL_TIME.size:
+                    continue
+                t1, _, _ = CSI_CTRL_TIME.unpack_from(data, hdr_len)
+            except struct.error:
+                continue
+            # t3 尽量靠近 sendto
+            sock.sendto(pack_ctrl(CSI_CTRL_TYPE_TIME_RESP, CSI_CTRL_TIME.pack(t1, t2, unix_us())), addr)
+            if verbose:
+                print(f'{addr[0]}:{addr[1]} t1={t1} t2={t2}')
+
+
+def join_multicast_group(sock, group, local_ip='0.0.0.0'):
+    '''
+    @brief:让已绑定的接收 socket 加入组播组（AirSight 的 AIRSIGHT_MCAST_REPUBLISH 或 AirProbe 的组播模式）
+    '''
+    mreq = struct.pack('4s4s', socket.inet_aton(group), socket.inet_aton(local_ip))
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+
+
+def start_subscription(sock):
+    '''
+    @brief:按 config 配置接收端的数据来源：
+    1.CSI_Multicast_Group 非空时加入组播组
+    2.AirSight_IP 非空时向 AirSight 订阅
+    都为空时依赖 AirSight 的固定转发表
+    @param:sock: 已绑定到数据端口的接收 socket
+    @return:AirSightSubscriber 或 None
+    '''
+    from config import AirSight_IP, AirSight_Probe_MACs, CSI_Multicast_Group
+    data_port = sock.getsockname()[1]
+    if CSI_Multicast_Group:
+        print(f'Joining multicast group {CSI_Multicast_Group} on port {data_port}')
+        join_multicast_group(sock, CSI_Multicast_Group)
+    if not AirSight_IP:
+        return None
+    print(f'Subscribing to AirSight {AirSight_IP} on port {data_port}')
+    return AirSightSubscriber(AirSight_IP, data_port, AirSight_Probe_MACs).start()
+
+
+def main():
+    parser = argparse.ArgumentParser(description='AirSight forward table control')
+    parser.add_argument('--host', help='AirSight IP address (not needed for serve-time)')
+    parser.add_argument('--port', type=int, default=AIRSIGHT_CTRL_PORT)
+    sub = parser.add_subparsers(dest='cmd', required=True)
+    sub.add_parser('get', help='show forward targets and counters')
+    set_parser = sub.add_parser('set', help='replace the forward table')
+    set_parser.add_argument('targets', nargs='+', help='ip[:port]')
+    set_parser.add_argument('--persist', action='store_true', help='store the table in NVS')
+    sub.add_parser('time', help='measure the AirSight clock against host Unix time')
+    sources_parser = sub.add_parser('sources', help='show per-probe loss, reorder and jitter counters')
+    sources_parser.add_argument('--reset', action='store_true', help='clear the counters after reading')
+    stats_parser = sub.add_parser('stats', help='show runtime metrics of AirSight and AirProbe nodes as JSON lines')
+    stats_parser.add_argument('nodes', nargs='*', help='host[:port] (default --host:--port; AirProbe listens on '
+                                                       f'{AIRPROBE_METRICS_PORT})')
+    stats_parser.add_argument('--interval', type=float, default=0.0, help='repeat every N seconds and add rates')
+    serve_parser = sub.add_parser('serve-time', help='answer probe clock sync requests with host Unix time')
+    serve_parser.add_argument('--bind', default='0.0.0.0')
+    serve_parser.add_argument('-v', '--verbose', action='store_true')
+    args = parser.parse_args()
+
+    if args.cmd == 'serve-time':
+        serve_time(args.port, args.bind, args.verbose)
+        return
+    if args.cmd == 'stats' and args.nodes:
+        scrape_stats([parse_node(n, args.port) for n in args.nodes], args.interval)
+        return
+    if not args.host:
+        parser.error('--host is required')
+
+    if args.cmd == 'time':
+        result = query_time(args.host, args.port)
+        if result is None:
+            print('no time reply')
+        else:
+            offset, delay = result
+            print(f'offset={offset} us (AirSight - Unix), round trip={delay} us')
+        return
+
+    if args.cmd == 'stats':
+        scrape_stats([(args.host, args.port)], args.interval)
+        return
+
+    if args.cmd == 'sources':
+        with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as sock:
+            sock.settimeout(2.0)
+            sock.sendto(pack_ctrl(CSI_CTRL_TYPE_SRC_GET, flags=CSI_CTRL_FLAG_RESET if args.reset else 0),
+                        (args.host, args.port))
+            data, _ = sock.recvfrom(2048)
+        for stats in unpack_src_status(data):
+            print(format_seq_stats(stats['source'], stats) + f" idle={stats['idle_ms']}ms")
+        return
+
+    if args.cmd == 'set':
+        entries = b''.join(parse_target(t) for t in args.targets)
+        payload = pack_ctrl(CSI_CTRL_TYPE_FWD_SET, entries, len(args.targets),
+                            CSI_CTRL_FLAG_PERSIST if args.persist else 0)
+    else:
+        payload = pack_ctrl(CSI_CTRL_TYPE_FWD_GET)
+
+    ok, targets = request(args.host, args.port, payload)
+    if not ok:
+        print('request rejected, forward table unchanged')
+    for t in targets:
+        print(f"{t['target']:<22} {t['kind']:<10} {t['state']:<8} backoff={t['backoff_ms']}ms sent={t['sent']} "
+              f"failed={t['failed']} skipped={t['skipped']} bytes={t['bytes']}")
+
+
+if __name__ == '__main__':
+    main()
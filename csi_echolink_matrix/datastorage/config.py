@@ -1,6 +1,17 @@
 UDP_Server_IP = "192.168.99.55"
 UDP_Server_Port = 4444
 
+# AirSight 的 IP：非空时接收端向 AirSight 订阅数据（见 airsight_ctrl.py），为空时依赖 AirSight 的固定转发表
+AirSight_IP = ""
+# 只接收这些 AirProbe 的数据（"aa:bb:cc:dd:ee:ff"），为空时接收全部
+AirSight_Probe_MACs = []
+# 组播组：非空时接收端加入该组（AirSight 的 AIRSIGHT_MCAST_GROUP 默认为 239.10.11.12），无需订阅或转发表
+CSI_Multicast_Group = ""
+# save_csidata.py 的保存格式："text" 为 csi_data_<ts>.txt（CSV 文本），"columnar" 为 csi_data_<ts>.csic（见 csi_capture.py）
+CSI_Capture_Format = "text"
+# save_csidata.py 每隔多少秒打印一次各探针的丢失/乱序/抖动统计（见 csi_seq.py），0 表示不打印
+Seq_Report_Interval_S = 10
+
 CSI_DATA_FIELD = 'type,seq,mac,rssi,rate,sigmode,mcs,bandwidth,smoothing,notsounding,aggregation,stbc,feccoding,sgi,noisefloor,ampducnt,channel,secondarychannel,localtimestamp,ant,siglen,rxstate,len,firstword,data'
 
 CSI_DATA_COLUMNS_NAMES = ["type", "id", "mac", "rssi", "rate", "sig_mode", "mcs", "bandwidth", "smoothing", "not_sounding", "aggregation", "stbc", "fec_coding",
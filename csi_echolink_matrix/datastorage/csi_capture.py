@@ -0,0 +1,482 @@
+'''
+@module:csi_capture
+@brief:列式、可 mmap 的 CSI 采集文件格式（csi_data_<ms>.csic）
+1.元数据按 CSI_DATA_COLUMNS_NAMES 存为定长记录（RECORD_DTYPE），I/Q 存为稠密 int8 块，分析时无需解析文本
+2.数据按块（chunk）写入，每块头部记录时间范围和出现过的 MAC，文件末尾附块索引，按时间范围定位时不读取数据
+3.按文件大小轮转（与 save_csidata.py 的 file_size_limit 相同的方式），文件名为 csi_data_<首帧毫秒时间戳>.csic
+4.未正常关闭（没有末尾索引）的文件仍可读取：依次扫描块头重建索引
+5.version 2 的记录追加了同步时间戳（sync_us 等，见 csi_frame.py），version 1 的文件仍可读取，新字段为 0
+6.命令行：
+    python csi_capture.py convert csi_data_1739685094262.txt -o captures   # 从 CSV 文本转换
+    python csi_capture.py info captures
+    python csi_capture.py export captures --start 1739685094 --end 1739685100 --mac 22:41:8a:71:1f:e0
+
+文件布局（小端）：
+    文件头 FILE_HDR (32B)
+    块 * N：CHUNK_HDR (64B) | MAC 表 mac_count * 8B | 记录 count * RECORD_DTYPE | I/Q count * iq_width | 补齐到 8 字节
+    块索引 INDEX_DTYPE * N | TRAILER (16B)        —— close() 时写入
+'''
+
+import argparse
+import glob
+import mmap
+import os
+import re
+import struct
+import sys
+import time
+
+import numpy as np
+
+from config import CSI_DATA_COLUMNS_NAMES
+from csi_frame import CSI_RECORD_DTYPE, mac_to_str, packet_to_record
+from csi_native import CsiParser, parse_datagrams
+
+CAPTURE_MAGIC = b'CSICAP\x00\x00'
+CAPTURE_VERSION = 2
+CAPTURE_SUFFIX = '.csic'
+
+# magic, version, header_size, record_size, reserved, created_us
+FILE_HDR = struct.Struct('<8sHHHHq8x')
+# magic, header_size, mac_count, count, iq_width, record_size, t_first_us, t_last_us,
+# records_offset, iq_offset, chunk_size（偏移均相对块起始）
+CHUNK_HDR = struct.Struct('<4sHHIHHqqIII20x')
+CHUNK_MAGIC = b'CHNK'
+# index_offset, chunk_count, magic
+TRAILER = struct.Struct('<QI4s')
+TRAILER_MAGIC = b'CIDX'
+
+MAC_KIND_TX = 0         # 记录中的 mac（发送端）
+MAC_KIND_PROBE = 1      # 记录中的 probe_mac（采集的 AirProbe，CSV 文本中没有该字段，为全 0）
+MAC_ENTRY_DTYPE = np.dtype([('mac', 'u1', (6,)), ('kind', 'u1'), ('reserved', 'u1')])
+
+# 记录格式与批量解析结果相同（csi_frame.CSI_RECORD_DTYPE），time_us 为按时间范围查询的依据
+RECORD_DTYPE = CSI_RECORD_DTYPE
+# version 1 文件的记录：没有末尾的同步时间戳字段
+RECORD_DTYPE_V1 = np.dtype({name: RECORD_DTYPE.fields[name] for name in RECORD_DTYPE.names
+                            if name not in ('sync_us', 'drift_ppb', 'sync_err_us')})
+RECORD_DTYPES = {1: RECORD_DTYPE_V1, CAPTURE_VERSION: RECORD_DTYPE}
+
+INDEX_DTYPE = np.dtype([('offset', '<u8'), ('t_first_us', '<i8'), ('t_last_us', '<i8'),
+                        ('count', '<u4'), ('iq_width', '<u2'), ('mac_count', '<u2')])
+
+
+def _mac_bytes(mac):
+    if isinstance(mac, (bytes, bytearray)):
+        return bytes(mac)
+    return bytes.fromhex(mac.replace(':', ''))
+
+
+def _pad8(size):
+    return (size + 7) & ~7
+
+
+class CaptureWriter:
+    '''
+    @brief:把数据包按块写入 .csic 文件，文件超过 rotate_bytes 后在下一块开始新文件
+    @param:directory: 输出目录
+    @param:rotate_bytes: 单个文件的大小上限
+    @param:chunk_records: 每块最多记录数
+    @param:chunk_interval_s: 每块最多跨越的时间（秒），保证实时写入时按时间定位的精度
+    '''
+
+    def __init__(self, directory='.', rotate_bytes=64 * 1024 * 1024, chunk_records=1024,
+                 chunk_interval_s=1.0, prefix='csi_data_'):
+        self.directory = directory
+        self.rotate_bytes = rotate_bytes
+        self.chunk_records = chunk_records
+        self.chunk_interval_us = int(chunk_interval_s * 1e6)
+        self.prefix = prefix
+
+        self.file = None
+        self.path = ''
+        self.file_size = 0
+        self.index = []
+        self.files = []
+
+        self.pending = []           # 尚未写入的 (records, iq)
+        self.pending_count = 0
+        self.pending_first_us = 0
+
+    def append(self, packet, time_us=None):
+        '''
+        @brief:追加一帧
+        @param:packet: csi_frame.parse_csi_packets 返回的字典（文本解析结果的值为字符串也可以）
+        @param:time_us: 主机接收时间，默认为当前时间
+        '''
+        if time_us is None:
+            time_us = time.time_ns() // 1000
+        record, iq = packet_to_record(packet, time_us)
+        self.append_batch(np.array([record], dtype=RECORD_DTYPE), iq[None, :])
+
+    def append_datagram(self, data, time_us=None):
+        '''
+        @brief:追加一个 UDP 数据报（二进制帧、聚合容器或 CSV 文本）中的所有帧
+        @return:追加的帧数
+        '''
+        records, _, iq = parse_datagrams([data], time_us, n_sub=0, with_iq=True)
+        self.append_batch(records, iq)
+        return len(records)
+
+    def append_batch(self, records, iq):
+        '''
+        @brief:追加批量解析的结果（csi_native.parse_datagrams(..., with_iq=True)）
+        @param:records: RECORD_DTYPE 数组
+        @param:iq: (len(records), width) 的 int8 数组
+        '''
+        times = records['time_us']
+        start = 0
+        while start < len(records):
+            if self.pending_count == 0:
+                self.pending_first_us = int(times[start])
+
+            # 块满或出现超出块时间跨度的帧时结束当前块
+            take = min(len(records) - start, self.chunk_records - self.pending_count)
+            late = np.flatnonzero(times[start:start + take] >= self.pending_first_us + self.chunk_interval_us)
+            if len(late):
+                take = int(late[0])
+            if take:
+                self.pending.append((records[start:start + take], iq[start:start + take]))
+                self.pending_count += take
+                start += take
+
+            if len(late) or self.pending_count >= self.chunk_records:
+                self.flush()
+
+    def flush(self):
+        '''
+        @brief:把缓存的帧写为一个块
+        '''
+        if not self.pending:
+            return
+
+        records = np.concatenate([r for r, _ in self.pending])
+        iq_width = max(rows.shape[1] for _, rows in self.pending)
+        iq = np.zeros((len(records), iq_width), dtype=np.int8)
+        row = 0
+        for r, rows in self.pending:
+            iq[row:row + len(r), :rows.shape[1]] = rows
+            row += len(r)
+        self.pending, self.pending_count = [], 0
+
+        macs = [(mac, MAC_KIND_TX) for mac in np.unique(records['mac'], axis=0)]
+        macs += [(mac, MAC_KIND_PROBE) for mac in np.unique(records['probe_mac'], axis=0) if mac.any()]
+        mac_table = np.zeros(len(macs), dtype=MAC_ENTRY_DTYPE)
+        for i, (mac, kind) in enumerate(macs):
+            mac_table[i] = (mac, kind, 0)
+
+        records_offset = CHUNK_HDR.size + mac_table.nbytes
+        iq_offset = records_offset + records.nbytes
+        chunk_size = _pad8(iq_offset + iq.nbytes)
+        t_first, t_last = int(records['time_us'].min()), int(records['time_us'].max())
+
+        if self.file is None or self.file_size >= self.rotate_bytes:
+            self._open_next(t_first)
+
+        header = CHUNK_HDR.pack(CHUNK_MAGIC, CHUNK_HDR.size, len(mac_table), len(records), iq_width,
+                                RECORD_DTYPE.itemsize, t_first, t_last, records_offset, iq_offset, chunk_size)
+        padding = b'\x00' * (chunk_size - iq_offset - iq.nbytes)
+        self.file.write(header + mac_table.tobytes() + records.tobytes() + iq.tobytes() + padding)
+        self.file.flush()
+
+        self.index.append((self.file_size, t_first, t_last, len(records), iq_width, len(mac_table)))
+        self.file_size += chunk_size
+
+    def close(self):
+        '''
+        @brief:写入剩余的帧和块索引并关闭文件
+        '''
+        self.flush()
+        self._finish_file()
+
+    def _open_next(self, t_first_us):
+        self._finish_file()
+
+        ms = t_first_us // 1000
+        path = os.path.join(self.directory, f'{self.prefix}{ms}{CAPTURE_SUFFIX}')
+        # 同一毫秒内轮转两次时避免覆盖：时间戳顺延
+        while os.path.exists(path):
+            ms += 1
+            path = os.path.join(self.directory, f'{self.prefix}{ms}{CAPTURE_SUFFIX}')
+
+        self.file = open(path, 'wb')
+        self.file.write(FILE_HDR.pack(CAPTURE_MAGIC, CAPTURE_VERSION, FILE_HDR.size, RECORD_DTYPE.itemsize, 0,
+                                      time.time_ns() // 1000))
+        self.path = path
+        self.file_size = FILE_HDR.size
+        self.index = []
+        self.files.append(path)
+
+    def _finish_file(self):
+        if self.file is None:
+            return
+        index = np.array(self.index, dtype=INDEX_DTYPE)
+        self.file.write(index.tobytes() + TRAILER.pack(self.file_size, len(index), TRAILER_MAGIC))
+        self.file.close()
+        self.file = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+class CaptureFile:
+    '''
+    @brief:以 mmap 方式只读打开一个 .csic 文件，记录和 I/Q 以 numpy 视图返回，不复制数据
+    '''
+
+    def __init__(self, path):
+        self.path = path
+        with open(path, 'rb') as f:
+            self.mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        magic, version, header_size, record_size, _, self.created_us = FILE_HDR.unpack_from(self.mm)
+        if (magic != CAPTURE_MAGIC or version not in RECORD_DTYPES
+                or record_size != RECORD_DTYPES[version].itemsize):
+            raise ValueError(f'{path}: not a supported CSI capture file (version {version})')
+        self.version = version
+        self.header_size = header_size
+        self.index = self._load_index()
+
+    def _load_index(self):
+        size = len(self.mm)
+        if size >= self.header_size + TRAILER.size:
+            index_offset, count, magic = TRAILER.unpack_from(self.mm, size - TRAILER.size)
+            if magic == TRAILER_MAGIC and index_offset + count * INDEX_DTYPE.itemsize + TRAILER.size == size:
+                return np.frombuffer(self.mm, dtype=INDEX_DTYPE, count=count, offset=index_offset)
+
+        # 没有末尾索引（写入时中断）：扫描块头，丢弃不完整的最后一块
+        entries = []
+        offset = self.header_size
+        while offset + CHUNK_HDR.size <= size:
+            (magic, _, mac_count, count, iq_width, _, t_first, t_last,
+             _, _, chunk_size) = CHUNK_HDR.unpack_from(self.mm, offset)
+            if magic != CHUNK_MAGIC or chunk_size == 0 or offset + chunk_size > size:
+                break
+            entries.append((offset, t_first, t_last, count, iq_width, mac_count))
+            offset += chunk_size
+        return np.array(entries, dtype=INDEX_DTYPE)
+
+    @property
+    def t_first_us(self):
+        return int(self.index['t_first_us'].min()) if len(self.index) else 0
+
+    @property
+    def t_last_us(self):
+        return int(self.index['t_last_us'].max()) if len(self.index) else 0
+
+    def __len__(self):
+        return int(self.index['count'].sum())
+
+    def chunk(self, i):
+        '''
+        @brief:第 i 块的 (records, iq)，iq 形状为 (count, iq_width)，均为 mmap 上的只读视图
+        @note:version 1 文件的 records 转换为 RECORD_DTYPE 的副本，同步时间戳字段为 0
+        '''
+        offset = int(self.index['offset'][i])
+        (_, _, _, count, iq_width, record_size, _, _,
+         records_offset, iq_offset, _) = CHUNK_HDR.unpack_from(self.mm, offset)
+        records = np.frombuffer(self.mm, dtype=RECORD_DTYPES[self.version], count=count,
+                                offset=offset + records_offset)
+        if self.version != CAPTURE_VERSION:
+            upgraded = np.zeros(count, dtype=RECORD_DTYPE)
+            for name in records.dtype.names:
+                upgraded[name] = records[name]
+            records = upgraded
+        iq = np.frombuffer(self.mm, dtype=np.int8, count=count * iq_width,
+                           offset=offset + iq_offset).reshape(count, iq_width)
+        return records, iq
+
+    def chunk_macs(self, i):
+        '''
+        @brief:第 i 块中出现过的 MAC 表（MAC_ENTRY_DTYPE）
+        '''
+        entry = self.index[i]
+        return np.frombuffer(self.mm, dtype=MAC_ENTRY_DTYPE, count=int(entry['mac_count']),
+                             offset=int(entry['offset']) + CHUNK_HDR.size)
+
+    def select(self, t_start_us=None, t_end_us=None, macs=None):
+        '''
+        @brief:按时间范围 [t_start_us, t_end_us) 和 MAC 过滤，逐块返回 (records, iq)
+        @param:macs: MAC 列表，匹配发送端 mac 或 probe_mac；为 None 时不过滤
+        @note:只按索引选择块，块内完全落在范围内时返回视图，否则返回过滤后的副本
+        '''
+        selected = np.ones(len(self.index), dtype=bool)
+        if t_start_us is not None:
+            selected &= self.index['t_last_us'] >= t_start_us
+        if t_end_us is not None:
+            selected &= self.index['t_first_us'] < t_end_us
+
+        wanted = None if macs is None else np.array([list(_mac_bytes(mac)) for mac in macs], dtype=np.uint8)
+
+        for i in np.flatnonzero(selected):
+            if wanted is not None:
+                table = self.chunk_macs(i)['mac']
+                if not (table[:, None, :] == wanted[None, :, :]).all(axis=2).any():
+                    continue
+
+            records, iq = self.chunk(i)
+            mask = np.ones(len(records), dtype=bool)
+            if t_start_us is not None:
+                mask &= records['time_us'] >= t_start_us
+            if t_end_us is not None:
+                mask &= records['time_us'] < t_end_us
+            if wanted is not None:
+                mask &= (_match_macs(records['mac'], wanted) | _match_macs(records['probe_mac'], wanted))
+
+            if mask.all():
+                yield records, iq
+            elif mask.any():
+                yield records[mask], iq[mask]
+
+    def close(self):
+        self.index = None
+        try:
+            self.mm.close()
+        except BufferError:
+            # 仍有 numpy 视图引用 mmap，由垃圾回收释放
+            pass
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+def _match_macs(column, wanted):
+    return (column[:, None, :] == wanted[None, :, :]).all(axis=2).any(axis=1)
+
+
+def open_captures(source):
+    '''
+    @brief:打开目录中（或给定列表中）的所有 .csic 文件，按首帧时间排序
+    '''
+    if isinstance(source, str):
+        source = [source]
+    paths = []
+    for item in source:
+        if os.path.isdir(item):
+            paths += glob.glob(os.path.join(item, f'*{CAPTURE_SUFFIX}'))
+        else:
+            paths.append(item)
+    files = [CaptureFile(path) for path in paths]
+    return sorted(files, key=lambda f: f.t_first_us)
+
+
+def read_range(source, t_start_us=None, t_end_us=None, macs=None):
+    '''
+    @brief:读取时间范围内的所有帧，返回 (records, iq)；iq 按最宽的块补 0
+    '''
+    parts = [part for f in open_captures(source) for part in f.select(t_start_us, t_end_us, macs)]
+    if not parts:
+        return np.zeros(0, dtype=RECORD_DTYPE), np.zeros((0, 0), dtype=np.int8)
+
+    width = max(iq.shape[1] for _, iq in parts)
+    records = np.concatenate([r for r, _ in parts])
+    iq = np.zeros((len(records), width), dtype=np.int8)
+    row = 0
+    for r, chunk_iq in parts:
+        iq[row:row + len(r), :chunk_iq.shape[1]] = chunk_iq
+        row += len(r)
+    return records, iq
+
+
+def record_to_csv(record, iq):
+    '''
+    @brief:把一条记录还原为 "CSI_DATA,..." 文本行（不含换行符），与 csi_frame.csi_frame_to_csv 一致
+    '''
+    fields = []
+    for name in CSI_DATA_COLUMNS_NAMES[:-1]:
+        if name == 'type':
+            fields.append('CSI_DATA')
+        elif name == 'mac':
+            fields.append(mac_to_str(bytes(record['mac'])))
+        else:
+            fields.append(str(int(record[name])))
+    values = iq[:int(record['len'])]
+    return ','.join(fields) + ',"[' + ','.join(str(v) for v in values.tolist()) + ']"'
+
+
+def convert_text(path, writer, start_us=None):
+    '''
+    @brief:把 csi_data_<ms>.txt / csi_data.csv 转换为列式格式
+    @param:start_us: 第一帧的主机时间；默认取文件名中的毫秒时间戳，没有时取文件修改时间。
+                     文本中没有主机接收时间，后续帧按 local_timestamp（微秒，32 位回绕）的增量推算
+    @return:(转换的帧数, 跳过的行数)
+    '''
+    if start_us is None:
+        match = re.search(r'(\d{13})', os.path.basename(path))
+        start_us = int(match.group(1)) * 1000 if match else int(os.path.getmtime(path) * 1e6)
+
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    # 整个文件作为一个数据报批量解析，表头等非 CSI_DATA 行被忽略
+    parser = CsiParser()
+    records, _, iq = parser.parse([data], 0, n_sub=0, with_iq=True)
+    if len(records):
+        ts = records['local_timestamp'].astype(np.int64)
+        elapsed = np.concatenate(([0], np.cumsum(np.diff(ts) & 0xFFFFFFFF)))
+        records['time_us'] = start_us + elapsed
+        writer.append_batch(records, iq)
+    return len(records), parser.errors
+
+
+def _parse_time(value):
+    return None if value is None else int(float(value) * 1e6)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='CSI 列式采集文件工具')
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    convert = sub.add_parser('convert', help='把 CSV 文本采集文件转换为 .csic')
+    convert.add_argument('inputs', nargs='+')
+    convert.add_argument('-o', '--output', default='.')
+    convert.add_argument('--rotate-bytes', type=int, default=64 * 1024 * 1024)
+    convert.add_argument('--start', help='第一帧的 Unix 时间（秒），默认取自文件名')
+
+    info = sub.add_parser('info', help='列出文件和块索引')
+    info.add_argument('sources', nargs='+')
+    info.add_argument('-v', '--verbose', action='store_true')
+
+    export = sub.add_parser('export', help='按时间范围/MAC 导出为 CSV 文本')
+    export.add_argument('sources', nargs='+')
+    export.add_argument('--start', help='Unix 时间（秒）')
+    export.add_argument('--end', help='Unix 时间（秒）')
+    export.add_argument('--mac', action='append')
+
+    args = parser.parse_args()
+
+    if args.command == 'convert':
+        os.makedirs(args.output, exist_ok=True)
+        with CaptureWriter(args.output, rotate_bytes=args.rotate_bytes) as writer:
+            for path in args.inputs:
+                converted, skipped = convert_text(path, writer, _parse_time(args.start))
+                print(f'{path}: {converted} frames, {skipped} lines skipped')
+        print('\n'.join(writer.files))
+
+    elif args.command == 'info':
+        for f in open_captures(args.sources):
+            print(f'{f.path}: {len(f)} frames, {len(f.index)} chunks, '
+                  f'{f.t_first_us / 1e6:.6f} .. {f.t_last_us / 1e6:.6f}')
+            if args.verbose:
+                for i, entry in enumerate(f.index):
+                    macs = ' '.join(mac_to_str(bytes(m['mac'])) + ('(probe)' if m['kind'] == MAC_KIND_PROBE else '')
+                                    for m in f.chunk_macs(i))
+                    print(f'  #{i} offset={entry["offset"]} count={entry["count"]} width={entry["iq_width"]} '
+                          f'{entry["t_first_us"] / 1e6:.6f} .. {entry["t_last_us"] / 1e6:.6f} {macs}')
+
+    elif args.command == 'export':
+        out = sys.stdout
+        for f in open_captures(args.sources):
+            for records, iq in f.select(_parse_time(args.start), _parse_time(args.end), args.mac):
+                for record, row in zip(records, iq):
+                    out.write(record_to_csv(record, row) + '\n')
+
+
+if __name__ == '__main__':
+    main()
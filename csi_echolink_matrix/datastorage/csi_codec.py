@@ -0,0 +1,227 @@
+'''
+@module:csi_codec
+@brief:压缩帧（CSI_FRAME_TYPE_PACKED）的 I/Q 编解码，规则与 components/csi_codec 一致
+1.编码：可选量化（舍去 quant 个低位）-> 沿子载波方向差分（x[i] - x[i-2]，按 8 位回绕）-> zigzag
+  -> 每 8 个值一块，按块内最大值的位宽存 w 个位平面字节；数据区开头为 2 字节的 CSI_CODEC_HDR
+2.pack_iq 与 AirProbe 的 csi_codec_pack 逐字节一致，不比原始 I/Q 短时返回 None（AirProbe 改为发送原始帧）
+3.unpack_iq 解码数据区，csi_frame.unpack_csi_frame 用它还原压缩帧，解码后的帧与原始帧字段相同
+4.verify：随机帧经 pack_iq 编码后，对比 libcsi_native 各指令集的 csi_iq_unpack、批量解析（CsiParser）
+  与 unpack_iq 的结果，逐字节一致（ctest 中运行）
+
+用法：
+    python csi_codec.py verify [--frames 2000]
+'''
+
+import argparse
+import ctypes
+import struct
+import sys
+
+import numpy as np
+
+# 压缩帧数据区的头部：info，低 12 位为 I/Q 字节数，高 4 位为量化位数
+CSI_CODEC_HDR = struct.Struct('<H')
+CSI_CODEC_BLOCK = 8
+CSI_CODEC_MAX_QUANT = 3
+# 与 csi_frame.h 的 CSI_FRAME_MAX_PAYLOAD 一致
+CSI_CODEC_MAX_LEN = 612
+
+_BITS = np.arange(8, dtype=np.uint8)
+
+
+def _widths(zz):
+    '''
+    @brief:每块的位宽（块内按位或的有效位数）
+    '''
+    any_bits = np.bitwise_or.reduce(zz, axis=1)
+    return np.where(any_bits > 0, np.floor(np.log2(np.maximum(any_bits, 1))).astype(np.int64) + 1, 0)
+
+
+def encode_iq(iq, quant=0):
+    '''
+    @brief:编码 I/Q（不含 CSI_CODEC_HDR），与 csi_codec_encode 一致
+    @return:bytes
+    '''
+    v = np.asarray(iq, dtype=np.int8).astype(np.int16)
+    n = len(v)
+    if quant:
+        v = np.minimum((v + (1 << (quant - 1))) >> quant, 127 >> quant)
+
+    prev = np.zeros(n, dtype=np.int16)
+    prev[2:] = v[:-2]
+    r = ((v - prev) & 0xFF).astype(np.uint8).view(np.int8).astype(np.int16)
+    zz = np.zeros(-(-n // CSI_CODEC_BLOCK) * CSI_CODEC_BLOCK, dtype=np.uint8)
+    zz[:n] = ((r << 1) ^ (r >> 7)) & 0xFF
+    zz = zz.reshape(-1, CSI_CODEC_BLOCK)
+
+    widths = _widths(zz)
+    table = np.zeros((len(widths) + 1) // 2, dtype=np.uint8)
+    np.bitwise_or.at(table, np.arange(len(widths)) // 2, (widths << (4 * (np.arange(len(widths)) & 1))).astype(np.uint8))
+
+    # planes[b, j] 的第 k 位为块 b 第 k 个值的第 j 位
+    bits = (zz[:, :, None] >> _BITS) & 1
+    planes = (bits << _BITS[:, None]).sum(axis=1, dtype=np.uint8)
+    body = b''.join(planes[b, :w].tobytes() for b, w in enumerate(widths))
+    return table.tobytes() + body
+
+
+def pack_iq(iq, quant=0):
+    '''
+    @brief:编码压缩帧的数据区（CSI_CODEC_HDR + 编码后的 I/Q），与 csi_codec_pack 一致
+    @return:bytes，不比原始 I/Q 短（或长度、量化位数非法）时返回 None
+    '''
+    n = len(iq)
+    if n <= CSI_CODEC_HDR.size or n > CSI_CODEC_MAX_LEN or not 0 <= quant <= CSI_CODEC_MAX_QUANT:
+        return None
+    body = encode_iq(iq, quant)
+    if CSI_CODEC_HDR.size + len(body) >= n:
+        return None
+    return CSI_CODEC_HDR.pack(n | quant << 12) + body
+
+
+def unpack_iq(data):
+    '''
+    @brief:解码压缩帧的数据区
+    @return:int8 数组，数据非法时返回 None
+    '''
+    if len(data) < CSI_CODEC_HDR.size:
+        return None
+    info, = CSI_CODEC_HDR.unpack_from(data)
+    n, quant = info & 0x0FFF, info >> 12
+    if n == 0 or n > CSI_CODEC_MAX_LEN or quant > CSI_CODEC_MAX_QUANT:
+        return None
+
+    buf = np.frombuffer(bytes(data), dtype=np.uint8, offset=CSI_CODEC_HDR.size)
+    blocks = -(-n // CSI_CODEC_BLOCK)
+    pos = (blocks + 1) // 2
+    if pos > len(buf):
+        return None
+    widths = (buf[np.arange(blocks) // 2] >> (4 * (np.arange(blocks) & 1))) & 0x0F
+    ends = pos + np.cumsum(widths.astype(np.int64))
+    if widths.max(initial=0) > 8 or (blocks and ends[-1] > len(buf)):
+        return None
+
+    planes = np.zeros((blocks, 8), dtype=np.uint8)
+    for b, w in enumerate(widths):
+        planes[b, :w] = buf[ends[b] - w:ends[b]]
+    bits = (planes[:, None, :] >> _BITS[:, None]) & 1
+    zz = (bits << _BITS).sum(axis=2, dtype=np.uint8).reshape(-1)[:n]
+
+    r = (zz >> 1) ^ (0 - (zz & 1)).astype(np.uint8)
+    v = np.zeros(n, dtype=np.uint8)
+    v[0::2] = np.cumsum(r[0::2], dtype=np.uint8)
+    v[1::2] = np.cumsum(r[1::2], dtype=np.uint8)
+    return (v << quant).astype(np.uint8).view(np.int8)
+
+
+# --------------------------------------------------------------------------- 与 libcsi_native 对比
+
+def _native_lib():
+    from csi_native import _lib
+    if _lib is None:
+        return None
+    _lib.csi_kernel_set_isa.restype = ctypes.c_int
+    _lib.csi_kernel_set_isa.argtypes = [ctypes.c_int]
+    _lib.csi_iq_unpack.restype = ctypes.c_size_t
+    _lib.csi_iq_unpack.argtypes = [ctypes.c_char_p, ctypes.c_size_t, ctypes.c_void_p, ctypes.c_size_t]
+    return _lib
+
+
+def _random_frame(rng):
+    '''
+    @brief:随机帧：平滑的信道响应加噪声、空子载波、偶尔的纯噪声帧（编码后不变短）、各采集配置的长度
+    '''
+    n = int(rng.choice([128, 128, 256, 384, 612, 130, 46, 3]))
+    t = np.arange(n // 2 + 1)
+    amp = rng.uniform(5, 120)
+    phase = rng.uniform(0, 2 * np.pi) + t * rng.uniform(-0.3, 0.3)
+    iq = np.empty(n)
+    iq[0::2] = (amp * np.sin(phase))[:len(iq[0::2])]
+    iq[1::2] = (amp * np.cos(phase))[:len(iq[1::2])]
+    iq += rng.normal(0, rng.choice([0.5, 2, 8]), size=n)
+    if rng.random() < 0.05:
+        iq = rng.integers(-128, 128, size=n)
+    iq[:min(n, 12)] = 0
+    return np.clip(np.round(iq), -128, 127).astype(np.int8)
+
+
+def _packed_datagram(data, seq):
+    from csi_frame import (CSI_FRAME_MAGIC, CSI_FRAME_VERSION, CSI_FRAME_HDR, CSI_FRAME_HDR_V2, CSI_FRAME_HDR_V3,
+                           CSI_FRAME_TYPE_PACKED)
+    hdr_len = CSI_FRAME_HDR.size + CSI_FRAME_HDR_V2.size + CSI_FRAME_HDR_V3.size
+    hdr = CSI_FRAME_HDR.pack(CSI_FRAME_MAGIC, CSI_FRAME_VERSION, CSI_FRAME_TYPE_PACKED, hdr_len, seq, 0, bytes(6),
+                             bytes(6), -50, *([0] * 18), len(data))
+    return hdr + CSI_FRAME_HDR_V2.pack(0, 0, seq) + CSI_FRAME_HDR_V3.pack(0, 0, 0) + data
+
+
+def verify(frames=2000, seed=1):
+    '''
+    @brief:对比 C 实现和参考实现，返回不一致的帧数
+    '''
+    from csi_native import CsiParser, KERNEL_ISA_NAMES
+    lib = _native_lib()
+    if lib is None:
+        print('libcsi_native not found, build datastorage/native first', file=sys.stderr)
+        return 1
+
+    rng = np.random.default_rng(seed)
+    mismatches = packed = 0
+    expected, datagrams = [], []
+    out = np.zeros(CSI_CODEC_MAX_LEN, dtype=np.int8)
+    isas = [isa for isa in range(len(KERNEL_ISA_NAMES)) if lib.csi_kernel_set_isa(isa) == isa]
+
+    for f in range(frames):
+        iq, quant = _random_frame(rng), int(rng.integers(0, CSI_CODEC_MAX_QUANT + 1))
+        data = pack_iq(iq, quant)
+        if data is None:
+            continue
+        packed += 1
+        ref = unpack_iq(data)
+        if quant == 0 and not np.array_equal(ref, iq):
+            mismatches += 1
+            print(f'frame {f}: lossless round trip mismatch', file=sys.stderr)
+        for isa in isas:
+            lib.csi_kernel_set_isa(isa)
+            size = lib.csi_iq_unpack(data, len(data), out.ctypes.data, len(out))
+            if size != len(iq) or not np.array_equal(out[:size], ref):
+                mismatches += 1
+                print(f'frame {f}: {KERNEL_ISA_NAMES[isa]} mismatch (quant {quant}, {len(iq)} bytes)', file=sys.stderr)
+        # 截断的数据区必须被拒绝
+        if lib.csi_iq_unpack(data[:-1], len(data) - 1, out.ctypes.data, len(out)) != 0 or unpack_iq(data[:-1]) is not None:
+            mismatches += 1
+            print(f'frame {f}: truncated payload accepted', file=sys.stderr)
+        expected.append(ref)
+        datagrams.append(_packed_datagram(data, f))
+    lib.csi_kernel_set_isa(isas[-1])
+
+    # 批量解析：与 csi_frame 的解码结果一致
+    from csi_frame import parse_csi_packets
+    records, _, iq = CsiParser().parse(datagrams, n_sub=0, with_iq=True)
+    if len(records) != len(expected):
+        mismatches += 1
+        print(f'CsiParser decoded {len(records)}/{len(expected)} frames', file=sys.stderr)
+    else:
+        for f, (record, ref, datagram) in enumerate(zip(records, expected, datagrams)):
+            packet = parse_csi_packets(datagram)
+            if (record['len'] != len(ref) or not np.array_equal(iq[f, :len(ref)], ref)
+                    or len(packet) != 1 or packet[0]['len'] != len(ref) or packet[0]['data'] != ref.tolist()):
+                mismatches += 1
+                print(f'datagram {f}: parser mismatch', file=sys.stderr)
+
+    print(f'{packed}/{frames} frames packed, {len(isas)} ISAs, {mismatches} mismatches')
+    return mismatches
+
+
+def main():
+    parser = argparse.ArgumentParser(description='AirProbe CSI payload codec')
+    sub = parser.add_subparsers(dest='command', required=True)
+    p = sub.add_parser('verify', help='compare libcsi_native with the Python reference')
+    p.add_argument('--frames', type=int, default=2000)
+    p.add_argument('--seed', type=int, default=1)
+    args = parser.parse_args()
+
+    sys.exit(1 if verify(args.frames, args.seed) else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -23,7 +23,6 @@
 
 import sys
 import csv
-import json
 import argparse
 import pandas as pd
 import numpy as np
@@ -40,37 +39,31 @@ import pyqtgraph as pq
 import threading
 import time
 from save_csidata import *
+from csi_native import amplitude_phase, parse_datagrams, subcarrier_map
 
 # Reduce displayed waveforms to avoid display freezes
 CSI_VAID_SUBCARRIER_INTERVAL = 3
 
 # Remove invalid subcarriers
-# secondary channel : below, HT, 40 MHz, non STBC, v, HT-LFT: 0~63, -64~-1, 384
-csi_vaid_subcarrier_index = []
+# 有效子载波由 subcarrier_map 按帧头的 len、bandwidth 自动选择（LLTF、HT-LTF、STBC HT-LTF、40 MHz），
+# 曲线按最大的采集配置（40 MHz + STBC，612 字节）分配，较小的帧只填前面的曲线，其余为 0
+CSI_DISPLAY_MAP = subcarrier_map(612, 1)
+csi_vaid_subcarrier_groups = CSI_DISPLAY_MAP.groups[::CSI_VAID_SUBCARRIER_INTERVAL]
+
+# 每个 LTF 一种颜色（LLTF 红、HT-LTF 绿、STBC HT-LTF 蓝），组内按频率由暗到亮
 csi_vaid_subcarrier_color = []
-color_step = 255 // (28 // CSI_VAID_SUBCARRIER_INTERVAL + 1)
-
-# LLTF: 52
-csi_vaid_subcarrier_index += [i for i in range(6, 32, CSI_VAID_SUBCARRIER_INTERVAL)]     # 26  red
-csi_vaid_subcarrier_color += [(i * color_step, 0, 0) for i in range(1,  26 // CSI_VAID_SUBCARRIER_INTERVAL + 2)]
-csi_vaid_subcarrier_index += [i for i in range(33, 59, CSI_VAID_SUBCARRIER_INTERVAL)]    # 26  green
-csi_vaid_subcarrier_color += [(0, i * color_step, 0) for i in range(1,  26 // CSI_VAID_SUBCARRIER_INTERVAL + 2)]
-CSI_DATA_LLFT_COLUMNS = len(csi_vaid_subcarrier_index)
-
-# HT-LFT: 56 + 56
-csi_vaid_subcarrier_index += [i for i in range(66, 94, CSI_VAID_SUBCARRIER_INTERVAL)]    # 28  blue
-csi_vaid_subcarrier_color += [(0, 0, i * color_step) for i in range(1,  28 // CSI_VAID_SUBCARRIER_INTERVAL + 2)]
-csi_vaid_subcarrier_index += [i for i in range(95, 123, CSI_VAID_SUBCARRIER_INTERVAL)]   # 28  White
-csi_vaid_subcarrier_color += [(i * color_step, i * color_step, i * color_step) for i in range(1,  28 // CSI_VAID_SUBCARRIER_INTERVAL + 2)]
-# csi_vaid_subcarrier_index += [i for i in range(124, 162)]  # 28  White
-# csi_vaid_subcarrier_index += [i for i in range(163, 191)]  # 28  White
+for group, base in enumerate([(1, 0, 0), (0, 1, 0), (0, 0, 1)]):
+    count = int(np.count_nonzero(csi_vaid_subcarrier_groups == group))
+    color_step = 255 // (count + 1)
+    csi_vaid_subcarrier_color += [tuple(c * i * color_step for c in base) for i in range(1, count + 1)]
 
 CSI_DATA_INDEX = 200  # buffer size
-CSI_DATA_COLUMNS = len(csi_vaid_subcarrier_index)
+CSI_DATA_COLUMNS = len(csi_vaid_subcarrier_groups)
 DATA_COLUMNS_NAMES = ["type", "id", "mac", "rssi", "rate", "sig_mode", "mcs", "bandwidth", "smoothing", "not_sounding", "aggregation", "stbc", "fec_coding",
                       "sgi", "noise_floor", "ampdu_cnt", "channel", "secondary_channel", "local_timestamp", "ant", "sig_len", "rx_state", "len", "first_word", "data"]
-csi_data_array = np.zeros(
-    [CSI_DATA_INDEX, CSI_DATA_COLUMNS], dtype=np.complex64)
+# 有效子载波的幅度，接收时计算，界面定时器直接绘制
+csi_amplitude_array = np.zeros(
+    [CSI_DATA_INDEX, CSI_DATA_COLUMNS], dtype=np.float32)
 
 class csi_data_graphical_window(QWidget):
     def __init__(self):
@@ -83,14 +76,13 @@ class csi_data_graphical_window(QWidget):
         self.plotWidget_ted.setYRange(-20, 100)
         self.plotWidget_ted.addLegend()
 
-        self.csi_amplitude_array = np.abs(csi_data_array)
         self.curve_list = []
 
         # print(f"csi_vaid_subcarrier_color, len: {len(csi_vaid_subcarrier_color)}, {csi_vaid_subcarrier_color}")
 
         for i in range(CSI_DATA_COLUMNS):
             curve = self.plotWidget_ted.plot(
-                self.csi_amplitude_array[:, i], name=str(i), pen=csi_vaid_subcarrier_color[i])
+                csi_amplitude_array[:, i], name=str(i), pen=csi_vaid_subcarrier_color[i])
             self.curve_list.append(curve)
 
         self.timer = pq.QtCore.QTimer()
@@ -98,10 +90,8 @@ class csi_data_graphical_window(QWidget):
         self.timer.start(100)
 
     def update_data(self):
-        self.csi_amplitude_array = np.abs(csi_data_array)
-
         for i in range(CSI_DATA_COLUMNS):
-            self.curve_list[i].setData(self.csi_amplitude_array[:, i])
+            self.curve_list[i].setData(csi_amplitude_array[:, i])
 
 
 def csi_data_read_parse(port: str, csv_writer, log_file_fd):
@@ -138,9 +128,9 @@ def csi_data_read_parse(port: str, csv_writer, log_file_fd):
             log_file_fd.flush()
             continue
 
-        try:
-            csi_raw_data = json.loads(csi_data[-1])
-        except json.JSONDecodeError:
+        # 批量解析库一次得到元数据和原始 I/Q
+        records, _, iq = parse_datagrams(strings.encode(), n_sub=0, with_iq=True)
+        if len(records) != 1:
             print("data is incomplete")
             log_file_fd.write("data is incomplete\n")
             log_file_fd.write(strings + '\n')
@@ -149,9 +139,11 @@ def csi_data_read_parse(port: str, csv_writer, log_file_fd):
 
         # Reference on the length of CSI data and usable subcarriers
         # https://docs.espressif.com/projects/esp-idf/en/stable/esp32/api-guides/wifi.html#wi-fi-channel-state-information
-        if len(csi_raw_data) != 128 and len(csi_raw_data) != 256 and len(csi_raw_data) != 384:
-            print(f"element number is not equal: {len(csi_raw_data)}")
-            log_file_fd.write(f"element number is not equal: {len(csi_raw_data)}\n")
+        csi_raw_len = int(records[0]['len'])
+        csi_vaid_subcarrier_index = subcarrier_map(csi_raw_len, records[0]['bandwidth']).positions[::CSI_VAID_SUBCARRIER_INTERVAL]
+        if not len(csi_vaid_subcarrier_index):
+            print(f"element number is not equal: {csi_raw_len}")
+            log_file_fd.write(f"element number is not equal: {csi_raw_len}\n")
             log_file_fd.write(strings + '\n')
             log_file_fd.flush()
             continue
@@ -159,16 +151,11 @@ def csi_data_read_parse(port: str, csv_writer, log_file_fd):
         csv_writer.writerow(csi_data)
 
         # Rotate data to the left
-        csi_data_array[:-1] = csi_data_array[1:]
-
-        if len(csi_raw_data) == 128:
-            csi_vaid_subcarrier_len = CSI_DATA_LLFT_COLUMNS
-        else:
-            csi_vaid_subcarrier_len = CSI_DATA_COLUMNS
+        csi_amplitude_array[:-1] = csi_amplitude_array[1:]
 
-        for i in range(csi_vaid_subcarrier_len):
-            csi_data_array[-1][i] = complex(csi_raw_data[csi_vaid_subcarrier_index[i] * 2 + 1],
-                                            csi_raw_data[csi_vaid_subcarrier_index[i] * 2])
+        amplitude, _ = amplitude_phase(iq[0], with_phase=False)
+        csi_amplitude_array[-1] = 0
+        csi_amplitude_array[-1][:len(csi_vaid_subcarrier_index)] = amplitude[csi_vaid_subcarrier_index]
 
     # ser.close()
     return
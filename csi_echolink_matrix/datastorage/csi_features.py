@@ -0,0 +1,363 @@
+'''
+@module:csi_features
+@brief:AirProbe 设备侧特征（components/csi_features）的 Python 参考实现、特征数据报解码和接收
+1.FeatureExtractor 按与 csi_features.c 相同的整数运算计算窗口特征：每个 LLTF 子载波的幅度方差、
+  平均幅度、运动能量（相邻帧幅度差的平方）、RSSI 平均值和斜率
+2.parse_features 解码 csi_features_hdr_t 特征数据报（components/csi_proto/include/csi_frame.h）
+3.verify：用随机数据流对比 libcsi_native 中编译的 C 实现与参考实现，逐窗口、逐字节一致（ctest 中运行）
+4.listen：接收特征数据报，打印或追加到 CSV
+
+用法：
+    python csi_features.py verify [--streams 20]
+    python csi_features.py listen [--port 4444] [--csv features.csv]
+'''
+
+import argparse
+import csv
+import ctypes
+import random
+import socket
+import struct
+import sys
+
+import numpy as np
+
+from csi_frame import CSI_FRAME_MAGIC, CSI_FRAME_TYPE_FEATURES, CSI_FRAME_VERSION, mac_to_str
+
+# magic, version, type, hdr_len, seq, frame_seq, local_timestamp, duration_us, probe_mac, mac,
+# frames, n_sub, reserved, rssi_mean_q8, rssi_slope_q8, amp_mean_q8, motion_q8, len
+CSI_FEATURES_HDR = struct.Struct('<BBBBIIII6s6sHBBhhHIH')
+assert CSI_FEATURES_HDR.size == 48
+
+# 与 csi_features.h 一致
+FEATURE_POSITIONS = list(range(6, 32)) + list(range(33, 59))
+FEATURE_SUBCARRIERS = len(FEATURE_POSITIONS)
+FEATURE_MIN_LEN = 118
+FEATURE_MAX_FRAMES = 1024
+FEATURE_MAX_INTERVAL_MS = 60000
+
+RESULT_FIELDS = ['seq', 'frame_seq', 'local_timestamp', 'duration_us', 'frames', 'rssi_mean_q8',
+                 'rssi_slope_q8', 'amp_mean_q8', 'motion_q8']
+
+
+def _div_round(a, b):
+    '''
+    @brief:四舍五入的整数除法（远离 0），b > 0，与 C 实现的 div_round 一致
+    '''
+    return (a + b // 2) // b if a >= 0 else -((-a + b // 2) // b)
+
+
+def _saturate_i16(v):
+    return max(-32768, min(32767, v))
+
+
+def amplitude_q8(iq):
+    '''
+    @brief:有效子载波的 Q8 幅度 floor(sqrt((I^2 + Q^2) << 16))
+    @param:iq: int8 I/Q（虚部在前），至少 FEATURE_MIN_LEN 字节；二维时每行一帧
+    @return:uint32 数组，最后一维为 FEATURE_SUBCARRIERS
+    '''
+    iq = np.asarray(iq, dtype=np.int64)
+    positions = np.array(FEATURE_POSITIONS)
+    power = (iq[..., 2 * positions] ** 2 + iq[..., 2 * positions + 1] ** 2) << 16
+    root = np.floor(np.sqrt(power.astype(np.float64))).astype(np.int64)
+    # 浮点开方可能差 1，按整数修正为精确的 floor
+    root -= (root * root > power)
+    root += ((root + 1) * (root + 1) <= power)
+    return root.astype(np.uint32)
+
+
+class FeatureExtractor:
+    '''
+    @brief:窗口特征的参考实现，接口与 csi_features_push / csi_features_flush 对应
+    @note:结果为字典，键为 RESULT_FIELDS 和 'variance_q4'（长度 FEATURE_SUBCARRIERS 的列表）
+    '''
+
+    def __init__(self, interval_ms, max_frames=0):
+        if not 0 < interval_ms <= FEATURE_MAX_INTERVAL_MS or max_frames > FEATURE_MAX_FRAMES:
+            raise ValueError('invalid feature window')
+        self.interval_us = interval_ms * 1000
+        self.max_frames = max_frames or FEATURE_MAX_FRAMES
+        self.seq = 0
+        self.prev = None
+        self._reset()
+
+    def _reset(self):
+        self.frames = 0
+        self.pairs = 0
+        self.sum_rssi = 0
+        self.sum_t = self.sum_tt = self.sum_tr = 0
+        self.sum_motion = 0
+        self.sum_amp = [0] * FEATURE_SUBCARRIERS
+        self.sum_amp2 = [0] * FEATURE_SUBCARRIERS
+
+    def push(self, iq, rssi, timestamp_us, seq):
+        '''
+        @return:当前窗口结束时返回它的特征，否则返回 None
+        '''
+        if len(iq) < FEATURE_MIN_LEN:
+            return None
+
+        result = None
+        if self.frames and ((timestamp_us - self.t0) & 0xFFFFFFFF >= self.interval_us
+                            or self.frames >= self.max_frames):
+            result = self.flush()
+
+        if not self.frames:
+            self.t0 = timestamp_us
+            self.frame_seq = seq
+        self.t_last = timestamp_us
+
+        amp = [int(a) for a in amplitude_q8(iq)]
+        for k, a in enumerate(amp):
+            self.sum_amp[k] += a
+            self.sum_amp2[k] += a * a
+        if self.prev is not None:
+            self.sum_motion += sum((a - p) ** 2 for a, p in zip(amp, self.prev))
+            self.pairs += 1
+        self.prev = amp
+
+        t = ((timestamp_us - self.t0) & 0xFFFFFFFF) // 1000
+        self.sum_rssi += rssi
+        self.sum_t += t
+        self.sum_tt += t * t
+        self.sum_tr += t * rssi
+        self.frames += 1
+        return result
+
+    def flush(self):
+        if not self.frames:
+            return None
+
+        n = self.frames
+        variance = []
+        for s, s2 in zip(self.sum_amp, self.sum_amp2):
+            variance.append(min(65535, _div_round(n * s2 - s * s, n * n * 4096)))
+
+        den = n * self.sum_tt - self.sum_t * self.sum_t
+        num = n * self.sum_tr - self.sum_t * self.sum_rssi
+        result = {
+            'seq': self.seq,
+            'frame_seq': self.frame_seq,
+            'local_timestamp': self.t0,
+            'duration_us': (self.t_last - self.t0) & 0xFFFFFFFF,
+            'frames': n,
+            'rssi_mean_q8': _saturate_i16(_div_round(self.sum_rssi * 256, n)),
+            'rssi_slope_q8': _saturate_i16(_div_round(num * 256000, den)) if den > 0 else 0,
+            'amp_mean_q8': _div_round(sum(self.sum_amp), n * FEATURE_SUBCARRIERS),
+            'motion_q8': _div_round(self.sum_motion, self.pairs * FEATURE_SUBCARRIERS * 256) if self.pairs else 0,
+            'variance_q4': variance,
+        }
+        self.seq += 1
+        self._reset()
+        return result
+
+
+def pack_features(result, probe_mac=bytes(6), mac=bytes(6)):
+    '''
+    @brief:编码为特征数据报，与 csi_features_encode 一致
+    '''
+    hdr = CSI_FEATURES_HDR.pack(
+        CSI_FRAME_MAGIC, CSI_FRAME_VERSION, CSI_FRAME_TYPE_FEATURES, CSI_FEATURES_HDR.size,
+        result['seq'], result['frame_seq'], result['local_timestamp'], result['duration_us'],
+        bytes(probe_mac), bytes(mac), result['frames'], FEATURE_SUBCARRIERS, 0,
+        result['rssi_mean_q8'], result['rssi_slope_q8'], result['amp_mean_q8'], result['motion_q8'],
+        FEATURE_SUBCARRIERS * 2)
+    return hdr + struct.pack(f'<{FEATURE_SUBCARRIERS}H', *result['variance_q4'])
+
+
+def is_features(data):
+    return len(data) >= CSI_FEATURES_HDR.size and data[0] == CSI_FRAME_MAGIC and data[2] == CSI_FRAME_TYPE_FEATURES
+
+
+def parse_features(data):
+    '''
+    @brief:解码特征数据报
+    @return:字典（定点字段已换算为浮点：rssi_mean dBm、rssi_slope dB/s、amp_mean、motion、variance 数组），
+            不是合法的特征数据报时返回 None
+    '''
+    if not is_features(data):
+        return None
+    (_, _, _, hdr_len, seq, frame_seq, local_timestamp, duration_us, probe_mac, mac, frames, n_sub, _,
+     rssi_mean_q8, rssi_slope_q8, amp_mean_q8, motion_q8, length) = CSI_FEATURES_HDR.unpack_from(data)
+    if hdr_len < CSI_FEATURES_HDR.size or hdr_len + length > len(data) or length < n_sub * 2:
+        return None
+
+    variance = np.frombuffer(data, dtype='<u2', count=n_sub, offset=hdr_len)
+    return {
+        'seq': seq,
+        'frame_seq': frame_seq,
+        'local_timestamp': local_timestamp,
+        'duration_us': duration_us,
+        'probe_mac': mac_to_str(probe_mac),
+        'mac': mac_to_str(mac),
+        'frames': frames,
+        'rssi_mean': rssi_mean_q8 / 256,
+        'rssi_slope': rssi_slope_q8 / 256,
+        'amp_mean': amp_mean_q8 / 256,
+        'motion': motion_q8 / 256,
+        'variance': variance.astype(np.float32) / 16,
+    }
+
+
+# --------------------------------------------------------------------------- libcsi_native 中的 C 实现
+
+class _Result(ctypes.Structure):
+    _fields_ = [('seq', ctypes.c_uint32), ('frame_seq', ctypes.c_uint32), ('local_timestamp', ctypes.c_uint32),
+                ('duration_us', ctypes.c_uint32), ('frames', ctypes.c_uint16), ('rssi_mean_q8', ctypes.c_int16),
+                ('rssi_slope_q8', ctypes.c_int16), ('amp_mean_q8', ctypes.c_uint16), ('motion_q8', ctypes.c_uint32),
+                ('variance_q4', ctypes.c_uint16 * FEATURE_SUBCARRIERS)]
+
+
+class _Config(ctypes.Structure):
+    _fields_ = [('interval_ms', ctypes.c_uint32), ('max_frames', ctypes.c_uint16)]
+
+
+def _native_lib():
+    from csi_native import _lib
+    if _lib is None:
+        return None
+    _lib.csi_features_state_size.restype = ctypes.c_size_t
+    _lib.csi_features_state_size.argtypes = []
+    _lib.csi_features_init.restype = ctypes.c_bool
+    _lib.csi_features_init.argtypes = [ctypes.c_void_p, ctypes.POINTER(_Config)]
+    _lib.csi_features_push.restype = ctypes.c_bool
+    _lib.csi_features_push.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t, ctypes.c_int8,
+                                       ctypes.c_uint32, ctypes.c_uint32, ctypes.POINTER(_Result)]
+    _lib.csi_features_flush.restype = ctypes.c_bool
+    _lib.csi_features_flush.argtypes = [ctypes.c_void_p, ctypes.POINTER(_Result)]
+    _lib.csi_features_encode.restype = ctypes.c_size_t
+    _lib.csi_features_encode.argtypes = [ctypes.POINTER(_Result), ctypes.c_char_p, ctypes.c_char_p,
+                                         ctypes.c_char_p, ctypes.c_size_t]
+    return _lib
+
+
+class NativeFeatureExtractor:
+    '''
+    @brief:libcsi_native 中的 csi_features（与 AirProbe 上运行的代码相同），接口与 FeatureExtractor 一致
+    '''
+
+    def __init__(self, interval_ms, max_frames=0):
+        self._lib = _native_lib()
+        if self._lib is None:
+            raise RuntimeError('libcsi_native not found, build datastorage/native first')
+        self._state = ctypes.create_string_buffer(self._lib.csi_features_state_size())
+        self._result = _Result()
+        if not self._lib.csi_features_init(self._state, ctypes.byref(_Config(interval_ms, max_frames))):
+            raise ValueError('invalid feature window')
+
+    def _to_dict(self):
+        result = {name: getattr(self._result, name) for name in RESULT_FIELDS}
+        result['variance_q4'] = list(self._result.variance_q4)
+        return result
+
+    def push(self, iq, rssi, timestamp_us, seq):
+        iq = bytes(np.asarray(iq, dtype=np.int8))
+        if self._lib.csi_features_push(self._state, iq, len(iq), rssi, timestamp_us, seq, ctypes.byref(self._result)):
+            return self._to_dict()
+        return None
+
+    def flush(self):
+        return self._to_dict() if self._lib.csi_features_flush(self._state, ctypes.byref(self._result)) else None
+
+    def encode(self, result, probe_mac=bytes(6), mac=bytes(6)):
+        native = _Result(**{name: result[name] for name in RESULT_FIELDS})
+        native.variance_q4[:] = result['variance_q4']
+        buf = ctypes.create_string_buffer(CSI_FEATURES_HDR.size + FEATURE_SUBCARRIERS * 2)
+        size = self._lib.csi_features_encode(ctypes.byref(native), bytes(probe_mac), bytes(mac), buf, len(buf))
+        return buf.raw[:size]
+
+
+# --------------------------------------------------------------------------- 命令行
+
+def _random_stream(rng, frames):
+    '''
+    @brief:随机数据流：静止/运动段交替、尖峰、丢帧（时间间隔不均）、短帧、RSSI 随机游走、时间戳回绕
+    '''
+    base = rng.integers(-40, 40, size=(128,))
+    t = int(rng.integers(0, 1 << 32))
+    rssi = int(rng.integers(-90, -30))
+    seq = int(rng.integers(0, 1 << 31))
+    for i in range(frames):
+        moving = (i // 50) % 2
+        noise = rng.integers(-30, 31, size=(128,)) if moving else rng.integers(-2, 3, size=(128,))
+        iq = np.clip(base + noise, -128, 127)
+        if rng.random() < 0.02:
+            iq = rng.integers(-128, 128, size=(128,))
+        length = 100 if rng.random() < 0.01 else 128
+        rssi = int(np.clip(rssi + rng.integers(-2, 3), -128, 0))
+        yield iq[:length].astype(np.int8), rssi, t & 0xFFFFFFFF, seq & 0xFFFFFFFF
+        t += int(rng.choice([10000, 10000, 10000, 9000, 30000, 250000]))
+        seq += int(rng.choice([1, 1, 1, 2]))
+
+
+def verify(streams=20, seed=1):
+    '''
+    @brief:对比 C 实现和参考实现，返回不一致的窗口数
+    '''
+    rng = np.random.default_rng(seed)
+    mismatches = windows = 0
+    for s in range(streams):
+        interval_ms = int(rng.choice([100, 500, 1000, 3000]))
+        max_frames = int(rng.choice([0, 0, 16, 200]))
+        reference = FeatureExtractor(interval_ms, max_frames)
+        native = NativeFeatureExtractor(interval_ms, max_frames)
+        mac = bytes(rng.integers(0, 256, size=6, dtype=np.uint8))
+
+        frames = list(_random_stream(rng, int(rng.integers(200, 1500))))
+        results = [(reference.push(*f), native.push(*f)) for f in frames]
+        results.append((reference.flush(), native.flush()))
+        for expect, actual in results:
+            if expect is None and actual is None:
+                continue
+            windows += 1
+            if expect != actual or pack_features(expect, mac, mac) != native.encode(actual, mac, mac):
+                mismatches += 1
+                print(f'stream {s}: mismatch\n  reference {expect}\n  native    {actual}', file=sys.stderr)
+    print(f'{windows} windows compared, {mismatches} mismatches')
+    return mismatches
+
+
+def listen(port, csv_path=None):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(('0.0.0.0', port))
+    writer = None
+    if csv_path:
+        csv_file = open(csv_path, 'a', newline='')
+        writer = csv.writer(csv_file)
+
+    while True:
+        data, _ = sock.recvfrom(2048)
+        features = parse_features(data)
+        if features is None:
+            continue
+        print(f"{features['probe_mac']} #{features['seq']} frames {features['frames']} "
+              f"motion {features['motion']:.2f} amp {features['amp_mean']:.2f} "
+              f"rssi {features['rssi_mean']:.1f} dBm ({features['rssi_slope']:+.2f} dB/s) "
+              f"max var {features['variance'].max():.2f}")
+        if writer:
+            writer.writerow([features[k] for k in ('probe_mac', 'mac', 'seq', 'frame_seq', 'local_timestamp',
+                                                   'duration_us', 'frames', 'rssi_mean', 'rssi_slope',
+                                                   'amp_mean', 'motion')]
+                            + [f'{v:g}' for v in features['variance']])
+            csv_file.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description='AirProbe on-device CSI features')
+    sub = parser.add_subparsers(dest='command', required=True)
+    p = sub.add_parser('verify', help='compare libcsi_native with the Python reference')
+    p.add_argument('--streams', type=int, default=20)
+    p.add_argument('--seed', type=int, default=1)
+    p = sub.add_parser('listen', help='receive and print feature datagrams')
+    p.add_argument('--port', type=int, default=4444)
+    p.add_argument('--csv', help='append features to this CSV file')
+    args = parser.parse_args()
+
+    if args.command == 'verify':
+        sys.exit(1 if verify(args.streams, args.seed) else 0)
+    listen(args.port, args.csv)
+
+
+if __name__ == '__main__':
+    main()
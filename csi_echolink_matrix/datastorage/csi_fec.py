@@ -0,0 +1,255 @@
+'''
+@module:csi_fec
+@brief:聚合数据报的异或校验（FEC）恢复，规则与 components/csi_fec 一致
+1.AirProbe 开启 AIRPROBE_FEC_ENABLE 时，每 k 个聚合数据报的容器头后带分组信息（CSI_BATCH_FEC），
+  组满或发送暂停时再发送一个校验数据报，内容为组内数据报逐字节异或（短的按 0 补齐）
+2.FecDecoder 按到达顺序接收一个探针的数据报，组内只丢失一个时恢复出与原始数据报逐字节相同的数据报，
+  丢失两个及以上时无法恢复，计入 failed；校验数据报丢失时组的实际大小未知，只有组内有空缺时才计入
+3.FecReceiver 按 probe_mac 分配解码器，恢复的数据报按正常收到的数据报处理即可（其中的帧计为迟到而不是丢失）
+4.FecEncoder 与 AirProbe 的编码一致，用于测试和回放
+'''
+
+import numpy as np
+
+from csi_frame import (CSI_FRAME_MAGIC, CSI_FRAME_VERSION, CSI_FRAME_TYPE_BATCH, CSI_FRAME_TYPE_PARITY,
+                       CSI_BATCH_HDR, CSI_BATCH_FLAG_FEC, CSI_BATCH_FEC, CSI_PARITY_HDR, mac_to_str)
+
+CSI_DATAGRAM_MAX_SIZE = 1472
+# 组大小上限（解码器用 32 位掩码记录收到的数据报）
+CSI_FEC_MAX_GROUP = 32
+# 开启 FEC 时聚合容器头的长度
+CSI_FEC_BATCH_HDR_LEN = CSI_BATCH_HDR.size + CSI_BATCH_FEC.size
+# 组内数据报的最大长度：校验数据报加上校验头后不能超过一个数据报
+CSI_FEC_MAX_DATAGRAM = CSI_DATAGRAM_MAX_SIZE - CSI_PARITY_HDR.size
+
+
+def batch_fec(data):
+    '''
+    @brief:聚合容器的 FEC 分组信息
+    @return:(probe_mac, group, index, k)，不是带 FEC 扩展的聚合容器时返回 None
+    '''
+    if len(data) < CSI_FEC_BATCH_HDR_LEN or data[0] != CSI_FRAME_MAGIC or data[2] != CSI_FRAME_TYPE_BATCH:
+        return None
+    _, _, _, hdr_len, _, flags, _ = CSI_BATCH_HDR.unpack_from(data)
+    if not flags & CSI_BATCH_FLAG_FEC or hdr_len < CSI_FEC_BATCH_HDR_LEN:
+        return None
+    return CSI_BATCH_FEC.unpack_from(data, CSI_BATCH_HDR.size)
+
+
+def is_parity(data):
+    '''
+    @brief:是否为校验数据报（不含 CSI 帧）
+    '''
+    return len(data) >= CSI_PARITY_HDR.size and data[0] == CSI_FRAME_MAGIC and data[2] == CSI_FRAME_TYPE_PARITY
+
+
+def parity_check(data):
+    '''
+    @brief:校验数据报头
+    @return:(probe_mac, group, count, len_xor, payload)，不是校验数据报时返回 None
+    '''
+    if not is_parity(data):
+        return None
+    _, _, _, hdr_len, probe_mac, group, count, _, len_xor, length = CSI_PARITY_HDR.unpack_from(data)
+    if hdr_len < CSI_PARITY_HDR.size or hdr_len + length > len(data) or count == 0:
+        return None
+    return probe_mac, group, count, len_xor, bytes(data[hdr_len:hdr_len + length])
+
+
+def fec_probe(data):
+    '''
+    @brief:带 FEC 信息的数据报所属探针 MAC（bytes），其它数据报返回 None
+    '''
+    fec = batch_fec(data)
+    if fec:
+        return fec[0]
+    parity = parity_check(data)
+    return parity[0] if parity else None
+
+
+class FecEncoder:
+    '''
+    @brief:AirProbe 侧编码：add() 填写分组信息并返回可发送的数据报，组满时 finish() 生成校验数据报
+    '''
+    def __init__(self, k, probe_mac):
+        self.k = min(max(int(k), 2), CSI_FEC_MAX_GROUP)
+        self.probe_mac = bytes(probe_mac)
+        self.group = 0
+        self._reset()
+
+    def _reset(self):
+        self.count = 0
+        self.len_xor = 0
+        self.acc = np.zeros(0, dtype=np.uint8)
+
+    def add(self, datagram):
+        '''
+        @param:datagram: 聚合数据报，hdr_len 须不小于 CSI_FEC_BATCH_HDR_LEN
+        @return:(填写分组信息后的数据报, 组是否已满)
+        '''
+        data = bytearray(datagram)
+        if len(data) > CSI_FEC_MAX_DATAGRAM or data[3] < CSI_FEC_BATCH_HDR_LEN:
+            raise ValueError('datagram has no room for the FEC header')
+        data[5] |= CSI_BATCH_FLAG_FEC
+        CSI_BATCH_FEC.pack_into(data, CSI_BATCH_HDR.size, self.probe_mac, self.group, self.count, self.k)
+
+        buf = np.frombuffer(bytes(data), dtype=np.uint8)
+        if len(buf) > len(self.acc):
+            self.acc = np.concatenate([self.acc, np.zeros(len(buf) - len(self.acc), dtype=np.uint8)])
+        self.acc[:len(buf)] ^= buf
+        self.len_xor ^= len(buf)
+        self.count += 1
+        return bytes(data), self.count >= self.k
+
+    def finish(self):
+        '''
+        @return:校验数据报，当前组为空时返回 None
+        '''
+        if not self.count:
+            return None
+        hdr = CSI_PARITY_HDR.pack(CSI_FRAME_MAGIC, CSI_FRAME_VERSION, CSI_FRAME_TYPE_PARITY, CSI_PARITY_HDR.size,
+                                  self.probe_mac, self.group, self.count, 0, self.len_xor, len(self.acc))
+        datagram = hdr + self.acc.tobytes()
+        self.group = (self.group + 1) & 0xFFFF
+        self._reset()
+        return datagram
+
+
+class FecDecoder:
+    '''
+    @brief:一个探针的解码器，字段与 csi_fec_dec_t 对应
+    '''
+    def __init__(self):
+        self.acc = np.zeros(CSI_FEC_MAX_DATAGRAM, dtype=np.uint8)
+        self.acc_len = 0
+        self.mask = 0
+        self.group = 0
+        self.len_xor = 0
+        self.k = 0
+        self.count = 0
+        self.active = False
+        self.done = False
+        self.groups = 0
+        self.recovered = 0
+        self.failed = 0
+
+    def _accumulate(self, data):
+        buf = np.frombuffer(data, dtype=np.uint8)
+        self.acc[:len(buf)] ^= buf
+        self.acc_len = max(self.acc_len, len(buf))
+
+    def _enter_group(self, group, k):
+        if self.active and group == self.group:
+            return True
+        if self.active:
+            # 更早的组的数据报（16 位序号按回绕比较）
+            if (group - self.group) & 0x8000:
+                return False
+            # 校验数据报丢失时组内实际的数据报数未知（组可能提前结束），只有收到的位置之间有空缺才确定有丢失
+            if self.count:
+                lost = bin(self.mask).count('1') < self.count
+            else:
+                lost = (self.mask & (self.mask + 1)) != 0
+            if not self.done and lost:
+                self.failed += 1
+
+        self.active = True
+        self.done = False
+        self.group = group
+        self.k = k
+        self.count = 0
+        self.mask = 0
+        self.len_xor = 0
+        self.acc[:self.acc_len] = 0
+        self.acc_len = 0
+        self.groups += 1
+        return True
+
+    def _try_recover(self):
+        if self.done or not self.count:
+            return None
+        received = bin(self.mask).count('1')
+        if received >= self.count:
+            self.done = True
+            return None
+        if received + 1 < self.count:
+            return None
+
+        missing = 0
+        while self.mask & (1 << missing):
+            missing += 1
+
+        self.done = True
+        length = self.len_xor
+        datagram = self.acc[:length].tobytes() if length <= self.acc_len else b''
+        fec = batch_fec(datagram)
+        if not fec or fec[1] != self.group or fec[2] != missing:
+            self.failed += 1
+            return None
+
+        self.mask |= 1 << missing
+        self.recovered += 1
+        return datagram
+
+    def push(self, data):
+        '''
+        @brief:交入该探针的一个数据报（按到达顺序）
+        @return:恢复出的数据报（bytes），没有恢复时返回 None
+        '''
+        fec = batch_fec(data)
+        if fec:
+            _, group, index, k = fec
+            if (len(data) > CSI_FEC_MAX_DATAGRAM or k > CSI_FEC_MAX_GROUP or index >= k
+                    or not self._enter_group(group, k) or self.mask & (1 << index)):
+                return None
+            self._accumulate(bytes(data))
+            self.len_xor ^= len(data)
+            self.mask |= 1 << index
+            return self._try_recover()
+
+        parity = parity_check(data)
+        if parity:
+            _, group, count, len_xor, payload = parity
+            if (len(payload) > CSI_FEC_MAX_DATAGRAM or count > CSI_FEC_MAX_GROUP
+                    or not self._enter_group(group, count) or self.count):
+                return None
+            self._accumulate(payload)
+            self.len_xor ^= len_xor
+            self.count = count
+            return self._try_recover()
+
+        return None
+
+
+class FecReceiver:
+    '''
+    @brief:多个探针的 FEC 恢复
+    用法：
+        fec = FecReceiver()
+        data, addr = sock.recvfrom(2048)
+        recovered = fec.push(data)
+        for datagram in (data, recovered):
+            if datagram is not None and not is_parity(datagram):
+                ...
+    '''
+    def __init__(self):
+        self.decoders = {}
+
+    def push(self, data):
+        '''
+        @return:恢复出的数据报，没有恢复（或不是带 FEC 信息的数据报）时返回 None
+        '''
+        probe_mac = fec_probe(data)
+        if probe_mac is None:
+            return None
+        decoder = self.decoders.get(probe_mac)
+        if decoder is None:
+            decoder = self.decoders[probe_mac] = FecDecoder()
+        return decoder.push(data)
+
+    def report(self):
+        '''
+        @brief:每个开启 FEC 的探针一行，与 csi_recvd 的报告一致
+        '''
+        return [f'{mac_to_str(mac)} fec groups={d.groups} recovered={d.recovered} failed={d.failed}'
+                for mac, d in sorted(self.decoders.items())]
@@ -0,0 +1,218 @@
+'''
+@module:csi_frame
+@brief:AirProbe 二进制 CSI 帧解码
+1.帧格式与 components/csi_proto/include/csi_frame.h 中的 csi_frame_hdr_t 保持一致
+2.解码结果的字段名与 CSI_DATA_COLUMNS_NAMES 对应，可直接替代文本解析结果
+3.支持把二进制帧还原为 "CSI_DATA,..." 文本行，保持 csi_data_*.txt 文件格式不变
+4.支持聚合容器（csi_batch_hdr_t + 多个完整帧）；其它类型（如特征数据报）不产生帧
+5.CSI_RECORD_DTYPE 为解码后元数据的定长记录，批量解析（csi_native）和列式采集文件（csi_capture）共用
+6.version 2 的帧头末尾有激励源（发射端）下标 tx 和源内序号 tx_seq，version 1 的帧按 tx = 0、tx_seq = id 解码
+7.version 3 的帧头再追加对时后的参考时间 sync_us、漂移 drift_ppb 和误差 sync_err_us，更早的帧 sync_us 为 0（未同步）
+8.开启 FEC 的聚合容器头后有分组信息（CSI_BATCH_FEC），按 hdr_len 跳过即可；校验数据报不产生帧，恢复见 csi_fec.py
+9.压缩帧（CSI_FRAME_TYPE_PACKED，单独发送或在聚合容器中）解码后与原始帧相同，'len' 为解码后的 I/Q 字节数，编解码见 csi_codec.py
+'''
+
+import struct
+import numpy as np
+from config import CSI_DATA_COLUMNS_NAMES
+from csi_codec import unpack_iq
+
+CSI_FRAME_MAGIC = 0xC5
+CSI_FRAME_VERSION = 3
+CSI_FRAME_TYPE_RAW = 0x01
+CSI_FRAME_TYPE_BATCH = 0x02
+CSI_FRAME_TYPE_FEATURES = 0x03    # 设备侧特征，不含 CSI 帧，解码见 csi_features.py
+CSI_FRAME_TYPE_PARITY = 0x04      # 一组聚合数据报的异或校验，不含 CSI 帧，解码见 csi_fec.py
+CSI_FRAME_TYPE_PACKED = 0x05      # 压缩的 I/Q，数据区为 csi_codec.CSI_CODEC_HDR + 编码结果
+
+# 小端、紧凑排列，与 csi_frame_hdr_t 一一对应
+CSI_FRAME_HDR = struct.Struct('<BBBBII6s6sbBBBBBBBBBBbBBBBBBHH')
+CSI_FRAME_HDR_FIELDS = ['magic', 'version', 'type', 'hdr_len', 'id', 'local_timestamp', 'probe_mac', 'mac',
+                        'rssi', 'rate', 'sig_mode', 'mcs', 'bandwidth', 'smoothing', 'not_sounding', 'aggregation',
+                        'stbc', 'fec_coding', 'sgi', 'noise_floor', 'ampdu_cnt', 'channel', 'secondary_channel',
+                        'ant', 'rx_state', 'first_word', 'sig_len', 'len']
+# version 2 追加的字段：tx, reserved, tx_seq
+CSI_FRAME_HDR_V2 = struct.Struct('<BBI')
+# version 3 追加的字段：sync_us, drift_ppb, sync_err_us
+CSI_FRAME_HDR_V3 = struct.Struct('<qiI')
+# 聚合容器头：magic, version, type, hdr_len, count, flags, len
+CSI_BATCH_HDR = struct.Struct('<BBBBBBH')
+CSI_BATCH_FLAG_FEC = 0x01
+# FEC 分组信息（flags 含 CSI_BATCH_FLAG_FEC 时紧跟容器头）：probe_mac, group, index, k
+CSI_BATCH_FEC = struct.Struct('<6sHBB')
+# 校验数据报头：magic, version, type, hdr_len, probe_mac, group, count, reserved, len_xor, len
+CSI_PARITY_HDR = struct.Struct('<BBBB6sHBBHH')
+
+# 每帧一条定长记录，字段名与 CSI_DATA_COLUMNS_NAMES 一致（type/data 除外），
+# 与 datastorage/native/src/csi_parse.h 中的 csi_record_t 逐字节一致
+CSI_RECORD_DTYPE = np.dtype([
+    ('time_us', '<i8'),             # 主机接收时间（Unix 微秒）
+    ('id', '<u4'),
+    ('local_timestamp', '<u4'),
+    ('mac', 'u1', (6,)),
+    ('probe_mac', 'u1', (6,)),      # 采集的 AirProbe，CSV 文本中没有该字段，为全 0
+    ('rssi', 'i1'),
+    ('rate', 'u1'),
+    ('sig_mode', 'u1'),
+    ('mcs', 'u1'),
+    ('bandwidth', 'u1'),
+    ('smoothing', 'u1'),
+    ('not_sounding', 'u1'),
+    ('aggregation', 'u1'),
+    ('stbc', 'u1'),
+    ('fec_coding', 'u1'),
+    ('sgi', 'u1'),
+    ('noise_floor', 'i1'),
+    ('ampdu_cnt', 'u1'),
+    ('channel', 'u1'),
+    ('secondary_channel', 'u1'),
+    ('ant', 'u1'),
+    ('rx_state', 'u1'),
+    ('first_word', 'u1'),
+    ('sig_len', '<u2'),
+    ('len', '<u2'),                 # I/Q 字节数
+    ('tx', 'u1'),                   # 激励源下标，CSV 文本中没有该字段，为 0
+    ('reserved', 'V1'),
+    ('tx_seq', '<u4'),              # 激励源内的帧序号，CSV 文本中为 id
+    ('sync_us', '<i8'),             # 参考时钟下的接收时间（微秒），未同步为 0
+    ('drift_ppb', '<i4'),
+    ('sync_err_us', '<u4'),
+])
+assert CSI_RECORD_DTYPE.itemsize == 72
+
+
+def mac_to_str(mac):
+    return ':'.join(f'{b:02x}' for b in mac)
+
+
+def is_csi_frame(data):
+    '''
+    @brief:判断数据报是否为二进制 CSI 帧或聚合容器（文本格式以 "CSI_DATA" 开头）
+    '''
+    return len(data) >= CSI_BATCH_HDR.size and data[0] == CSI_FRAME_MAGIC
+
+
+def unpack_csi_frame(data, offset=0):
+    '''
+    @brief:解码一个二进制 CSI 帧（原始帧或压缩帧）
+    @param:data: 接收到的字节串
+    @param:offset: 帧在 data 中的起始偏移
+    @return:(packet, size)，packet 的键与 CSI_DATA_COLUMNS_NAMES 一致，
+            'data' 为 int 列表；size 为该帧占用的字节数。非法帧返回 (None, 0)
+    '''
+    if (len(data) - offset < CSI_FRAME_HDR.size or data[offset] != CSI_FRAME_MAGIC
+            or data[offset + 2] not in (CSI_FRAME_TYPE_RAW, CSI_FRAME_TYPE_PACKED)):
+        return None, 0
+
+    packet = dict(zip(CSI_FRAME_HDR_FIELDS, CSI_FRAME_HDR.unpack_from(data, offset)))
+    hdr_len = packet['hdr_len']
+    length = packet['len']
+    if hdr_len < CSI_FRAME_HDR.size or offset + hdr_len + length > len(data):
+        return None, 0
+
+    if hdr_len >= CSI_FRAME_HDR.size + CSI_FRAME_HDR_V2.size:
+        packet['tx'], _, packet['tx_seq'] = CSI_FRAME_HDR_V2.unpack_from(data, offset + CSI_FRAME_HDR.size)
+    else:
+        packet['tx'], packet['tx_seq'] = 0, packet['id']
+    v3_offset = CSI_FRAME_HDR.size + CSI_FRAME_HDR_V2.size
+    if hdr_len >= v3_offset + CSI_FRAME_HDR_V3.size:
+        packet['sync_us'], packet['drift_ppb'], packet['sync_err_us'] = \
+            CSI_FRAME_HDR_V3.unpack_from(data, offset + v3_offset)
+    else:
+        packet['sync_us'], packet['drift_ppb'], packet['sync_err_us'] = 0, 0, 0
+    packet['type'] = 'CSI_DATA'
+    packet['mac'] = mac_to_str(packet['mac'])
+    packet['probe_mac'] = mac_to_str(packet['probe_mac'])
+    if data[offset + 2] == CSI_FRAME_TYPE_PACKED:
+        iq = unpack_iq(bytes(data[offset + hdr_len:offset + hdr_len + length]))
+        if iq is None:
+            return None, 0
+        packet['len'] = len(iq)
+        packet['data'] = iq.tolist()
+    else:
+        packet['data'] = list(struct.unpack_from(f'{length}b', data, offset + hdr_len))
+    return packet, hdr_len + length
+
+
+def iter_csi_frames(data):
+    '''
+    @brief:依次解码二进制数据报中的 CSI 帧，单帧和聚合容器都适用，遇到非法数据时停止
+    '''
+    offset, end = 0, len(data)
+    if is_csi_frame(data) and data[2] == CSI_FRAME_TYPE_BATCH:
+        _, _, _, hdr_len, _, _, length = CSI_BATCH_HDR.unpack_from(data)
+        if hdr_len < CSI_BATCH_HDR.size or hdr_len + length > end:
+            return
+        offset, end = hdr_len, hdr_len + length
+        data = data[:end]
+
+    while offset < end:
+        packet, size = unpack_csi_frame(data, offset)
+        if packet is None:
+            return
+        yield packet
+        offset += size
+
+
+def csi_frame_to_csv(packet):
+    '''
+    @brief:把解码后的帧还原为 "CSI_DATA,..." 文本行（不含换行符）
+    '''
+    fields = [str(packet[name]) for name in CSI_DATA_COLUMNS_NAMES[:-1]]
+    return ','.join(fields) + ',"[' + ','.join(str(v) for v in packet['data']) + ']"'
+
+
+def datagram_to_text(data):
+    '''
+    @brief:把一个 UDP 数据报转换为 CSI 文本，聚合容器中的每帧占一行，文本格式原样返回
+    '''
+    if is_csi_frame(data):
+        return '\n'.join(csi_frame_to_csv(packet) for packet in iter_csi_frames(data))
+    return data.decode('utf-8')
+
+
+def parse_csi_packets(data):
+    '''
+    @brief:解析一个 UDP 数据报（二进制帧、聚合容器或 CSV 文本）
+    @return:字典列表，键与 CSI_DATA_COLUMNS_NAMES 一致，'data' 为数值列表；不是 CSI 数据时返回空列表
+    '''
+    if is_csi_frame(data):
+        return list(iter_csi_frames(data))
+
+    decoded = data.decode().strip().replace('"', '')
+    if not decoded.startswith("CSI_DATA"):
+        return []
+
+    parts = decoded.split(',', len(CSI_DATA_COLUMNS_NAMES) - 1)
+    if len(parts) != len(CSI_DATA_COLUMNS_NAMES):
+        return []
+
+    packet = dict(zip(CSI_DATA_COLUMNS_NAMES, parts))
+    packet['data'] = [float(x) for x in packet['data'].strip('[]').split(',')]
+    return [packet]
+
+
+def packet_to_record(packet, time_us=0):
+    '''
+    @brief:把解码后的帧（字典）转换为 CSI_RECORD_DTYPE 记录
+    @return:(record, iq)，record 为可直接放入 CSI_RECORD_DTYPE 数组的元组，iq 为 int8 数组
+    '''
+    iq = np.asarray(packet['data'], dtype=np.float32).astype(np.int8)
+    record = [int(time_us)]
+    for name in CSI_RECORD_DTYPE.names[1:]:
+        if name in ('mac', 'probe_mac'):
+            value = packet.get(name)
+            record.append(tuple(bytes.fromhex(value.replace(':', ''))) if value else (0,) * 6)
+        elif name == 'len':
+            record.append(len(iq))
+        elif name == 'reserved':
+            record.append(b'')
+        elif name == 'tx':
+            record.append(int(packet.get('tx', 0)))
+        elif name == 'tx_seq':
+            record.append(int(packet.get('tx_seq', packet['id'])))
+        elif name in ('sync_us', 'drift_ppb', 'sync_err_us'):
+            record.append(int(packet.get(name, 0)))
+        else:
+            record.append(int(packet[name]))
+    return tuple(record), iq
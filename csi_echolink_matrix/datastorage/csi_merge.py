@@ -0,0 +1,175 @@
+'''
+@module:csi_merge
+@brief:按同步时间戳（sync_us，见 csi_frame.py 的 version 3）对齐多个探针、多个激励源的 CSI 流
+1.每个 (probe_mac, tx) 是一路流，帧按 sync_us 落入长度为 period_us 的时隙，同一时隙内同一路流只保留最后一帧
+2.水位 = 所有流中最新的 sync_us - max_lag_us；早于水位的时隙按时间顺序输出，之后到达的帧按迟到丢弃，
+  缓冲的时隙数不超过 max_lag_us / period_us，内存有界，某一路流中断时也不会阻塞其它流
+3.输出为 (t_slot_us, csi, mask)：csi 形状为 (流数, n_sub)，mask 标记该时隙内有帧的流；流的下标按首次出现的顺序，
+  流数随新流出现而增加
+4.sync_us 为 0（探针未同步或旧固件）的帧不参与对齐，计入 unsynced
+5.命令行：
+    python csi_merge.py listen [--port 4444] [--period-ms 10] [--lag-ms 200]
+'''
+
+import argparse
+import socket
+import time
+
+import numpy as np
+
+from csi_frame import mac_to_str
+from csi_native import parse_datagrams
+
+
+class CsiMerger:
+    '''
+    @brief:多流时间对齐，push 一批解码结果，pop 取出已经完整的时隙
+    用法：
+        merger = CsiMerger(period_us=10000, n_sub=64)
+        records, csi = parse_datagrams(datagrams, n_sub=64)
+        merger.push(records, csi)
+        for t_slot_us, csi, mask in merger.pop():
+            ...
+    '''
+    def __init__(self, period_us=10000, max_lag_us=200000, n_sub=64, max_err_us=None):
+        '''
+        @param:period_us: 时隙长度（微秒），一般取激励周期
+        @param:max_lag_us: 等待迟到帧的时间，应大于探针之间的上报延迟差（聚合发送时为聚合时长）
+        @param:n_sub: 每帧保留的子载波数，不足时补 0
+        @param:max_err_us: 丢弃 sync_err_us 超过该值的帧，None 表示不限制
+        '''
+        self.period_us = int(period_us)
+        self.max_lag_us = int(max_lag_us)
+        self.n_sub = int(n_sub)
+        self.max_err_us = max_err_us
+        self.streams = []           # 下标 -> (probe_mac, tx)
+        self._stream_index = {}
+        self._slots = {}            # 时隙编号 -> {流下标: csi 行}
+        self._latest_us = None
+        self._next_slot = None      # 尚未输出的最早时隙，更早的帧按迟到处理
+        self.merged = 0
+        self.unsynced = 0
+        self.late = 0
+        self.duplicates = 0
+
+    def stream_name(self, i):
+        probe_mac, tx = self.streams[i]
+        return f'{probe_mac}/{tx}'
+
+    def _stream(self, record):
+        key = (mac_to_str(bytes(record['probe_mac'])), int(record['tx']))
+        i = self._stream_index.get(key)
+        if i is None:
+            i = self._stream_index[key] = len(self.streams)
+            self.streams.append(key)
+        return i
+
+    def push(self, records, csi):
+        '''
+        @brief:加入一批帧
+        @param:records: CSI_RECORD_DTYPE 数组
+        @param:csi: 与 records 对应的 CSI，形状为 (帧数, 子载波数)
+        '''
+        for record, row in zip(records, csi):
+            sync_us = int(record['sync_us'])
+            if sync_us == 0 or (self.max_err_us is not None and record['sync_err_us'] > self.max_err_us):
+                self.unsynced += 1
+                continue
+
+            slot = sync_us // self.period_us
+            if self._next_slot is not None and slot < self._next_slot:
+                self.late += 1
+                continue
+
+            frames = self._slots.setdefault(slot, {})
+            i = self._stream(record)
+            if i in frames:
+                self.duplicates += 1
+            frames[i] = row[:self.n_sub]
+            self.merged += 1
+            if self._latest_us is None or sync_us > self._latest_us:
+                self._latest_us = sync_us
+
+    def pop(self, flush=False):
+        '''
+        @brief:按时间顺序取出早于水位的时隙
+        @param:flush: 为 True 时取出全部缓冲的时隙（输入结束时调用）
+        @return:[(t_slot_us, csi, mask), ...]
+        '''
+        if not self._slots:
+            return []
+
+        if flush:
+            ready = sorted(self._slots)
+        else:
+            watermark = (self._latest_us - self.max_lag_us) // self.period_us
+            ready = sorted(slot for slot in self._slots if slot < watermark)
+        if not ready:
+            return []
+
+        out = []
+        n_streams = len(self.streams)
+        for slot in ready:
+            frames = self._slots.pop(slot)
+            csi = np.zeros((n_streams, self.n_sub), dtype=np.complex64)
+            mask = np.zeros(n_streams, dtype=bool)
+            for i, row in frames.items():
+                csi[i, :len(row)] = row
+                mask[i] = True
+            out.append((slot * self.period_us, csi, mask))
+        self._next_slot = ready[-1] + 1
+        return out
+
+    def pending(self):
+        return len(self._slots)
+
+
+def listen(port, period_us, max_lag_us, n_sub):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(('0.0.0.0', port))
+    sock.settimeout(0.05)
+    merger = CsiMerger(period_us, max_lag_us, n_sub)
+    last_report = time.monotonic()
+    slots = complete = 0
+
+    while True:
+        datagrams = []
+        try:
+            while len(datagrams) < 256:
+                data, _ = sock.recvfrom(2048)
+                datagrams.append(data)
+        except socket.timeout:
+            pass
+        if datagrams:
+            records, csi = parse_datagrams(datagrams, n_sub=n_sub)
+            merger.push(records, csi)
+
+        for _, _, mask in merger.pop():
+            slots += 1
+            complete += bool(mask.all())
+
+        now = time.monotonic()
+        if now - last_report >= 1.0:
+            last_report = now
+            names = ', '.join(merger.stream_name(i) for i in range(len(merger.streams)))
+            print(f'{len(merger.streams)} streams [{names}]: {slots} slots, {complete} complete, '
+                  f'{merger.pending()} pending, late {merger.late}, unsynced {merger.unsynced}, '
+                  f'duplicates {merger.duplicates}')
+            slots = complete = 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Align CSI streams from several probes by sync timestamp')
+    sub = parser.add_subparsers(dest='command', required=True)
+    p = sub.add_parser('listen', help='receive CSI datagrams and report slot alignment')
+    p.add_argument('--port', type=int, default=4444)
+    p.add_argument('--period-ms', type=float, default=10.0, help='slot length, usually the stimulus period')
+    p.add_argument('--lag-ms', type=float, default=200.0, help='how long to wait for late frames')
+    p.add_argument('--n-sub', type=int, default=64)
+    args = parser.parse_args()
+
+    listen(args.port, int(args.period_ms * 1000), int(args.lag_ms * 1000), args.n_sub)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,475 @@
+'''
+@module:csi_native
+@brief:CSI 批量解析，一次调用把一批 UDP 数据报解码为连续的 numpy 数组
+1.元数据为 csi_frame.CSI_RECORD_DTYPE 数组，CSI 为 complex64 数组（子载波 k = data[2k+1] + 1j*data[2k]，虚部在前）
+2.二进制帧、聚合容器、CSV 文本都适用；文本可以多行，整个 csi_data_*.txt 也可以作为一个数据报解析
+3.优先使用 datastorage/native 编译出的 libcsi_native（见 native/src/csi_parse.h），
+  找不到时退回纯 Python 实现（csi_frame.parse_csi_packets），结果相同
+4.库路径可用环境变量 CSI_NATIVE_LIB 指定，默认在 native/build 下查找
+5.amplitude_phase / unwrap_phase / sanitize_phase 使用同一个库中的 SIMD 内核（native/src/csi_kernels.h），
+  没有库时用 numpy 计算（相位差异在 1e-6 rad 以内）
+6.subcarrier_map 按帧头的 len、bandwidth 给出有效子载波（LLTF、HT-LTF、STBC HT-LTF、40 MHz），
+  各采集配置（见 airprobe Kconfig 的 AIRPROBE_CSI_PROFILE）的帧都能自动选择
+7.StreamingDenoiser / DenoiserBank 为逐子载波沿时间的流式 Hampel + Savitzky-Golay 去噪（native/src/csi_denoise.h）
+
+编译：
+    cmake -S native -B native/build && cmake --build native/build -j
+用法：
+    records, csi = parse_datagrams([data1, data2, ...])
+    amplitude = np.abs(csi)
+    records, _, iq = parse_datagrams([data1, data2, ...], n_sub=0, with_iq=True)
+    amplitude, phase = amplitude_phase(iq)
+'''
+
+import collections
+import ctypes
+import functools
+import os
+import sys
+import threading
+import time
+
+import numpy as np
+
+from csi_frame import CSI_FRAME_MAGIC, CSI_RECORD_DTYPE, packet_to_record, parse_csi_packets
+
+_LIB_NAMES = ['libcsi_native.so', 'libcsi_native.dylib', 'libcsi_native.dll', 'csi_native.dll']
+
+
+def _load_library():
+    candidates = []
+    if os.environ.get('CSI_NATIVE_LIB'):
+        candidates.append(os.environ['CSI_NATIVE_LIB'])
+    build_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'native', 'build')
+    for sub in ('', 'Release'):
+        candidates += [os.path.join(build_dir, sub, name) for name in _LIB_NAMES]
+
+    for path in candidates:
+        if not os.path.exists(path):
+            continue
+        try:
+            lib = ctypes.CDLL(path)
+        except OSError as e:
+            print(f'csi_native: failed to load {path}: {e}', file=sys.stderr)
+            continue
+
+        lib.csi_parser_new.restype = ctypes.c_void_p
+        lib.csi_parser_new.argtypes = []
+        lib.csi_parser_free.restype = None
+        lib.csi_parser_free.argtypes = [ctypes.c_void_p]
+        lib.csi_parser_parse.restype = ctypes.c_size_t
+        lib.csi_parser_parse.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_void_p,
+                                         ctypes.c_size_t, ctypes.c_void_p]
+        lib.csi_parser_max_len.restype = ctypes.c_uint32
+        lib.csi_parser_max_len.argtypes = [ctypes.c_void_p]
+        lib.csi_parser_errors.restype = ctypes.c_uint64
+        lib.csi_parser_errors.argtypes = [ctypes.c_void_p]
+        lib.csi_parser_export.restype = None
+        lib.csi_parser_export.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_uint32,
+                                          ctypes.c_void_p, ctypes.c_uint32, ctypes.c_void_p]
+
+        lib.csi_kernel_get_isa.restype = ctypes.c_int
+        lib.csi_kernel_get_isa.argtypes = []
+        lib.csi_iq_to_amp_phase.restype = None
+        lib.csi_iq_to_amp_phase.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.c_void_p, ctypes.c_void_p]
+        lib.csi_phase_unwrap.restype = ctypes.c_int
+        lib.csi_phase_unwrap.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.c_size_t, ctypes.c_void_p]
+        lib.csi_phase_sanitize.restype = ctypes.c_int
+        lib.csi_phase_sanitize.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.c_size_t, ctypes.c_void_p,
+                                           ctypes.c_void_p, ctypes.c_size_t, ctypes.c_void_p]
+
+        lib.csi_denoiser_new.restype = ctypes.c_void_p
+        lib.csi_denoiser_new.argtypes = [ctypes.c_uint32, ctypes.c_uint32, ctypes.c_float, ctypes.c_uint32,
+                                         ctypes.c_uint32]
+        lib.csi_denoiser_free.restype = None
+        lib.csi_denoiser_free.argtypes = [ctypes.c_void_p]
+        lib.csi_denoiser_reset.restype = None
+        lib.csi_denoiser_reset.argtypes = [ctypes.c_void_p]
+        lib.csi_denoiser_delay.restype = ctypes.c_uint32
+        lib.csi_denoiser_delay.argtypes = [ctypes.c_void_p]
+        lib.csi_denoiser_push.restype = ctypes.c_size_t
+        lib.csi_denoiser_push.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t, ctypes.c_void_p]
+        return lib
+    return None
+
+
+_lib = _load_library()
+NATIVE = _lib is not None
+
+# 与 csi_kernels.h 的 CSI_KERNEL_MAX_SUBCARRIERS 一致
+KERNEL_MAX_SUBCARRIERS = 512
+KERNEL_ISA_NAMES = ('scalar', 'sse41', 'avx2')
+
+
+def kernel_isa():
+    '''
+    @brief:当前使用的内核实现：'scalar' / 'sse41' / 'avx2'，没有库时为 'numpy'
+    '''
+    return KERNEL_ISA_NAMES[_lib.csi_kernel_get_isa()] if _lib else 'numpy'
+
+
+def _ptr(array):
+    return None if array is None else array.ctypes.data
+
+
+def _times_array(times_us, count):
+    if times_us is None:
+        times_us = time.time_ns() // 1000
+    return np.broadcast_to(np.asarray(times_us, dtype=np.int64), (count,)).copy()
+
+
+class CsiParser:
+    '''
+    @brief:批量解析器，内部缓冲区在多次调用间重复使用；不是线程安全的，每个线程使用各自的实例
+    @note:errors 为累计无法解析的二进制数据报或 CSI_DATA 文本行数
+    '''
+
+    def __init__(self):
+        self._lib = _lib
+        self._handle = _lib.csi_parser_new() if _lib else None
+        self._python_errors = 0
+
+    def __del__(self):
+        if getattr(self, '_handle', None):
+            self._lib.csi_parser_free(self._handle)
+            self._handle = None
+
+    @property
+    def errors(self):
+        return self._lib.csi_parser_errors(self._handle) if self._handle else self._python_errors
+
+    def parse(self, datagrams, times_us=None, n_sub=None, with_iq=False, with_source=False):
+        '''
+        @brief:解析一批数据报
+        @param:datagrams: bytes 列表（单个 bytes 也可以）
+        @param:times_us: 每个数据报的接收时间（Unix 微秒），标量或数组，默认为当前时间
+        @param:n_sub: CSI 子载波数，默认按本批最长的帧（I/Q 字节数 / 2）；0 表示不计算 CSI
+        @param:with_iq: 同时返回原始 int8 I/Q（按本批最长的帧补 0）
+        @param:with_source: 同时返回每帧所在数据报的下标
+        @return:(records, csi[, iq][, source])
+        '''
+        if isinstance(datagrams, (bytes, bytearray, memoryview)):
+            datagrams = [datagrams]
+        times = _times_array(times_us, len(datagrams))
+
+        if self._handle:
+            lengths = np.fromiter((len(d) for d in datagrams), dtype=np.uint64, count=len(datagrams))
+            offsets = np.zeros(len(datagrams) + 1, dtype=np.uint64)
+            np.cumsum(lengths, out=offsets[1:])
+            buf = b''.join(datagrams)
+
+            lib = self._lib
+            frames = lib.csi_parser_parse(self._handle, buf, _ptr(offsets), len(datagrams), _ptr(times))
+            max_len = lib.csi_parser_max_len(self._handle)
+            if n_sub is None:
+                n_sub = max_len // 2
+
+            records = np.empty(frames, dtype=CSI_RECORD_DTYPE)
+            csi = np.empty((frames, n_sub), dtype=np.complex64)
+            iq = np.empty((frames, max_len), dtype=np.int8) if with_iq else None
+            source = np.empty(frames, dtype=np.uint32) if with_source else None
+            lib.csi_parser_export(self._handle, _ptr(records), _ptr(csi) if n_sub else None, n_sub,
+                                   _ptr(iq), max_len, _ptr(source))
+        else:
+            records, csi, iq, source = self._parse_python(datagrams, times, n_sub)
+
+        result = (records, csi)
+        if with_iq:
+            result += (iq,)
+        if with_source:
+            result += (source,)
+        return result
+
+    def _parse_python(self, datagrams, times, n_sub):
+        rows, iq_rows, source = [], [], []
+        for i, data in enumerate(datagrams):
+            data = bytes(data)
+            if data[:1] == bytes([CSI_FRAME_MAGIC]):
+                lines = [data]
+            else:
+                lines = [line for line in data.splitlines() if line.strip().startswith(b'CSI_DATA')]
+            for line in lines:
+                try:
+                    packets = parse_csi_packets(line)
+                except (ValueError, UnicodeDecodeError):
+                    packets = []
+                if not packets:
+                    self._python_errors += 1
+                for packet in packets:
+                    record, iq = packet_to_record(packet, times[i])
+                    rows.append(record)
+                    iq_rows.append(iq)
+                    source.append(i)
+
+        max_len = max((len(row) for row in iq_rows), default=0)
+        records = np.array(rows, dtype=CSI_RECORD_DTYPE)
+        iq = np.zeros((len(rows), max_len), dtype=np.int8)
+        for f, row in enumerate(iq_rows):
+            iq[f, :len(row)] = row
+
+        if n_sub is None:
+            n_sub = max_len // 2
+        pairs = min(n_sub, max_len // 2)
+        csi = np.zeros((len(rows), n_sub), dtype=np.complex64)
+        csi[:, :pairs].real = iq[:, 1:2 * pairs:2]
+        csi[:, :pairs].imag = iq[:, 0:2 * pairs:2]
+        # 奇数长度帧的最后一个字节不构成子载波
+        for f, row in enumerate(iq_rows):
+            if len(row) // 2 < pairs:
+                csi[f, len(row) // 2:] = 0
+        return records, csi, iq, np.array(source, dtype=np.uint32)
+
+
+_local = threading.local()
+
+
+def parse_datagrams(datagrams, times_us=None, n_sub=None, with_iq=False, with_source=False):
+    '''
+    @brief:用当前线程的 CsiParser 解析一批数据报，参数和返回值见 CsiParser.parse
+    '''
+    parser = getattr(_local, 'parser', None)
+    if parser is None:
+        parser = _local.parser = CsiParser()
+    return parser.parse(datagrams, times_us, n_sub, with_iq, with_source)
+
+
+def amplitude_phase(iq, with_phase=True):
+    '''
+    @brief:int8 I/Q（虚部在前）批量转换为幅度和相位
+    @param:iq: int8 数组，最后一维为每帧的 I/Q 字节（parse_datagrams(..., with_iq=True) 的输出），奇数时忽略最后一个字节
+    @param:with_phase: 为 False 时只计算幅度，phase 返回 None
+    @return:(amplitude, phase)，float32，最后一维为子载波
+    '''
+    iq = np.asarray(iq, dtype=np.int8)
+    n_sub = iq.shape[-1] // 2
+    iq = np.ascontiguousarray(iq[..., :2 * n_sub])
+    shape = iq.shape[:-1] + (n_sub,)
+
+    if _lib is None:
+        imag = iq[..., 0::2].astype(np.float32)
+        real = iq[..., 1::2].astype(np.float32)
+        amplitude = np.sqrt(real * real + imag * imag)
+        phase = np.arctan2(imag, real) if with_phase else None
+        return amplitude, phase
+
+    amplitude = np.empty(shape, dtype=np.float32)
+    phase = np.empty(shape, dtype=np.float32) if with_phase else None
+    if amplitude.size:
+        _lib.csi_iq_to_amp_phase(_ptr(iq), amplitude.size, _ptr(amplitude), _ptr(phase))
+    return amplitude, phase
+
+
+def unwrap_phase(phase):
+    '''
+    @brief:沿最后一维（子载波）解缠绕相位，相邻子载波的相位差超过 pi 时加减 2*pi
+    @return:float32，形状与 phase 相同
+    '''
+    phase = np.ascontiguousarray(phase, dtype=np.float32)
+    n_sub = phase.shape[-1] if phase.ndim else 0
+    if _lib is None or n_sub > KERNEL_MAX_SUBCARRIERS:
+        turns = np.zeros_like(phase)
+        turns[..., 1:] = np.cumsum(np.rint(np.diff(phase, axis=-1) / np.float32(2 * np.pi)), axis=-1)
+        return (phase - turns * np.float32(2 * np.pi)).astype(np.float32)
+
+    out = np.empty_like(phase)
+    if n_sub:
+        _lib.csi_phase_unwrap(_ptr(phase), phase.size // n_sub, n_sub, _ptr(out))
+    return out
+
+
+# CSI 中各 LTF 的布局：(I/Q 字节数, 是否 40 MHz) -> [(名称, 子载波数, 直流所在下标, 有效 |k| 下限, 上限), ...]
+# 每段按频率从低到高排列（下标 i 对应 k = i - 直流下标），与 AirProbe 实测数据一致；
+# 380/376 字节为次信道在下方/上方时截短的 HT-LTF（63/62 个子载波）
+# https://docs.espressif.com/projects/esp-idf/en/stable/esp32/api-guides/wifi.html#wi-fi-channel-state-information
+_LTF_LAYOUTS = {
+    (128, False): [('lltf', 64, 32, 1, 26)],
+    (256, False): [('lltf', 64, 32, 1, 26), ('ht_ltf', 64, 32, 1, 28)],
+    (384, False): [('lltf', 64, 32, 1, 26), ('ht_ltf', 64, 32, 1, 28), ('stbc_ht_ltf', 64, 32, 1, 28)],
+    (380, False): [('lltf', 64, 32, 1, 26), ('ht_ltf', 63, 32, 1, 28), ('stbc_ht_ltf', 63, 32, 1, 28)],
+    (376, False): [('lltf', 64, 32, 1, 26), ('ht_ltf', 62, 32, 1, 28), ('stbc_ht_ltf', 62, 32, 1, 28)],
+    (384, True): [('lltf', 64, 32, 1, 26), ('ht_ltf', 128, 64, 2, 58)],
+    (612, True): [('lltf', 64, 32, 1, 26), ('ht_ltf', 121, 60, 2, 58), ('stbc_ht_ltf', 121, 60, 2, 58)],
+}
+
+SubcarrierMap = collections.namedtuple('SubcarrierMap', ['positions', 'offsets', 'groups', 'names'])
+
+
+@functools.lru_cache(maxsize=None)
+def subcarrier_map(length, bandwidth=0):
+    '''
+    @brief:按帧头的 len 和 bandwidth 选择有效子载波，替代各脚本里手写的 csi_vaid_subcarrier_index
+    @param:length: CSI 的 I/Q 字节数（记录的 len）
+    @param:bandwidth: 记录的 bandwidth（0 为 20 MHz，1 为 40 MHz）
+    @return:SubcarrierMap：positions 为 amplitude_phase 输出中的下标，offsets 为频率编号 k，
+            groups 为所属 LTF 的序号（names[groups]），可直接传给 sanitize_phase；数组只读。
+            未知的组合只取 LLTF，不足 128 字节时为空
+    '''
+    length = int(length)
+    layout = _LTF_LAYOUTS.get((length, bool(bandwidth)))
+    if layout is None:
+        layout = _LTF_LAYOUTS[(128, False)] if length >= 128 else []
+
+    positions, offsets, groups = [], [], []
+    start = 0
+    for group, (_, size, dc, lo, hi) in enumerate(layout):
+        k = np.arange(size) - dc
+        index = np.flatnonzero((np.abs(k) >= lo) & (np.abs(k) <= hi))
+        positions.append(start + index)
+        offsets.append(k[index])
+        groups.append(np.full(len(index), group))
+        start += size
+
+    arrays = [np.concatenate(a) if a else np.empty(0) for a in (positions, offsets, groups)]
+    arrays = [a.astype(dtype) for a, dtype in zip(arrays, (np.int64, np.float32, np.int64))]
+    for a in arrays:
+        a.setflags(write=False)
+    return SubcarrierMap(*arrays, tuple(entry[0] for entry in layout))
+
+
+def subcarrier_offsets(positions):
+    '''
+    @brief:20 MHz 帧中 I/Q 子载波下标对应的频率编号：每 64 个一组（LLTF、HT-LTF、STBC HT-LTF），
+           组内按频率排列，直流在第 32 个，即 k = i % 64 - 32；40 MHz 帧请用 subcarrier_map
+    '''
+    return (np.asarray(positions) % 64 - 32).astype(np.float32)
+
+
+def _sanitize_group(phase, positions, x):
+    frames = phase.reshape(-1, phase.shape[-1])
+    n_valid = len(positions)
+    if _lib is not None and 2 <= n_valid <= KERNEL_MAX_SUBCARRIERS:
+        out = np.empty((frames.shape[0], n_valid), dtype=np.float32)
+        positions = np.ascontiguousarray(positions, dtype=np.uint32)
+        x = np.ascontiguousarray(x, dtype=np.float32)
+        if _lib.csi_phase_sanitize(_ptr(frames), frames.shape[0], frames.shape[1], _ptr(positions),
+                                   _ptr(x), n_valid, _ptr(out)) == 0:
+            return out
+
+    out = unwrap_phase(frames[:, positions])
+    if n_valid >= 2 and np.ptp(x) > 0:
+        a, b = np.polyfit(x.astype(np.float64), out.T.astype(np.float64), 1)
+        out = (out - (np.outer(a, x) + b[:, None])).astype(np.float32)
+    return out
+
+
+def sanitize_phase(phase, positions, x=None, groups=None):
+    '''
+    @brief:相位校正：取出有效子载波，解缠绕后减去最小二乘拟合的直线，消除采样时间偏移和载波相位偏移
+    @param:phase: amplitude_phase 输出的相位，最后一维为子载波
+    @param:positions: 有效子载波下标，或 subcarrier_map 的结果（此时 x、groups 取自其中）
+    @param:x: 每个下标的频率编号，默认按 subcarrier_offsets 计算
+    @param:groups: 每个下标所属的 LTF，每组分别拟合；默认按 positions // 64 分组
+    @return:float32，最后一维为 len(positions)，顺序与 positions 相同
+    '''
+    if isinstance(positions, SubcarrierMap):
+        positions, x, groups = positions.positions, positions.offsets, positions.groups
+    phase = np.ascontiguousarray(phase, dtype=np.float32)
+    positions = np.asarray(positions, dtype=np.int64)
+    out = np.empty(phase.shape[:-1] + (len(positions),), dtype=np.float32)
+    flat = out.reshape(-1, len(positions))
+
+    x = subcarrier_offsets(positions) if x is None else np.asarray(x, dtype=np.float32)
+    groups = positions // 64 if groups is None else np.asarray(groups)
+    for group in np.unique(groups):
+        # 每组按频率排序后拟合，结果放回 positions 的顺序
+        index = np.flatnonzero(groups == group)
+        index = index[np.argsort(x[index], kind='stable')]
+        flat[:, index] = _sanitize_group(phase, positions[index], x[index])
+    return out
+
+
+def _savgol_coeffs(window, order):
+    half = window // 2
+    a = np.vander(np.arange(-half, half + 1, dtype=np.float64), order + 1, increasing=True)
+    return np.linalg.pinv(a)[0].astype(np.float32)
+
+
+class StreamingDenoiser:
+    '''
+    @brief:逐子载波沿时间的流式去噪：Hampel（滑动中位数/MAD）去离群点，再做 Savitzky-Golay 平滑
+    @note:每帧每个子载波的代价为常数（窗口长度固定）；输出比输入晚 delay 帧，复位后的第一帧填满窗口
+          （相当于该帧之前一直重复）。参数含义与 hampel(data, window_size, n_sigma)、
+          savgol_filter(data, window_length, polyorder) 相同，但沿时间方向而不是沿子载波方向
+    '''
+
+    def __init__(self, n_sub, hampel_window=7, n_sigma=5.0, sg_window=5, sg_order=3):
+        if hampel_window % 2 == 0 or sg_window % 2 == 0 or (sg_window > 1 and sg_order >= sg_window):
+            raise ValueError('windows must be odd and sg_order < sg_window')
+        self.n_sub = n_sub
+        self.delay = hampel_window // 2 + sg_window // 2
+        self._lib = _lib
+        self._handle = _lib.csi_denoiser_new(n_sub, hampel_window, n_sigma, sg_window, sg_order) if _lib else None
+        if not self._handle:
+            self._hampel_window = hampel_window
+            self._threshold = np.float32(n_sigma * 1.4826)
+            self._sg = _savgol_coeffs(sg_window, sg_order) if sg_window > 1 else np.ones(1, dtype=np.float32)
+        self._frames = 0
+
+    def __del__(self):
+        if getattr(self, '_handle', None):
+            self._lib.csi_denoiser_free(self._handle)
+            self._handle = None
+
+    def reset(self):
+        self._frames = 0
+        if self._handle:
+            self._lib.csi_denoiser_reset(self._handle)
+
+    def push(self, frames):
+        '''
+        @brief:输入一帧（n_sub,）或多帧（n, n_sub），返回已经可以确定的输出帧
+        @return:float32 数组（k, n_sub），第 i 行对应 delay 帧之前的输入；填充阶段 k 可能为 0
+        '''
+        frames = np.ascontiguousarray(frames, dtype=np.float32).reshape(-1, self.n_sub)
+        if self._handle:
+            out = np.empty_like(frames)
+            written = self._lib.csi_denoiser_push(self._handle, _ptr(frames), len(frames), _ptr(out))
+            return out[:written]
+
+        out = []
+        for frame in frames:
+            y = self._step(frame)
+            if self._frames > self.delay:
+                out.append(y)
+        return np.array(out, dtype=np.float32).reshape(-1, self.n_sub)
+
+    def _step(self, frame):
+        if self._frames == 0:
+            self._window = np.tile(frame, (self._hampel_window, 1))
+            self._smooth = np.tile(frame, (len(self._sg), 1))
+        self._frames += 1
+
+        self._window = np.roll(self._window, -1, axis=0)
+        self._window[-1] = frame
+        median = np.median(self._window, axis=0)
+        mad = np.median(np.abs(self._window - median), axis=0)
+        x = self._window[self._hampel_window // 2]
+        x = np.where(np.abs(x - median) > self._threshold * mad, median, x)
+
+        self._smooth = np.roll(self._smooth, -1, axis=0)
+        self._smooth[-1] = x
+        return self._sg @ self._smooth
+
+
+class DenoiserBank:
+    '''
+    @brief:每个发送端/探针一个 StreamingDenoiser，按 key（如 MAC）分别维护状态；子载波数变化时重新开始
+    '''
+
+    def __init__(self, **params):
+        self._params = params
+        self._filters = {}
+
+    def push(self, key, frames):
+        frames = np.asarray(frames, dtype=np.float32)
+        n_sub = frames.shape[-1]
+        denoiser = self._filters.get(key)
+        if denoiser is None or denoiser.n_sub != n_sub:
+            denoiser = self._filters[key] = StreamingDenoiser(n_sub, **self._params)
+        return denoiser.push(frames)
+
+    def reset(self, key=None):
+        if key is None:
+            self._filters.clear()
+        else:
+            self._filters.pop(key, None)
@@ -0,0 +1,151 @@
+'''
+@module:csi_seq
+@brief:按数据源统计帧序号：丢失、重复、乱序、探针重启、空洞长度分布和到达抖动
+1.计数规则与 components/csi_seq 一致（AirSight 和 csi_recvd 共用），三处的统计可以直接对比
+2.二进制帧按 probe_mac 区分数据源并用帧头的 local_timestamp 估计到达抖动，CSV 文本按发送端地址区分
+3.SeqTracker.update_records 直接接受 csi_native.parse_datagrams 的记录数组
+'''
+
+import time
+
+# 序号回退超过该值时视为探针重启，而不是乱序
+SEQ_RESTART_WINDOW = 1024
+# 空洞长度分桶：丢失 1、2-3、4-7 ... 帧
+SEQ_GAP_LABELS = ['1', '2-3', '4-7', '8-15', '16-31', '32-63', '64-127', '128+']
+
+_U32 = 0xFFFFFFFF
+
+
+def _s32(value):
+    value &= _U32
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def gap_bucket(missing):
+    return min(missing.bit_length() - 1, len(SEQ_GAP_LABELS) - 1)
+
+
+class SeqStats:
+    '''
+    @brief:一个数据源的统计，字段与 csi_seq_stats_t 对应
+    '''
+    def __init__(self):
+        self.received = 0
+        self.lost = 0
+        self.duplicate = 0
+        self.reordered = 0
+        self.restarts = 0
+        self.gaps = [0] * len(SEQ_GAP_LABELS)
+        self.jitter_q4 = 0
+        self.last_seq = 0
+        self.last_transit = None
+        self.started = False
+
+    @property
+    def jitter_us(self):
+        return self.jitter_q4 >> 4
+
+    def _update_jitter(self, send_us, arrival_us):
+        transit = (arrival_us - send_us) & _U32
+        if self.last_transit is not None:
+            d = abs(_s32(transit - self.last_transit))
+            self.jitter_q4 = (self.jitter_q4 + d - ((self.jitter_q4 + 8) >> 4)) & _U32
+        self.last_transit = transit
+
+    def update(self, seq, send_us=None, arrival_us=None):
+        '''
+        @brief:统计一帧
+        @param:send_us: 发送端时间戳（微秒，帧头的 local_timestamp），为 None 时不更新抖动
+        @param:arrival_us: 本地到达时刻（微秒）
+        '''
+        self.received += 1
+        if not self.started:
+            self.started = True
+            self.last_seq = seq
+        else:
+            delta = _s32(seq - self.last_seq)
+            if delta > 0:
+                missing = delta - 1
+                if missing:
+                    self.lost += missing
+                    self.gaps[gap_bucket(missing)] += 1
+                self.last_seq = seq
+            elif delta == 0:
+                self.duplicate += 1
+                return
+            elif -delta > SEQ_RESTART_WINDOW:
+                self.restarts += 1
+                self.last_seq = seq
+                self.last_transit = None
+            else:
+                # 迟到的帧此前已被计为丢失
+                self.reordered += 1
+                if self.lost:
+                    self.lost -= 1
+
+        if send_us is not None:
+            self._update_jitter(int(send_us), int(arrival_us))
+
+    def as_dict(self):
+        return {'received': self.received, 'lost': self.lost, 'duplicate': self.duplicate,
+                'reordered': self.reordered, 'restarts': self.restarts, 'jitter_us': self.jitter_us,
+                'last_seq': self.last_seq, 'gaps': list(self.gaps)}
+
+
+def format_seq_stats(source, stats):
+    '''
+    @brief:一个数据源的统计格式化为一行，与 csi_recvd 的报告一致
+    @param:stats: SeqStats.as_dict() 或 airsight_ctrl.unpack_src_status 的条目
+    '''
+    total = stats['received'] + stats['lost']
+    loss = 100.0 * stats['lost'] / total if total else 0.0
+    line = (f"{source} received={stats['received']} lost={stats['lost']} ({loss:.2f}%) "
+            f"dup={stats['duplicate']} reordered={stats['reordered']} restarts={stats['restarts']} "
+            f"jitter={stats['jitter_us']}us last_seq={stats['last_seq']}")
+    gaps = ' '.join(f'{label}:{n}' for label, n in zip(SEQ_GAP_LABELS, stats['gaps']) if n)
+    if gaps:
+        line += f' gaps({gaps})'
+    return line
+
+
+class SeqTracker:
+    '''
+    @brief:多个数据源的序号统计
+    用法：
+        tracker = SeqTracker()
+        records, csi = parse_datagrams(data, n_sub=0)
+        tracker.update_records(records, addr)
+        for line in tracker.report():
+            print(line)
+    '''
+    def __init__(self):
+        self.sources = {}
+
+    def update(self, source, seq, send_us=None, arrival_us=None):
+        stats = self.sources.get(source)
+        if stats is None:
+            stats = self.sources[source] = SeqStats()
+        stats.update(seq, send_us, arrival_us)
+
+    def update_records(self, records, addr=None, arrival_us=None):
+        '''
+        @brief:统计一个数据报解析出的记录（CSI_RECORD_DTYPE）
+        @param:addr: 数据报的发送端 (ip, port)，CSV 文本（probe_mac 为全 0）按它区分数据源
+        @param:arrival_us: 数据报的到达时刻（微秒），默认为当前时间
+        '''
+        if arrival_us is None:
+            arrival_us = time.time_ns() // 1000
+        for record in records:
+            probe_mac = bytes(record['probe_mac'])
+            if any(probe_mac):
+                source = ':'.join(f'{b:02x}' for b in probe_mac)
+                self.update(source, int(record['id']), int(record['local_timestamp']), arrival_us)
+            else:
+                source = f'{addr[0]}:{addr[1]}' if addr else 'csv'
+                self.update(source, int(record['id']))
+
+    def report(self):
+        '''
+        @brief:每个数据源一行
+        '''
+        return [format_seq_stats(source, stats.as_dict()) for source, stats in sorted(self.sources.items())]
@@ -0,0 +1,181 @@
+/**
+ * @file csi_codec_bench.c
+ * @brief csi_codec 压缩率与性能：回放 CSI_DATA 文本采集（csi_data_*.txt 或 save_csidata 的 csi_data.csv），
+ *        每个量化位数下的数据区压缩率、编码耗时，以及各指令集的解码耗时
+ *
+ * 压缩率按 AirProbe 的发送规则计算：编码结果不比原始 I/Q 短的帧按原始帧发送（计入 raw 列）。
+ * 设备侧的编码耗时由 AirProbe 随统计日志打印（AIRPROBE_CSI_CODEC_ENABLE）。
+ *
+ *   ./csi_codec_bench [采集文件，默认为仓库中的示例采集] [回放次数，默认 50]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "csi_codec.h"
+#include "csi_kernels.h"
+
+#ifndef CSI_BENCH_DEFAULT_CAPTURE
+#define CSI_BENCH_DEFAULT_CAPTURE "csi_data.csv"
+#endif
+
+typedef struct {
+    int8_t iq[CSI_FRAME_MAX_PAYLOAD];
+    size_t len;
+} frame_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/** 一行 "CSI_DATA,...,\"[v,v,...]\""：取最后一个字段中的数值 */
+static size_t parse_line(const char *line, int8_t *iq)
+{
+    const char *p = strrchr(line, '[');
+    size_t n = 0;
+
+    if (strncmp(line, "CSI_DATA", 8) != 0 || !p) {
+        return 0;
+    }
+    for (p++; n < CSI_FRAME_MAX_PAYLOAD;) {
+        char *end;
+        long v = strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        iq[n++] = (int8_t)v;
+        p = end;
+        while (*p == ' ' || *p == ',') {
+            p++;
+        }
+    }
+    return n;
+}
+
+static frame_t *load_capture(const char *path, size_t *count)
+{
+    FILE *f = fopen(path, "r");
+    static char line[16384];
+    frame_t *frames = NULL;
+    size_t n = 0, cap = 0;
+
+    if (!f) {
+        return NULL;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if (n == cap) {
+            cap = cap ? cap * 2 : 1024;
+            frame_t *grown = realloc(frames, cap * sizeof(*frames));
+            if (!grown) {
+                break;
+            }
+            frames = grown;
+        }
+        frames[n].len = parse_line(line, frames[n].iq);
+        if (frames[n].len) {
+            n++;
+        }
+    }
+    fclose(f);
+    *count = n;
+    return frames;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : CSI_BENCH_DEFAULT_CAPTURE;
+    size_t rounds = argc > 2 ? strtoul(argv[2], NULL, 10) : 50;
+    static const char *isa_names[] = {"scalar", "sse41", "avx2"};
+    size_t count = 0;
+    frame_t *frames = load_capture(path, &count);
+
+    if (!frames || count == 0) {
+        fprintf(stderr, "%s: no CSI_DATA lines\n", path);
+        return 1;
+    }
+
+    // 每帧的数据区：压缩成功时为 csi_codec_hdr_t + 编码结果，否则为原始 I/Q
+    uint8_t (*packed)[CSI_FRAME_MAX_PAYLOAD] = malloc(count * sizeof(*packed));
+    size_t *packed_len = malloc(count * sizeof(size_t));
+    int8_t out[CSI_FRAME_MAX_PAYLOAD];
+    size_t raw_bytes = 0;
+
+    if (!packed || !packed_len) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        raw_bytes += frames[i].len;
+    }
+
+    printf("%s: %zu frames, %.1f I/Q bytes/frame, %zu rounds\n", path, count, (double)raw_bytes / count, rounds);
+    printf("%-6s %10s %8s %8s %6s %14s %14s %14s %14s\n", "quant", "bytes/frame", "payload", "frame", "raw",
+           "encode", "decode scalar", "decode sse41", "decode avx2");
+
+    for (unsigned q = 0; q <= CSI_CODEC_MAX_QUANT; q++) {
+        size_t packed_bytes = 0, raw_frames = 0;
+        double t0 = now_s();
+        for (size_t r = 0; r < rounds; r++) {
+            for (size_t i = 0; i < count; i++) {
+                packed_len[i] = csi_codec_pack(frames[i].iq, frames[i].len, q, packed[i]);
+            }
+        }
+        double encode_ns = (now_s() - t0) * 1e9 / (rounds * count);
+
+        for (size_t i = 0; i < count; i++) {
+            if (packed_len[i]) {
+                packed_bytes += packed_len[i];
+            } else {
+                packed_bytes += frames[i].len;
+                raw_frames++;
+            }
+        }
+
+        char decode[3][24];
+        for (int isa = CSI_KERNEL_ISA_SCALAR; isa <= CSI_KERNEL_ISA_AVX2; isa++) {
+            snprintf(decode[isa], sizeof(decode[isa]), "n/a");
+            if (csi_kernel_set_isa((csi_kernel_isa_t)isa) != (csi_kernel_isa_t)isa) {
+                continue;
+            }
+            size_t errors = 0;
+            t0 = now_s();
+            for (size_t r = 0; r < rounds; r++) {
+                for (size_t i = 0; i < count; i++) {
+                    if (packed_len[i] && csi_iq_unpack(packed[i], packed_len[i], out, sizeof(out)) != frames[i].len) {
+                        errors++;
+                    }
+                }
+            }
+            snprintf(decode[isa], sizeof(decode[isa]), "%.1f ns", (now_s() - t0) * 1e9 / (rounds * count));
+            if (errors) {
+                fprintf(stderr, "quant %u %s: %zu decode errors\n", q, isa_names[isa], errors);
+                return 1;
+            }
+        }
+
+        // 无损模式逐字节还原
+        for (size_t i = 0; q == 0 && i < count; i++) {
+            if (packed_len[i] && (csi_iq_unpack(packed[i], packed_len[i], out, sizeof(out)) != frames[i].len
+                                  || memcmp(out, frames[i].iq, frames[i].len) != 0)) {
+                fprintf(stderr, "frame %zu: lossless round trip mismatch\n", i);
+                return 1;
+            }
+        }
+
+        // frame 列计入 csi_frame_hdr_t，即线上每帧的字节数之比
+        double hdr_bytes = (double)count * sizeof(csi_frame_hdr_t);
+        printf("%-6u %10.1f %7.2fx %7.2fx %6zu %11.1f ns %14s %14s %14s\n", q,
+               (double)packed_bytes / count, (double)raw_bytes / packed_bytes,
+               (hdr_bytes + raw_bytes) / (hdr_bytes + packed_bytes), raw_frames,
+               encode_ns, decode[0], decode[1], decode[2]);
+    }
+
+    free(frames);
+    free(packed);
+    free(packed_len);
+    return 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file csi_fec_bench.c
+ * @brief csi_fec 性能测试：不同组大小下每个数据报的编码、解码（每组丢失一个）耗时
+ *
+ * 设备侧的编码耗时由 AirProbe 随统计日志打印（AIRPROBE_FEC_ENABLE）。
+ *
+ *   ./csi_fec_bench [组数，默认 20000]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "csi_fec.h"
+
+#define MAX_K   16
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+    size_t groups = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+    static const uint8_t probe_mac[6] = {0x24, 0x6f, 0x28, 0x01, 0x02, 0x03};
+    static const unsigned ks[] = {2, 4, 8, 16};
+    static uint8_t data[MAX_K][CSI_FEC_MAX_DATAGRAM];
+    static uint8_t parity[CSI_DATAGRAM_MAX_SIZE];
+    static uint8_t out[CSI_FEC_MAX_DATAGRAM];
+    csi_fec_enc_t *enc = malloc(sizeof(*enc));
+    csi_fec_dec_t *dec = malloc(sizeof(*dec));
+    size_t len = CSI_FEC_MAX_DATAGRAM;
+
+    if (!enc || !dec) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    srand(1);
+    for (unsigned i = 0; i < MAX_K; i++) {
+        csi_batch_hdr_t hdr;
+        csi_batch_hdr_init(&hdr);
+        hdr.hdr_len = CSI_FEC_BATCH_HDR_LEN;
+        hdr.len = (uint16_t)(len - CSI_FEC_BATCH_HDR_LEN);
+        memcpy(data[i], &hdr, sizeof(hdr));
+        for (size_t j = sizeof(hdr); j < len; j++) {
+            data[i][j] = (uint8_t)rand();
+        }
+    }
+
+    printf("%zu groups, %zu byte datagrams, one loss per group\n", groups, len);
+    printf("%-4s %16s %16s %10s\n", "k", "encode", "decode", "recovered");
+    for (size_t n = 0; n < sizeof(ks) / sizeof(ks[0]); n++) {
+        unsigned k = ks[n];
+        size_t parity_len = 0, recovered = 0;
+
+        csi_fec_enc_init(enc, (uint8_t)k, probe_mac);
+        double t0 = now_s();
+        for (size_t g = 0; g < groups; g++) {
+            for (unsigned i = 0; i < k; i++) {
+                csi_fec_enc_add(enc, data[i], len);
+            }
+            parity_len = csi_fec_enc_finish(enc);
+        }
+        double t1 = now_s();
+
+        // 组内各数据报只有组序号随组变化，k 为偶数时在异或中相互抵消，同一份校验数据适用于每一组
+        memcpy(parity, enc->buf, parity_len);
+        csi_parity_hdr_t *hdr = (csi_parity_hdr_t *)parity;
+        csi_fec_dec_init(dec);
+        double t2 = now_s();
+        for (size_t g = 0; g < groups; g++) {
+            unsigned lost = (unsigned)(g % k);
+            hdr->group = (uint16_t)g;
+            for (unsigned i = 0; i < k; i++) {
+                ((csi_batch_fec_t *)(data[i] + sizeof(csi_batch_hdr_t)))->group = (uint16_t)g;
+            }
+            for (unsigned i = 0; i < k; i++) {
+                if (i != lost) {
+                    csi_fec_dec_push(dec, data[i], len, out);
+                }
+            }
+            if (csi_fec_dec_push(dec, parity, parity_len, out) == len && memcmp(out, data[lost], len) == 0) {
+                recovered++;
+            }
+        }
+        double t3 = now_s();
+
+        printf("%-4u %10.1f ns/dg %10.1f ns/dg %10zu\n", k,
+               (t1 - t0) * 1e9 / (groups * k), (t3 - t2) * 1e9 / (groups * k), recovered);
+        if (recovered != groups) {
+            fprintf(stderr, "k=%u: recovered %zu of %zu groups\n", k, recovered, groups);
+            return 1;
+        }
+    }
+
+    free(enc);
+    free(dec);
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "capture_writer.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace csi {
+
+CaptureWriter::CaptureWriter(std::string dir, uint64_t rotate_bytes, std::string prefix, std::string suffix)
+    : dir_(std::move(dir)), prefix_(std::move(prefix)), suffix_(std::move(suffix)), rotate_bytes_(rotate_bytes)
+{
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    flush();
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool CaptureWriter::open_next()
+{
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::system_clock::now().time_since_epoch()).count();
+    std::string path = dir_ + "/" + prefix_ + std::to_string(ms) + suffix_;
+    // 同一毫秒内轮转两次时避免覆盖：时间戳顺延
+    while (path == path_) {
+        path = dir_ + "/" + prefix_ + std::to_string(++ms) + suffix_;
+    }
+
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        std::fprintf(stderr, "Failed to open %s: %s\n", path.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    path_ = path;
+    file_bytes_ = static_cast<uint64_t>(::lseek(fd_, 0, SEEK_END));
+    files_opened_++;
+    return true;
+}
+
+bool CaptureWriter::flush()
+{
+    if (buffer_.empty()) {
+        return true;
+    }
+
+    if (fd_ < 0 || (rotate_bytes_ && file_bytes_ > rotate_bytes_)) {
+        if (!open_next()) {
+            return false;
+        }
+    }
+
+    const char *p = buffer_.data();
+    size_t left = buffer_.size();
+    while (left) {
+        ssize_t n = ::write(fd_, p, left);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::fprintf(stderr, "Failed to write %s: %s\n", path_.c_str(), std::strerror(errno));
+            size_t written = buffer_.size() - left;
+            file_bytes_ += written;
+            total_bytes_ += written;
+            buffer_.erase(0, written);
+            return false;
+        }
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+
+    file_bytes_ += buffer_.size();
+    total_bytes_ += buffer_.size();
+    buffer_.clear();
+    return true;
+}
+
+}  // namespace csi
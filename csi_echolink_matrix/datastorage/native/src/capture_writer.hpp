@@ -0,0 +1,60 @@
+/**
+ * @file capture_writer.hpp
+ * @brief 带缓冲、按大小轮转的 csi_data_<ts>.txt 写入器
+ *
+ * 命名和轮转规则与 save_csidata.Udp_Server 一致：文件名为 csi_data_<毫秒时间戳>.txt，
+ * 当前文件超过 rotate_bytes 后新建文件。与 Python 版本不同的是文件只打开一次，
+ * 数据先累积在内存中，由调用方按批或按时间 flush，文件大小在内存中计数，不逐包 stat。
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace csi {
+
+class CaptureWriter {
+public:
+    /**
+     * @param dir 输出目录
+     * @param prefix 文件名前缀，默认与 save_csidata.py 一致
+     * @param suffix 文件名后缀（含点）
+     * @param rotate_bytes 当前文件超过该大小后在下次 flush 时新建文件，0 表示不轮转
+     */
+    CaptureWriter(std::string dir, uint64_t rotate_bytes,
+                  std::string prefix = "csi_data_", std::string suffix = ".txt");
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter &) = delete;
+    CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+    /** 待写入的缓冲区，调用方直接追加 */
+    std::string &buffer() { return buffer_; }
+
+    /**
+     * @brief 把缓冲区写入当前文件，必要时轮转
+     * @return 写入失败时返回 false，缓冲区保留
+     */
+    bool flush();
+
+    const std::string &path() const { return path_; }
+    uint64_t bytes_written() const { return total_bytes_; }
+    uint32_t files_opened() const { return files_opened_; }
+
+private:
+    bool open_next();
+
+    std::string dir_;
+    std::string prefix_;
+    std::string suffix_;
+    uint64_t rotate_bytes_;
+    std::string buffer_;
+    std::string path_;
+    int fd_ = -1;
+    uint64_t file_bytes_ = 0;
+    uint64_t total_bytes_ = 0;
+    uint32_t files_opened_ = 0;
+};
+
+}  // namespace csi
@@ -0,0 +1,363 @@
+#include "csi_denoise.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+/** MAD 换算为正态分布标准差的系数 */
+constexpr float kMadScale = 1.4826f;
+
+/**
+ * 一个通道的滑动中位数：窗口中的样本按槽位存放，较小的一半在大顶堆 lo、较大的一半在小顶堆 hi，
+ * lo 比 hi 多一个元素，中位数为 lo 的堆顶。堆中存槽位号，where[槽位] 记录它在堆中的位置
+ * （< lo_size 为 lo 的下标，否则减去 lo_size 为 hi 的下标），替换槽位的值只需调整一次堆。
+ */
+class MedianHeaps {
+public:
+    MedianHeaps(float *values, uint16_t *lo, uint16_t *hi, uint16_t *where, uint32_t window)
+        : v_(values), lo_(lo), hi_(hi), where_(where), lo_size_(window / 2 + 1), hi_size_(window / 2)
+    {
+    }
+
+    /** 所有槽位填为同一个值 */
+    void fill(float value)
+    {
+        for (uint32_t i = 0; i < lo_size_ + hi_size_; i++) {
+            v_[i] = value;
+            where_[i] = static_cast<uint16_t>(i);
+            if (i < lo_size_) {
+                lo_[i] = static_cast<uint16_t>(i);
+            } else {
+                hi_[i - lo_size_] = static_cast<uint16_t>(i);
+            }
+        }
+    }
+
+    void replace(uint32_t slot, float value)
+    {
+        float old = v_[slot];
+        v_[slot] = value;
+
+        uint32_t pos = where_[slot];
+        if (pos < lo_size_) {
+            if (value > old) {
+                lo_up(pos);
+            } else {
+                lo_down(pos);
+            }
+        } else {
+            if (value < old) {
+                hi_up(pos - lo_size_);
+            } else {
+                hi_down(pos - lo_size_);
+            }
+        }
+
+        // 只有一个值变化，至多交换一次堆顶即可恢复 lo <= hi
+        if (hi_size_ && v_[lo_[0]] > v_[hi_[0]]) {
+            std::swap(lo_[0], hi_[0]);
+            where_[lo_[0]] = 0;
+            where_[hi_[0]] = static_cast<uint16_t>(lo_size_);
+            lo_down(0);
+            hi_down(0);
+        }
+    }
+
+    float median() const { return v_[lo_[0]]; }
+
+private:
+    void lo_set(uint32_t i, uint16_t slot)
+    {
+        lo_[i] = slot;
+        where_[slot] = static_cast<uint16_t>(i);
+    }
+
+    void hi_set(uint32_t i, uint16_t slot)
+    {
+        hi_[i] = slot;
+        where_[slot] = static_cast<uint16_t>(lo_size_ + i);
+    }
+
+    void lo_up(uint32_t i)
+    {
+        uint16_t slot = lo_[i];
+        while (i > 0) {
+            uint32_t parent = (i - 1) / 2;
+            if (!(v_[slot] > v_[lo_[parent]])) {
+                break;
+            }
+            lo_set(i, lo_[parent]);
+            i = parent;
+        }
+        lo_set(i, slot);
+    }
+
+    void lo_down(uint32_t i)
+    {
+        uint16_t slot = lo_[i];
+        for (;;) {
+            uint32_t child = 2 * i + 1;
+            if (child >= lo_size_) {
+                break;
+            }
+            if (child + 1 < lo_size_ && v_[lo_[child + 1]] > v_[lo_[child]]) {
+                child++;
+            }
+            if (!(v_[lo_[child]] > v_[slot])) {
+                break;
+            }
+            lo_set(i, lo_[child]);
+            i = child;
+        }
+        lo_set(i, slot);
+    }
+
+    void hi_up(uint32_t i)
+    {
+        uint16_t slot = hi_[i];
+        while (i > 0) {
+            uint32_t parent = (i - 1) / 2;
+            if (!(v_[slot] < v_[hi_[parent]])) {
+                break;
+            }
+            hi_set(i, hi_[parent]);
+            i = parent;
+        }
+        hi_set(i, slot);
+    }
+
+    void hi_down(uint32_t i)
+    {
+        uint16_t slot = hi_[i];
+        for (;;) {
+            uint32_t child = 2 * i + 1;
+            if (child >= hi_size_) {
+                break;
+            }
+            if (child + 1 < hi_size_ && v_[hi_[child + 1]] < v_[hi_[child]]) {
+                child++;
+            }
+            if (!(v_[hi_[child]] < v_[slot])) {
+                break;
+            }
+            hi_set(i, hi_[child]);
+            i = child;
+        }
+        hi_set(i, slot);
+    }
+
+    float *v_;
+    uint16_t *lo_;
+    uint16_t *hi_;
+    uint16_t *where_;
+    uint32_t lo_size_;
+    uint32_t hi_size_;
+};
+
+/** 中心点平滑的 Savitzky-Golay 系数：最小二乘拟合 order 阶多项式后在窗口中心取值 */
+std::vector<float> savgol_coeffs(uint32_t window, uint32_t order)
+{
+    const int half = static_cast<int>(window / 2);
+    const uint32_t m = order + 1;
+
+    // 法方程 (A^T A) z = e0，A[i][j] = (i - half)^j；系数 c[i] = sum_j A[i][j] * z[j]
+    std::vector<double> g(m * (m + 1), 0.0);
+    for (uint32_t r = 0; r < m; r++) {
+        for (uint32_t c = 0; c < m; c++) {
+            double sum = 0.0;
+            for (int i = -half; i <= half; i++) {
+                sum += std::pow(static_cast<double>(i), static_cast<double>(r + c));
+            }
+            g[r * (m + 1) + c] = sum;
+        }
+        g[r * (m + 1) + m] = r == 0 ? 1.0 : 0.0;
+    }
+
+    // 高斯消元（部分主元）
+    for (uint32_t col = 0; col < m; col++) {
+        uint32_t pivot = col;
+        for (uint32_t r = col + 1; r < m; r++) {
+            if (std::fabs(g[r * (m + 1) + col]) > std::fabs(g[pivot * (m + 1) + col])) {
+                pivot = r;
+            }
+        }
+        for (uint32_t c = 0; c <= m; c++) {
+            std::swap(g[col * (m + 1) + c], g[pivot * (m + 1) + c]);
+        }
+        for (uint32_t r = 0; r < m; r++) {
+            if (r == col) {
+                continue;
+            }
+            double f = g[r * (m + 1) + col] / g[col * (m + 1) + col];
+            for (uint32_t c = col; c <= m; c++) {
+                g[r * (m + 1) + c] -= f * g[col * (m + 1) + c];
+            }
+        }
+    }
+
+    std::vector<float> coeffs(window);
+    for (int i = -half; i <= half; i++) {
+        double sum = 0.0;
+        for (uint32_t j = 0; j < m; j++) {
+            double z = g[j * (m + 1) + m] / g[j * (m + 1) + j];
+            sum += std::pow(static_cast<double>(i), static_cast<double>(j)) * z;
+        }
+        coeffs[i + half] = static_cast<float>(sum);
+    }
+    return coeffs;
+}
+
+}  // namespace
+
+struct csi_denoiser {
+    uint32_t n_channels;
+    uint32_t hampel_window;
+    uint32_t sg_window;
+    float threshold_scale;          // n_sigma * kMadScale
+    std::vector<float> sg;          // 卷积系数
+
+    // 每个通道一段，按通道连续存放
+    std::vector<float> values;      // Hampel 窗口，hampel_window 个槽位
+    std::vector<uint16_t> lo, hi, where;
+    std::vector<float> smooth;      // Savitzky-Golay 窗口（Hampel 的输出），sg_window 个
+    std::vector<float> scratch;     // MAD 计算用
+
+    uint32_t hampel_head = 0;       // 最旧样本的槽位，各通道相同
+    uint32_t sg_head = 0;
+    uint64_t frames = 0;            // 复位后输入的帧数
+};
+
+namespace {
+
+MedianHeaps heaps(csi_denoiser *d, uint32_t ch)
+{
+    const uint32_t hw = d->hampel_window;
+    return MedianHeaps(d->values.data() + ch * hw, d->lo.data() + ch * (hw / 2 + 1), d->hi.data() + ch * (hw / 2),
+                       d->where.data() + ch * hw, hw);
+}
+
+void prime(csi_denoiser *d, const float *frame)
+{
+    const uint32_t sw = d->sg_window;
+    for (uint32_t ch = 0; ch < d->n_channels; ch++) {
+        heaps(d, ch).fill(frame[ch]);
+        std::fill_n(d->smooth.data() + ch * sw, sw, frame[ch]);
+    }
+    d->hampel_head = 0;
+    d->sg_head = 0;
+}
+
+/** 一帧：各通道替换最旧样本，求窗口中心的 Hampel 输出，再求 Savitzky-Golay 窗口中心的输出 */
+void step(csi_denoiser *d, const float *in, float *out)
+{
+    const uint32_t hw = d->hampel_window;
+    const uint32_t sw = d->sg_window;
+    const uint32_t slot = d->hampel_head;
+    const uint32_t center = (slot + 1 + hw / 2) % hw;     // 写入后最旧为 slot + 1
+    float *scratch = d->scratch.data();
+
+    for (uint32_t ch = 0; ch < d->n_channels; ch++) {
+        const float *values = d->values.data() + ch * hw;
+        MedianHeaps median_heaps = heaps(d, ch);
+        median_heaps.replace(slot, in[ch]);
+
+        float x = values[center];
+        if (hw > 1) {
+            float median = median_heaps.median();
+            for (uint32_t i = 0; i < hw; i++) {
+                scratch[i] = std::fabs(values[i] - median);
+            }
+            std::nth_element(scratch, scratch + hw / 2, scratch + hw);
+            float mad = scratch[hw / 2];
+            if (std::fabs(x - median) > d->threshold_scale * mad) {
+                x = median;
+            }
+        }
+
+        float *smooth = d->smooth.data() + ch * sw;
+        smooth[d->sg_head] = x;
+        float y = 0.0f;
+        uint32_t j = (d->sg_head + 1) % sw;
+        for (uint32_t k = 0; k < sw; k++) {
+            y += d->sg[k] * smooth[j];
+            j = j + 1 == sw ? 0 : j + 1;
+        }
+        if (out) {
+            out[ch] = y;
+        }
+    }
+
+    d->hampel_head = (slot + 1) % hw;
+    d->sg_head = (d->sg_head + 1) % sw;
+}
+
+}  // namespace
+
+extern "C" {
+
+csi_denoiser_t *csi_denoiser_new(uint32_t n_channels, uint32_t hampel_window, float n_sigma,
+                                 uint32_t sg_window, uint32_t sg_order)
+{
+    // 堆中以 uint16_t 存槽位号
+    if (n_channels == 0 || hampel_window % 2 == 0 || hampel_window > 0xFFFF || sg_window % 2 == 0 ||
+        (sg_window > 1 && sg_order >= sg_window) || !(n_sigma >= 0.0f)) {
+        return nullptr;
+    }
+
+    auto *d = new csi_denoiser;
+    d->n_channels = n_channels;
+    d->hampel_window = hampel_window;
+    d->sg_window = sg_window;
+    d->threshold_scale = n_sigma * kMadScale;
+    d->sg = sg_window > 1 ? savgol_coeffs(sg_window, sg_order) : std::vector<float>{1.0f};
+    d->values.resize(size_t(n_channels) * hampel_window);
+    d->lo.resize(size_t(n_channels) * (hampel_window / 2 + 1));
+    d->hi.resize(size_t(n_channels) * (hampel_window / 2));
+    d->where.resize(size_t(n_channels) * hampel_window);
+    d->smooth.resize(size_t(n_channels) * sg_window);
+    d->scratch.resize(hampel_window);
+    return d;
+}
+
+void csi_denoiser_free(csi_denoiser_t *denoiser)
+{
+    delete denoiser;
+}
+
+void csi_denoiser_reset(csi_denoiser_t *denoiser)
+{
+    denoiser->frames = 0;
+}
+
+uint32_t csi_denoiser_delay(const csi_denoiser_t *denoiser)
+{
+    return denoiser->hampel_window / 2 + denoiser->sg_window / 2;
+}
+
+void csi_denoiser_sg_coeffs(const csi_denoiser_t *denoiser, float *coeffs)
+{
+    std::copy(denoiser->sg.begin(), denoiser->sg.end(), coeffs);
+}
+
+size_t csi_denoiser_push(csi_denoiser_t *denoiser, const float *in, size_t n_frames, float *out)
+{
+    const uint64_t delay = csi_denoiser_delay(denoiser);
+    size_t written = 0;
+
+    for (size_t f = 0; f < n_frames; f++) {
+        const float *frame = in + f * denoiser->n_channels;
+        if (denoiser->frames == 0) {
+            prime(denoiser, frame);
+        }
+        // 前 delay 帧的输出对应复位之前（填充）的帧，不输出
+        bool ready = denoiser->frames >= delay;
+        step(denoiser, frame, ready ? out + written * denoiser->n_channels : nullptr);
+        written += ready;
+        denoiser->frames++;
+    }
+    return written;
+}
+
+}  // extern "C"
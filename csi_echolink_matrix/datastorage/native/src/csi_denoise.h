@@ -0,0 +1,71 @@
+/**
+ * @file csi_denoise.h
+ * @brief 流式 CSI 去噪：逐子载波沿时间做 Hampel 去离群点 + Savitzky-Golay 平滑（C 接口，编译进 libcsi_native）
+ *
+ * 每个通道（子载波）一份状态：
+ * - Hampel：长度 hampel_window 的滑动窗口，中位数用双堆（大顶堆 + 小顶堆）维护，新样本替换最旧样本
+ *   为 O(log w)；MAD 在窗口副本上做一次选择，为 O(w)。|x - 中位数| > n_sigma * 1.4826 * MAD 时
+ *   用中位数代替 x（与 hampel 包的 hampel(data, window_size, n_sigma) 相同）；
+ * - Savitzky-Golay：初始化时求出中心点的卷积系数，每帧为一次长度 sg_window 的点积。
+ * 窗口长度固定，因此每帧每通道的代价是常数，与已处理的帧数无关。
+ *
+ * 两个窗口都以中心点为输出，输出比输入晚 csi_denoiser_delay() 帧；复位后的第一帧会填满两个窗口
+ * （相当于该帧在之前一直重复），因此从第 delay 帧起每输入一帧就输出一帧。
+ *
+ * 用法：
+ *   csi_denoiser_t *d = csi_denoiser_new(64, 7, 5.0f, 5, 3);
+ *   size_t n = csi_denoiser_push(d, in, n_frames, out);    // out 按 n_frames * n_channels 分配
+ *   csi_denoiser_free(d);
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#define CSI_DENOISE_API __declspec(dllexport)
+#else
+#define CSI_DENOISE_API __attribute__((visibility("default")))
+#endif
+
+typedef struct csi_denoiser csi_denoiser_t;
+
+/**
+ * @brief 创建去噪器
+ *
+ * @param n_channels 通道数（每帧的子载波数）
+ * @param hampel_window Hampel 窗口长度，奇数；1 表示不做 Hampel
+ * @param n_sigma Hampel 阈值（MAD 标准差的倍数）
+ * @param sg_window Savitzky-Golay 窗口长度，奇数且大于 sg_order；1 表示不平滑
+ * @param sg_order Savitzky-Golay 多项式阶数
+ * @return 参数非法时返回 NULL
+ */
+CSI_DENOISE_API csi_denoiser_t *csi_denoiser_new(uint32_t n_channels, uint32_t hampel_window, float n_sigma,
+                                                 uint32_t sg_window, uint32_t sg_order);
+CSI_DENOISE_API void csi_denoiser_free(csi_denoiser_t *denoiser);
+
+/** 丢弃所有历史，下一帧重新填充窗口 */
+CSI_DENOISE_API void csi_denoiser_reset(csi_denoiser_t *denoiser);
+
+/** 输出相对输入的延迟帧数：hampel_window / 2 + sg_window / 2 */
+CSI_DENOISE_API uint32_t csi_denoiser_delay(const csi_denoiser_t *denoiser);
+
+/** Savitzky-Golay 卷积系数（sg_window 个），窗口中最旧的样本在前 */
+CSI_DENOISE_API void csi_denoiser_sg_coeffs(const csi_denoiser_t *denoiser, float *coeffs);
+
+/**
+ * @brief 输入若干帧，输出已经可以确定的帧
+ *
+ * @param in n_frames * n_channels 个幅度（或其他有限的实数），按帧连续存放
+ * @param out 至少 n_frames * n_channels 个 float
+ * @return 写入 out 的帧数，第 i 帧对应 delay 帧之前的输入
+ */
+CSI_DENOISE_API size_t csi_denoiser_push(csi_denoiser_t *denoiser, const float *in, size_t n_frames, float *out);
+
+#ifdef __cplusplus
+}
+#endif
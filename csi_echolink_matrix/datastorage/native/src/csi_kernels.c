@@ -0,0 +1,232 @@
+#include "csi_kernels_impl.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "csi_codec.h"
+
+/* ---------------------------------------------------------------- 标量实现 */
+
+static void scalar_amp_phase(const int8_t *iq, size_t count, float *amplitude, float *phase)
+{
+    for (size_t i = 0; i < count; i++) {
+        float y = iq[2 * i];
+        float x = iq[2 * i + 1];
+        if (amplitude) {
+            amplitude[i] = sqrtf(x * x + y * y);
+        }
+        if (phase) {
+            phase[i] = csi_atan2_scalar(y, x);
+        }
+    }
+}
+
+static void scalar_unwrap_wraps(const float *in, size_t n, float *wraps)
+{
+    for (size_t k = 1; k < n; k++) {
+        wraps[k] = nearbyintf((in[k] - in[k - 1]) * CSI_INV_2PI_F);
+    }
+}
+
+static void scalar_unwrap_apply(const float *in, const float *turns, size_t n, float *out)
+{
+    for (size_t k = 0; k < n; k++) {
+        out[k] = in[k] - turns[k] * CSI_2PI_F;
+    }
+}
+
+static void scalar_fit_sums(const float *p, const float *x, size_t n, float sp[8], float sxp[8])
+{
+    memset(sp, 0, 8 * sizeof(float));
+    memset(sxp, 0, 8 * sizeof(float));
+    for (size_t k = 0; k < n; k++) {
+        sp[k % 8] += p[k];
+        sxp[k % 8] += x[k] * p[k];
+    }
+}
+
+static void scalar_remove_line(float *p, const float *x, size_t n, float a, float b)
+{
+    for (size_t k = 0; k < n; k++) {
+        p[k] = p[k] - (a * x[k] + b);
+    }
+}
+
+const csi_kernel_ops_t csi_kernel_ops_scalar = {
+    .amp_phase = scalar_amp_phase,
+    .unwrap_wraps = scalar_unwrap_wraps,
+    .unwrap_apply = scalar_unwrap_apply,
+    .fit_sums = scalar_fit_sums,
+    .remove_line = scalar_remove_line,
+    .codec_reconstruct = csi_codec_reconstruct,
+};
+
+/* ---------------------------------------------------------------- 运行时选择 */
+
+static const csi_kernel_ops_t *s_ops;
+static csi_kernel_isa_t s_isa = CSI_KERNEL_ISA_SCALAR;
+
+static csi_kernel_isa_t cpu_max_isa(void)
+{
+#if defined(CSI_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return CSI_KERNEL_ISA_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return CSI_KERNEL_ISA_SSE41;
+    }
+#endif
+    return CSI_KERNEL_ISA_SCALAR;
+}
+
+static csi_kernel_isa_t env_max_isa(void)
+{
+    const char *env = getenv("CSI_KERNEL_ISA");
+    if (!env || !*env || strcmp(env, "avx2") == 0) {
+        return CSI_KERNEL_ISA_AVX2;
+    }
+    if (strcmp(env, "sse41") == 0) {
+        return CSI_KERNEL_ISA_SSE41;
+    }
+    return CSI_KERNEL_ISA_SCALAR;
+}
+
+csi_kernel_isa_t csi_kernel_set_isa(csi_kernel_isa_t isa)
+{
+    csi_kernel_isa_t max = cpu_max_isa();
+    if (isa > max) {
+        isa = max;
+    }
+
+    switch (isa) {
+#if defined(CSI_KERNELS_X86)
+    case CSI_KERNEL_ISA_AVX2:
+        s_ops = &csi_kernel_ops_avx2;
+        break;
+    case CSI_KERNEL_ISA_SSE41:
+        s_ops = &csi_kernel_ops_sse41;
+        break;
+#endif
+    default:
+        isa = CSI_KERNEL_ISA_SCALAR;
+        s_ops = &csi_kernel_ops_scalar;
+        break;
+    }
+
+    s_isa = isa;
+    return isa;
+}
+
+static const csi_kernel_ops_t *ops(void)
+{
+    // 首次调用时选择，多线程同时初始化的结果相同
+    if (!s_ops) {
+        csi_kernel_set_isa(env_max_isa());
+    }
+    return s_ops;
+}
+
+csi_kernel_isa_t csi_kernel_get_isa(void)
+{
+    ops();
+    return s_isa;
+}
+
+/* ---------------------------------------------------------------- 公共流程 */
+
+void csi_iq_to_amp_phase(const int8_t *iq, size_t count, float *amplitude, float *phase)
+{
+    if (count && (amplitude || phase)) {
+        ops()->amp_phase(iq, count, amplitude, phase);
+    }
+}
+
+static void unwrap_row(const csi_kernel_ops_t *o, const float *in, size_t n, float *out)
+{
+    float turns[CSI_KERNEL_MAX_SUBCARRIERS];
+
+    if (n == 0) {
+        return;
+    }
+
+    // 每个子载波相对第一个子载波累计的整圈数（整数，求和顺序不影响结果）
+    o->unwrap_wraps(in, n, turns);
+    turns[0] = 0.0f;
+    for (size_t k = 1; k < n; k++) {
+        turns[k] = turns[k - 1] + turns[k];
+    }
+    o->unwrap_apply(in, turns, n, out);
+}
+
+int csi_phase_unwrap(const float *phase, size_t n_frames, size_t n_sub, float *out)
+{
+    if (n_sub > CSI_KERNEL_MAX_SUBCARRIERS) {
+        return -1;
+    }
+
+    const csi_kernel_ops_t *o = ops();
+    for (size_t f = 0; f < n_frames; f++) {
+        unwrap_row(o, phase + f * n_sub, n_sub, out + f * n_sub);
+    }
+    return 0;
+}
+
+int csi_phase_sanitize(const float *phase, size_t n_frames, size_t stride,
+                       const uint32_t *positions, const float *x, size_t n_valid,
+                       float *out)
+{
+    if (n_valid < 2 || n_valid > CSI_KERNEL_MAX_SUBCARRIERS) {
+        return -1;
+    }
+    for (size_t k = 0; k < n_valid; k++) {
+        if (positions[k] >= stride) {
+            return -1;
+        }
+    }
+
+    // 自变量的和只与 x 有关，用标量实现计算，各指令集共用
+    float lanes_x[8], lanes_xx[8];
+    scalar_fit_sums(x, x, n_valid, lanes_x, lanes_xx);
+    float n = (float)n_valid;
+    float sx = csi_reduce8(lanes_x);
+    float sxx = csi_reduce8(lanes_xx);
+    float det = n * sxx - sx * sx;
+    if (det == 0.0f) {
+        return -1;
+    }
+
+    const csi_kernel_ops_t *o = ops();
+    for (size_t f = 0; f < n_frames; f++) {
+        const float *row = phase + f * stride;
+        float *dst = out + f * n_valid;
+
+        for (size_t k = 0; k < n_valid; k++) {
+            dst[k] = row[positions[k]];
+        }
+        unwrap_row(o, dst, n_valid, dst);
+
+        float lanes_p[8], lanes_xp[8];
+        o->fit_sums(dst, x, n_valid, lanes_p, lanes_xp);
+        float sp = csi_reduce8(lanes_p);
+        float sxp = csi_reduce8(lanes_xp);
+        float a = (n * sxp - sx * sp) / det;
+        float b = (sp - a * sx) / n;
+        o->remove_line(dst, x, n_valid, a, b);
+    }
+    return 0;
+}
+
+size_t csi_iq_unpack(const uint8_t *data, size_t len, int8_t *iq, size_t iq_size)
+{
+    uint8_t zz[CSI_CODEC_PADDED(CSI_FRAME_MAX_PAYLOAD)];
+    const csi_codec_hdr_t *hdr = csi_codec_check(data, len);
+    size_t n = hdr ? CSI_CODEC_RAW_LEN(hdr->info) : 0;
+
+    if (!hdr || n > iq_size || !csi_codec_unpack(data + sizeof(*hdr), len - sizeof(*hdr), n, zz)) {
+        return 0;
+    }
+
+    ops()->codec_reconstruct(zz, n, CSI_CODEC_QUANT(hdr->info), iq);
+    return n;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file csi_kernels.h
+ * @brief CSI 子载波处理内核：幅度/相位、相位解缠绕、线性相位偏移消除（C 接口，编译进 libcsi_native）
+ *
+ * I/Q 为 ESP-IDF 的 int8 排列：每个子载波两个字节，虚部在前、实部在后。
+ * 每个内核都有标量实现和 SSE4.1 / AVX2 实现，运行时按 CPU 选择；各实现使用相同的运算顺序
+ * （同一个 atan 多项式、按 8 路分组的求和、不做 FMA 合并），因此结果逐位一致，
+ * 由 tests/csi_kernels_test.c 校验。
+ *
+ * 相位使用多项式近似的 atan2，最大绝对误差约 1e-6 rad。
+ *
+ * 压缩帧（CSI_FRAME_TYPE_PACKED）的 I/Q 解码也在这里：位平面展开与 components/csi_codec 共用，
+ * 差分还原和反量化有 SIMD 实现，结果与 csi_codec 的标量解码逐字节一致。
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#define CSI_KERNEL_API __declspec(dllexport)
+#else
+#define CSI_KERNEL_API __attribute__((visibility("default")))
+#endif
+
+/** 解缠绕/相位校正一次处理的最大子载波数 */
+#define CSI_KERNEL_MAX_SUBCARRIERS  512
+
+typedef enum {
+    CSI_KERNEL_ISA_SCALAR = 0,
+    CSI_KERNEL_ISA_SSE41  = 1,
+    CSI_KERNEL_ISA_AVX2   = 2,
+} csi_kernel_isa_t;
+
+/**
+ * @brief 选择内核实现
+ *
+ * 默认使用 CPU 支持的最高指令集；环境变量 CSI_KERNEL_ISA=scalar|sse41|avx2 可以限制上限。
+ * @param isa 期望的实现，CPU 不支持时降级
+ * @return 实际使用的实现
+ */
+CSI_KERNEL_API csi_kernel_isa_t csi_kernel_set_isa(csi_kernel_isa_t isa);
+
+/** 当前使用的实现 */
+CSI_KERNEL_API csi_kernel_isa_t csi_kernel_get_isa(void);
+
+/**
+ * @brief int8 I/Q 批量转换为幅度和相位
+ *
+ * 多帧 I/Q 连续存放时可以作为一个整体传入，count 为子载波总数。
+ * @param iq 2 * count 个 int8（虚部、实部交替）
+ * @param amplitude count 个 float，sqrt(I^2 + Q^2)，可为 NULL
+ * @param phase count 个 float，atan2(虚部, 实部)，范围 [-pi, pi]，可为 NULL
+ */
+CSI_KERNEL_API void csi_iq_to_amp_phase(const int8_t *iq, size_t count, float *amplitude, float *phase);
+
+/**
+ * @brief 沿子载波方向解缠绕相位：相邻子载波的相位差超过 pi 时加减 2*pi
+ *
+ * @param phase n_frames 行，每行 n_sub 个相位
+ * @param out 同样大小的输出，可以与 phase 相同
+ * @return 0 成功，-1 参数非法（n_sub 超过 CSI_KERNEL_MAX_SUBCARRIERS）
+ */
+CSI_KERNEL_API int csi_phase_unwrap(const float *phase, size_t n_frames, size_t n_sub, float *out);
+
+/**
+ * @brief 相位校正：取出有效子载波，解缠绕后减去最小二乘拟合的直线 a * x + b
+ *
+ * 消除采样时间偏移（斜率）和载波相位偏移（常数项）。
+ * @param phase n_frames 行，每行 stride 个相位（csi_iq_to_amp_phase 的输出）
+ * @param positions n_valid 个有效子载波在行中的下标（如 csi_vaid_subcarrier_index），按频率顺序排列
+ * @param x n_valid 个子载波频率编号（如 LLTF 的 -26..26），作为拟合的自变量
+ * @param out n_frames 行，每行 n_valid 个校正后的相位
+ * @return 0 成功，-1 参数非法（n_valid 小于 2、超过 CSI_KERNEL_MAX_SUBCARRIERS、下标越界或 x 全相同）
+ */
+CSI_KERNEL_API int csi_phase_sanitize(const float *phase, size_t n_frames, size_t stride,
+                                      const uint32_t *positions, const float *x, size_t n_valid,
+                                      float *out);
+
+/**
+ * @brief 解码 CSI_FRAME_TYPE_PACKED 帧的数据区（csi_codec_hdr_t + 编码后的 I/Q）
+ *
+ * @param data 帧的数据区，len 为帧头中的 len
+ * @param iq 至少 iq_size 字节
+ * @return 解码后的 I/Q 字节数，数据非法或超过 iq_size 时返回 0
+ */
+CSI_KERNEL_API size_t csi_iq_unpack(const uint8_t *data, size_t len, int8_t *iq, size_t iq_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,172 @@
+/**
+ * AVX2 实现：每次处理 8 个子载波，尾部交给标量实现（与标量逐条对应，结果逐位一致）。
+ * 本文件单独以 -mavx2 编译，只在 CPU 支持 AVX2 时被调用。
+ */
+#include "csi_kernels_impl.h"
+
+#include <immintrin.h>
+#include <string.h>
+
+static inline __m256 atan2_avx2(__m256 y, __m256 x)
+{
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    __m256 ax = _mm256_andnot_ps(sign, x);
+    __m256 ay = _mm256_andnot_ps(sign, y);
+    __m256 gt = _mm256_cmp_ps(ax, ay, _CMP_GT_OQ);
+    __m256 mx = _mm256_blendv_ps(ay, ax, gt);
+    __m256 mn = _mm256_blendv_ps(ax, ay, gt);
+    __m256 den = _mm256_blendv_ps(mx, one, _mm256_cmp_ps(mx, zero, _CMP_EQ_OQ));
+    __m256 a = _mm256_div_ps(mn, den);
+    __m256 s = _mm256_mul_ps(a, a);
+
+    __m256 p = _mm256_set1_ps(CSI_ATAN_C8);
+    p = _mm256_add_ps(_mm256_mul_ps(p, s), _mm256_set1_ps(CSI_ATAN_C7));
+    p = _mm256_add_ps(_mm256_mul_ps(p, s), _mm256_set1_ps(CSI_ATAN_C6));
+    p = _mm256_add_ps(_mm256_mul_ps(p, s), _mm256_set1_ps(CSI_ATAN_C5));
+    p = _mm256_add_ps(_mm256_mul_ps(p, s), _mm256_set1_ps(CSI_ATAN_C4));
+    p = _mm256_add_ps(_mm256_mul_ps(p, s), _mm256_set1_ps(CSI_ATAN_C3));
+    p = _mm256_add_ps(_mm256_mul_ps(p, s), _mm256_set1_ps(CSI_ATAN_C2));
+    p = _mm256_add_ps(_mm256_mul_ps(p, s), _mm256_set1_ps(CSI_ATAN_C1));
+    p = _mm256_add_ps(_mm256_mul_ps(p, s), _mm256_set1_ps(CSI_ATAN_C0));
+    __m256 r = _mm256_mul_ps(p, a);
+
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(CSI_PI_2_F), r), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(CSI_PI_F), r), _mm256_cmp_ps(x, zero, _CMP_LT_OQ));
+    return _mm256_or_ps(r, _mm256_and_ps(y, sign));
+}
+
+static void avx2_amp_phase(const int8_t *iq, size_t count, float *amplitude, float *phase)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // 16 个 int8 扩展为 16 个 int16，每个 32 位通道低半为虚部、高半为实部
+        __m256i v = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(iq + 2 * i)));
+        __m256 y = _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16));
+        __m256 x = _mm256_cvtepi32_ps(_mm256_srai_epi32(v, 16));
+
+        if (amplitude) {
+            __m256 sq = _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y));
+            _mm256_storeu_ps(amplitude + i, _mm256_sqrt_ps(sq));
+        }
+        if (phase) {
+            _mm256_storeu_ps(phase + i, atan2_avx2(y, x));
+        }
+    }
+
+    if (i < count) {
+        csi_kernel_ops_scalar.amp_phase(iq + 2 * i, count - i, amplitude ? amplitude + i : NULL,
+                                        phase ? phase + i : NULL);
+    }
+}
+
+static void avx2_unwrap_wraps(const float *in, size_t n, float *wraps)
+{
+    const __m256 inv_2pi = _mm256_set1_ps(CSI_INV_2PI_F);
+    size_t k = 1;
+    for (; k + 8 <= n; k += 8) {
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(in + k), _mm256_loadu_ps(in + k - 1));
+        __m256 w = _mm256_round_ps(_mm256_mul_ps(d, inv_2pi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm256_storeu_ps(wraps + k, w);
+    }
+    for (; k < n; k++) {
+        wraps[k] = nearbyintf((in[k] - in[k - 1]) * CSI_INV_2PI_F);
+    }
+}
+
+static void avx2_unwrap_apply(const float *in, const float *turns, size_t n, float *out)
+{
+    const __m256 two_pi = _mm256_set1_ps(CSI_2PI_F);
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256 v = _mm256_sub_ps(_mm256_loadu_ps(in + k), _mm256_mul_ps(_mm256_loadu_ps(turns + k), two_pi));
+        _mm256_storeu_ps(out + k, v);
+    }
+    csi_kernel_ops_scalar.unwrap_apply(in + k, turns + k, n - k, out + k);
+}
+
+static void avx2_fit_sums(const float *p, const float *x, size_t n, float sp[8], float sxp[8])
+{
+    __m256 acc_p = _mm256_setzero_ps();
+    __m256 acc_xp = _mm256_setzero_ps();
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256 vp = _mm256_loadu_ps(p + k);
+        acc_p = _mm256_add_ps(acc_p, vp);
+        acc_xp = _mm256_add_ps(acc_xp, _mm256_mul_ps(_mm256_loadu_ps(x + k), vp));
+    }
+    _mm256_storeu_ps(sp, acc_p);
+    _mm256_storeu_ps(sxp, acc_xp);
+
+    // 尾部第 j 个元素累加到第 j 路，与标量实现的 k % 8 一致
+    for (size_t j = 0; k < n; k++, j++) {
+        sp[j] += p[k];
+        sxp[j] += x[k] * p[k];
+    }
+}
+
+static void avx2_remove_line(float *p, const float *x, size_t n, float a, float b)
+{
+    const __m256 va = _mm256_set1_ps(a);
+    const __m256 vb = _mm256_set1_ps(b);
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256 line = _mm256_add_ps(_mm256_mul_ps(va, _mm256_loadu_ps(x + k)), vb);
+        _mm256_storeu_ps(p + k, _mm256_sub_ps(_mm256_loadu_ps(p + k), line));
+    }
+    csi_kernel_ops_scalar.remove_line(p + k, x + k, n - k, a, b);
+}
+
+/**
+ * 32 个 zigzag 差值，做法同 SSE4.1 实现；移位相加只在 128 位通道内进行，
+ * 低通道最后一对的累计值再加到高通道
+ */
+static inline __m256i codec_block_avx2(__m256i u, __m256i *carry)
+{
+    const __m256i last_pair = _mm256_setr_epi8(14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15,
+                                               14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15);
+    __m256i sign = _mm256_sub_epi8(_mm256_setzero_si256(), _mm256_and_si256(u, _mm256_set1_epi8(1)));
+    __m256i r = _mm256_xor_si256(_mm256_and_si256(_mm256_srli_epi16(u, 1), _mm256_set1_epi8(0x7F)), sign);
+
+    r = _mm256_add_epi8(r, _mm256_slli_si256(r, 2));
+    r = _mm256_add_epi8(r, _mm256_slli_si256(r, 4));
+    r = _mm256_add_epi8(r, _mm256_slli_si256(r, 8));
+    __m256i lane_last = _mm256_shuffle_epi8(r, last_pair);
+    r = _mm256_add_epi8(r, _mm256_permute2x128_si256(lane_last, lane_last, 0x08)); // 低通道清零，高通道取低通道
+    r = _mm256_add_epi8(r, *carry);
+    lane_last = _mm256_shuffle_epi8(r, last_pair);
+    *carry = _mm256_permute2x128_si256(lane_last, lane_last, 0x11);                // 两个通道都取高通道
+    return r;
+}
+
+static void avx2_codec_reconstruct(const uint8_t *zz, size_t n, unsigned quant, int8_t *iq)
+{
+    const __m128i count = _mm_cvtsi32_si128((int)quant);
+    const __m256i mask = _mm256_set1_epi8((char)(0xFF << quant));
+    __m256i carry = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = codec_block_avx2(_mm256_loadu_si256((const __m256i *)(zz + i)), &carry);
+        _mm256_storeu_si256((__m256i *)(iq + i), _mm256_and_si256(_mm256_sll_epi16(v, count), mask));
+    }
+
+    if (i < n) {
+        uint8_t tail[32] = {0};
+        memcpy(tail, zz + i, n - i);
+        __m256i v = codec_block_avx2(_mm256_loadu_si256((const __m256i *)tail), &carry);
+        _mm256_storeu_si256((__m256i *)tail, _mm256_and_si256(_mm256_sll_epi16(v, count), mask));
+        memcpy(iq + i, tail, n - i);
+    }
+}
+
+const csi_kernel_ops_t csi_kernel_ops_avx2 = {
+    .amp_phase = avx2_amp_phase,
+    .unwrap_wraps = avx2_unwrap_wraps,
+    .unwrap_apply = avx2_unwrap_apply,
+    .fit_sums = avx2_fit_sums,
+    .remove_line = avx2_remove_line,
+    .codec_reconstruct = avx2_codec_reconstruct,
+};
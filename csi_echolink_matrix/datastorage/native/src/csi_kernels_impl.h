@@ -0,0 +1,86 @@
+/**
+ * @file csi_kernels_impl.h
+ * @brief csi_kernels 各指令集实现共用的常量、标量函数和函数表（内部头文件）
+ *
+ * 逐位一致的约定：
+ * - atan2 使用同一个多项式，按相同顺序做乘、加（编译时 -ffp-contract=off，不生成 FMA）；
+ * - 求和按 8 路分组：第 k 个元素累加到第 k % 8 路，最后用 csi_reduce8 的固定顺序合并；
+ * - 解缠绕的 2*pi 计数是整数，前缀和在公共代码中按顺序计算；
+ * - I/Q 解码是 8 位整数运算，前缀和按 8 位回绕，与计算顺序无关。
+ */
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "csi_kernels.h"
+
+#define CSI_PI_F        3.14159265358979323846f
+#define CSI_PI_2_F      1.57079632679489661923f
+#define CSI_2PI_F       6.28318530717958647692f
+#define CSI_INV_2PI_F   0.15915494309189533577f
+
+/* atan(a) = a * P(a^2)，a ∈ [0, 1]，Abramowitz & Stegun 4.4.49，|误差| <= 2e-8 */
+#define CSI_ATAN_C0     1.0f
+#define CSI_ATAN_C1    -0.3333314528f
+#define CSI_ATAN_C2     0.1999355085f
+#define CSI_ATAN_C3    -0.1420889944f
+#define CSI_ATAN_C4     0.1065626393f
+#define CSI_ATAN_C5    -0.0752896400f
+#define CSI_ATAN_C6     0.0429096138f
+#define CSI_ATAN_C7    -0.0161657367f
+#define CSI_ATAN_C8     0.0028662257f
+
+/** 标量 atan2，SIMD 实现逐条对应 */
+static inline float csi_atan2_scalar(float y, float x)
+{
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    float mx = ax > ay ? ax : ay;
+    float mn = ax > ay ? ay : ax;
+    float a = mn / (mx == 0.0f ? 1.0f : mx);
+    float s = a * a;
+
+    float p = CSI_ATAN_C8;
+    p = p * s + CSI_ATAN_C7;
+    p = p * s + CSI_ATAN_C6;
+    p = p * s + CSI_ATAN_C5;
+    p = p * s + CSI_ATAN_C4;
+    p = p * s + CSI_ATAN_C3;
+    p = p * s + CSI_ATAN_C2;
+    p = p * s + CSI_ATAN_C1;
+    p = p * s + CSI_ATAN_C0;
+    float r = p * a;
+
+    r = ay > ax ? CSI_PI_2_F - r : r;
+    r = x < 0.0f ? CSI_PI_F - r : r;
+    return copysignf(r, y);
+}
+
+/** 8 路部分和的固定合并顺序 */
+static inline float csi_reduce8(const float v[8])
+{
+    return ((v[0] + v[4]) + (v[2] + v[6])) + ((v[1] + v[5]) + (v[3] + v[7]));
+}
+
+typedef struct {
+    /** 幅度和相位，amplitude/phase 可为 NULL */
+    void (*amp_phase)(const int8_t *iq, size_t count, float *amplitude, float *phase);
+    /** wraps[k] = round((in[k] - in[k-1]) / 2pi)，k = 1..n-1 */
+    void (*unwrap_wraps)(const float *in, size_t n, float *wraps);
+    /** out[k] = in[k] - turns[k] * 2pi */
+    void (*unwrap_apply)(const float *in, const float *turns, size_t n, float *out);
+    /** 8 路分组的 sum(p) 与 sum(x * p) */
+    void (*fit_sums)(const float *p, const float *x, size_t n, float sp[8], float sxp[8]);
+    /** p[k] -= a * x[k] + b */
+    void (*remove_line)(float *p, const float *x, size_t n, float a, float b);
+    /** csi_codec 解码的第二步：zigzag 还原、步长 2 的前缀和（按 8 位回绕）、左移 quant 位 */
+    void (*codec_reconstruct)(const uint8_t *zz, size_t n, unsigned quant, int8_t *iq);
+} csi_kernel_ops_t;
+
+extern const csi_kernel_ops_t csi_kernel_ops_scalar;
+#if defined(CSI_KERNELS_X86)
+extern const csi_kernel_ops_t csi_kernel_ops_sse41;
+extern const csi_kernel_ops_t csi_kernel_ops_avx2;
+#endif
@@ -0,0 +1,175 @@
+/**
+ * SSE4.1 实现：每次处理 4 个子载波，求和用两个寄存器对应 8 路分组，尾部交给标量实现。
+ * 本文件单独以 -msse4.1 编译，只在 CPU 支持 SSE4.1 时被调用。
+ */
+#include "csi_kernels_impl.h"
+
+#include <smmintrin.h>
+#include <string.h>
+
+static inline __m128 atan2_sse41(__m128 y, __m128 x)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    __m128 ax = _mm_andnot_ps(sign, x);
+    __m128 ay = _mm_andnot_ps(sign, y);
+    __m128 gt = _mm_cmpgt_ps(ax, ay);
+    __m128 mx = _mm_blendv_ps(ay, ax, gt);
+    __m128 mn = _mm_blendv_ps(ax, ay, gt);
+    __m128 den = _mm_blendv_ps(mx, one, _mm_cmpeq_ps(mx, zero));
+    __m128 a = _mm_div_ps(mn, den);
+    __m128 s = _mm_mul_ps(a, a);
+
+    __m128 p = _mm_set1_ps(CSI_ATAN_C8);
+    p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(CSI_ATAN_C7));
+    p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(CSI_ATAN_C6));
+    p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(CSI_ATAN_C5));
+    p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(CSI_ATAN_C4));
+    p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(CSI_ATAN_C3));
+    p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(CSI_ATAN_C2));
+    p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(CSI_ATAN_C1));
+    p = _mm_add_ps(_mm_mul_ps(p, s), _mm_set1_ps(CSI_ATAN_C0));
+    __m128 r = _mm_mul_ps(p, a);
+
+    r = _mm_blendv_ps(r, _mm_sub_ps(_mm_set1_ps(CSI_PI_2_F), r), _mm_cmpgt_ps(ay, ax));
+    r = _mm_blendv_ps(r, _mm_sub_ps(_mm_set1_ps(CSI_PI_F), r), _mm_cmplt_ps(x, zero));
+    return _mm_or_ps(r, _mm_and_ps(y, sign));
+}
+
+static void sse41_amp_phase(const int8_t *iq, size_t count, float *amplitude, float *phase)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // 8 个 int8 扩展为 8 个 int16，每个 32 位通道低半为虚部、高半为实部
+        __m128i v = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(iq + 2 * i)));
+        __m128 y = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(v, 16), 16));
+        __m128 x = _mm_cvtepi32_ps(_mm_srai_epi32(v, 16));
+
+        if (amplitude) {
+            __m128 sq = _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y));
+            _mm_storeu_ps(amplitude + i, _mm_sqrt_ps(sq));
+        }
+        if (phase) {
+            _mm_storeu_ps(phase + i, atan2_sse41(y, x));
+        }
+    }
+
+    if (i < count) {
+        csi_kernel_ops_scalar.amp_phase(iq + 2 * i, count - i, amplitude ? amplitude + i : NULL,
+                                        phase ? phase + i : NULL);
+    }
+}
+
+static void sse41_unwrap_wraps(const float *in, size_t n, float *wraps)
+{
+    const __m128 inv_2pi = _mm_set1_ps(CSI_INV_2PI_F);
+    size_t k = 1;
+    for (; k + 4 <= n; k += 4) {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(in + k), _mm_loadu_ps(in + k - 1));
+        __m128 w = _mm_round_ps(_mm_mul_ps(d, inv_2pi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_ps(wraps + k, w);
+    }
+    for (; k < n; k++) {
+        wraps[k] = nearbyintf((in[k] - in[k - 1]) * CSI_INV_2PI_F);
+    }
+}
+
+static void sse41_unwrap_apply(const float *in, const float *turns, size_t n, float *out)
+{
+    const __m128 two_pi = _mm_set1_ps(CSI_2PI_F);
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m128 v = _mm_sub_ps(_mm_loadu_ps(in + k), _mm_mul_ps(_mm_loadu_ps(turns + k), two_pi));
+        _mm_storeu_ps(out + k, v);
+    }
+    csi_kernel_ops_scalar.unwrap_apply(in + k, turns + k, n - k, out + k);
+}
+
+static void sse41_fit_sums(const float *p, const float *x, size_t n, float sp[8], float sxp[8])
+{
+    // lo 为第 0..3 路，hi 为第 4..7 路
+    __m128 p_lo = _mm_setzero_ps(), p_hi = _mm_setzero_ps();
+    __m128 xp_lo = _mm_setzero_ps(), xp_hi = _mm_setzero_ps();
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m128 vp_lo = _mm_loadu_ps(p + k);
+        __m128 vp_hi = _mm_loadu_ps(p + k + 4);
+        p_lo = _mm_add_ps(p_lo, vp_lo);
+        p_hi = _mm_add_ps(p_hi, vp_hi);
+        xp_lo = _mm_add_ps(xp_lo, _mm_mul_ps(_mm_loadu_ps(x + k), vp_lo));
+        xp_hi = _mm_add_ps(xp_hi, _mm_mul_ps(_mm_loadu_ps(x + k + 4), vp_hi));
+    }
+    _mm_storeu_ps(sp, p_lo);
+    _mm_storeu_ps(sp + 4, p_hi);
+    _mm_storeu_ps(sxp, xp_lo);
+    _mm_storeu_ps(sxp + 4, xp_hi);
+
+    // 尾部第 j 个元素累加到第 j 路，与标量实现的 k % 8 一致
+    for (size_t j = 0; k < n; k++, j++) {
+        sp[j] += p[k];
+        sxp[j] += x[k] * p[k];
+    }
+}
+
+static void sse41_remove_line(float *p, const float *x, size_t n, float a, float b)
+{
+    const __m128 va = _mm_set1_ps(a);
+    const __m128 vb = _mm_set1_ps(b);
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m128 line = _mm_add_ps(_mm_mul_ps(va, _mm_loadu_ps(x + k)), vb);
+        _mm_storeu_ps(p + k, _mm_sub_ps(_mm_loadu_ps(p + k), line));
+    }
+    csi_kernel_ops_scalar.remove_line(p + k, x + k, n - k, a, b);
+}
+
+/**
+ * 16 个 zigzag 差值：还原为有符号差值，块内做步长 2 的前缀和（3 次移位相加），
+ * 再加上前一块最后一对的累计值；*carry 更新为本块最后一对的累计值（广播到每一对）
+ */
+static inline __m128i codec_block_sse41(__m128i u, __m128i *carry)
+{
+    const __m128i last_pair = _mm_setr_epi8(14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15);
+    __m128i sign = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(u, _mm_set1_epi8(1)));
+    __m128i r = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(u, 1), _mm_set1_epi8(0x7F)), sign);
+
+    r = _mm_add_epi8(r, _mm_slli_si128(r, 2));
+    r = _mm_add_epi8(r, _mm_slli_si128(r, 4));
+    r = _mm_add_epi8(r, _mm_slli_si128(r, 8));
+    r = _mm_add_epi8(r, *carry);
+    *carry = _mm_shuffle_epi8(r, last_pair);
+    return r;
+}
+
+static void sse41_codec_reconstruct(const uint8_t *zz, size_t n, unsigned quant, int8_t *iq)
+{
+    // 没有 8 位移位指令：按 16 位左移后清除从低字节移入的位
+    const __m128i count = _mm_cvtsi32_si128((int)quant);
+    const __m128i mask = _mm_set1_epi8((char)(0xFF << quant));
+    __m128i carry = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = codec_block_sse41(_mm_loadu_si128((const __m128i *)(zz + i)), &carry);
+        _mm_storeu_si128((__m128i *)(iq + i), _mm_and_si128(_mm_sll_epi16(v, count), mask));
+    }
+
+    if (i < n) {
+        uint8_t tail[16] = {0};
+        memcpy(tail, zz + i, n - i);
+        __m128i v = codec_block_sse41(_mm_loadu_si128((const __m128i *)tail), &carry);
+        _mm_storeu_si128((__m128i *)tail, _mm_and_si128(_mm_sll_epi16(v, count), mask));
+        memcpy(iq + i, tail, n - i);
+    }
+}
+
+const csi_kernel_ops_t csi_kernel_ops_sse41 = {
+    .amp_phase = sse41_amp_phase,
+    .unwrap_wraps = sse41_unwrap_wraps,
+    .unwrap_apply = sse41_unwrap_apply,
+    .fit_sums = sse41_fit_sums,
+    .remove_line = sse41_remove_line,
+    .codec_reconstruct = sse41_codec_reconstruct,
+};
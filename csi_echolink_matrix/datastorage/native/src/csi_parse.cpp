@@ -0,0 +1,369 @@
+#include "csi_parse.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <vector>
+
+#include "csi_frame.h"
+#include "csi_kernels.h"
+
+static_assert(sizeof(csi_record_t) == 72, "csi_record_t must match csi_frame.CSI_RECORD_DTYPE");
+
+struct csi_parser {
+    std::vector<csi_record_t> records;
+    std::vector<int8_t> iq;             // 所有帧的 I/Q 首尾相接
+    std::vector<size_t> iq_offset;      // 每帧 I/Q 在 iq 中的起始位置
+    std::vector<uint32_t> source;
+    uint32_t max_len = 0;
+    uint64_t errors = 0;
+};
+
+namespace {
+
+constexpr char kTextPrefix[] = "CSI_DATA";
+constexpr size_t kTextPrefixLen = sizeof(kTextPrefix) - 1;
+
+/** 文本行中的一个逗号分隔字段解析器，游标越界或格式错误后所有读取均失败 */
+class LineCursor {
+public:
+    LineCursor(const char *begin, const char *end) : pos_(begin), end_(end) {}
+
+    bool ok() const { return ok_; }
+
+    /** 跳过一个字段（含逗号） */
+    void skip_field()
+    {
+        const char *comma = static_cast<const char *>(std::memchr(pos_, ',', end_ - pos_));
+        if (!comma) {
+            ok_ = false;
+            return;
+        }
+        pos_ = comma + 1;
+    }
+
+    template <typename T>
+    T integer()
+    {
+        long long value = 0;
+        skip_spaces();
+        auto [ptr, ec] = std::from_chars(pos_, end_, value);
+        if (ec != std::errc() || !expect_comma(ptr)) {
+            ok_ = false;
+            return 0;
+        }
+        return static_cast<T>(value);
+    }
+
+    void mac(uint8_t out[6])
+    {
+        skip_spaces();
+        for (int i = 0; i < 6; i++) {
+            unsigned value = 0;
+            auto [ptr, ec] = std::from_chars(pos_, end_, value, 16);
+            if (ec != std::errc() || value > 0xFF || ptr == end_ || *ptr != (i < 5 ? ':' : ',')) {
+                ok_ = false;
+                return;
+            }
+            out[i] = static_cast<uint8_t>(value);
+            pos_ = ptr + 1;
+        }
+    }
+
+    /** 最后一个字段 "[v,v,...]"（引号可省略），数值追加到 out，返回个数 */
+    size_t values(std::vector<int8_t> &out)
+    {
+        skip_spaces();
+        if (pos_ < end_ && *pos_ == '"') {
+            pos_++;
+        }
+        if (pos_ >= end_ || *pos_ != '[') {
+            ok_ = false;
+            return 0;
+        }
+        pos_++;
+
+        size_t count = 0;
+        while (true) {
+            skip_spaces();
+            if (pos_ < end_ && *pos_ == ']') {
+                return count;
+            }
+
+            long value = 0;
+            auto [ptr, ec] = std::from_chars(pos_, end_, value);
+            if (ec != std::errc()) {
+                ok_ = false;
+                return count;
+            }
+            pos_ = ptr;
+            // 兼容 "1.0" 形式的数值：截断小数部分
+            if (pos_ < end_ && *pos_ == '.') {
+                do {
+                    pos_++;
+                } while (pos_ < end_ && *pos_ >= '0' && *pos_ <= '9');
+            }
+            out.push_back(static_cast<int8_t>(value));
+            count++;
+
+            skip_spaces();
+            if (pos_ < end_ && *pos_ == ',') {
+                pos_++;
+            } else if (pos_ >= end_ || *pos_ != ']') {
+                ok_ = false;
+                return count;
+            }
+        }
+    }
+
+private:
+    void skip_spaces()
+    {
+        while (pos_ < end_ && *pos_ == ' ') {
+            pos_++;
+        }
+    }
+
+    bool expect_comma(const char *ptr)
+    {
+        while (ptr < end_ && *ptr == ' ') {
+            ptr++;
+        }
+        if (ptr >= end_ || *ptr != ',') {
+            return false;
+        }
+        pos_ = ptr + 1;
+        return true;
+    }
+
+    const char *pos_;
+    const char *end_;
+    bool ok_ = true;
+};
+
+void push_frame(csi_parser &p, const csi_record_t &record, uint32_t source)
+{
+    p.records.push_back(record);
+    p.source.push_back(source);
+    p.max_len = std::max<uint32_t>(p.max_len, record.len);
+}
+
+void parse_binary(csi_parser &p, const uint8_t *buf, size_t size, int64_t time_us, uint32_t source)
+{
+    csi_frame_iter_t it;
+    csi_frame_iter_init(&it, buf, size);
+
+    size_t frames = 0;
+    for (const csi_frame_hdr_t *hdr; (hdr = csi_frame_iter_next(&it)) != nullptr; frames++) {
+        csi_record_t r{};
+        r.time_us = time_us;
+        r.id = hdr->seq;
+        r.local_timestamp = hdr->local_timestamp;
+        std::memcpy(r.mac, hdr->mac, 6);
+        std::memcpy(r.probe_mac, hdr->probe_mac, 6);
+        r.rssi = hdr->rssi;
+        r.rate = hdr->rate;
+        r.sig_mode = hdr->sig_mode;
+        r.mcs = hdr->mcs;
+        r.bandwidth = hdr->cwb;
+        r.smoothing = hdr->smoothing;
+        r.not_sounding = hdr->not_sounding;
+        r.aggregation = hdr->aggregation;
+        r.stbc = hdr->stbc;
+        r.fec_coding = hdr->fec_coding;
+        r.sgi = hdr->sgi;
+        r.noise_floor = hdr->noise_floor;
+        r.ampdu_cnt = hdr->ampdu_cnt;
+        r.channel = hdr->channel;
+        r.secondary_channel = hdr->secondary_channel;
+        r.ant = hdr->ant;
+        r.rx_state = hdr->rx_state;
+        r.first_word = hdr->first_word_invalid;
+        r.sig_len = hdr->sig_len;
+        r.len = hdr->len;
+        r.tx = csi_frame_tx(hdr, &r.tx_seq);
+        r.sync_us = csi_frame_sync(hdr, &r.drift_ppb, &r.sync_err_us);
+
+        const uint8_t *data = reinterpret_cast<const uint8_t *>(hdr) + hdr->hdr_len;
+        size_t start = p.iq.size();
+        if (hdr->type == CSI_FRAME_TYPE_PACKED) {
+            // 压缩帧：len 为数据区长度，解码后的 I/Q 长度见 csi_codec_hdr_t
+            p.iq.resize(start + CSI_FRAME_MAX_PAYLOAD);
+            size_t n = csi_iq_unpack(data, hdr->len, p.iq.data() + start, CSI_FRAME_MAX_PAYLOAD);
+            p.iq.resize(start + n);
+            if (n == 0) {
+                p.errors++;
+                continue;
+            }
+            r.len = static_cast<uint16_t>(n);
+        } else {
+            p.iq.insert(p.iq.end(), data, data + hdr->len);
+        }
+        p.iq_offset.push_back(start);
+        push_frame(p, r, source);
+    }
+
+    if (frames == 0) {
+        p.errors++;
+    }
+}
+
+/** 解析一行 "CSI_DATA,..."，字段顺序与 CSI_DATA_COLUMNS_NAMES 一致 */
+bool parse_line(csi_parser &p, const char *begin, const char *end, int64_t time_us, uint32_t source)
+{
+    LineCursor c(begin, end);
+    csi_record_t r{};
+    r.time_us = time_us;
+
+    c.skip_field();                     // type
+    r.id = c.integer<uint32_t>();
+    c.mac(r.mac);
+    r.rssi = c.integer<int8_t>();
+    r.rate = c.integer<uint8_t>();
+    r.sig_mode = c.integer<uint8_t>();
+    r.mcs = c.integer<uint8_t>();
+    r.bandwidth = c.integer<uint8_t>();
+    r.smoothing = c.integer<uint8_t>();
+    r.not_sounding = c.integer<uint8_t>();
+    r.aggregation = c.integer<uint8_t>();
+    r.stbc = c.integer<uint8_t>();
+    r.fec_coding = c.integer<uint8_t>();
+    r.sgi = c.integer<uint8_t>();
+    r.noise_floor = c.integer<int8_t>();
+    r.ampdu_cnt = c.integer<uint8_t>();
+    r.channel = c.integer<uint8_t>();
+    r.secondary_channel = c.integer<uint8_t>();
+    r.local_timestamp = c.integer<uint32_t>();
+    r.ant = c.integer<uint8_t>();
+    r.sig_len = c.integer<uint16_t>();
+    r.rx_state = c.integer<uint8_t>();
+    c.integer<uint16_t>();              // len：以实际数值个数为准
+    r.first_word = c.integer<uint8_t>();
+
+    size_t start = p.iq.size();
+    size_t count = c.values(p.iq);
+    if (!c.ok() || count > UINT16_MAX) {
+        p.iq.resize(start);
+        return false;
+    }
+
+    r.len = static_cast<uint16_t>(count);
+    r.tx_seq = r.id;
+    p.iq_offset.push_back(start);
+    push_frame(p, r, source);
+    return true;
+}
+
+void parse_text(csi_parser &p, const uint8_t *buf, size_t size, int64_t time_us, uint32_t source)
+{
+    const char *pos = reinterpret_cast<const char *>(buf);
+    const char *end = pos + size;
+
+    while (pos < end) {
+        const char *eol = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+        const char *line_end = eol ? eol : end;
+        while (line_end > pos && (line_end[-1] == '\r' || line_end[-1] == ' ')) {
+            line_end--;
+        }
+
+        // 只解析 CSI_DATA 行，其他文本（表头、日志）忽略
+        if (static_cast<size_t>(line_end - pos) > kTextPrefixLen
+                && std::memcmp(pos, kTextPrefix, kTextPrefixLen) == 0
+                && !parse_line(p, pos, line_end, time_us, source)) {
+            p.errors++;
+        }
+
+        pos = eol ? eol + 1 : end;
+    }
+}
+
+}  // namespace
+
+extern "C" {
+
+csi_parser_t *csi_parser_new(void)
+{
+    return new (std::nothrow) csi_parser;
+}
+
+void csi_parser_free(csi_parser_t *parser)
+{
+    delete parser;
+}
+
+size_t csi_parser_parse(csi_parser_t *parser, const uint8_t *buf, const uint64_t *offsets,
+                        size_t count, const int64_t *time_us)
+{
+    csi_parser &p = *parser;
+    p.records.clear();
+    p.iq.clear();
+    p.iq_offset.clear();
+    p.source.clear();
+    p.max_len = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *data = buf + offsets[i];
+        size_t size = static_cast<size_t>(offsets[i + 1] - offsets[i]);
+        int64_t t = time_us ? time_us[i] : 0;
+        if (size == 0) {
+            continue;
+        }
+
+        if (data[0] == CSI_FRAME_MAGIC) {
+            parse_binary(p, data, size, t, static_cast<uint32_t>(i));
+        } else {
+            parse_text(p, data, size, t, static_cast<uint32_t>(i));
+        }
+    }
+
+    return p.records.size();
+}
+
+uint32_t csi_parser_max_len(const csi_parser_t *parser)
+{
+    return parser->max_len;
+}
+
+uint64_t csi_parser_errors(const csi_parser_t *parser)
+{
+    return parser->errors;
+}
+
+void csi_parser_export(const csi_parser_t *parser, csi_record_t *records,
+                       float *csi, uint32_t n_sub, int8_t *iq, uint32_t iq_width,
+                       uint32_t *source)
+{
+    const csi_parser &p = *parser;
+    size_t frames = p.records.size();
+
+    if (records) {
+        std::memcpy(records, p.records.data(), frames * sizeof(csi_record_t));
+    }
+    if (source) {
+        std::memcpy(source, p.source.data(), frames * sizeof(uint32_t));
+    }
+
+    for (size_t f = 0; f < frames; f++) {
+        const int8_t *data = p.iq.data() + p.iq_offset[f];
+        uint32_t len = p.records[f].len;
+
+        if (csi) {
+            float *row = csi + f * n_sub * 2;
+            uint32_t pairs = std::min(n_sub, len / 2);
+            for (uint32_t k = 0; k < pairs; k++) {
+                row[2 * k] = data[2 * k + 1];
+                row[2 * k + 1] = data[2 * k];
+            }
+            std::fill(row + 2 * pairs, row + 2 * n_sub, 0.0f);
+        }
+
+        if (iq) {
+            int8_t *row = iq + f * iq_width;
+            uint32_t n = std::min(iq_width, len);
+            std::memcpy(row, data, n);
+            std::memset(row + n, 0, iq_width - n);
+        }
+    }
+}
+
+}  // extern "C"
@@ -0,0 +1,106 @@
+/**
+ * @file csi_parse.h
+ * @brief 主机侧 CSI 批量解析（C 接口，编译为 libcsi_native，由 datastorage/csi_native.py 通过 ctypes 调用）
+ *
+ * 一次调用解析一批数据报：二进制帧、聚合容器或 "CSI_DATA,..." 文本（一个缓冲区中可以有多行，
+ * 因此整个 csi_data_*.txt 也可以作为一个"数据报"传入）。压缩帧在解析时解码（csi_iq_unpack），
+ * 记录中的 len 为解码后的 I/Q 字节数。结果为定长元数据记录和 I/Q，
+ * 导出时可同时得到 complex64 CSI（子载波 k = data[2k+1] + j*data[2k]，与 ESP-IDF 的虚部在前一致）
+ * 和原始 int8 I/Q。
+ *
+ * 用法：
+ *   csi_parser_t *p = csi_parser_new();
+ *   size_t n = csi_parser_parse(p, buf, offsets, count, time_us);     // 数据报 i 为 buf[offsets[i], offsets[i+1])
+ *   csi_parser_export(p, records, csi, n_sub, iq, iq_width, source);   // 调用方按 n 和 csi_parser_max_len 分配
+ *   csi_parser_free(p);
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#define CSI_PARSE_API __declspec(dllexport)
+#else
+#define CSI_PARSE_API __attribute__((visibility("default")))
+#endif
+
+/**
+ * 每帧一条定长记录，字段按自然对齐恰好无填充；与 csi_frame.CSI_RECORD_DTYPE
+ * （也是 .csic 采集文件的记录格式）逐字节一致
+ */
+typedef struct {
+    int64_t  time_us;           /*!< 主机接收时间（Unix 微秒），由调用方传入 */
+    uint32_t id;                /*!< 帧序号 */
+    uint32_t local_timestamp;
+    uint8_t  mac[6];            /*!< 发送端 MAC */
+    uint8_t  probe_mac[6];      /*!< 采集的 AirProbe MAC，CSV 文本中没有该字段，为全 0 */
+    int8_t   rssi;
+    uint8_t  rate;
+    uint8_t  sig_mode;
+    uint8_t  mcs;
+    uint8_t  bandwidth;
+    uint8_t  smoothing;
+    uint8_t  not_sounding;
+    uint8_t  aggregation;
+    uint8_t  stbc;
+    uint8_t  fec_coding;
+    uint8_t  sgi;
+    int8_t   noise_floor;
+    uint8_t  ampdu_cnt;
+    uint8_t  channel;
+    uint8_t  secondary_channel;
+    uint8_t  ant;
+    uint8_t  rx_state;
+    uint8_t  first_word;
+    uint16_t sig_len;
+    uint16_t len;               /*!< I/Q 字节数 */
+    uint8_t  tx;                /*!< 激励源下标，CSV 文本中为 0 */
+    uint8_t  reserved;
+    uint32_t tx_seq;            /*!< 激励源内的帧序号，CSV 文本中与 id 相同 */
+    int64_t  sync_us;           /*!< 参考时钟下的接收时间（微秒），未同步或 CSV 文本中为 0 */
+    int32_t  drift_ppb;
+    uint32_t sync_err_us;
+} csi_record_t;
+
+typedef struct csi_parser csi_parser_t;
+
+CSI_PARSE_API csi_parser_t *csi_parser_new(void);
+CSI_PARSE_API void csi_parser_free(csi_parser_t *parser);
+
+/**
+ * @brief 解析一批数据报，替换上一次的结果（内部缓冲区重复使用）
+ *
+ * @param buf 所有数据报首尾相接
+ * @param offsets count + 1 个偏移，数据报 i 为 buf[offsets[i], offsets[i + 1])
+ * @param time_us 每个数据报的接收时间，可为 NULL（记为 0）
+ * @return 解析出的帧数
+ */
+CSI_PARSE_API size_t csi_parser_parse(csi_parser_t *parser, const uint8_t *buf, const uint64_t *offsets,
+                                      size_t count, const int64_t *time_us);
+
+/** 上一次解析中最长的 I/Q 字节数 */
+CSI_PARSE_API uint32_t csi_parser_max_len(const csi_parser_t *parser);
+
+/** 累计无法解析的数据报（二进制）或 CSI_DATA 行（文本） */
+CSI_PARSE_API uint64_t csi_parser_errors(const csi_parser_t *parser);
+
+/**
+ * @brief 导出上一次解析的结果，输出数组均按帧数分配，不需要的输出传 NULL
+ *
+ * @param records 帧数个记录
+ * @param csi 帧数 * n_sub 个 complex64（实部、虚部交替的 float），超出 I/Q 长度的子载波为 0
+ * @param iq 帧数 * iq_width 个 int8，超出 I/Q 长度的部分为 0
+ * @param source 每帧所在数据报的下标
+ */
+CSI_PARSE_API void csi_parser_export(const csi_parser_t *parser, csi_record_t *records,
+                                     float *csi, uint32_t n_sub, int8_t *iq, uint32_t iq_width,
+                                     uint32_t *source);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,421 @@
+/**
+ * @file csi_recvd.cpp
+ * @brief CSI 数据接收守护进程（Linux），替代 save_csidata.py 的 Udp_Server
+ *
+ * - recvmmsg 一次取一批数据报，SO_RCVBUF 默认 8 MiB，内核丢包数通过 SO_RXQ_OVFL 读出；
+ * - 二进制帧按 probe_mac、CSV 文本按发送端地址统计序号（丢失/重复/乱序/重启、空洞长度分布），
+ *   二进制帧另按内核接收时间戳（SO_TIMESTAMP）与帧头 local_timestamp 估计到达抖动；
+ * - AirProbe 开启 FEC 时按探针恢复每组中丢失的一个聚合数据报，恢复的帧与收到的帧一样写入文件，
+ *   在序号统计中计为乱序（迟到）而不是丢失；
+ * - 输出 csi_data_<ts>.txt，内容与 save_csidata.py 写出的 "CSI_DATA,..." 行一致，
+ *   数据先累积在内存中，每批或每秒写一次，按大小轮转；
+ * - 可选加入组播组（AIRSIGHT_MCAST_REPUBLISH）或向 AirSight 订阅并续约。
+ *
+ * 用法：
+ *   csi_recvd [--port 4444] [--bind 0.0.0.0] [--dir .] [--rotate-bytes 1048576]
+ *             [--rcvbuf 8388608] [--stats 10] [--multicast 239.10.11.12]
+ *             [--airsight 192.168.99.1[:3334] [--probe aa:bb:cc:dd:ee:ff]... [--lease 30]]
+ */
+#include <arpa/inet.h>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "capture_writer.hpp"
+#include "csi_ctrl.h"
+#include "csi_frame.h"
+#include "csi_text.hpp"
+#include "fec_receiver.hpp"
+#include "seq_tracker.hpp"
+
+namespace {
+
+constexpr unsigned kBatch = 64;                     // 每次 recvmmsg 最多取的数据报数
+constexpr size_t kDatagramSize = 2048;              // 大于 CSI_DATAGRAM_MAX_SIZE 和 CSV 文本长度
+constexpr size_t kFlushBytes = 256 * 1024;          // 缓冲区超过该大小立即写盘
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void on_signal(int)
+{
+    g_stop = 1;
+}
+
+struct Options {
+    std::string bind_ip = "0.0.0.0";
+    uint16_t port = 4444;
+    std::string dir = ".";
+    uint64_t rotate_bytes = 1024 * 1024;            // 与 save_csidata.py 的 file_size_limit 一致
+    int rcvbuf = 8 * 1024 * 1024;
+    int stats_interval_s = 10;
+    std::string multicast_group;
+    std::string airsight_host;
+    uint16_t airsight_port = 3334;
+    std::vector<std::array<uint8_t, 6>> probe_macs;
+    uint16_t lease_s = 30;
+};
+
+struct Counters {
+    uint64_t datagrams = 0;
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+    uint64_t truncated = 0;
+    uint64_t batches = 0;
+    uint64_t recovered = 0;                         // FEC 恢复的数据报
+    uint32_t kernel_drops = 0;                      // SO_RXQ_OVFL，内核累计值
+};
+
+void usage(const char *prog)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--port N] [--bind IP] [--dir DIR] [--rotate-bytes N] [--rcvbuf N]\n"
+                 "          [--stats SECONDS] [--multicast GROUP]\n"
+                 "          [--airsight HOST[:PORT] [--probe MAC]... [--lease SECONDS]]\n",
+                 prog);
+}
+
+bool parse_mac(const char *text, std::array<uint8_t, 6> &mac)
+{
+    unsigned v[6];
+    if (std::sscanf(text, "%2x:%2x:%2x:%2x:%2x:%2x", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 6) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) {
+        mac[i] = static_cast<uint8_t>(v[i]);
+    }
+    return true;
+}
+
+bool parse_options(int argc, char **argv, Options &opt)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "-h" || arg == "--help" || !value) {
+            return false;
+        }
+        i++;
+
+        if (arg == "--port") {
+            opt.port = static_cast<uint16_t>(std::atoi(value));
+        } else if (arg == "--bind") {
+            opt.bind_ip = value;
+        } else if (arg == "--dir") {
+            opt.dir = value;
+        } else if (arg == "--rotate-bytes") {
+            opt.rotate_bytes = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--rcvbuf") {
+            opt.rcvbuf = std::atoi(value);
+        } else if (arg == "--stats") {
+            opt.stats_interval_s = std::atoi(value);
+        } else if (arg == "--multicast") {
+            opt.multicast_group = value;
+        } else if (arg == "--airsight") {
+            std::string host = value;
+            size_t colon = host.find(':');
+            if (colon != std::string::npos) {
+                opt.airsight_port = static_cast<uint16_t>(std::atoi(host.c_str() + colon + 1));
+                host.resize(colon);
+            }
+            opt.airsight_host = host;
+        } else if (arg == "--probe") {
+            std::array<uint8_t, 6> mac;
+            if (!parse_mac(value, mac)) {
+                std::fprintf(stderr, "Invalid MAC: %s\n", value);
+                return false;
+            }
+            opt.probe_macs.push_back(mac);
+        } else if (arg == "--lease") {
+            opt.lease_s = static_cast<uint16_t>(std::atoi(value));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int open_data_socket(const Options &opt)
+{
+    int sock = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        std::perror("socket");
+        return -1;
+    }
+
+    int one = 1;
+    ::setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    ::setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one));
+    ::setsockopt(sock, SOL_SOCKET, SO_TIMESTAMP, &one, sizeof(one));
+
+    // SO_RCVBUF 受 net.core.rmem_max 限制，SO_RCVBUFFORCE 需要 CAP_NET_ADMIN，先试后者
+    if (::setsockopt(sock, SOL_SOCKET, SO_RCVBUFFORCE, &opt.rcvbuf, sizeof(opt.rcvbuf)) < 0) {
+        ::setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &opt.rcvbuf, sizeof(opt.rcvbuf));
+    }
+    int actual = 0;
+    socklen_t len = sizeof(actual);
+    ::getsockopt(sock, SOL_SOCKET, SO_RCVBUF, &actual, &len);
+    if (actual < opt.rcvbuf) {
+        std::fprintf(stderr, "SO_RCVBUF is %d bytes (requested %d), raise net.core.rmem_max\n",
+                     actual, opt.rcvbuf);
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(opt.port);
+    if (::inet_pton(AF_INET, opt.bind_ip.c_str(), &addr.sin_addr) != 1
+            || ::bind(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        std::fprintf(stderr, "Failed to bind %s:%d: %s\n", opt.bind_ip.c_str(), opt.port, std::strerror(errno));
+        ::close(sock);
+        return -1;
+    }
+
+    if (!opt.multicast_group.empty()) {
+        ip_mreq mreq{};
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (::inet_pton(AF_INET, opt.multicast_group.c_str(), &mreq.imr_multiaddr) != 1
+                || ::setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            std::fprintf(stderr, "Failed to join %s: %s\n", opt.multicast_group.c_str(), std::strerror(errno));
+            ::close(sock);
+            return -1;
+        }
+    }
+
+    return sock;
+}
+
+// 向 AirSight 发送 SUBSCRIBE（见 csi_ctrl.h），应答在主循环中读取并丢弃
+void send_subscribe(int ctrl_sock, const sockaddr_in &airsight, const Options &opt)
+{
+    std::vector<uint8_t> msg(sizeof(csi_ctrl_hdr_t) + sizeof(csi_ctrl_subscribe_t) + 6 * opt.probe_macs.size());
+    csi_ctrl_hdr_t hdr;
+    csi_ctrl_hdr_init(&hdr, CSI_CTRL_TYPE_SUBSCRIBE);
+    hdr.count = static_cast<uint8_t>(opt.probe_macs.size());
+    hdr.len = static_cast<uint16_t>(msg.size() - sizeof(hdr));
+    std::memcpy(msg.data(), &hdr, sizeof(hdr));
+
+    csi_ctrl_subscribe_t sub = {opt.port, opt.lease_s};
+    std::memcpy(msg.data() + sizeof(hdr), &sub, sizeof(sub));
+    for (size_t i = 0; i < opt.probe_macs.size(); i++) {
+        std::memcpy(msg.data() + sizeof(hdr) + sizeof(sub) + 6 * i, opt.probe_macs[i].data(), 6);
+    }
+
+    if (::sendto(ctrl_sock, msg.data(), msg.size(), 0, reinterpret_cast<const sockaddr *>(&airsight),
+                 sizeof(airsight)) < 0) {
+        std::fprintf(stderr, "Subscribe to %s failed: %s\n", opt.airsight_host.c_str(), std::strerror(errno));
+    }
+}
+
+// 处理一个数据报：统计序号并把文本行追加到写缓冲区
+// arrival_us 为内核收到该数据报的时刻（没有时间戳时为 0），同一个聚合容器中的帧到达时刻相同
+void handle_datagram(const uint8_t *buf, size_t len, const sockaddr_in &from, uint64_t arrival_us,
+                     csi::SeqTracker &tracker, csi::CaptureWriter &writer, Counters &counters)
+{
+    if (len && buf[0] == CSI_FRAME_MAGIC) {
+        csi_frame_iter_t it;
+        csi_frame_iter_init(&it, buf, len);
+        for (const csi_frame_hdr_t *hdr; (hdr = csi_frame_iter_next(&it)) != nullptr;) {
+            csi::SourceKey key = csi::SourceKey::probe(hdr->probe_mac);
+            if (arrival_us) {
+                tracker.on_frame(key, hdr->seq, hdr->local_timestamp, arrival_us);
+            } else {
+                tracker.on_frame(key, hdr->seq);
+            }
+        }
+    } else if (len > 9 && std::memcmp(buf, "CSI_DATA,", 9) == 0) {
+        // CSV 文本的第二列为序号
+        tracker.on_frame(csi::SourceKey::address(from.sin_addr.s_addr, from.sin_port),
+                         static_cast<uint32_t>(std::strtoul(reinterpret_cast<const char *>(buf) + 9, nullptr, 10)));
+    }
+
+    counters.frames += csi::append_datagram_text(writer.buffer(), buf, len);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int sock = open_data_socket(opt);
+    if (sock < 0) {
+        return 1;
+    }
+
+    int ctrl_sock = -1;
+    sockaddr_in airsight{};
+    if (!opt.airsight_host.empty()) {
+        airsight.sin_family = AF_INET;
+        airsight.sin_port = htons(opt.airsight_port);
+        if (::inet_pton(AF_INET, opt.airsight_host.c_str(), &airsight.sin_addr) != 1) {
+            std::fprintf(stderr, "Invalid AirSight address: %s\n", opt.airsight_host.c_str());
+            return 2;
+        }
+        ctrl_sock = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (ctrl_sock < 0) {
+            std::perror("socket");
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    csi::CaptureWriter writer(opt.dir, opt.rotate_bytes);
+    csi::SeqTracker tracker;
+    csi::FecReceiver fec;
+    Counters counters;
+
+    // recvmmsg 的接收缓冲区只分配一次
+    std::vector<uint8_t> storage(kBatch * kDatagramSize);
+    std::vector<sockaddr_in> addrs(kBatch);
+    std::vector<iovec> iovs(kBatch);
+    std::vector<mmsghdr> msgs(kBatch);
+    std::vector<std::array<uint8_t, CMSG_SPACE(sizeof(uint32_t)) + CMSG_SPACE(sizeof(timeval))>> cmsgs(kBatch);
+    for (unsigned i = 0; i < kBatch; i++) {
+        iovs[i] = {storage.data() + i * kDatagramSize, kDatagramSize};
+    }
+
+    using clock = std::chrono::steady_clock;
+    auto last_flush = clock::now();
+    auto last_stats = clock::now();
+    auto next_subscribe = clock::now();
+    Counters last_counters;
+
+    std::fprintf(stderr, "csi_recvd listening on %s:%d, writing to %s\n",
+                 opt.bind_ip.c_str(), opt.port, opt.dir.c_str());
+
+    while (!g_stop) {
+        auto now = clock::now();
+        if (ctrl_sock >= 0 && now >= next_subscribe) {
+            send_subscribe(ctrl_sock, airsight, opt);
+            next_subscribe = now + std::chrono::seconds(opt.lease_s > 3 ? opt.lease_s / 3 : 1);
+        }
+
+        pollfd fds[2] = {{sock, POLLIN, 0}, {ctrl_sock, POLLIN, 0}};
+        int ready = ::poll(fds, ctrl_sock >= 0 ? 2 : 1, 1000);
+        if (ready < 0 && errno != EINTR) {
+            std::perror("poll");
+            break;
+        }
+
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            // 一次唤醒取完所有待处理的数据报
+            while (true) {
+                for (unsigned i = 0; i < kBatch; i++) {
+                    msgs[i].msg_hdr = {};
+                    msgs[i].msg_hdr.msg_name = &addrs[i];
+                    msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+                    msgs[i].msg_hdr.msg_iov = &iovs[i];
+                    msgs[i].msg_hdr.msg_iovlen = 1;
+                    msgs[i].msg_hdr.msg_control = cmsgs[i].data();
+                    msgs[i].msg_hdr.msg_controllen = cmsgs[i].size();
+                }
+
+                int n = ::recvmmsg(sock, msgs.data(), kBatch, MSG_DONTWAIT, nullptr);
+                if (n <= 0) {
+                    break;
+                }
+                counters.batches++;
+
+                for (int i = 0; i < n; i++) {
+                    const msghdr &mh = msgs[i].msg_hdr;
+                    counters.datagrams++;
+                    counters.bytes += msgs[i].msg_len;
+
+                    uint64_t arrival_us = 0;
+                    for (cmsghdr *c = CMSG_FIRSTHDR(&mh); c; c = CMSG_NXTHDR(const_cast<msghdr *>(&mh), c)) {
+                        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_RXQ_OVFL) {
+                            std::memcpy(&counters.kernel_drops, CMSG_DATA(c), sizeof(uint32_t));
+                        } else if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMP) {
+                            timeval tv;
+                            std::memcpy(&tv, CMSG_DATA(c), sizeof(tv));
+                            arrival_us = static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+                        }
+                    }
+
+                    if (mh.msg_flags & MSG_TRUNC) {
+                        counters.truncated++;
+                        continue;
+                    }
+                    const uint8_t *buf = static_cast<const uint8_t *>(iovs[i].iov_base);
+                    handle_datagram(buf, msgs[i].msg_len, addrs[i], arrival_us, tracker, writer, counters);
+
+                    // 恢复的数据报晚于原本的到达时刻，不参与抖动估计
+                    size_t recovered = fec.on_datagram(buf, msgs[i].msg_len);
+                    if (recovered) {
+                        counters.recovered++;
+                        handle_datagram(fec.recovered(), recovered, addrs[i], 0, tracker, writer, counters);
+                    }
+                }
+
+                if (writer.buffer().size() >= kFlushBytes) {
+                    writer.flush();
+                    last_flush = clock::now();
+                }
+                if (static_cast<unsigned>(n) < kBatch) {
+                    break;
+                }
+            }
+        }
+
+        if (ready > 0 && ctrl_sock >= 0 && (fds[1].revents & POLLIN)) {
+            uint8_t reply[64];
+            while (::recv(ctrl_sock, reply, sizeof(reply), 0) > 0) {
+            }
+        }
+
+        now = clock::now();
+        if (now - last_flush >= std::chrono::seconds(1)) {
+            writer.flush();
+            last_flush = now;
+        }
+
+        if (opt.stats_interval_s > 0 && now - last_stats >= std::chrono::seconds(opt.stats_interval_s)) {
+            double secs = std::chrono::duration<double>(now - last_stats).count();
+            uint64_t datagrams = counters.datagrams - last_counters.datagrams;
+            uint64_t batches = counters.batches - last_counters.batches;
+            std::fprintf(stderr,
+                         "datagrams=%.0f/s frames=%.0f/s bytes=%.0f/s per_batch=%.1f truncated=%llu "
+                         "recovered=%llu kernel_drops=%u file=%s\n",
+                         datagrams / secs, (counters.frames - last_counters.frames) / secs,
+                         (counters.bytes - last_counters.bytes) / secs,
+                         batches ? static_cast<double>(datagrams) / batches : 0.0,
+                         static_cast<unsigned long long>(counters.truncated),
+                         static_cast<unsigned long long>(counters.recovered), counters.kernel_drops,
+                         writer.path().c_str());
+            tracker.report(stderr);
+            fec.report(stderr);
+            last_counters = counters;
+            last_stats = now;
+        }
+    }
+
+    writer.flush();
+    std::fprintf(stderr, "csi_recvd stopped: %llu datagrams, %llu frames, %llu bytes written\n",
+                 static_cast<unsigned long long>(counters.datagrams),
+                 static_cast<unsigned long long>(counters.frames),
+                 static_cast<unsigned long long>(writer.bytes_written()));
+    tracker.report(stderr);
+    fec.report(stderr);
+
+    if (ctrl_sock >= 0) {
+        ::close(ctrl_sock);
+    }
+    ::close(sock);
+    return 0;
+}
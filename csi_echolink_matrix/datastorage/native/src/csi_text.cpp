@@ -0,0 +1,116 @@
+#include "csi_text.hpp"
+
+#include <charconv>
+
+#include "csi_codec.h"
+
+namespace csi {
+
+namespace {
+
+template <typename T>
+void append_int(std::string &out, T value)
+{
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, res.ptr);
+}
+
+void append_field(std::string &out, long value)
+{
+    append_int(out, value);
+    out.push_back(',');
+}
+
+}  // namespace
+
+std::string mac_to_str(const uint8_t mac[6])
+{
+    static const char hex[] = "0123456789abcdef";
+    std::string s;
+    s.reserve(17);
+    for (int i = 0; i < 6; i++) {
+        if (i) {
+            s.push_back(':');
+        }
+        s.push_back(hex[mac[i] >> 4]);
+        s.push_back(hex[mac[i] & 0x0f]);
+    }
+    return s;
+}
+
+void append_frame_csv(std::string &out, const csi_frame_hdr_t *hdr)
+{
+    // 列顺序与 config.CSI_DATA_COLUMNS_NAMES 一致
+    out.append("CSI_DATA,");
+    append_field(out, hdr->seq);
+    out.append(mac_to_str(hdr->mac));
+    out.push_back(',');
+    append_field(out, hdr->rssi);
+    append_field(out, hdr->rate);
+    append_field(out, hdr->sig_mode);
+    append_field(out, hdr->mcs);
+    append_field(out, hdr->cwb);
+    append_field(out, hdr->smoothing);
+    append_field(out, hdr->not_sounding);
+    append_field(out, hdr->aggregation);
+    append_field(out, hdr->stbc);
+    append_field(out, hdr->fec_coding);
+    append_field(out, hdr->sgi);
+    append_field(out, hdr->noise_floor);
+    append_field(out, hdr->ampdu_cnt);
+    append_field(out, hdr->channel);
+    append_field(out, hdr->secondary_channel);
+    append_field(out, hdr->local_timestamp);
+    append_field(out, hdr->ant);
+    append_field(out, hdr->sig_len);
+    append_field(out, hdr->rx_state);
+
+    // 压缩帧还原为原始 I/Q，输出与未压缩时相同；无法解码时输出空列表
+    const int8_t *data = reinterpret_cast<const int8_t *>(hdr) + hdr->hdr_len;
+    size_t len = hdr->len;
+    int8_t unpacked[CSI_FRAME_MAX_PAYLOAD];
+    if (hdr->type == CSI_FRAME_TYPE_PACKED) {
+        len = csi_codec_unpack_frame(data, hdr->len, unpacked, sizeof(unpacked));
+        data = unpacked;
+    }
+    append_field(out, static_cast<long>(len));
+    append_field(out, hdr->first_word_invalid);
+
+    out.append("\"[");
+    for (size_t i = 0; i < len; i++) {
+        if (i) {
+            out.push_back(',');
+        }
+        append_int(out, static_cast<int>(data[i]));
+    }
+    out.append("]\"");
+}
+
+size_t append_datagram_text(std::string &out, const uint8_t *buf, size_t len)
+{
+    if (len == 0) {
+        return 0;
+    }
+
+    if (buf[0] != CSI_FRAME_MAGIC) {
+        while (len && (buf[len - 1] == '\n' || buf[len - 1] == '\r')) {
+            len--;
+        }
+        out.append(reinterpret_cast<const char *>(buf), len);
+        out.push_back('\n');
+        return 1;
+    }
+
+    size_t lines = 0;
+    csi_frame_iter_t it;
+    csi_frame_iter_init(&it, buf, len);
+    for (const csi_frame_hdr_t *hdr; (hdr = csi_frame_iter_next(&it)) != nullptr;) {
+        append_frame_csv(out, hdr);
+        out.push_back('\n');
+        lines++;
+    }
+    return lines;
+}
+
+}  // namespace csi
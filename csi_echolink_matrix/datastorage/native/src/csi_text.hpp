@@ -0,0 +1,37 @@
+/**
+ * @file csi_text.hpp
+ * @brief 把 CSI 数据报还原为 "CSI_DATA,..." 文本行
+ *
+ * 输出与 datastorage/csi_frame.py 的 datagram_to_text() 逐字节一致，
+ * 因此原生接收端写出的 csi_data_<ts>.txt 可以直接交给现有脚本读取。
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "csi_frame.h"
+
+namespace csi {
+
+/**
+ * @brief 把一个二进制 CSI 帧格式化为一行文本追加到 out，不含换行符
+ */
+void append_frame_csv(std::string &out, const csi_frame_hdr_t *hdr);
+
+/**
+ * @brief 把一个 UDP 数据报转换为文本追加到 out，每帧一行（以 '\n' 结尾）
+ *
+ * 二进制帧和聚合容器逐帧格式化；文本数据报原样追加（去掉末尾的换行符后补一个 '\n'）。
+ *
+ * @return 追加的行数
+ */
+size_t append_datagram_text(std::string &out, const uint8_t *buf, size_t len);
+
+/**
+ * @brief 格式化 MAC 地址，与 csi_frame.py 的 mac_to_str() 一致（小写，冒号分隔）
+ */
+std::string mac_to_str(const uint8_t mac[6]);
+
+}  // namespace csi
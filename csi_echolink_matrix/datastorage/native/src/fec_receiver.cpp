@@ -0,0 +1,34 @@
+#include "fec_receiver.hpp"
+
+#include <cinttypes>
+#include <cstring>
+
+#include "csi_text.hpp"
+
+namespace csi {
+
+size_t FecReceiver::on_datagram(const uint8_t *buf, size_t len)
+{
+    const uint8_t *probe_mac = csi_fec_probe(buf, len);
+    if (!probe_mac) {
+        return 0;
+    }
+
+    std::array<uint8_t, 6> key;
+    std::memcpy(key.data(), probe_mac, key.size());
+    auto [it, inserted] = decoders_.try_emplace(key);
+    if (inserted) {
+        csi_fec_dec_init(&it->second);
+    }
+    return csi_fec_dec_push(&it->second, buf, len, out_.data());
+}
+
+void FecReceiver::report(FILE *out) const
+{
+    for (const auto &[mac, dec] : decoders_) {
+        std::fprintf(out, "  %s fec groups=%" PRIu32 " recovered=%" PRIu32 " failed=%" PRIu32 "\n",
+                     mac_to_str(mac.data()).c_str(), dec.groups, dec.recovered, dec.failed);
+    }
+}
+
+}  // namespace csi
@@ -0,0 +1,39 @@
+/**
+ * @file fec_receiver.hpp
+ * @brief 按探针恢复 FEC 分组中丢失的聚合数据报（components/csi_fec）
+ *
+ * 每个探针一个解码器，以校验头和容器头 FEC 扩展中的 probe_mac 区分；不带 FEC 信息的数据报直接忽略。
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+
+#include "csi_fec.h"
+
+namespace csi {
+
+class FecReceiver {
+public:
+    /**
+     * @brief 交入一个收到的数据报
+     *
+     * @return 恢复出的数据报长度（内容见 recovered()），没有恢复时返回 0
+     */
+    size_t on_datagram(const uint8_t *buf, size_t len);
+
+    /** 最近一次恢复出的数据报，下一次调用 on_datagram() 前有效 */
+    const uint8_t *recovered() const { return out_.data(); }
+
+    /** 每个开启 FEC 的探针打印一行：组数、恢复的数据报数、无法恢复的组数 */
+    void report(FILE *out) const;
+
+private:
+    std::map<std::array<uint8_t, 6>, csi_fec_dec_t> decoders_;
+    std::array<uint8_t, CSI_FEC_MAX_DATAGRAM> out_{};
+};
+
+}  // namespace csi
@@ -0,0 +1,76 @@
+#include "seq_tracker.hpp"
+
+#include <arpa/inet.h>
+#include <cinttypes>
+#include <cstring>
+
+#include "csi_text.hpp"
+
+namespace csi {
+
+SourceKey SourceKey::probe(const uint8_t mac[6])
+{
+    SourceKey key;
+    key.kind = kProbeMac;
+    std::memcpy(key.id.data(), mac, 6);
+    return key;
+}
+
+SourceKey SourceKey::address(uint32_t ip_be, uint16_t port_be)
+{
+    SourceKey key;
+    key.kind = kAddress;
+    std::memcpy(key.id.data(), &ip_be, 4);
+    std::memcpy(key.id.data() + 4, &port_be, 2);
+    return key;
+}
+
+std::string SourceKey::label() const
+{
+    if (kind == kProbeMac) {
+        return mac_to_str(id.data());
+    }
+
+    char ip[INET_ADDRSTRLEN];
+    uint16_t port_be;
+    std::memcpy(&port_be, id.data() + 4, 2);
+    inet_ntop(AF_INET, id.data(), ip, sizeof(ip));
+    return std::string(ip) + ":" + std::to_string(ntohs(port_be));
+}
+
+void SeqTracker::on_frame(const Key &source, uint32_t seq)
+{
+    csi_seq_update(&sources_[source], seq, false, 0, 0);
+}
+
+void SeqTracker::on_frame(const Key &source, uint32_t seq, uint32_t send_us, uint64_t arrival_us)
+{
+    csi_seq_update(&sources_[source], seq, true, send_us, static_cast<uint32_t>(arrival_us));
+}
+
+void SeqTracker::report(FILE *out) const
+{
+    // 空洞长度分桶：丢失 1、2-3、4-7 ... 帧
+    static const char *const kGapLabels[CSI_SEQ_GAP_BUCKETS] = {
+        "1", "2-3", "4-7", "8-15", "16-31", "32-63", "64-127", "128+"};
+
+    for (const auto &[key, s] : sources_) {
+        std::fprintf(out,
+                     "  %s received=%" PRIu32 " lost=%" PRIu32 " (%.2f%%) dup=%" PRIu32
+                     " reordered=%" PRIu32 " restarts=%" PRIu32 " jitter=%" PRIu32 "us last_seq=%" PRIu32 "\n",
+                     key.label().c_str(), s.received, s.lost, csi_seq_loss_bp(&s) / 100.0, s.duplicate,
+                     s.reordered, s.restarts, csi_seq_jitter_us(&s), s.last_seq);
+
+        std::string gaps;
+        for (unsigned i = 0; i < CSI_SEQ_GAP_BUCKETS; i++) {
+            if (s.gaps[i]) {
+                gaps += std::string(" ") + kGapLabels[i] + ":" + std::to_string(s.gaps[i]);
+            }
+        }
+        if (!gaps.empty()) {
+            std::fprintf(out, "    gaps (frames lost:count)%s\n", gaps.c_str());
+        }
+    }
+}
+
+}  // namespace csi
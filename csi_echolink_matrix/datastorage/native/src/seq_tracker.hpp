@@ -0,0 +1,62 @@
+/**
+ * @file seq_tracker.hpp
+ * @brief 按数据源统计帧序号：丢失、重复、乱序、探针重启、空洞长度分布和到达抖动
+ *
+ * 二进制帧以 probe_mac 区分数据源，CSV 文本以发送端地址区分；CSV 文本没有发送端时间戳，不统计抖动。
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+
+#include "csi_seq.h"
+
+namespace csi {
+
+/** 计数规则与 AirSight 相同（components/csi_seq） */
+using SeqStats = csi_seq_stats_t;
+
+/** 数据源：二进制帧为探针 MAC，CSV 文本为发送端 IPv4 地址 + 端口（网络字节序） */
+struct SourceKey {
+    enum Kind : uint8_t { kProbeMac = 0, kAddress = 1 };
+
+    Kind kind = kProbeMac;
+    std::array<uint8_t, 6> id{};
+
+    static SourceKey probe(const uint8_t mac[6]);
+    static SourceKey address(uint32_t ip_be, uint16_t port_be);
+
+    std::string label() const;
+
+    bool operator<(const SourceKey &other) const
+    {
+        return kind != other.kind ? kind < other.kind : id < other.id;
+    }
+};
+
+class SeqTracker {
+public:
+    using Key = SourceKey;
+
+    /** 不带发送端时间戳的帧 */
+    void on_frame(const Key &source, uint32_t seq);
+
+    /**
+     * @param send_us 帧头的 local_timestamp
+     * @param arrival_us 本机接收时刻（微秒）
+     */
+    void on_frame(const Key &source, uint32_t seq, uint32_t send_us, uint64_t arrival_us);
+
+    const std::map<Key, SeqStats> &sources() const { return sources_; }
+
+    /** 每个数据源打印两行：计数和空洞长度分布 */
+    void report(FILE *out) const;
+
+private:
+    std::map<Key, SeqStats> sources_;
+};
+
+}  // namespace csi
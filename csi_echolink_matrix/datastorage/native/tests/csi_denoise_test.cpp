@@ -0,0 +1,194 @@
+/**
+ * @file csi_denoise_test.cpp
+ * @brief csi_denoise 测试：流式结果与整段重新计算（排序求中位数/MAD、直接卷积）的参考实现一致
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "csi_denoise.h"
+
+static int s_failures;
+
+#define CHECK(cond, ...)                                         \
+    do {                                                         \
+        if (!(cond)) {                                           \
+            std::fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+            std::fprintf(stderr, __VA_ARGS__);                   \
+            std::fprintf(stderr, "\n");                          \
+            s_failures++;                                        \
+        }                                                        \
+    } while (0)
+
+static float median_of(std::vector<float> v)
+{
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+/**
+ * 参考实现：单通道，输入前补 hw + sw 个第一帧，对每个位置重新计算 Hampel，再按 SG 系数卷积；
+ * 第 t 帧的输出以补齐后的第 pad + t 个样本为中心
+ */
+static std::vector<float> reference(const std::vector<float> &x, uint32_t hw, float n_sigma,
+                                    const std::vector<float> &sg)
+{
+    const size_t pad = hw + sg.size();
+    const size_t hh = hw / 2, sh = sg.size() / 2;
+    std::vector<float> ext(pad, x[0]);
+    ext.insert(ext.end(), x.begin(), x.end());
+
+    std::vector<float> hampel(ext.size(), 0.0f);
+    for (size_t i = hh; i + hh < ext.size(); i++) {
+        std::vector<float> window(ext.begin() + (i - hh), ext.begin() + (i + hh + 1));
+        float median = median_of(window);
+        for (float &v : window) {
+            v = std::fabs(v - median);
+        }
+        float mad = median_of(window);
+        hampel[i] = std::fabs(ext[i] - median) > n_sigma * 1.4826f * mad ? median : ext[i];
+    }
+
+    std::vector<float> out;
+    for (size_t t = 0; pad + t + sh + hh < ext.size(); t++) {
+        float y = 0.0f;
+        for (size_t k = 0; k < sg.size(); k++) {
+            y += sg[k] * hampel[pad + t - sh + k];
+        }
+        out.push_back(y);
+    }
+    return out;
+}
+
+static void test_against_reference(uint32_t hw, uint32_t sw, uint32_t order)
+{
+    const uint32_t channels = 5;
+    const size_t frames = 400;
+    std::mt19937 rng(hw * 100 + sw);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::uniform_int_distribution<int> spike(0, 19);
+
+    // 通道 c：正弦 + 噪声 + 随机尖峰，第 4 个通道有大量重复值
+    std::vector<float> in(frames * channels);
+    for (size_t f = 0; f < frames; f++) {
+        for (uint32_t c = 0; c < channels; c++) {
+            float v = 20.0f + 5.0f * std::sin(0.05f * f + c) + noise(rng);
+            if (spike(rng) == 0) {
+                v += 40.0f;
+            }
+            in[f * channels + c] = c == 3 ? std::round(v / 8.0f) : v;
+        }
+    }
+
+    csi_denoiser_t *d = csi_denoiser_new(channels, hw, 3.0f, sw, order);
+    CHECK(d, "new(%u, %u, %u)", hw, sw, order);
+    if (!d) {
+        return;
+    }
+    std::vector<float> sg(sw);
+    csi_denoiser_sg_coeffs(d, sg.data());
+
+    // 分成不同大小的批次输入
+    std::vector<float> out(frames * channels);
+    size_t written = 0;
+    for (size_t f = 0, batch = 1; f < frames; f += batch, batch = batch % 7 + 1) {
+        size_t n = std::min(batch, frames - f);
+        written += csi_denoiser_push(d, &in[f * channels], n, &out[written * channels]);
+    }
+    uint32_t delay = csi_denoiser_delay(d);
+    CHECK(delay == hw / 2 + sw / 2, "delay %u", delay);
+    CHECK(written == frames - delay, "written %zu", written);
+
+    double max_err = 0.0;
+    for (uint32_t c = 0; c < channels; c++) {
+        std::vector<float> x(frames);
+        for (size_t f = 0; f < frames; f++) {
+            x[f] = in[f * channels + c];
+        }
+        std::vector<float> expect = reference(x, hw, 3.0f, sg);
+        CHECK(expect.size() == written, "reference size %zu", expect.size());
+        for (size_t t = 0; t < std::min(expect.size(), written); t++) {
+            max_err = std::max(max_err, double(std::fabs(out[t * channels + c] - expect[t])));
+        }
+    }
+    CHECK(max_err < 1e-4, "hampel %u sg %u/%u max error %g", hw, sw, order, max_err);
+    csi_denoiser_free(d);
+}
+
+static void test_coeffs()
+{
+    // scipy.signal.savgol_coeffs(5, 3) = [-3, 12, 17, 12, -3] / 35
+    const float expect[] = {-3 / 35.0f, 12 / 35.0f, 17 / 35.0f, 12 / 35.0f, -3 / 35.0f};
+    float coeffs[5];
+    csi_denoiser_t *d = csi_denoiser_new(1, 7, 5.0f, 5, 3);
+    csi_denoiser_sg_coeffs(d, coeffs);
+    for (int i = 0; i < 5; i++) {
+        CHECK(std::fabs(coeffs[i] - expect[i]) < 1e-6f, "coeff %d = %g", i, coeffs[i]);
+    }
+    csi_denoiser_free(d);
+
+    CHECK(!csi_denoiser_new(0, 7, 5.0f, 5, 3), "no channels");
+    CHECK(!csi_denoiser_new(1, 6, 5.0f, 5, 3), "even hampel window");
+    CHECK(!csi_denoiser_new(1, 7, 5.0f, 5, 5), "sg order too high");
+}
+
+static void test_spike_and_reset()
+{
+    // 常数信号中的单个尖峰被去掉；复位后重新填充
+    csi_denoiser_t *d = csi_denoiser_new(1, 7, 5.0f, 5, 3);
+    std::vector<float> in(30, 10.0f), out(30);
+    in[15] = 100.0f;
+    size_t n = csi_denoiser_push(d, in.data(), in.size(), out.data());
+    for (size_t i = 0; i < n; i++) {
+        CHECK(std::fabs(out[i] - 10.0f) < 1e-5f, "frame %zu = %g", i, out[i]);
+    }
+
+    csi_denoiser_reset(d);
+    float v = 3.0f, y = 0.0f;
+    CHECK(csi_denoiser_push(d, &v, 1, &y) == 0, "first frame after reset");
+    csi_denoiser_free(d);
+}
+
+static void bench()
+{
+    const uint32_t channels = 64;
+    const size_t frames = 20000;
+    std::vector<float> in(frames * channels), out(frames * channels);
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(0.0f, 40.0f);
+    for (float &v : in) {
+        v = dist(rng);
+    }
+
+    csi_denoiser_t *d = csi_denoiser_new(channels, 7, 5.0f, 5, 3);
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < frames; f++) {
+        csi_denoiser_push(d, &in[f * channels], 1, &out[f * channels]);
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("throughput: %.0f frames/s x %u subcarriers (%.0f ns/sample)\n", frames / s, channels,
+                s * 1e9 / (frames * channels));
+    csi_denoiser_free(d);
+}
+
+int main()
+{
+    test_coeffs();
+    test_spike_and_reset();
+    test_against_reference(7, 5, 3);
+    test_against_reference(3, 7, 2);
+    test_against_reference(1, 5, 3);
+    test_against_reference(15, 1, 0);
+    test_against_reference(31, 11, 4);
+    bench();
+
+    if (s_failures) {
+        std::fprintf(stderr, "%d failure(s)\n", s_failures);
+        return 1;
+    }
+    std::printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,279 @@
+/**
+ * @file csi_kernels_test.c
+ * @brief csi_kernels 测试：SSE4.1 / AVX2 与标量实现逐位一致，精度对比双精度参考值；
+ *        压缩帧的 I/Q 解码与编码前的数据一致
+ *
+ * CPU 不支持的指令集会被跳过。
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "csi_codec.h"
+#include "csi_kernels.h"
+
+#define FRAMES      64
+#define SUBCARRIERS 128     /* LLTF + HT-LTF */
+#define COUNT       (FRAMES * SUBCARRIERS)
+
+/* 压缩帧的长度：各采集配置，以及不是向量宽度整数倍的长度 */
+static const size_t codec_lengths[] = {128, 256, 384, 612, 130, 46, 2};
+#define CODEC_LENGTHS   (sizeof(codec_lengths) / sizeof(codec_lengths[0]))
+#define CODEC_BYTES     (2 * (CSI_CODEC_MAX_QUANT + 1) * (128 + 256 + 384 + 612 + 130 + 46 + 2))
+
+static int s_failures;
+
+#define CHECK(cond, ...)                        \
+    do {                                        \
+        if (!(cond)) {                          \
+            fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);       \
+            fprintf(stderr, "\n");              \
+            s_failures++;                       \
+        }                                       \
+    } while (0)
+
+static const char *isa_name(csi_kernel_isa_t isa)
+{
+    switch (isa) {
+    case CSI_KERNEL_ISA_AVX2:
+        return "avx2";
+    case CSI_KERNEL_ISA_SSE41:
+        return "sse41";
+    default:
+        return "scalar";
+    }
+}
+
+/* 随机 I/Q，开头放入边界值：0、-128、127、轴上和对角线上的点 */
+static void fill_iq(int8_t *iq, size_t count)
+{
+    static const int8_t edges[][2] = {
+        {0, 0}, {0, 1}, {0, -1}, {1, 0}, {-1, 0}, {-128, -128}, {-128, 127}, {127, -128},
+        {127, 127}, {5, 5}, {-5, 5}, {5, -5}, {-5, -5}, {0, -128}, {-128, 0}, {1, -128},
+    };
+    size_t n_edges = sizeof(edges) / sizeof(edges[0]);
+
+    srand(12345);
+    for (size_t i = 0; i < count; i++) {
+        if (i < n_edges) {
+            iq[2 * i] = edges[i][0];
+            iq[2 * i + 1] = edges[i][1];
+        } else {
+            iq[2 * i] = (int8_t)(rand() % 256 - 128);
+            iq[2 * i + 1] = (int8_t)(rand() % 256 - 128);
+        }
+    }
+}
+
+typedef struct {
+    float amp[COUNT];
+    float phase[COUNT];
+    float unwrapped[COUNT];
+    float sanitized[COUNT];
+    float tail_amp[COUNT];      /* 起点不对齐、长度不是向量宽度整数倍 */
+    int8_t unpacked[CODEC_BYTES]; /* 随机 I/Q 和平滑 I/Q 按各长度、量化位数编码后再解码 */
+} results_t;
+
+/* 类似实际 CSI 的 I/Q：沿子载波方向平滑变化，叠加少量噪声 */
+static void fill_smooth(int8_t *iq, size_t n)
+{
+    srand(777);
+    for (size_t i = 0; i < n; i++) {
+        double sub = (double)(i / 2);
+        double v = 60.0 * ((i & 1) ? cos(sub * 0.11) : sin(sub * 0.11));
+        iq[i] = (int8_t)(v + rand() % 5 - 2);
+    }
+}
+
+/* 编码为压缩帧的数据区（csi_codec_hdr_t + 编码结果），不要求比原始数据短 */
+static size_t pack_frame(const int8_t *iq, size_t n, unsigned quant, uint8_t *data)
+{
+    csi_codec_hdr_t hdr = {.info = CSI_CODEC_INFO(n, quant)};
+    memcpy(data, &hdr, sizeof(hdr));
+    return sizeof(hdr) + csi_codec_encode(iq, n, quant, data + sizeof(hdr), CSI_CODEC_MAX_SIZE(n));
+}
+
+static void run_codec(const int8_t *random, const int8_t *smooth, int8_t *out)
+{
+    uint8_t data[sizeof(csi_codec_hdr_t) + CSI_CODEC_MAX_SIZE(CSI_FRAME_MAX_PAYLOAD)];
+
+    for (int source = 0; source < 2; source++) {
+        for (unsigned q = 0; q <= CSI_CODEC_MAX_QUANT; q++) {
+            for (size_t l = 0; l < CODEC_LENGTHS; l++) {
+                size_t n = codec_lengths[l];
+                size_t len = pack_frame(source ? smooth : random, n, q, data);
+                CHECK(csi_iq_unpack(data, len, out, n) == n, "unpack %zu bytes, quant %u", n, q);
+                CHECK(csi_iq_unpack(data, len - 1, out, n) == 0, "truncated %zu bytes", n);
+                out += n;
+            }
+        }
+    }
+}
+
+static void run_all(const int8_t *iq, const uint32_t *positions, const float *x, size_t n_valid,
+                    results_t *r)
+{
+    memset(r, 0, sizeof(*r));
+    csi_iq_to_amp_phase(iq, COUNT, r->amp, r->phase);
+    CHECK(csi_phase_unwrap(r->phase, FRAMES, SUBCARRIERS, r->unwrapped) == 0, "unwrap");
+    CHECK(csi_phase_sanitize(r->phase, FRAMES, SUBCARRIERS, positions, x, n_valid, r->sanitized) == 0,
+          "sanitize");
+    csi_iq_to_amp_phase(iq + 2, COUNT - 13, r->tail_amp, NULL);
+
+    static int8_t smooth[CSI_FRAME_MAX_PAYLOAD];
+    fill_smooth(smooth, sizeof(smooth));
+    run_codec(iq, smooth, r->unpacked);
+}
+
+/* 与 datastorage/csi_native.py 的默认一致：LLTF 的 52 个有效子载波，x 为 -26..-1、1..26 */
+static size_t lltf_positions(uint32_t *positions, float *x)
+{
+    size_t n = 0;
+    for (int k = 38; k < 64; k++, n++) {
+        positions[n] = (uint32_t)k;
+        x[n] = (float)(k - 64);
+    }
+    for (int k = 1; k < 27; k++, n++) {
+        positions[n] = (uint32_t)k;
+        x[n] = (float)k;
+    }
+    return n;
+}
+
+static void test_accuracy(const int8_t *iq, const results_t *r)
+{
+    double max_amp = 0, max_phase = 0;
+    for (size_t i = 0; i < COUNT; i++) {
+        double y = iq[2 * i], x = iq[2 * i + 1];
+        double amp_err = fabs(r->amp[i] - hypot(x, y)) / (hypot(x, y) > 1 ? hypot(x, y) : 1);
+        double phase_err = fabs(r->phase[i] - atan2(y, x));
+        if (amp_err > max_amp) {
+            max_amp = amp_err;
+        }
+        if (phase_err > max_phase) {
+            max_phase = phase_err;
+        }
+    }
+    printf("accuracy: amplitude rel %.3g, phase abs %.3g rad\n", max_amp, max_phase);
+    CHECK(max_amp < 1e-6, "amplitude error %g", max_amp);
+    CHECK(max_phase < 2e-6, "phase error %g", max_phase);
+}
+
+static void test_unwrap(const results_t *r)
+{
+    // 解缠绕后相邻子载波相差不超过 pi，且与原相位相差 2*pi 的整数倍
+    for (size_t f = 0; f < FRAMES; f++) {
+        const float *in = r->phase + f * SUBCARRIERS;
+        const float *out = r->unwrapped + f * SUBCARRIERS;
+        CHECK(out[0] == in[0], "frame %zu first subcarrier", f);
+        for (size_t k = 1; k < SUBCARRIERS; k++) {
+            CHECK(fabsf(out[k] - out[k - 1]) <= 3.1416f, "frame %zu sub %zu jump", f, k);
+            double turns = (in[k] - out[k]) / (2 * M_PI);
+            CHECK(fabs(turns - nearbyint(turns)) < 1e-3, "frame %zu sub %zu turns %g", f, k, turns);
+        }
+    }
+}
+
+static void test_codec(const int8_t *iq, const results_t *r)
+{
+    // 无损模式与原始数据相同；有损模式的误差不超过量化步长的一半（接近 127 的值除外）
+    static int8_t smooth[CSI_FRAME_MAX_PAYLOAD];
+    const int8_t *out = r->unpacked;
+    int max_err = 0;
+
+    fill_smooth(smooth, sizeof(smooth));
+    for (int source = 0; source < 2; source++) {
+        for (unsigned q = 0; q <= CSI_CODEC_MAX_QUANT; q++) {
+            int half = q ? 1 << (q - 1) : 0;
+            for (size_t l = 0; l < CODEC_LENGTHS; l++) {
+                const int8_t *in = source ? smooth : iq;
+                for (size_t i = 0; i < codec_lengths[l]; i++) {
+                    int err = abs(out[i] - in[i]);
+                    if (in[i] <= 127 - half && err > max_err) {
+                        max_err = err;
+                    }
+                    CHECK(in[i] > 127 - half || err <= half, "quant %u value %d -> %d", q, in[i], out[i]);
+                }
+                out += codec_lengths[l];
+            }
+        }
+    }
+    printf("codec: %zu frames decoded, max error %d\n", 2 * (CSI_CODEC_MAX_QUANT + 1) * CODEC_LENGTHS, max_err);
+
+    uint8_t bad[8] = {0};
+    int8_t sink[CSI_FRAME_MAX_PAYLOAD + 2];
+    csi_codec_hdr_t hdr = {.info = CSI_CODEC_INFO(CSI_FRAME_MAX_PAYLOAD + 2, 0)};
+    memcpy(bad, &hdr, sizeof(hdr));
+    CHECK(csi_iq_unpack(bad, sizeof(bad), sink, sizeof(sink)) == 0, "raw length range");
+}
+
+static void test_sanitize(void)
+{
+    // 直线相位（加上若干圈缠绕）校正后应接近 0
+    uint32_t positions[64];
+    float x[64];
+    size_t n_valid = lltf_positions(positions, x);
+    float phase[SUBCARRIERS] = {0};
+    float out[64];
+
+    for (size_t k = 0; k < n_valid; k++) {
+        double v = 0.3 * x[k] + 1.2;
+        phase[positions[k]] = (float)(v - 2 * M_PI * floor((v + M_PI) / (2 * M_PI)));
+    }
+    CHECK(csi_phase_sanitize(phase, 1, SUBCARRIERS, positions, x, n_valid, out) == 0, "sanitize");
+    for (size_t k = 0; k < n_valid; k++) {
+        CHECK(fabsf(out[k]) < 1e-4f, "residual %zu = %g", k, out[k]);
+    }
+
+    // 参数检查
+    CHECK(csi_phase_sanitize(phase, 1, SUBCARRIERS, positions, x, 1, out) == -1, "n_valid 1");
+    positions[0] = SUBCARRIERS;
+    CHECK(csi_phase_sanitize(phase, 1, SUBCARRIERS, positions, x, n_valid, out) == -1, "position range");
+    CHECK(csi_phase_unwrap(phase, 1, CSI_KERNEL_MAX_SUBCARRIERS + 1, out) == -1, "n_sub range");
+}
+
+int main(void)
+{
+    static int8_t iq[2 * COUNT];
+    static results_t reference, current;
+    uint32_t positions[64];
+    float x[64];
+    size_t n_valid = lltf_positions(positions, x);
+
+    fill_iq(iq, COUNT);
+
+    CHECK(csi_kernel_set_isa(CSI_KERNEL_ISA_SCALAR) == CSI_KERNEL_ISA_SCALAR, "select scalar");
+    run_all(iq, positions, x, n_valid, &reference);
+    test_accuracy(iq, &reference);
+    test_unwrap(&reference);
+    test_codec(iq, &reference);
+    test_sanitize();
+
+    for (int isa = CSI_KERNEL_ISA_SSE41; isa <= CSI_KERNEL_ISA_AVX2; isa++) {
+        if (csi_kernel_set_isa((csi_kernel_isa_t)isa) != (csi_kernel_isa_t)isa) {
+            printf("%s: not supported, skipped\n", isa_name((csi_kernel_isa_t)isa));
+            continue;
+        }
+        run_all(iq, positions, x, n_valid, &current);
+        CHECK(memcmp(current.amp, reference.amp, sizeof(current.amp)) == 0, "%s amplitude", isa_name(isa));
+        CHECK(memcmp(current.phase, reference.phase, sizeof(current.phase)) == 0, "%s phase", isa_name(isa));
+        CHECK(memcmp(current.unwrapped, reference.unwrapped, sizeof(current.unwrapped)) == 0,
+              "%s unwrap", isa_name(isa));
+        CHECK(memcmp(current.sanitized, reference.sanitized, sizeof(current.sanitized)) == 0,
+              "%s sanitize", isa_name(isa));
+        CHECK(memcmp(current.tail_amp, reference.tail_amp, sizeof(current.tail_amp)) == 0,
+              "%s unaligned tail", isa_name(isa));
+        CHECK(memcmp(current.unpacked, reference.unpacked, sizeof(current.unpacked)) == 0,
+              "%s codec", isa_name(isa));
+        printf("%s: bit-exact with scalar\n", isa_name(isa));
+    }
+
+    if (s_failures) {
+        fprintf(stderr, "%d failure(s)\n", s_failures);
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -27,8 +27,11 @@ import threading
 import matplotlib.pyplot as plt
 import matplotlib.animation as animation
 from matplotlib.gridspec import GridSpec
-import math
+import numpy as np
 from collections import deque
+from csi_frame import mac_to_str
+from csi_native import amplitude_phase, parse_datagrams, subcarrier_map
+from airsight_ctrl import start_subscription
 
 # ========================
 # 配置参数
@@ -63,65 +66,44 @@ global_data = {
 def udp_receiver():
     sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
     sock.bind(("0.0.0.0", UDP_PORT))
+    # 按配置加入组播组，或向 AirSight 订阅（后台线程定期续约）
+    start_subscription(sock)
     sock.settimeout(0.1)
 
     while True:
         try:
-            data, addr = sock.recvfrom(1024)
+            data, addr = sock.recvfrom(2048)
             # if addr[0] != UDP_IP:
             #     continue
             # print(data)
 
-            # 数据预处理
-            decoded = data.decode().strip().replace('"', '')
-            if not decoded.startswith("CSI_DATA"):
-                continue
-
-            # 结构化解析
-            parts = decoded.split(',', len(CSI_COLUMNS)-1)
-            if len(parts) != len(CSI_COLUMNS):
-                continue
-
-            packet = dict(zip(CSI_COLUMNS, parts))
-            
             try:
-                # 解析CSI数据
-                csi_str = packet['data'].strip('[]')
-                csi_pairs = [float(x) for x in csi_str.split(',')]
-                
-                # 计算幅度
-                magnitudes = []
-                for i in range(0, len(csi_pairs)-1, 2):
-                    try:
-                        imag = csi_pairs[i]
-                        real = csi_pairs[i+1]
-                        mag = math.sqrt(imag**2 + real**2)
-                        # if real < 0:
-                        #     mag = mag * -1
-                        magnitudes.append(mag)
-                    except IndexError:
-                        continue
+                # 批量解析（二进制帧、聚合容器或CSV文本），幅度由 SIMD 内核按整批计算
+                records, _, iq = parse_datagrams(data, n_sub=0, with_iq=True)
+                amplitude, _ = amplitude_phase(iq, with_phase=False)
+                for record, row in zip(records, amplitude):
+                    magnitudes = row[subcarrier_map(record['len'], record['bandwidth']).positions]
                 
-                # 提取参数
-                params = {
-                    'local_timestamp': packet['local_timestamp'],
-                    'mac': packet['mac'][:17],  # MAC地址截断
-                    'rate': f"{packet['rate']} Mbps",
-                    'mcs': packet['mcs'],
-                    'channel': packet['channel'],
-                    'rssi': f"{packet['rssi']} dBm",
-                    'noise_floor': f"{packet['noise_floor']} dBm",
-                    'bandwidth': f"{packet['bandwidth']} MHz"
-                }
+                    # 提取参数
+                    params = {
+                        'local_timestamp': int(record['local_timestamp']),
+                        'mac': mac_to_str(bytes(record['mac'])),
+                        'rate': f"{record['rate']} Mbps",
+                        'mcs': int(record['mcs']),
+                        'channel': int(record['channel']),
+                        'rssi': f"{record['rssi']} dBm",
+                        'noise_floor': f"{record['noise_floor']} dBm",
+                        'bandwidth': f"{record['bandwidth']} MHz"
+                    }
                 
 
-                # 更新全局数据
-                with global_data['lock']:
-                    if magnitudes:
-                        global_data['csi_mag'].extend(magnitudes)
-                    global_data['rssi'].append(float(packet['rssi']))
-                    global_data['params'] = params
-                    # print(params)
+                    # 更新全局数据
+                    with global_data['lock']:
+                        if len(magnitudes):
+                            global_data['csi_mag'].extend(magnitudes)
+                        global_data['rssi'].append(float(record['rssi']))
+                        global_data['params'] = params
+                        # print(params)
 
             except (ValueError, KeyError) as e:
                 print(f"数据解析错误: {str(e)}")
@@ -3,14 +3,10 @@ import threading
 import matplotlib.pyplot as plt
 import matplotlib.animation as animation
 import matplotlib.gridspec as gridspec
-import math
 import numpy as np
 from collections import deque
-from config import CSI_DATA_COLUMNS_NAMES
-
-import pandas as pd
-from hampel import hampel
-from scipy.signal import savgol_filter
+from csi_native import DenoiserBank, amplitude_phase, parse_datagrams, subcarrier_map
+from airsight_ctrl import start_subscription
 
 
 # 配置参数
@@ -19,9 +15,8 @@ UDP_PORT = 4444
 CSI_DATA_LEN = 128
 
 MAX_CACHE_FRAME = 1
-FRONT_INVAILD = 12
-END_INVAILD = 10
-MAX_POINTS = int((CSI_DATA_LEN - FRONT_INVAILD - END_INVAILD)/2) # 最大显示点数
+# 有效子载波由 subcarrier_map 按帧头的 len、bandwidth 选择，显示范围按 CSI_DATA_LEN 的 20 MHz 布局
+MAX_POINTS = len(subcarrier_map(CSI_DATA_LEN).positions) # 最大显示点数
 # MAX_POINTS = int(CSI_DATA_LEN/2)
 
 
@@ -35,21 +30,9 @@ global_data = {
     'lock': threading.Lock()
 }
 
-def csidata_noise_filter(data):
-    # 参数说明
-    #data 为1个包的csi数据
-    # print(data)
-    amplitude_df = pd.DataFrame(data)
-    amp_np = amplitude_df.to_numpy().T
-    
-    # Hampel滤波
-    result = hampel(amp_np[0], window_size=7, n_sigma=5.0)
-    filtered_data = result.filtered_data
-
-    # Savitzky - Golay滤波
-    savgol_filtered = savgol_filter(filtered_data, window_length=5, polyorder=3)
-    # return filtered_data,savgol_filtered
-    return savgol_filtered
+# 每个发送端一组流式滤波器：逐子载波沿时间做 Hampel(7, 5σ) + Savitzky-Golay(5, 3)，
+# 每帧都要输入，因此在接收线程中调用；输出比输入晚 5 帧
+csi_denoiser = DenoiserBank(hampel_window=7, n_sigma=5.0, sg_window=5, sg_order=3)
 
 # --------------------------------------------------
 # 增强型UDP接收器
@@ -57,44 +40,40 @@ def csidata_noise_filter(data):
 def udp_receiver():
     sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
     sock.bind(("0.0.0.0", UDP_PORT))
+    # 按配置加入组播组，或向 AirSight 订阅（后台线程定期续约）
+    start_subscription(sock)
     sock.settimeout(0.1)
 
     while True:
         try:
             data, addr = sock.recvfrom(4096)
 
-            print(data.decode())
+            # print(data.decode())
             
             # print(addr[0])
             # if addr[0] != UDP_IP:
             #     continue
                 
-            # 数据预处理
-            decoded = data.decode().strip().replace('"','')
-            if not decoded.startswith("CSI_DATA"):
-                continue
-
-            # 结构化解析
-            parts = decoded.split(',', len(CSI_DATA_COLUMNS_NAMES)-1)
-            if len(parts) != len(CSI_DATA_COLUMNS_NAMES):
-                continue
-
-            # 提取关键字段
-            packet = dict(zip(CSI_DATA_COLUMNS_NAMES, parts))
             try:
-                # 解析CSI数据
-                csi_str = packet['data'].strip('[]')
-                csi_values = [float(x) for x in csi_str.split(',')]
-                csi_values = csi_values[FRONT_INVAILD:-1*END_INVAILD]
-                # csi_values[:-1] = csi_values[1:]
-                # 提取RSSI
-                rssi = float(packet['rssi'])
+                # 批量解析（二进制帧、聚合容器或CSV文本），幅度由 SIMD 内核按整批计算
+                records, _, iq = parse_datagrams(data, n_sub=0, with_iq=True)
+                amplitude, _ = amplitude_phase(iq, with_phase=False)
+                for record, amp, row in zip(records, amplitude, iq):
+                    # 只保留有效子载波（去掉保护带和直流）
+                    valid = subcarrier_map(record['len'], record['bandwidth']).positions
+                    denoised = csi_denoiser.push(bytes(record['mac']), amp[valid])
+                    if not len(denoised):
+                        continue
+                    # 提取RSSI
+                    rssi = float(record['rssi'])
                 
-                with global_data['lock']:
-                    global_data['raw_packet'] = {
-                        'csi': csi_values,
-                        'rssi': rssi
-                    }
+                    with global_data['lock']:
+                        global_data['raw_packet'] = {
+                            'amplitude': denoised[-1],
+                            'imag': row[0::2][valid],
+                            'real': row[1::2][valid],
+                            'rssi': rssi
+                        }
                     
             except (ValueError, KeyError) as e:
                 print(f"解析错误: {str(e)}")
@@ -113,33 +92,15 @@ def data_processor():
             raw = global_data['raw_packet']
         
         if raw:
-            # CSI数据处理
-            csi_pairs = []
-            imag_list = []
-            real_list = []            
-            csi_data = raw['csi']
-            # print(csi_data)
-            # Rotate data to the left
-            # csi_data[:-1] = csi_data[1:]
-            for i in range(0, len(csi_data)-1, 2):
-                try:
-                    imag = float(csi_data[i])
-                    real = float(csi_data[i+1])
-                    csi_pairs.append(math.sqrt(imag**2 + real**2))
-                    # if math.sqrt(imag**2 + real**2) == 0:
-                    #     print(f'csi_pairs index:{i},{i+1}')
-                    #     print(csi_data)
-                    imag_list.append(imag)
-                    real_list.append(real)                    
-                except (IndexError, ValueError):
-                    continue
+            # CSI数据处理：幅度已在接收时计算并去噪
+            csi_pairs = raw['amplitude']
             
             # 更新全局数据
             with global_data['lock']:
-                if csi_pairs:
-                    global_data['csi_magnitude'].extend(csidata_noise_filter(csi_pairs))
-                    global_data['imag_values'].extend(imag_list)
-                    global_data['real_values'].extend(real_list)
+                if len(csi_pairs):
+                    global_data['csi_magnitude'].extend(csi_pairs)
+                    global_data['imag_values'].extend(raw['imag'])
+                    global_data['real_values'].extend(raw['real'])
                 global_data['rssi_values'].append(raw['rssi'])
                 
             global_data['raw_packet'] = None
@@ -2,10 +2,11 @@ import socket
 import threading
 import matplotlib.pyplot as plt
 import matplotlib.animation as animation
-import math
 import ast
+import numpy as np
 from collections import deque
-from config import CSI_DATA_COLUMNS_NAMES
+from csi_native import amplitude_phase, parse_datagrams, subcarrier_map
+from airsight_ctrl import start_subscription
 
 # 配置参数
 UDP_IP = "192.168.99.55"
@@ -27,6 +28,8 @@ global_data = {
 def udp_receiver():
     sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
     sock.bind(("0.0.0.0", UDP_PORT))
+    # 按配置加入组播组，或向 AirSight 订阅（后台线程定期续约）
+    start_subscription(sock)
     sock.settimeout(0.1)
 
     while True:
@@ -37,30 +40,20 @@ def udp_receiver():
             # if addr[0] != UDP_IP:
             #     continue
                 
-            # 数据预处理
-            decoded = data.decode().strip().replace('"','')
-            if not decoded.startswith("CSI_DATA"):
-                continue
-
-            # 结构化解析
-            parts = decoded.split(',', len(CSI_DATA_COLUMNS_NAMES)-1)
-            if len(parts) != len(CSI_DATA_COLUMNS_NAMES):
-                continue
-
-            # 提取关键字段
-            packet = dict(zip(CSI_DATA_COLUMNS_NAMES, parts))
             try:
-                # 解析CSI数据
-                csi_str = packet['data'].strip('[]')
-                csi_values = [float(x) for x in csi_str.split(',')]
-                # 提取RSSI
-                rssi = float(packet['rssi'])
+                # 批量解析（二进制帧、聚合容器或CSV文本），幅度由 SIMD 内核按整批计算
+                records, _, iq = parse_datagrams(data, n_sub=0, with_iq=True)
+                amplitude, _ = amplitude_phase(iq, with_phase=False)
+                for record, row in zip(records, amplitude):
+                    csi_values = row[subcarrier_map(record['len'], record['bandwidth']).positions]
+                    # 提取RSSI
+                    rssi = float(record['rssi'])
                 
-                with global_data['lock']:
-                    global_data['raw_packet'] = {
-                        'csi': csi_values,
-                        'rssi': rssi
-                    }
+                    with global_data['lock']:
+                        global_data['raw_packet'] = {
+                            'amplitude': csi_values,
+                            'rssi': rssi
+                        }
                     
             except (ValueError, KeyError) as e:
                 print(f"解析错误: {str(e)}")
@@ -79,20 +72,12 @@ def data_processor():
             raw = global_data['raw_packet']
         
         if raw:
-            # CSI数据处理
-            csi_pairs = []
-            csi_data = raw['csi']
-            for i in range(0, len(csi_data)-1, 2):
-                try:
-                    imag = float(csi_data[i])
-                    real = float(csi_data[i+1])
-                    csi_pairs.append(math.sqrt(imag**2 + real**2))
-                except (IndexError, ValueError):
-                    continue
+            # CSI数据处理：幅度已在接收时计算
+            csi_pairs = raw['amplitude']
             
             # 更新全局数据
             with global_data['lock']:
-                if csi_pairs:
+                if len(csi_pairs):
                     global_data['csi_magnitude'].extend(csi_pairs)
                 global_data['rssi_values'].append(raw['rssi'])
                 
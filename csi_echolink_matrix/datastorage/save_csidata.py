@@ -20,6 +20,12 @@ import os
 import time
 from config import *
 from tools import *
+from csi_frame import datagram_to_text
+from csi_native import parse_datagrams
+from csi_capture import CaptureWriter
+from csi_seq import SeqTracker
+from csi_fec import FecReceiver, is_parity
+from airsight_ctrl import start_subscription
 
 class Udp_Server:
     def __init__(self, ip_type, ip, port):
@@ -29,9 +35,18 @@ class Udp_Server:
         self.sock = None
         self.csi_data_file_name = ""
         self.file_size_limit = 1 * 1024 * 1024  # 1MB
+        # 列式格式按块写入，单个文件可以更大
+        self.capture_writer = None
+        if CSI_Capture_Format == 'columnar':
+            self.capture_writer = CaptureWriter('.', rotate_bytes=64 * self.file_size_limit)
         
         self.recv_csi_raw_data = ""
         self.g_r_count = 0
+        # 按探针统计丢失、乱序和到达抖动，每 Seq_Report_Interval_S 秒打印一次
+        self.seq_tracker = SeqTracker()
+        self.last_seq_report = time.monotonic()
+        # AirProbe 开启 FEC 时恢复每组中丢失的一个聚合数据报
+        self.fec_receiver = FecReceiver()
 
     def socket_bind(self):
         '''
@@ -76,22 +91,18 @@ class Udp_Server:
             while True:
                 # time.sleep(1)
                 try:
-                    data, addr = self.sock.recvfrom(1024)
+                    data, addr = self.sock.recvfrom(2048)
                     self.g_r_count = self.g_r_count + 1
                     print(f'Received {self.g_r_count} message from {addr[0]} : {addr[1]}')
                     # print('Data:' + data.decode('utf-8'))
                     # 发送接收成功数据
                     # self.send_data('Data received successfully', addr)
-                    if action == "file":
-                        # 保存csi数据
-                        self.save_csi_data(data)
-                    else:
-                        self.recv_csi_raw_data = data.decode('utf-8')    
- 
-                        csi_data_dict = parse_csi_data(self.recv_csi_raw_data)
-                        if len(csi_data_dict) >0 :
-                            print(f'rssi={csi_data_dict['rssi']}')
-                            print(f'csi={csi_data_dict['data']}')
+                    # 校验数据报只用于恢复，FEC 恢复出的数据报与收到的数据报一样处理
+                    recovered = self.fec_receiver.push(data)
+                    if not is_parity(data):
+                        self.handle_datagram(data, addr, action)
+                    if recovered:
+                        self.handle_datagram(recovered, addr, action)
                 except socket.error as msg:
                     print(f'Recv failed. Error Info: {msg}')
                     # sys.exit()
@@ -100,6 +111,42 @@ class Udp_Server:
             self.close()
             sys.exit()
 
+    def handle_datagram(self, data, addr, action):
+        '''
+        @brief:统计序号后保存或打印一个数据报中的 CSI 数据
+        @param:action: 'file' 保存到文件，其它值只打印
+        '''
+        self.track_seq(data, addr)
+        if action == "file":
+            # 保存csi数据
+            self.save_csi_data(data)
+        else:
+            # 聚合容器中的每帧各占一行
+            for line in datagram_to_text(data).splitlines():
+                self.recv_csi_raw_data = line
+
+            records, csi = parse_datagrams(data)
+            for record, row in zip(records, csi):
+                print(f"rssi={record['rssi']}")
+                print(f"csi={row[:int(record['len']) // 2]}")
+
+    def track_seq(self, data, addr):
+        '''
+        @brief:统计数据报中各帧的序号，到时打印各探针的丢失率、空洞长度分布和抖动
+        @param:data: 收到的数据报
+        @param:addr: 发送端地址，CSV 文本按它区分数据源
+        '''
+        if not Seq_Report_Interval_S:
+            return
+        records, _ = parse_datagrams(data, n_sub=0)
+        self.seq_tracker.update_records(records, addr)
+
+        now = time.monotonic()
+        if now - self.last_seq_report >= Seq_Report_Interval_S:
+            self.last_seq_report = now
+            for line in self.seq_tracker.report() + self.fec_receiver.report():
+                print(line)
+
     def send_data(self, data, addr):
         '''
         @brief:send data
@@ -120,6 +167,8 @@ class Udp_Server:
         @param:none
         @return:none
         '''
+        if self.capture_writer is not None:
+            self.capture_writer.close()
         self.sock.close()
 
     def create_csi_data_file(self):
@@ -159,10 +208,17 @@ class Udp_Server:
         @return:none
         '''
         
+        if self.capture_writer is not None:
+            try:
+                self.capture_writer.append_datagram(data)
+            except Exception as e:
+                print(f"Error saving data: {e}")
+            return
+
         # 检查文件是否存在以及大小
         try:
             csi_file = self.create_csi_data_file()
-            csi_file.write(data.decode('utf-8') + '\n')  # 写入数据，添加换行符
+            csi_file.write(datagram_to_text(data) + '\n')  # 写入数据（二进制帧还原为CSV文本），添加换行符
             csi_file.close()
         except Exception as e:
             print(f"Error saving data: {e}")
@@ -171,6 +227,7 @@ if __name__ == '__main__':
     try:
         udp_server = Udp_Server('ipv4', UDP_Server_IP, UDP_Server_Port)
         udp_server.socket_bind()
+        start_subscription(udp_server.sock)
         udp_server.recv_data('file')       
     except KeyboardInterrupt:
         print('Keyboard interrupt received. Closing socket and exiting.')
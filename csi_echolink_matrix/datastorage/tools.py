@@ -13,7 +13,7 @@ csidata_sample = 'CSIDATA,19003,24:ec:4a:04:7a:0d,-49,11,1,7,1,1,1,0,0,0,1,-95,0
 
 def parse_csi_data(csi_data):
     """
-    解析 CSI 数据
+    解析 CSI 数据（逐字段字符串，保留供旧脚本使用；新代码使用 csi_native.parse_datagrams 批量解析）
     :param csi_data_tile: 数据格式定义
     :param csi_data: 接收到的 CSI 数据
     :return: 解析后的字典